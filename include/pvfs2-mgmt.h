@@ -89,6 +89,37 @@ enum PINT_server_perf_keys
     PINT_PERF_IO = 20,                  /* io requests called */
     PINT_PERF_SMALL_IO = 21,            /* small_io requests called */
     PINT_PERF_READDIR = 22,             /* readdir requests called */
+    PINT_PERF_REQSCHED_META_QUEUED = 23, /* queued metadata requests */
+    PINT_PERF_REQSCHED_IO_QUEUED = 24,  /* queued I/O requests */
+    PINT_PERF_REQSCHED_MGMT_QUEUED = 25, /* queued mgmt requests */
+    PINT_PERF_FLOW_BUFFERS = 26,        /* flow buffers allocated */
+    PINT_PERF_FLOW_BUFFER_BYTES = 27,   /* bytes in flow buffers */
+    PINT_PERF_FLOW_DEPTH_GROW = 28,     /* flow pipeline depth increases */
+    PINT_PERF_FLOW_POOL_INUSE = 29,     /* pooled flow buffer bytes in use */
+    PINT_PERF_FLOW_POOL_CACHED = 30,    /* pooled flow buffer bytes idle */
+    PINT_PERF_FLOW_POOL_HITS = 31,      /* flow buffers reused from pool */
+    PINT_PERF_FLOW_POOL_MISSES = 32,    /* flow buffers newly allocated */
+    PINT_PERF_FLOW_POOL_WAITS = 33,     /* flows queued for a buffer */
+    PINT_PERF_FLOW_SENDFILE = 34,       /* bytes sent with sendfile() */
+    PINT_PERF_META_BATCHES = 35,        /* metadata batches committed */
+    PINT_PERF_META_BATCH_OPS = 36,      /* metadata ops in those batches */
+    PINT_PERF_META_BATCH_1 = 37,        /* batches of 1 op */
+    PINT_PERF_META_BATCH_2_7 = 38,      /* batches of 2-7 ops */
+    PINT_PERF_META_BATCH_8_31 = 39,     /* batches of 8-31 ops */
+    PINT_PERF_META_BATCH_32 = 40,       /* batches of 32 or more ops */
+    PINT_PERF_META_BATCH_LAT_100US = 41, /* batches durable in < 100us */
+    PINT_PERF_META_BATCH_LAT_1MS = 42,  /* batches durable in < 1ms */
+    PINT_PERF_META_BATCH_LAT_10MS = 43, /* batches durable in < 10ms */
+    PINT_PERF_META_BATCH_LAT_SLOW = 44, /* batches taking 10ms or more */
+    PINT_PERF_TROVE_READ_QUEUED = 45,   /* ops queued for read threads */
+    PINT_PERF_TROVE_READ_OPS = 46,      /* ops serviced by read threads */
+    PINT_PERF_READDIRPLUS = 47,         /* readdirplus requests called */
+    PINT_PERF_SMALL_IO_BATCHES = 48,    /* coalesced small I/O trove ops */
+    PINT_PERF_SMALL_IO_BATCH_OPS = 49,  /* small I/O requests they served */
+    PINT_PERF_SMALL_IO_BATCH_SEGS = 50, /* datafile regions after merging */
+    PINT_PERF_DIR_SPLITS = 51,          /* directory splits in progress */
+    PINT_PERF_DIR_SPLIT_SCANNED = 52,   /* entries scanned by splits */
+    PINT_PERF_DIR_SPLIT_MOVED = 53,     /* entries moved by splits */
 };
 
 /*
@@ -106,6 +137,13 @@ enum PINT_server_perf_tkeys
     PINT_PERF_TIO = 7,                  /* time for io requests */
     PINT_PERF_TSMALL_IO = 8,            /* time for small_io requests */
     PINT_PERF_TREADDIR = 9,             /* time for readdir requests */
+    PINT_PERF_TREQSCHED_META_WAIT = 10, /* sched wait, metadata requests */
+    PINT_PERF_TREQSCHED_IO_WAIT = 11,   /* sched wait, I/O requests */
+    PINT_PERF_TREQSCHED_MGMT_WAIT = 12, /* sched wait, mgmt requests */
+    PINT_PERF_TFLOW_POOL_WAIT = 13,     /* flow wait for a pooled buffer */
+    PINT_PERF_TMETA_BATCH = 14,         /* metadata batch open to durable */
+    PINT_PERF_TREADDIRPLUS = 15,        /* time for readdirplus requests */
+    PINT_PERF_TDIR_SPLIT_FLIP = 16,     /* directory held by a split */
 };
 
 /** A counter is simply a 64-bit integer.  A timer is 4 64-bit integers 
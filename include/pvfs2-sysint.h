@@ -31,6 +31,8 @@ enum PVFS_sys_setinfo_opt
     PVFS_SYS_MSG_TIMEOUT_SECS,
     PVFS_SYS_MSG_RETRY_LIMIT,
     PVFS_SYS_MSG_RETRY_DELAY_MSECS,
+    PVFS_SYS_WB_MEM_LIMIT_BYTES,
+    PVFS_SYS_WB_BUFFER_SIZE,
 };
 
 /** Holds a non-blocking system interface operation handle. */
@@ -136,6 +138,17 @@ struct PVFS_sysresp_create_s
 };
 typedef struct PVFS_sysresp_create_s PVFS_sysresp_create;
 
+/** Holds results of a create_list operation (one reference and one error
+ *  code per requested name, both allocated by the call and freed by the
+ *  caller).
+ */
+struct PVFS_sysresp_create_list_s
+{
+    PVFS_object_ref *ref_array;
+    PVFS_error *error_array;
+};
+typedef struct PVFS_sysresp_create_list_s PVFS_sysresp_create_list;
+
 /* remove */
 /* no data returned in remove response */
 
@@ -194,6 +207,15 @@ typedef struct PVFS_sysresp_readdirplus_s PVFS_sysresp_readdirplus;
 /* truncate */
 /* no data returned in truncate response */
 
+/** Holds results of a copy_range operation (number of bytes of the
+ *  source file copied).
+ */
+struct PVFS_sysresp_copy_range_s
+{
+    PVFS_size total_copied;
+};
+typedef struct PVFS_sysresp_copy_range_s PVFS_sysresp_copy_range;
+
 struct PVFS_sysresp_statfs_s
 {
     PVFS_statfs statfs_buf;
@@ -405,6 +427,30 @@ PVFS_error PVFS_sys_create(
     PVFS_sys_layout *layout,
     PVFS_hint hints);
 
+PVFS_error PVFS_isys_create_list(
+    char **entry_names,
+    int count,
+    PVFS_object_ref ref,
+    PVFS_sys_attr attr,
+    const PVFS_credential *credential,
+    PVFS_sys_dist *dist,
+    PVFS_sys_layout *layout,
+    PVFS_sysresp_create_list *resp,
+    PVFS_sys_op_id *op_id,
+    PVFS_hint hints,
+    void *user_ptr);
+
+PVFS_error PVFS_sys_create_list(
+    char **entry_names,
+    int count,
+    PVFS_object_ref ref,
+    PVFS_sys_attr attr,
+    const PVFS_credential *credential,
+    PVFS_sys_dist *dist,
+    PVFS_sysresp_create_list *resp,
+    PVFS_sys_layout *layout,
+    PVFS_hint hints);
+
 PVFS_error PVFS_isys_remove(
     char *entry_name,
     PVFS_object_ref ref,
@@ -511,6 +557,28 @@ PVFS_error PVFS_sys_truncate(
     const PVFS_credential *credential,
     PVFS_hint hints);
 
+PVFS_error PVFS_isys_copy_range(
+    PVFS_object_ref src_ref,
+    PVFS_offset src_offset,
+    PVFS_object_ref dst_ref,
+    PVFS_offset dst_offset,
+    PVFS_size length,
+    const PVFS_credential *credential,
+    PVFS_sysresp_copy_range *resp,
+    PVFS_sys_op_id *op_id,
+    PVFS_hint hints,
+    void *user_ptr);
+
+PVFS_error PVFS_sys_copy_range(
+    PVFS_object_ref src_ref,
+    PVFS_offset src_offset,
+    PVFS_object_ref dst_ref,
+    PVFS_offset dst_offset,
+    PVFS_size length,
+    const PVFS_credential *credential,
+    PVFS_sysresp_copy_range *resp,
+    PVFS_hint hints);
+
 PVFS_error PVFS_sys_getparent(
     PVFS_fs_id fs_id,
     char *entry_name,
@@ -530,6 +598,12 @@ PVFS_error PVFS_sys_flush(
     const PVFS_credential *credential,
     PVFS_hint hints);
 
+PVFS_error PVFS_sys_write_behind_enable(
+    PVFS_object_ref ref);
+
+PVFS_error PVFS_sys_write_behind_release(
+    PVFS_object_ref ref);
+
 PVFS_error PVFS_isys_statfs(
     PVFS_fs_id fs_id,
     const PVFS_credential *credential,
@@ -33,6 +33,7 @@ struct options
     PVFS_size strip_size;
     int num_datafiles;
     int buf_size;
+    int num_io;
     char* srcfile;
     char* destfile;
     int show_timings;
@@ -71,6 +72,43 @@ typedef struct file_object_s {
     } u;
 } file_object;
 
+/* the step a buffer is at; the operation for that step has been started */
+enum io_state {
+    IO_IDLE = 0,
+    IO_READING,
+    IO_WRITING
+};
+
+/* one buffer's worth of the copy, read from the source and then written
+ * to the same offset in the destination */
+typedef struct io_slot_s {
+    int state;
+    int pending;                /* PVFS operation posted, not yet tested */
+    char *buffer;
+    int64_t offset;
+    size_t count;
+    PVFS_sys_op_id op_id;
+    PVFS_Request mem_req;
+    PVFS_sysresp_io resp_io;
+} io_slot;
+
+/* the whole copy: slots are started in file order and finish in any
+ * order, so several reads and writes can be outstanding at once */
+typedef struct copy_state_s {
+    file_object *src;
+    file_object *dest;
+    PVFS_credential *credentials;
+    int buf_size;
+    int64_t next_offset;
+    int64_t total_written;
+    int in_flight;
+    int eof;
+    int error;
+} copy_state;
+
+#define DEFAULT_NUM_IO 4
+#define MAX_NUM_IO 64
+
 static PVFS_hint hints = NULL;
 
 static struct options* parse_args(int argc, char* argv[]);
@@ -80,10 +118,12 @@ static void print_timings( double time, int64_t total);
 static int resolve_filename(file_object *obj, char *filename);
 static int generic_open(file_object *obj, PVFS_credential *credentials,
         int nr_datafiles, PVFS_size strip_size, char *srcname, int open_type);
-static size_t generic_read(file_object *src, char *buffer,
-        int64_t offset, size_t count, PVFS_credential *credentials);
-static size_t generic_write(file_object *dest, char *buffer,
-        int64_t offset, size_t count, PVFS_credential *credentials);
+static int post_generic_io(file_object *obj, io_slot *slot,
+        enum PVFS_io_type type, PVFS_credential *credentials);
+static void advance_slot(copy_state *cs, io_slot *slot);
+static int copy_data(file_object *src, file_object *dest,
+        struct options *user_opts, PVFS_credential *credentials,
+        int64_t *total_written);
 static int generic_cleanup(file_object *src, file_object *dest,
                            PVFS_credential *credentials);
 static void make_attribs(PVFS_sys_attr *attr,
@@ -120,10 +160,8 @@ int main (int argc, char ** argv)
 {
     struct options* user_opts = NULL;
     double time1=0, time2=0;
-    int current_size=0;
-    int64_t total_written=0, buffer_size=0;
+    int64_t total_written=0;
     file_object src, dest;
-    void* buffer = NULL;
     int64_t ret;
     PVFS_credential credentials;
 
@@ -172,35 +210,12 @@ int main (int argc, char ** argv)
     }
 
     /* start moving data */
-    buffer = malloc(user_opts->buf_size);
-    if(!buffer)
-    {
-        perror("malloc");
-        ret = -1;
-        goto main_out;
-    }
-
     time1 = Wtime();
-    while((current_size = generic_read(&src, buffer,
-                    total_written, user_opts->buf_size, &credentials)) > 0)
+    ret = copy_data(&src, &dest, user_opts, &credentials, &total_written);
+    if (ret < 0)
     {
-        buffer_size = current_size;
-
-        ret = generic_write(&dest, buffer, total_written,
-                buffer_size, &credentials);
-        if (ret != current_size)
-        {
-            if (ret == -1) {
-                perror("generic_write");
-            } else {
-                fprintf(stderr, "Error in write\n");
-            }
-            ret = -1;
-            goto main_out;
-        }
-        total_written += current_size;
+        goto main_out;
     }
-
     time2 = Wtime();
 
     if (user_opts->show_timings)
@@ -215,7 +230,6 @@ main_out:
     PVFS_sys_finalize();
     PINT_cleanup_credential(&credentials);
     free(user_opts);
-    free(buffer);
 
     PVFS_hint_free(&hints);
     return(ret);
@@ -229,7 +243,7 @@ main_out:
  */
 static struct options* parse_args(int argc, char* argv[])
 {
-    char flags[] = "tvs:n:b:";
+    char flags[] = "tvs:n:b:p:";
     int one_opt = 0;
 
     struct options* tmp_opts = NULL;
@@ -246,6 +260,7 @@ static struct options* parse_args(int argc, char* argv[])
     tmp_opts->strip_size = -1;
     tmp_opts->num_datafiles = -1;
     tmp_opts->buf_size = 10*1024*1024;
+    tmp_opts->num_io = DEFAULT_NUM_IO;
 
     /* look at command line arguments */
     while((one_opt = getopt(argc, argv, flags)) != EOF)
@@ -273,7 +288,17 @@ static struct options* parse_args(int argc, char* argv[])
                 break;
             case('b'):
                 ret = sscanf(optarg, "%d", &tmp_opts->buf_size);
-                if(ret < 1){
+                if(ret < 1 || tmp_opts->buf_size < 1){
+                    free(tmp_opts);
+                    return(NULL);
+                }
+                break;
+            case('p'):
+                ret = sscanf(optarg, "%d", &tmp_opts->num_io);
+                if(ret < 1 || tmp_opts->num_io < 1 ||
+                   tmp_opts->num_io > MAX_NUM_IO){
+                    fprintf(stderr, "number of I/Os in flight must be "
+                            "between 1 and %d\n", MAX_NUM_IO);
                     free(tmp_opts);
                     return(NULL);
                 }
@@ -305,8 +330,13 @@ static void usage(int argc, char** argv)
         "\n-s <strip_size>\t\t\tsize of access to PVFS2 volume"
         "\n-n <num_datafiles>\t\tnumber of PVFS2 datafiles to use"
         "\n-b <buffer_size in bytes>\thow much data to read/write at once"
+        "\n-p <num_io>\t\t\tnumber of buffers to keep in flight"
         "\n-t\t\t\t\tprint some timing information"
         "\n-v\t\t\t\tprint version number and exit\n");
+    fprintf(stderr, "\nBetween files on the same PVFS2 volume the servers "
+        "copy the data\nthemselves.  That only works if the files have the "
+        "same layout;\notherwise it fails with EOPNOTSUPP and the data is "
+        "copied through\nthis program instead.\n");
     return;
 }
 
@@ -323,71 +353,251 @@ static void print_timings( double time, int64_t total)
             lld(total), time, (total/time)/(1024*1024));
 }
 
-/* read 'count' bytes from a (unix or pvfs2) file 'src', placing the result in
- * 'buffer' */
-static size_t generic_read(file_object *src, char *buffer,
-        int64_t offset, size_t count, PVFS_credential *credentials)
+/* start reading or writing 'slot->count' bytes at 'slot->offset' of a (unix
+ * or pvfs2) file through 'slot->buffer'.  Unix I/O is done right away; the
+ * byte count is left in slot->resp_io either way.  Returns 1 if the
+ * operation has already finished, 0 if a PVFS2 operation was posted and
+ * must be tested for, and < 0 on error.
+ */
+static int post_generic_io(file_object *obj, io_slot *slot,
+        enum PVFS_io_type type, PVFS_credential *credentials)
 {
-    PVFS_Request mem_req, file_req;
-    PVFS_sysresp_io resp_io;
+    ssize_t count;
     int ret;
 
-    if(src->fs_type == UNIX_FILE)
-        return (read(src->u.ufs.fd, buffer, count));
-    else
+    if (obj->fs_type == UNIX_FILE)
     {
-        file_req = PVFS_BYTE;
-        ret = PVFS_Request_contiguous(count, PVFS_BYTE, &mem_req);
+        if (type == PVFS_IO_READ)
+        {
+            count = pread(obj->u.ufs.fd, slot->buffer, slot->count,
+                          slot->offset);
+        }
+        else
+        {
+            count = pwrite(obj->u.ufs.fd, slot->buffer, slot->count,
+                           slot->offset);
+        }
+        if (count < 0)
+        {
+            perror(type == PVFS_IO_READ ? "pread" : "pwrite");
+            return -1;
+        }
+        slot->resp_io.total_completed = count;
+        return 1;
+    }
+
+    ret = PVFS_Request_contiguous(slot->count, PVFS_BYTE, &slot->mem_req);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_Request_contiguous", ret);
+        return ret;
+    }
+    PVFS_util_refresh_credential(credentials);
+    ret = PVFS_isys_io(obj->u.pvfs2.ref, PVFS_BYTE, slot->offset,
+            slot->buffer, slot->mem_req, credentials, &slot->resp_io,
+            type, &slot->op_id, hints, slot);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_isys_io", ret);
+        PVFS_Request_free(&slot->mem_req);
+        return ret;
+    }
+    if (ret == 1 || slot->op_id == -1)
+    {
+        /* ran to completion without having to wait */
+        PVFS_Request_free(&slot->mem_req);
+        return 1;
+    }
+    slot->pending = 1;
+    return 0;
+}
+
+/* called when the operation 'slot' is waiting on has finished (or the
+ * slot is idle); starts the next step, and keeps going for as long as
+ * steps finish immediately.  Errors and end of file are recorded in 'cs'.
+ */
+static void advance_slot(copy_state *cs, io_slot *slot)
+{
+    int ret = 0;
+
+    for (;;)
+    {
+        if (cs->error)
+        {
+            slot->state = IO_IDLE;
+            return;
+        }
+
+        switch (slot->state)
+        {
+            case IO_IDLE:
+                if (cs->eof)
+                {
+                    return;
+                }
+                slot->offset = cs->next_offset;
+                slot->count = cs->buf_size;
+                cs->next_offset += cs->buf_size;
+                slot->state = IO_READING;
+                ret = post_generic_io(cs->src, slot, PVFS_IO_READ,
+                                      cs->credentials);
+                break;
+            case IO_READING:
+                /* a short read means the end of the source; anything
+                 * already posted past it will come back empty */
+                if (slot->resp_io.total_completed < slot->count)
+                {
+                    cs->eof = 1;
+                }
+                if (slot->resp_io.total_completed == 0)
+                {
+                    slot->state = IO_IDLE;
+                    continue;
+                }
+                slot->count = slot->resp_io.total_completed;
+                slot->state = IO_WRITING;
+                ret = post_generic_io(cs->dest, slot, PVFS_IO_WRITE,
+                                      cs->credentials);
+                break;
+            case IO_WRITING:
+                if (slot->resp_io.total_completed != slot->count)
+                {
+                    fprintf(stderr, "Error in write\n");
+                    cs->error = -1;
+                    continue;
+                }
+                cs->total_written += slot->count;
+                slot->state = IO_IDLE;
+                continue;
+        }
+
         if (ret < 0)
         {
-            fprintf(stderr, "Error: PVFS_Request_contiguous failure\n");
-            return (ret);
+            cs->error = ret;
+            continue;
         }
-        PVFS_util_refresh_credential(credentials);
-        ret = PVFS_sys_read(src->u.pvfs2.ref, file_req, offset,
-                buffer, mem_req, credentials, &resp_io, hints);
         if (ret == 0)
         {
-            PVFS_Request_free(&mem_req);
-            return (resp_io.total_completed);
+            /* posted; testsome will hand it back to us */
+            cs->in_flight++;
+            return;
         }
-        else
-            PVFS_perror("PVFS_sys_read", ret);
     }
-    return (ret);
 }
 
-/* write 'count' bytes from 'buffer' into (unix or pvfs2) file 'dest' */
-static size_t generic_write(file_object *dest, char *buffer,
-    int64_t offset, size_t count, PVFS_credential *credentials)
+/* copy all of 'src' to 'dest', keeping up to user_opts->num_io buffers of
+ * user_opts->buf_size bytes in flight.  When both are PVFS2 files with
+ * matching layouts the servers copy the data between themselves instead.
+ * Returns 0 on success.
+ */
+static int copy_data(file_object *src, file_object *dest,
+        struct options *user_opts, PVFS_credential *credentials,
+        int64_t *total_written)
 {
-    PVFS_Request mem_req, file_req;
-    PVFS_sysresp_io resp_io;
+    copy_state cs;
+    io_slot *slots = NULL;
+    PVFS_sys_op_id op_ids[MAX_NUM_IO];
+    void *user_ptrs[MAX_NUM_IO];
+    int error_codes[MAX_NUM_IO];
+    PVFS_sysresp_copy_range resp_copy;
+    int num_io = user_opts->num_io;
+    int op_count;
+    int i;
     int ret;
 
-    if (dest->fs_type == UNIX_FILE)
-        return(write(dest->u.ufs.fd, buffer, count));
-    else
+    if (src->fs_type == PVFS2_FILE && dest->fs_type == PVFS2_FILE &&
+        src->u.pvfs2.fs_id == dest->u.pvfs2.fs_id)
+    {
+        memset(&resp_copy, 0, sizeof(resp_copy));
+        ret = PVFS_sys_copy_range(src->u.pvfs2.ref, 0, dest->u.pvfs2.ref, 0,
+                                  src->u.pvfs2.attr.size, credentials,
+                                  &resp_copy, hints);
+        if (ret == 0)
+        {
+            *total_written = resp_copy.total_copied;
+            return 0;
+        }
+        if (ret != -PVFS_EOPNOTSUPP)
+        {
+            PVFS_perror("PVFS_sys_copy_range", ret);
+            return ret;
+        }
+        /* layouts differ; move the data through here */
+    }
+
+    memset(&cs, 0, sizeof(cs));
+    cs.src = src;
+    cs.dest = dest;
+    cs.credentials = credentials;
+    cs.buf_size = user_opts->buf_size;
+
+    slots = (io_slot *)calloc(num_io, sizeof(io_slot));
+    if (!slots)
     {
-        file_req = PVFS_BYTE;
-        ret = PVFS_Request_contiguous(count, PVFS_BYTE, &mem_req);
+        perror("malloc");
+        return -1;
+    }
+    for (i = 0; i < num_io; i++)
+    {
+        slots[i].buffer = malloc(user_opts->buf_size);
+        if (!slots[i].buffer)
+        {
+            perror("malloc");
+            cs.error = -1;
+            goto out;
+        }
+    }
+
+    for (i = 0; i < num_io; i++)
+    {
+        advance_slot(&cs, &slots[i]);
+    }
+
+    while (cs.in_flight > 0)
+    {
+        op_count = 0;
+        for (i = 0; i < num_io; i++)
+        {
+            if (slots[i].pending)
+            {
+                op_ids[op_count++] = slots[i].op_id;
+            }
+        }
+
+        ret = PVFS_sys_testsome(op_ids, &op_count, user_ptrs,
+                                error_codes, 10);
         if (ret < 0)
         {
-            PVFS_perror("PVFS_Request_contiguous", ret);
-            return(ret);
+            /* the buffers may still be in use, so we can't free them */
+            PVFS_perror("PVFS_sys_testsome", ret);
+            return ret;
         }
-        PVFS_util_refresh_credential(credentials);
-        ret = PVFS_sys_write(dest->u.pvfs2.ref, file_req, offset,
-                buffer, mem_req, credentials, &resp_io, hints);
-        if (ret == 0)
+
+        for (i = 0; i < op_count; i++)
         {
-            PVFS_Request_free(&mem_req);
-            return(resp_io.total_completed);
+            io_slot *slot = (io_slot *)user_ptrs[i];
+
+            slot->pending = 0;
+            cs.in_flight--;
+            PVFS_Request_free(&slot->mem_req);
+            if (error_codes[i] != 0)
+            {
+                PVFS_perror("PVFS_isys_io", error_codes[i]);
+                cs.error = error_codes[i];
+            }
+            advance_slot(&cs, slot);
         }
-        else
-            PVFS_perror("PVFS_sys_write", ret);
     }
-    return ret;
+
+out:
+    for (i = 0; i < num_io; i++)
+    {
+        free(slots[i].buffer);
+    }
+    free(slots);
+
+    *total_written = cs.total_written;
+    return cs.error;
 }
 
 /* resolve_filename:
@@ -29,6 +29,7 @@
 struct options
 {
     int random;
+    int batch;
     char* server_list;
     uint32_t num_files;
     char **filenames;
@@ -36,11 +37,14 @@ struct options
 
 static struct options *parse_args(int argc, char **argv);
 static void usage(int argc, char **argv);
+static int split_path(char *working_file, PVFS_fs_id *fs_id,
+                      char *directory, char *filename);
 
 int main(int argc, char **argv)
 {
-    int ret = -1, i = 0;
+    int ret = -1, i = 0, j = 0;
     struct options *user_opts = NULL;
+    char **batch_names = NULL;
     char* tmp_server;
     int tmp_server_index;
     PVFS_sys_layout layout;
@@ -65,11 +69,20 @@ int main(int argc, char **argv)
 	return -1;
     }
 
-    /* Remove each specified file */
+    if (user_opts->batch)
+    {
+        batch_names = malloc(user_opts->num_files * sizeof(char *));
+        if (!batch_names)
+        {
+            perror("malloc");
+            return -1;
+        }
+    }
+
+    /* Create each specified file */
     for (i = 0; i < user_opts->num_files; ++i)
     {
         int rc;
-        int num_segs;
         char *working_file = user_opts->filenames[i];
         char directory[PVFS_NAME_MAX] = {0};
         char filename[PVFS_SEGMENT_MAX] = {0};
@@ -82,34 +95,18 @@ int main(int argc, char **argv)
         }
         layout.server_list.servers = NULL;
 
-        char pvfs_path[PVFS_NAME_MAX] = {0};
         PVFS_fs_id cur_fs;
         PVFS_sysresp_lookup resp_lookup;
         PVFS_sysresp_create resp_create;
+        PVFS_sysresp_create_list resp_list;
         PVFS_credential credentials;
         PVFS_object_ref parent_ref;
         PVFS_sys_attr attr;
 
 
-        /* Translate the working file into a pvfs2 relative path*/
-        rc = PVFS_util_resolve(working_file, &cur_fs, pvfs_path, PVFS_NAME_MAX);
-        if (rc)
-        {
-            PVFS_perror("PVFS_util_resolve", rc);
-            ret = -1;
-            break;
-        }
-
-        /* Get the parent directory of the working file */
-        rc = PINT_get_base_dir(pvfs_path, directory, PVFS_NAME_MAX);
-
-        /* Determine the filename from the working */
-        num_segs = PINT_string_count_segments(working_file);
-        rc = PINT_get_path_element(working_file, num_segs - 1,
-                                   filename, PVFS_SEGMENT_MAX);
+        rc = split_path(working_file, &cur_fs, directory, filename);
         if (rc)
         {
-            fprintf(stderr, "Unknown path format: %s\n", working_file);
             ret = -1;
             break;
         }
@@ -203,6 +200,73 @@ int main(int argc, char **argv)
             }
         }
 
+        if (user_opts->batch)
+        {
+            /* create this file and the ones after it that go in the same
+             * directory with one call
+             */
+            PVFS_fs_id next_fs;
+            char next_directory[PVFS_NAME_MAX] = {0};
+            char next_filename[PVFS_SEGMENT_MAX] = {0};
+            int count = 0;
+
+            batch_names[count++] = strdup(filename);
+            for (j = i + 1; j < user_opts->num_files; j++)
+            {
+                if (split_path(user_opts->filenames[j], &next_fs,
+                               next_directory, next_filename) ||
+                    next_fs != cur_fs || strcmp(next_directory, directory))
+                {
+                    break;
+                }
+                batch_names[count++] = strdup(next_filename);
+            }
+
+            memset(&resp_list, 0, sizeof(resp_list));
+            rc = PVFS_sys_create_list(batch_names,
+                                      count,
+                                      parent_ref,
+                                      attr,
+                                      &credentials,
+                                      NULL,
+                                      &resp_list,
+                                      &layout,
+                                      NULL);
+            if (rc)
+            {
+                fprintf(stderr, "Error: An error occurred while creating "
+                        "files in %s\n", directory);
+                PVFS_perror("PVFS_sys_create_list", rc);
+                ret = -1;
+            }
+            else
+            {
+                for (j = 0; j < count; j++)
+                {
+                    if (resp_list.error_array[j])
+                    {
+                        fprintf(stderr, "Error: An error occurred while "
+                                "creating %s\n", user_opts->filenames[i + j]);
+                        PVFS_perror("PVFS_sys_create_list",
+                                    resp_list.error_array[j]);
+                        ret = -1;
+                    }
+                }
+                free(resp_list.ref_array);
+                free(resp_list.error_array);
+            }
+            for (j = 0; j < count; j++)
+            {
+                free(batch_names[j]);
+            }
+            if (ret == -1)
+            {
+                break;
+            }
+            i += count - 1;
+            continue;
+        }
+
         rc = PVFS_sys_create(filename,
                              parent_ref,
                              attr,
@@ -223,6 +287,7 @@ int main(int argc, char **argv)
 
     PVFS_sys_finalize();
 
+    free(batch_names);
     if(user_opts->server_list)
     {
         free(layout.server_list.servers);
@@ -242,7 +307,7 @@ int main(int argc, char **argv)
 static struct options* parse_args(int argc, char **argv)
 {
     int one_opt = 0;
-    char flags[] = "l:r?";
+    char flags[] = "bl:r?";
     struct options *tmp_opts = NULL;
 
     tmp_opts = (struct options *)malloc(sizeof(struct options));
@@ -274,6 +339,9 @@ static struct options* parse_args(int argc, char **argv)
             case('r'):
                 tmp_opts->random = 1;
                 break;
+            case('b'):
+                tmp_opts->batch = 1;
+                break;
 	}
     }
 
@@ -310,6 +378,44 @@ static void usage(int argc, char **argv)
     fprintf(stderr, "   optional arguments:\n");
     fprintf(stderr, "   -l   use list layout (requires comma separated list of servers)\n");
     fprintf(stderr, "   -r   use random layout\n");
+    fprintf(stderr, "   -b   create files in the same directory with one request\n");
+}
+
+/* split_path()
+ *
+ * finds the file system, parent directory and last path element of a
+ * file named on the command line
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int split_path(char *working_file, PVFS_fs_id *fs_id,
+                      char *directory, char *filename)
+{
+    int rc;
+    int num_segs;
+    char pvfs_path[PVFS_NAME_MAX] = {0};
+
+    /* Translate the working file into a pvfs2 relative path*/
+    rc = PVFS_util_resolve(working_file, fs_id, pvfs_path, PVFS_NAME_MAX);
+    if (rc)
+    {
+        PVFS_perror("PVFS_util_resolve", rc);
+        return -1;
+    }
+
+    /* Get the parent directory of the working file */
+    rc = PINT_get_base_dir(pvfs_path, directory, PVFS_NAME_MAX);
+
+    /* Determine the filename from the working */
+    num_segs = PINT_string_count_segments(working_file);
+    rc = PINT_get_path_element(working_file, num_segs - 1,
+                               filename, PVFS_SEGMENT_MAX);
+    if (rc)
+    {
+        fprintf(stderr, "Unknown path format: %s\n", working_file);
+        return -1;
+    }
+    return 0;
 }
 
 /*
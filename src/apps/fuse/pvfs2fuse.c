@@ -28,6 +28,7 @@ char *pvfs2fuse_version = "0.01";
 #include <stdio.h>
 #include <utime.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "pvfs2-compat.h"
 #include "pint-dev-shared.h"
@@ -36,6 +37,7 @@ char *pvfs2fuse_version = "0.01";
 #include "pvfs2-util.h"
 #include "pint-security.h"
 #include "security-util.h"
+#include "gen-locks.h"
 
 typedef struct {
 	  PVFS_object_ref	ref;
@@ -45,12 +47,39 @@ typedef struct {
 struct pvfs2fuse {
 	  char	*fs_spec;
 	  char	*mntpoint;
+	  char	*cache;
 	  PVFS_fs_id	fs_id;
 	  struct PVFS_sys_mntent mntent;
 };
 
 static struct pvfs2fuse pvfs2fuse;
 
+/* how much pvfs2fuse lets the kernel cache, from -o cache=MODE */
+enum {
+   PVFS2FUSE_CACHE_NONE,	/* nothing; every request reaches the servers */
+   PVFS2FUSE_CACHE_ATTR,	/* attributes and names, for the acache and
+						   ncache timeouts */
+   PVFS2FUSE_CACHE_PAGE,	/* also file data, revalidated on open */
+};
+
+/* Credentials are generated by running pvfs2-gencred, so keep the
+ * ones we have made and reuse them until they are close to expiring
+ * rather than forking for every request.
+ */
+#define CRED_CACHE_SIZE 32
+#define CRED_CACHE_MARGIN_SECS 60
+
+static struct {
+   uid_t	uid;
+   gid_t	gid;
+   int		valid;
+   PVFS_credential cred;
+} cred_cache[CRED_CACHE_SIZE];
+static gen_mutex_t cred_cache_mutex = GEN_MUTEX_INITIALIZER;
+/* PVFS_util_gen_credential swaps the SIGCHLD handler around its fork,
+ * so only one thread may run it at a time */
+static gen_mutex_t cred_gen_mutex = GEN_MUTEX_INITIALIZER;
+
 #if __LP64__
 #define SET_FUSE_HANDLE( fi, pfh ) \
 	fi->fh = (uint64_t)pfh
@@ -75,6 +104,68 @@ static struct pvfs2fuse pvfs2fuse;
 
 #define pvfs_fuse_cleanup_credential(cred) PINT_cleanup_credential(cred)
 
+static int cred_cache_lookup(uid_t uid, gid_t gid,
+                             PVFS_credential *credential)
+{
+   int i;
+   int ret = -1;
+   time_t now = time(NULL);
+
+   gen_mutex_lock(&cred_cache_mutex);
+   for (i = 0; i < CRED_CACHE_SIZE; i++)
+   {
+      if (cred_cache[i].valid && cred_cache[i].uid == uid &&
+          cred_cache[i].gid == gid)
+      {
+         if (cred_cache[i].cred.timeout > now + CRED_CACHE_MARGIN_SECS)
+         {
+            ret = PINT_copy_credential(&cred_cache[i].cred, credential);
+         }
+         break;
+      }
+   }
+   gen_mutex_unlock(&cred_cache_mutex);
+
+   return ret;
+}
+
+static void cred_cache_insert(uid_t uid, gid_t gid,
+                              const PVFS_credential *credential)
+{
+   int i;
+   int slot = 0;
+
+   gen_mutex_lock(&cred_cache_mutex);
+   /* replace the entry for this user if any, else the one closest to
+	* expiring */
+   for (i = 0; i < CRED_CACHE_SIZE; i++)
+   {
+      if (!cred_cache[i].valid ||
+          (cred_cache[i].uid == uid && cred_cache[i].gid == gid))
+      {
+         slot = i;
+         break;
+      }
+      if (cred_cache[i].cred.timeout < cred_cache[slot].cred.timeout)
+      {
+         slot = i;
+      }
+   }
+
+   if (cred_cache[slot].valid)
+   {
+      pvfs_fuse_cleanup_credential(&cred_cache[slot].cred);
+      cred_cache[slot].valid = 0;
+   }
+   if (PINT_copy_credential(credential, &cred_cache[slot].cred) == 0)
+   {
+      cred_cache[slot].uid = uid;
+      cred_cache[slot].gid = gid;
+      cred_cache[slot].valid = 1;
+   }
+   gen_mutex_unlock(&cred_cache_mutex);
+}
+
 static int pvfs_fuse_gen_credential(
    PVFS_credential *credential)
 {
@@ -83,6 +174,11 @@ static int pvfs_fuse_gen_credential(
    char uid[16], gid[16];
    int ret;
 
+   if (cred_cache_lookup(ctx->uid, ctx->gid, credential) == 0)
+   {
+      return 0;
+   }
+
    /* convert uid/gid to strings */
    ret = snprintf(uid, sizeof(uid), "%u", ctx->uid);
    if (ret < 0 || ret >= sizeof(uid))
@@ -105,16 +201,19 @@ static int pvfs_fuse_gen_credential(
    memset(new_cred, 0, sizeof(PVFS_credential));
 
    /* generate credential -- this process must be running as root */
+   gen_mutex_lock(&cred_gen_mutex);
    ret = PVFS_util_gen_credential(uid, 
                                   gid, 
                                   PVFS2_DEFAULT_CREDENTIAL_TIMEOUT, 
                                   NULL, NULL,
                                   new_cred);
+   gen_mutex_unlock(&cred_gen_mutex);
 
    if (ret == 0)
    {
        /* copy credential to provided buffer */
        ret = PINT_copy_credential(new_cred, credential);      
+       cred_cache_insert(ctx->uid, ctx->gid, new_cred);
    }
 
    /* free generated credential */
@@ -1103,6 +1202,7 @@ enum {
 
 static struct fuse_opt pvfs2fuse_opts[] = {
    PVFS2FUSE_OPT("fs_spec=%s",     fs_spec, 0),
+   PVFS2FUSE_OPT("cache=%s",       cache, 0),
 
    FUSE_OPT_KEY("-V",             KEY_VERSION),
    FUSE_OPT_KEY("--version",      KEY_VERSION),
@@ -1123,6 +1223,12 @@ static void usage(const char *progname)
 		   "\n"
 		   "PVFS2FUSE options:\n"
 		   "    -o fs_spec=FS_SPEC     PVFS2 fs_spec URI (eg. tcp://localhost:3334/pvfs2-fs)\n"
+		   "    -o cache=MODE          what the kernel may cache (default: attr)\n"
+		   "                             none: nothing, every request goes to the servers\n"
+		   "                             attr: attributes and names, for the PVFS2\n"
+		   "                                   attribute and name cache timeouts\n"
+		   "                             page: attr, plus file data, revalidated on open\n"
+		   "    -s                     single threaded operation\n"
 		   "\n", progname);
 }
 
@@ -1181,6 +1287,7 @@ static int pvfs2fuse_opt_proc(void *data, const char *arg, int key,
 int main(int argc, char *argv[])
 {
    int ret;
+   int cache_mode = PVFS2FUSE_CACHE_ATTR;
    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
 
    umask(0);
@@ -1189,6 +1296,21 @@ int main(int argc, char *argv[])
 					  pvfs2fuse_opt_proc) == -1 )
 	  exit(1);
 
+   if (pvfs2fuse.cache != NULL)
+   {
+	  if (strcmp(pvfs2fuse.cache, "none") == 0)
+		 cache_mode = PVFS2FUSE_CACHE_NONE;
+	  else if (strcmp(pvfs2fuse.cache, "attr") == 0)
+		 cache_mode = PVFS2FUSE_CACHE_ATTR;
+	  else if (strcmp(pvfs2fuse.cache, "page") == 0)
+		 cache_mode = PVFS2FUSE_CACHE_PAGE;
+	  else
+	  {
+		 fprintf(stderr, "Error: invalid cache mode: %s\n", pvfs2fuse.cache);
+		 exit(1);
+	  }
+   }
+
    if (pvfs2fuse.fs_spec == NULL)
    {
 	  ret = PVFS_util_init_defaults();
@@ -1206,9 +1328,6 @@ int main(int argc, char *argv[])
 	  }
 
 	  PVFS_util_get_mntent_copy( pvfs2fuse.fs_id, &pvfs2fuse.mntent );
-	  /* Set timeouts for PVFS2's name cache and attribute cache */
-	  PVFS_sys_set_info(PVFS_SYS_ACACHE_TIMEOUT_MSECS, 0);
-	  PVFS_sys_set_info(PVFS_SYS_NCACHE_TIMEOUT_MSECS, 0);
    }
    else
    {
@@ -1323,16 +1442,59 @@ int main(int argc, char *argv[])
 
    /* FIXME should we allow all the FUSE options?  Maybe we should
 	* pass only some of the FUSE options to fuse_main.  For now,
-	* force the direct_io and allow_other options.  Also turn off
-	* multithreaded operation since it doesnt work with PVFS.
+	* force the caching and allow_other options.  We link against the
+	* threaded system interface, so FUSE may run multithreaded unless
+	* the user asks for -s.
 	*/
 
-   fuse_opt_insert_arg( &args, 1, "-odirect_io" );
-   fuse_opt_insert_arg( &args, 1, "-oattr_timeout=0");
+   if (cache_mode == PVFS2FUSE_CACHE_NONE)
+   {
+	  /* the kernel caches nothing, so neither should we */
+	  PVFS_sys_set_info(PVFS_SYS_ACACHE_TIMEOUT_MSECS, 0);
+	  PVFS_sys_set_info(PVFS_SYS_NCACHE_TIMEOUT_MSECS, 0);
+	  fuse_opt_insert_arg( &args, 1, "-oattr_timeout=0" );
+	  fuse_opt_insert_arg( &args, 1, "-oentry_timeout=0" );
+   }
+   else
+   {
+	  /* let the kernel keep attributes and names exactly as long as
+	   * the client library's own caches would
+	   */
+	  unsigned int acache_msecs = 0;
+	  unsigned int ncache_msecs = 0;
+	  char opt[64];
+
+	  PVFS_sys_get_info(PVFS_SYS_ACACHE_TIMEOUT_MSECS, &acache_msecs);
+	  PVFS_sys_get_info(PVFS_SYS_NCACHE_TIMEOUT_MSECS, &ncache_msecs);
+
+	  snprintf( opt, sizeof(opt), "-oattr_timeout=%u.%03u",
+				acache_msecs / 1000, acache_msecs % 1000 );
+	  fuse_opt_insert_arg( &args, 1, opt );
+	  snprintf( opt, sizeof(opt), "-oentry_timeout=%u.%03u",
+				ncache_msecs / 1000, ncache_msecs % 1000 );
+	  fuse_opt_insert_arg( &args, 1, opt );
+   }
+   fuse_opt_insert_arg( &args, 1, "-onegative_timeout=0" );
+
+   if (cache_mode == PVFS2FUSE_CACHE_PAGE)
+   {
+	  /* keep file data in the page cache; auto_cache drops it when
+	   * the size or mtime seen at open has changed
+	   */
+	  fuse_opt_insert_arg( &args, 1, "-oauto_cache" );
+   }
+   else
+   {
+	  fuse_opt_insert_arg( &args, 1, "-odirect_io" );
+   }
+
    fuse_opt_insert_arg( &args, 1, "-omax_write=524288");
+#if FUSE_VERSION >= 28
+   /* without big_writes the kernel splits writes into single pages */
+   fuse_opt_insert_arg( &args, 1, "-obig_writes" );
+#endif
    if ( getuid() == 0 )
 	  fuse_opt_insert_arg( &args, 1, "-oallow_other" );
-   fuse_opt_insert_arg( &args, 1, "-s" );
     
    {
 	  /* set the fsname and volname */
@@ -60,12 +60,24 @@
 /* only relevant if USE_RA_CACHE is on */
 
 /*
-  an arbitrary limit to the max number of operations we'll support in
-  flight at once, and the max number of items we can write into the
-  device file as a response
+  op slots: each vfs_request posted as an unexpected device job can
+  receive one upcall, so the number of slots bounds the operations in
+  flight at once.  We start with min-ops slots and post more, up to
+  max-ops, whenever fewer than OP_SLOT_SPARE of them are left waiting
+  on the device.  Slots beyond min-ops are released again when they
+  complete while at least min-ops others are still waiting.
 */
-#define MAX_NUM_OPS                 64
-#define MAX_LIST_SIZE      MAX_NUM_OPS
+#define DEFAULT_MIN_NUM_OPS         64
+#define DEFAULT_MAX_NUM_OPS       1024
+#define MAX_NUM_OPS_LIMIT        16384
+#define OP_SLOT_SPARE                8
+
+/* the most completions PVFS_sys_testany can return at once */
+#define MAX_OPS_PER_TEST           256
+
+/* the max number of items we can write into the device file as a
+ * response */
+#define MAX_LIST_SIZE               64
 #define IOX_HINDEXED_COUNT          64
 
 #define REMOUNT_PENDING     0xFFEEFF33
@@ -142,6 +154,9 @@ typedef struct
     int readahead_count;
     int readahead_readcnt;
     int readahead_pinned;
+    unsigned int min_ops;
+    unsigned int max_ops;
+    int max_ops_set;
 } options_t;
 
 /*
@@ -207,6 +222,8 @@ typedef struct
 
     struct qlist_head hash_link;
 
+    int slot;   /* index in s_vfs_request_array, -1 if not an op slot */
+
 #ifdef CLIENT_CORE_OP_TIMING
     PINT_time_marker start;
     PINT_time_marker end;
@@ -257,8 +274,11 @@ static struct PINT_dev_params s_desc_params[NUM_MAP_DESC];
 
 /* static char hostname[100]; */
 
-/* used only for deleting all allocated vfs_request objects */
-vfs_request_t *s_vfs_request_array[MAX_NUM_OPS] = {NULL};
+/* all allocated op slots; s_num_idle_ops of them are posted to the
+ * device waiting for an upcall */
+vfs_request_t **s_vfs_request_array = NULL;
+static int s_num_ops = 0;
+static int s_num_idle_ops = 0;
 
 static struct PINT_tcache *credential_cache = NULL;
 
@@ -322,6 +342,9 @@ static int write_device_response(
 static PVFS_error write_downcall(vfs_request_t *vfs_request);
 
 static PVFS_error repost_unexp_vfs_request(vfs_request_t *v, char *s);
+static PVFS_error post_op_slot(void);
+static void release_op_slot(vfs_request_t *vfs_request);
+static void grow_op_slots(void);
 
 #define write_inlined_device_response(vfs_request)                           \
 do {                                                                         \
@@ -446,9 +469,11 @@ static int initialize_ops_in_progress_table(void)
 {
     if (!s_ops_in_progress_table)
     {
+        /* sized for the most ops we may have in flight */
         s_ops_in_progress_table = qhash_init(
             hash_key_compare, hash_key,
-            DEFAULT_OPS_IN_PROGRESS_HTABLE_SIZE);
+            (s_opts.max_ops > DEFAULT_OPS_IN_PROGRESS_HTABLE_SIZE ?
+             (int)s_opts.max_ops | 1 : DEFAULT_OPS_IN_PROGRESS_HTABLE_SIZE));
     }
     return (s_ops_in_progress_table ? 0 : -PVFS_ENOMEM);
 }
@@ -1750,6 +1775,24 @@ static PVFS_error service_perf_count_request(vfs_request_t *vfs_request)
                 vfs_request->out_downcall.status = 0;
             }
             break;
+
+#ifdef USE_RA_CACHE
+        case PVFS2_PERF_COUNT_REQUEST_RACACHE:
+            tmp_str = PINT_perf_generate_text(pint_racache_get_pc(),
+                PERF_COUNT_BUF_SIZE);
+            if(!tmp_str)
+            {
+                vfs_request->out_downcall.status = -PVFS_EINVAL;
+            }
+            else
+            {
+                strncpy(vfs_request->out_downcall.resp.perf_count.buffer,
+                    tmp_str, PERF_COUNT_BUF_SIZE);
+                free(tmp_str);
+                vfs_request->out_downcall.status = 0;
+            }
+            break;
+#endif
            
         default:
             /* unsupported request, didn't match anything in case statement */
@@ -2063,6 +2106,14 @@ static PVFS_error service_param_request(vfs_request_t *vfs_request)
                 ret = PINT_perf_set_info(PINT_client_capcache_get_pc(),
                                          PINT_PERF_UPDATE_HISTORY,
                                          tmp_perf_val);
+#ifdef USE_RA_CACHE
+                if(pint_racache_get_pc())
+                {
+                    ret = PINT_perf_set_info(pint_racache_get_pc(),
+                                             PINT_PERF_UPDATE_HISTORY,
+                                             tmp_perf_val);
+                }
+#endif
             }    
             vfs_request->out_downcall.status = ret;
             return(0);
@@ -2074,6 +2125,12 @@ static PVFS_error service_param_request(vfs_request_t *vfs_request)
                 PINT_perf_reset(PINT_acache_get_pc());
                 PINT_perf_reset(PINT_ncache_get_pc());
                 PINT_perf_reset(PINT_client_capcache_get_pc());
+#ifdef USE_RA_CACHE
+                if(pint_racache_get_pc())
+                {
+                    PINT_perf_reset(pint_racache_get_pc());
+                }
+#endif
             }    
             vfs_request->out_downcall.resp.param.u.value64 = 0;
             vfs_request->out_downcall.status = 0;
@@ -2338,11 +2395,11 @@ static PVFS_error post_io_readahead_request(vfs_request_t *vfs_request,
         free(credential);
     }
 
-    /* We do not call check_for_speculative here because we cannot
-     * tell if the current buffer was EOF until it gets back - if we
-     * did then t ends up creating a lot of extra cycles through
-     * the code - so we are leaving it out for now, maybe rework
-     * it in the future
+    /* We do not call check_for_speculative here: phantom requests
+     * are posted through this function too.  post_io_request calls
+     * it for demand reads, and the racache only returns offsets past
+     * a buffer still in flight once the access pattern is established
+     * since until it gets back we cannot tell if it was EOF.
      */
 
     return 0;
@@ -2389,6 +2446,7 @@ static PVFS_error create_phantom_req(vfs_request_t **reqpp,
     rareq->num_incomplete_ops = 1;
     rareq->in_upcall.req.io.count = prev_buff->buff_sz;
     rareq->racache_buff = NULL;
+    rareq->slot = -1; /* freed when done, never reposted */
 
     *reqpp = rareq;
     // if (vfs_request->hints != NULL && rareq->hints == NULL)
@@ -2398,9 +2456,41 @@ static PVFS_error create_phantom_req(vfs_request_t **reqpp,
     return 0;
 }
 
-/* This checks to see if we should do a speculative readahead
- * by seeing if there is already a buffer beyond the current one
- * for this file
+/* Helper function for check_for_speculative: the width of one full
+ * stripe of the file (strip size times datafile count) if its
+ * attributes are cached, otherwise 0
+ */
+static PVFS_size racache_stripe_width(PVFS_object_ref refn)
+{
+    PVFS_object_attr attr;
+    PVFS_size size = 0;
+    PVFS_size width = 0;
+    int attr_status = 0;
+    int size_status = 0;
+    int ret = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    ret = PINT_acache_get_cached_entry(refn, &attr, &attr_status,
+                                       &size, &size_status);
+    if (ret == 0 && attr_status == 0)
+    {
+        if ((attr.mask & PVFS_ATTR_META_DIST) && attr.u.meta.dist &&
+            attr.u.meta.dist->methods->get_blksize)
+        {
+            width = attr.u.meta.dist->methods->get_blksize(
+                        attr.u.meta.dist->params, 1) *
+                    attr.u.meta.dfile_count;
+        }
+        PINT_free_object_attr(&attr);
+    }
+    return width;
+}
+
+/* This checks to see if we should do speculative readaheads for the
+ * buffers the racache expects to be read next - following, preceding
+ * or a stride away from the current one depending on how the file is
+ * being read - and posts a read for each one not already cached, so
+ * that up to a window of reads is kept in flight
  */
 static PVFS_error check_for_speculative(vfs_request_t *vfs_request,
                                       racache_buffer_t *prev_buff)
@@ -2409,6 +2499,8 @@ static PVFS_error check_for_speculative(vfs_request_t *vfs_request,
     racache_buffer_t *rabuff = NULL; /* new buffer we will read */
     vfs_request_t *rareq = NULL; /* phantom request */
     PVFS_object_ref refn;
+    PVFS_size offsets[PVFS2_MAX_RACACHE_READCNT];
+    int count;
     int amt_returned;
     int b;
 
@@ -2426,14 +2518,6 @@ static PVFS_error check_for_speculative(vfs_request_t *vfs_request,
         return 0;
     }
 
-    if (prev_buff->data_sz < prev_buff->buff_sz)
-    {
-        /* we hit eof so don't readahead */
-        gossip_debug(GOSSIP_RACACHE_DEBUG,
-                     "--- check_for_speculative negative:EOF\n");
-        return 0;
-    }
-
     if (prev_buff->readcnt < 1)
     {
         /* read count less than one so don't readahead */
@@ -2447,6 +2531,23 @@ static PVFS_error check_for_speculative(vfs_request_t *vfs_request,
                         &(vfs_request->in_upcall.req.io.refn.khandle));
     refn.fs_id = vfs_request->in_upcall.req.io.refn.fs_id;
 
+    /* size the window to cover at least one stripe */
+    if (pint_racache_stripe_width(refn) == 0)
+    {
+        pint_racache_set_stripe_width(refn, racache_stripe_width(refn));
+    }
+
+    /* the racache stops at EOF and for random access */
+    count = pint_racache_readahead_offsets(prev_buff,
+                                           offsets,
+                                           PVFS2_MAX_RACACHE_READCNT);
+    if (count < 1)
+    {
+        gossip_debug(GOSSIP_RACACHE_DEBUG,
+                     "--- check_for_speculative negative:PATTERN/EOF\n");
+        return 0;
+    }
+
     /* We need a request struct in order to search for
      * a buffer, so we build one here.  
      * If we find a buffer we will free this, * otherwise
@@ -2461,18 +2562,14 @@ static PVFS_error check_for_speculative(vfs_request_t *vfs_request,
         return ret;
     }
 
-    /* The first read was the original buffer
-     * so potentially issue prev_buff->readcnt - 1 more
-     */
     gossip_debug(GOSSIP_RACACHE_DEBUG,
-              "--- check_for_speculative issue %d more reads\n",
-              (int)(prev_buff->readcnt - 1));
-    for(b = 1; b < prev_buff->readcnt; b++)
+              "--- check_for_speculative issue up to %d more reads\n",
+              count);
+    for(b = 0; b < count; b++)
     {
 
         /* select the desired buffer */
-        rareq->in_upcall.req.io.offset = prev_buff->file_offset +
-                                         (b * prev_buff->buff_sz);
+        rareq->in_upcall.req.io.offset = offsets[b];
         /* find a buffer */
         rareq->racache_status = pint_racache_get_block(
                                             refn,
@@ -2713,10 +2810,16 @@ static PVFS_error post_io_request(vfs_request_t *vfs_request)
                 return ret; /* check for errors? */
 
             case RACACHE_WAIT:
-                /* really nothing to do until outstanding read
-                 * finishes */
+                /* nothing to do for this request until the outstanding
+                 * read finishes, but if that was a readahead the
+                 * reader has caught up with it so keep the window
+                 * ahead of it filled */
                 gossip_debug(GOSSIP_RACACHE_DEBUG,
                              "--- Readahead cache wait!\n");
+                if (buff->speculative)
+                {
+                    ret = check_for_speculative(vfs_request, buff);
+                }
                 return 0; /* check for errors? */
 
             case RACACHE_READ:
@@ -2736,9 +2839,14 @@ static PVFS_error post_io_request(vfs_request_t *vfs_request)
                 {
                     gossip_debug(GOSSIP_RACACHE_DEBUG,
                                  "--- readahead io posting succeeded!\n");
+                    /* once the access pattern is established the
+                     * racache hands back offsets while this read is
+                     * still in flight, so the following reads are
+                     * posted alongside it rather than after it */
+                    check_for_speculative(vfs_request, buff);
                     /* if the readahead request succeeds, return. 
                      */
-                    return ret;
+                    return 0;
                 }
                 /*
                  * this falls through to normal posting/servicing
@@ -4195,6 +4303,7 @@ static inline PVFS_error repost_unexp_vfs_request(
     vfs_request_t *vfs_request, char *completion_handle_desc)
 {
     PVFS_error ret = -PVFS_EINVAL;
+    int slot;
 
     assert(vfs_request);
     
@@ -4220,8 +4329,22 @@ static inline PVFS_error repost_unexp_vfs_request(
     PINT_dev_release_unexpected(&vfs_request->info);
     PINT_sys_release(vfs_request->op_id);
     PVFS_hint_free(&vfs_request->hints);
+
+    /* the burst that needed this slot is over */
+    if (s_num_ops > (int)s_opts.min_ops &&
+        s_num_idle_ops >= (int)s_opts.min_ops)
+    {
+        gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "[-] releasing op slot "
+                     "[%p] after %s (%d slots)\n", vfs_request,
+                     completion_handle_desc, s_num_ops - 1);
+        release_op_slot(vfs_request);
+        return 0;
+    }
+
     /* wipe the vfs_request here before we resubmit */
+    slot = vfs_request->slot;
     memset(vfs_request, 0, sizeof(vfs_request_t));
+    vfs_request->slot = slot;
 
     vfs_request->is_dev_unexp = 1;
 
@@ -4233,6 +4356,7 @@ static inline PVFS_error repost_unexp_vfs_request(
     }
     else
     {
+        s_num_idle_ops++;
         gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "[-] reposted unexp "
                      "req [%p] due to %s\n", vfs_request,
                      completion_handle_desc);
@@ -4240,6 +4364,82 @@ static inline PVFS_error repost_unexp_vfs_request(
     return ret;
 }
 
+/* allocate a new op slot and post it to the device */
+static PVFS_error post_op_slot(void)
+{
+    PVFS_error ret = -PVFS_EINVAL;
+    vfs_request_t *vfs_request = NULL;
+
+    if (s_num_ops >= (int)s_opts.max_ops)
+    {
+        return -PVFS_EBUSY;
+    }
+
+    vfs_request = (vfs_request_t *)malloc(sizeof(vfs_request_t));
+    if (!vfs_request)
+    {
+        return -PVFS_ENOMEM;
+    }
+    memset(vfs_request, 0, sizeof(vfs_request_t));
+    vfs_request->is_dev_unexp = 1;
+    vfs_request->slot = s_num_ops;
+
+    ret = PINT_sys_dev_unexp(&vfs_request->info,
+                             &vfs_request->jstat,
+                             &vfs_request->op_id,
+                             vfs_request);
+    if (ret < 0)
+    {
+        PVFS_perror_gossip("PINT_sys_dev_unexp()", ret);
+        free(vfs_request);
+        return ret;
+    }
+    s_vfs_request_array[s_num_ops++] = vfs_request;
+    s_num_idle_ops++;
+    return 0;
+}
+
+/* free an op slot that is not posted or in progress */
+static void release_op_slot(vfs_request_t *vfs_request)
+{
+    int slot = vfs_request->slot;
+
+    assert(slot >= 0 && slot < s_num_ops);
+    assert(s_vfs_request_array[slot] == vfs_request);
+
+    /* keep the array dense by moving the last slot into the hole */
+    s_num_ops--;
+    s_vfs_request_array[slot] = s_vfs_request_array[s_num_ops];
+    s_vfs_request_array[slot]->slot = slot;
+    s_vfs_request_array[s_num_ops] = NULL;
+    free(vfs_request);
+}
+
+/* called when an idle slot picks up an upcall: keep a few slots
+ * waiting on the device so a burst of upcalls is not serialized
+ * behind the operations already in flight
+ */
+static void grow_op_slots(void)
+{
+    int added = 0;
+
+    while (s_num_idle_ops < OP_SLOT_SPARE &&
+           s_num_ops < (int)s_opts.max_ops)
+    {
+        if (post_op_slot() < 0)
+        {
+            break;
+        }
+        added++;
+    }
+    if (added)
+    {
+        gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "added %d op slots "
+                     "(%d total, %d idle)\n", added, s_num_ops,
+                     s_num_idle_ops);
+    }
+}
+
 static inline PVFS_error handle_unexp_vfs_request(vfs_request_t *vfs_request)
 {
     PVFS_error ret = -PVFS_EINVAL;
@@ -4579,9 +4779,9 @@ static PVFS_error process_vfs_requests(void)
     PVFS_error ret = 0; 
     int op_count = 0, i = 0;
     vfs_request_t *vfs_request = NULL;
-    vfs_request_t *vfs_request_array[MAX_NUM_OPS] = {NULL};
-    PVFS_sys_op_id op_id_array[MAX_NUM_OPS];
-    int error_code_array[MAX_NUM_OPS] = {0};
+    vfs_request_t *vfs_request_array[MAX_OPS_PER_TEST] = {NULL};
+    PVFS_sys_op_id op_id_array[MAX_OPS_PER_TEST];
+    int error_code_array[MAX_OPS_PER_TEST] = {0};
 #ifdef USE_RA_CACHE
     struct qlist_head *link = NULL;
     gen_link_t *glink = NULL;
@@ -4594,25 +4794,18 @@ static PVFS_error process_vfs_requests(void)
                  "process_vfs_requests called\n");
 
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Post Initial Unexp Requests\n");
+    s_vfs_request_array = (vfs_request_t **)calloc(s_opts.max_ops,
+                                                   sizeof(vfs_request_t *));
+    if (!s_vfs_request_array)
+    {
+        return -PVFS_ENOMEM;
+    }
     /* allocate and post all of our initial unexpected vfs requests */
-    for(i = 0; i < MAX_NUM_OPS; i++)
+    for(i = 0; i < (int)s_opts.min_ops; i++)
     {
-        vfs_request = (vfs_request_t *)malloc(sizeof(vfs_request_t));
-        assert(vfs_request);
-
-        s_vfs_request_array[i] = vfs_request;
-
-        memset(vfs_request, 0, sizeof(vfs_request_t));
-        vfs_request->is_dev_unexp = 1;
-
-        ret = PINT_sys_dev_unexp(&vfs_request->info,
-                                 &vfs_request->jstat,
-                                 &vfs_request->op_id,
-                                 vfs_request);
-
+        ret = post_op_slot();
         if (ret < 0)
         {
-	    PVFS_perror_gossip("PINT_sys_dev_unexp()", ret);
             return -PVFS_ENOMEM;
         }
     }
@@ -4626,9 +4819,10 @@ static PVFS_error process_vfs_requests(void)
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Start Processing Loop\n");
     while(s_client_is_processing)
     {
-        op_count = MAX_NUM_OPS;
-        memset(error_code_array, 0, (MAX_NUM_OPS * sizeof(int)));
-        memset(vfs_request_array, 0, (MAX_NUM_OPS * sizeof(vfs_request_t *)));
+        op_count = MAX_OPS_PER_TEST;
+        memset(error_code_array, 0, (MAX_OPS_PER_TEST * sizeof(int)));
+        memset(vfs_request_array, 0,
+               (MAX_OPS_PER_TEST * sizeof(vfs_request_t *)));
 
 #if 0
         /* generates too much logging, but useful sometimes */
@@ -4707,6 +4901,8 @@ static PVFS_error process_vfs_requests(void)
                              " returned unexp vfs_request %p, tag: %llu\n",
                              vfs_request,
                              llu(vfs_request->info.tag));
+                s_num_idle_ops--;
+                grow_op_slots();
                 ret = handle_unexp_vfs_request(vfs_request);
                 if (ret != 0)
                 {
@@ -5070,7 +5266,21 @@ int main(int argc, char **argv)
     s_opts.readahead_readcnt = PVFS2_DEFAULT_RACACHE_READCNT;
     s_opts.readahead_pinned = PVFS2_DEFAULT_RACACHE_PINNED;
 #endif
+    s_opts.min_ops = DEFAULT_MIN_NUM_OPS;
+    s_opts.max_ops = DEFAULT_MAX_NUM_OPS;
     parse_args(argc, argv, &s_opts);
+    if (s_opts.max_ops < s_opts.min_ops)
+    {
+        /* an explicit ceiling wins over the default floor */
+        if (s_opts.max_ops_set)
+        {
+            s_opts.min_ops = s_opts.max_ops;
+        }
+        else
+        {
+            s_opts.max_ops = s_opts.min_ops;
+        }
+    }
 
     signal(SIGHUP,  client_core_sig_handler);
     signal(SIGINT,  client_core_sig_handler);
@@ -5280,11 +5490,35 @@ int main(int argc, char **argv)
         return(-PVFS_ENOMEM);
     }
 
+#ifdef USE_RA_CACHE
+    /* the racache is optional - it may have failed to initialize */
+    gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Set Racache Counters\n");
+    if(pint_racache_get_pc())
+    {
+        ret = PINT_perf_set_info(pint_racache_get_pc(),
+                                 PINT_PERF_UPDATE_HISTORY,
+                                 s_opts.perf_history_size);
+        if(ret < 0)
+        {
+            gossip_err("%s: racache PINT_perf_set_info (history_size).\n",
+                       __func__);
+            finalize_perf_items(0);
+            return(ret);
+        }
+    }
+#endif
+
     /* original code made into a function */
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Start Counter Rollover\n");
     ret = client_perf_start_rollover(PINT_acache_get_pc(), NULL);
     ret = client_perf_start_rollover(PINT_ncache_get_pc(), NULL);
     ret = client_perf_start_rollover(PINT_client_capcache_get_pc(), NULL);
+#ifdef USE_RA_CACHE
+    if(pint_racache_get_pc())
+    {
+        ret = client_perf_start_rollover(pint_racache_get_pc(), NULL);
+    }
+#endif
 
     /* set up structure for kernel interaction */
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Init Ops In Progress Table\n");
@@ -5364,12 +5598,15 @@ int main(int argc, char **argv)
 
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Freeing Allocated Resources\n");
     /* free all allocated resources */
-    for(i = 0; i < MAX_NUM_OPS; i++)
+    for(i = 0; i < s_num_ops; i++)
     {
         PINT_dev_release_unexpected(&s_vfs_request_array[i]->info);
         PINT_sys_release(s_vfs_request_array[i]->op_id);
         free(s_vfs_request_array[i]);
     }
+    free(s_vfs_request_array);
+    s_vfs_request_array = NULL;
+    s_num_ops = 0;
 
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG, "Close Job Context\n");
     job_close_context(s_client_dev_context);
@@ -5408,6 +5645,16 @@ int main(int argc, char **argv)
         PVFS_hint_free(&capc_sm_p->hints);
         PINT_smcb_free(capc_smcb);
     }
+#ifdef USE_RA_CACHE
+    if(pint_racache_get_pc() && pint_racache_get_pc()->smcb)
+    {
+        struct PINT_perf_counter *rac_pcnt = pint_racache_get_pc();
+        PINT_smcb *rac_smcb = rac_pcnt->smcb;
+        PINT_client_sm *rac_sm_p = PINT_sm_frame(rac_smcb, PINT_FRAME_CURRENT);
+        PVFS_hint_free(&rac_sm_p->hints);
+        PINT_smcb_free(rac_smcb);
+    }
+#endif
 
     gossip_debug(GOSSIP_CLIENTCORE_DEBUG,
                  "calling PVFS_sys_finalize()\n");
@@ -5474,6 +5721,8 @@ static void print_help(char *progname)
     printf("--create-request-id           create a id which is transfered to the server\n");
     printf("--desc-count=VALUE            overrides the default # of kernel buffer descriptors\n");
     printf("--desc-size=VALUE             overrides the default size of each kernel buffer descriptor\n");
+    printf("--min-ops=VALUE               operations kept posted to the device (default %d)\n", DEFAULT_MIN_NUM_OPS);
+    printf("--max-ops=VALUE               most operations allowed in flight (default %d)\n", DEFAULT_MAX_NUM_OPS);
     printf("--events=EVENT_LIST           specify the events to enable\n");
 }
 
@@ -5511,6 +5760,8 @@ static void parse_args(int argc, char **argv, options_t *opts)
         {"capcache-soft-limit",1,0,0},
         {"desc-count",1,0,0},
         {"desc-size",1,0,0},
+        {"min-ops",1,0,0},
+        {"max-ops",1,0,0},
         {"logfile",1,0,0},
         {"logtype",1,0,0},
         {"logstamp",1,0,0},
@@ -5574,6 +5825,29 @@ static void parse_args(int argc, char **argv, options_t *opts)
                     }
                     opts->dev_buffer_size_set = 1;
                 }
+                else if (strcmp("min-ops", cur_option) == 0)
+                {
+                    ret = sscanf(optarg, "%u", &opts->min_ops);
+                    if(ret != 1 || opts->min_ops < 1 ||
+                       opts->min_ops > MAX_NUM_OPS_LIMIT)
+                    {
+                        gossip_err(
+                            "Error: invalid min-ops value.\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                else if (strcmp("max-ops", cur_option) == 0)
+                {
+                    ret = sscanf(optarg, "%u", &opts->max_ops);
+                    if(ret != 1 || opts->max_ops < 1 ||
+                       opts->max_ops > MAX_NUM_OPS_LIMIT)
+                    {
+                        gossip_err(
+                            "Error: invalid max-ops value.\n");
+                        exit(EXIT_FAILURE);
+                    }
+                    opts->max_ops_set = 1;
+                }
                 else if (strcmp("logfile", cur_option) == 0)
                 {
                     goto do_logfile;
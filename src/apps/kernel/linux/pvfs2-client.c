@@ -69,6 +69,8 @@ typedef struct
     char *logstamp;
     char *dev_buffer_count;
     char *dev_buffer_size;
+    char *min_ops;
+    char *max_ops;
     char *logtype;
     char *events;
     char *keypath;
@@ -511,6 +513,18 @@ static int monitor_pvfs2_client(options_t *opts)
                 arg_list[arg_index+1] = opts->dev_buffer_size;
                 arg_index+=2;
             }
+            if(opts->min_ops)
+            {
+                arg_list[arg_index] = "--min-ops";
+                arg_list[arg_index+1] = opts->min_ops;
+                arg_index+=2;
+            }
+            if(opts->max_ops)
+            {
+                arg_list[arg_index] = "--max-ops";
+                arg_list[arg_index+1] = opts->max_ops;
+                arg_index+=2;
+            }
             if(opts->events)
             {
                 arg_list[arg_index] = "--events";
@@ -588,6 +602,8 @@ static void print_help(char *progname)
            "PATH\n");
     printf("--desc-count=VALUE            overrides the default # of kernel buffer descriptors\n");
     printf("--desc-size=VALUE             overrides the default size of each kernel buffer descriptor\n");
+    printf("--min-ops=VALUE               operations the client core keeps posted to the device\n");
+    printf("--max-ops=VALUE               most operations the client core allows in flight\n");
     printf("--logstamp=none|usec|datetime override default log message time stamp format\n");
     printf("--logtype=file|syslog         specify writing logs to file or syslog\n");
     printf("--events=EVENTS               enable tracing of certain EVENTS\n");
@@ -624,6 +640,8 @@ static void parse_args(int argc, char **argv, options_t *opts)
         {"capcache-reclaim-percentage",1,0,0},
         {"desc-count",1,0,0},
         {"desc-size",1,0,0},
+        {"min-ops",1,0,0},
+        {"max-ops",1,0,0},
         {"perf-time-interval-secs",1,0,0},
         {"perf-history-size",1,0,0},
 #ifdef USE_RA_CACHE
@@ -754,6 +772,14 @@ static void parse_args(int argc, char **argv, options_t *opts)
                 {
                     opts->dev_buffer_size = optarg;
                 }
+                else if (strcmp("min-ops", cur_option) == 0)
+                {
+                    opts->min_ops = optarg;
+                }
+                else if (strcmp("max-ops", cur_option) == 0)
+                {
+                    opts->max_ops = optarg;
+                }
                 else if (strcmp("perf-time-interval-secs", cur_option) == 0)
                 {
                     opts->perf_time_interval_secs = optarg;
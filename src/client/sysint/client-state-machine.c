@@ -25,6 +25,7 @@
 #include "id-generator.h"
 #include "ncache.h"
 #include "acache.h"
+#include "wbcache.h"
 #include "pint-event.h"
 #include "pint-hint.h"
 #include "security-util.h"
@@ -364,7 +365,9 @@ struct PINT_client_op_entry_s PINT_client_sm_sys_table[] =
     {&pvfs2_client_statfs_sm},
     {&pvfs2_fs_add_sm},
     {&pvfs2_client_readdirplus_sm},
-    {&pvfs2_client_atomic_eattr_sm}
+    {&pvfs2_client_atomic_eattr_sm},
+    {&pvfs2_client_create_list_sm},
+    {&pvfs2_client_copy_range_sm}
 };
 
 struct PINT_client_op_entry_s PINT_client_sm_mgmt_table[] =
@@ -1204,6 +1207,8 @@ const char *PINT_client_get_name_str(int op_type)
     {
         { PVFS_SYS_REMOVE, "PVFS_SYS_REMOVE" },
         { PVFS_SYS_CREATE, "PVFS_SYS_CREATE" },
+        { PVFS_SYS_CREATE_LIST, "PVFS_SYS_CREATE_LIST" },
+        { PVFS_SYS_COPY_RANGE, "PVFS_SYS_COPY_RANGE" },
         { PVFS_SYS_MKDIR, "PVFS_SYS_MKDIR" },
         { PVFS_SYS_SYMLINK, "PVFS_SYS_SYMLINK" },
         { PVFS_SYS_READDIR, "PVFS_SYS_READDIR" },
@@ -1325,6 +1330,12 @@ PVFS_error PVFS_sys_set_info(
         case PVFS_SYS_ACACHE_TIMEOUT_MSECS:
             ret = PINT_acache_set_info(ACACHE_TIMEOUT_MSECS, arg);
             break;
+        case PVFS_SYS_WB_MEM_LIMIT_BYTES:
+            ret = PINT_wbcache_set_info(WBCACHE_MEM_LIMIT, arg);
+            break;
+        case PVFS_SYS_WB_BUFFER_SIZE:
+            ret = PINT_wbcache_set_info(WBCACHE_BUFFER_SIZE, arg);
+            break;
         case PVFS_SYS_MSG_TIMEOUT_SECS:
         case PVFS_SYS_MSG_RETRY_LIMIT:
         case PVFS_SYS_MSG_RETRY_DELAY_MSECS:
@@ -1364,6 +1375,12 @@ PVFS_error PVFS_sys_get_info(
         case PVFS_SYS_ACACHE_TIMEOUT_MSECS:
             ret = PINT_acache_get_info(ACACHE_TIMEOUT_MSECS, arg);
             break;
+        case PVFS_SYS_WB_MEM_LIMIT_BYTES:
+            ret = PINT_wbcache_get_info(WBCACHE_MEM_LIMIT, arg);
+            break;
+        case PVFS_SYS_WB_BUFFER_SIZE:
+            ret = PINT_wbcache_get_info(WBCACHE_BUFFER_SIZE, arg);
+            break;
         case PVFS_SYS_MSG_TIMEOUT_SECS:
         case PVFS_SYS_MSG_RETRY_LIMIT:
         case PVFS_SYS_MSG_RETRY_DELAY_MSECS:
@@ -61,6 +61,19 @@ int PINT_client_state_machine_initialize(void);
 void PINT_client_state_machine_finalize(void);
 job_context_id PINT_client_get_sm_context(void);
 
+/* PVFS_isys_io without the write-behind layer, defined in sys-io.sm */
+PVFS_error PINT_client_io_post(PVFS_object_ref ref,
+                               PVFS_Request file_req,
+                               PVFS_offset file_req_offset,
+                               void *buffer,
+                               PVFS_Request mem_req,
+                               const PVFS_credential *credential,
+                               PVFS_sysresp_io *resp_p,
+                               enum PVFS_io_type io_type,
+                               PVFS_sys_op_id *op_id,
+                               PVFS_hint hints,
+                               void *user_ptr);
+
 /* this structure is used to handle mirrored retries in the small-io case*/
 typedef struct PINT_client_mirror_ctx
 {
@@ -183,6 +196,16 @@ struct PINT_client_remove_sm
     PVFS_capability parent_capability;
 };
 
+/* one file of a PVFS_sys_create_list() call */
+typedef struct
+{
+    PVFS_handle metafile_handle;
+    int dfile_count;
+    PVFS_handle *dfile_array;
+    int linked;           /* directory entry is in place */
+    PVFS_error error;
+} PINT_client_create_list_entry;
+
 struct PINT_client_create_sm
 {
     char *object_name;                /* input parameter */
@@ -205,6 +228,18 @@ struct PINT_client_create_sm
     PVFS_handle handles[2];
 
     struct PVFS_servresp_create server_resp; /* data returned from the server request */
+
+    /* PVFS_sys_create_list() only; the fields above hold what all of
+     * the files have in common */
+    int list_count;                        /* input parameter */
+    char **list_names;                     /* input parameter */
+    PVFS_sysresp_create_list *list_resp;   /* in/out parameter */
+    PINT_client_create_list_entry *list_entries;
+    int list_per_req;        /* files per create_list request */
+    int *list_order;         /* entry of each name sent in crdirent_list */
+    int *list_msg_first;     /* first list_order slot of each msgpair */
+    char **list_msg_names;
+    PVFS_handle *list_msg_handles;
 };
 
 struct PINT_client_mkdir_sm
@@ -388,6 +423,7 @@ struct PINT_client_readdirplus_sm
     int svr_count;
     PVFS_size        **size_array;
     PVFS_object_attr *obj_attr_array;
+    PVFS_error       *plus_err_array;
     struct handle_to_index *input_handle_array;
     PVFS_BMI_addr_t *server_addresses;
     int  *handle_count;
@@ -532,6 +568,18 @@ struct PINT_client_truncate_sm
     PVFS_size size; /* new logical size of object*/
 };
 
+struct PINT_client_copy_range_sm
+{
+    PVFS_object_ref dst_ref;         /* object_ref holds the source */
+    PVFS_offset src_offset;
+    PVFS_offset dst_offset;
+    PVFS_size length;                /* clamped to the source size */
+    PVFS_object_attr src_attr;       /* saved source attributes */
+    PVFS_size dst_size;              /* destination size before the copy */
+    PVFS_hint copy_hints;            /* hints naming the destination */
+    PVFS_sysresp_copy_range *resp_p;
+};
+
 struct PINT_server_get_config_sm
 {
     struct server_configuration_s *config;
@@ -651,6 +699,13 @@ typedef struct
     PVFS_ds_position pos_token;     /* input/output parameter */
     int32_t      dirent_limit;      /* input parameter */
     int32_t      dirdata_index;      /* input parameter */
+    /* set by readdirplus to have the dirdata servers return attributes
+     * along with the entries; each array has dirent_limit slots
+     */
+    PVFS_object_attr *plus_attr_array;  /* output */
+    PVFS_error       *plus_err_array;   /* output */
+    PVFS_size        **plus_size_array; /* output */
+    uint32_t         plus_attrmask;     /* input parameter */
 } PINT_sm_readdir_state;
 
 typedef struct PINT_client_sm
@@ -707,6 +762,7 @@ typedef struct PINT_client_sm
         struct PINT_client_rename_sm rename;
         struct PINT_client_mgmt_setparam_list_sm setparam_list;
         struct PINT_client_truncate_sm  truncate;
+        struct PINT_client_copy_range_sm copy_range;
         struct PINT_client_mgmt_statfs_list_sm statfs_list;
         struct PINT_client_mgmt_perf_mon_list_sm perf_mon_list;
         struct PINT_client_mgmt_event_mon_list_sm event_mon_list;
@@ -814,6 +870,8 @@ enum
     PVFS_SYS_FS_ADD                = 19,
     PVFS_SYS_READDIRPLUS           = 20,
     PVFS_SYS_ATOMICEATTR           = 21,
+    PVFS_SYS_CREATE_LIST           = 22,
+    PVFS_SYS_COPY_RANGE            = 23,
     PVFS_MGMT_SETPARAM_LIST        = 70,
     PVFS_MGMT_NOOP                 = 71,
     PVFS_MGMT_STATFS_LIST          = 72,
@@ -834,7 +892,7 @@ enum
     PVFS_DEV_UNEXPECTED            = 400
 };
 
-#define PVFS_OP_SYS_MAXVALID  22
+#define PVFS_OP_SYS_MAXVALID  24
 #define PVFS_OP_SYS_MAXVAL 69
 #define PVFS_OP_MGMT_MAXVALID 84
 #define PVFS_OP_MGMT_MAXVAL 199
@@ -902,6 +960,8 @@ extern struct PINT_client_op_entry_s PINT_client_sm_mgmt_table[];
 /* system interface function state machines */
 extern struct PINT_state_machine_s pvfs2_client_remove_sm;
 extern struct PINT_state_machine_s pvfs2_client_create_sm;
+extern struct PINT_state_machine_s pvfs2_client_create_list_sm;
+extern struct PINT_state_machine_s pvfs2_client_copy_range_sm;
 extern struct PINT_state_machine_s pvfs2_client_mkdir_sm;
 extern struct PINT_state_machine_s pvfs2_client_symlink_sm;
 extern struct PINT_state_machine_s pvfs2_client_sysint_getattr_sm;
@@ -13,6 +13,7 @@
 #include "pint-sysint-utils.h"
 #include "acache.h"
 #include "ncache.h"
+#include "wbcache.h"
 #include "client-capcache.h"
 #include "gen-locks.h"
 #include "pint-cached-config.h"
@@ -64,10 +65,22 @@ int PVFS_sys_finalize()
         return 0;
     }
 
-    id_gen_safe_finalize();
-
     /* If desired, display cache perf counters before they are finalized. */
     perf_counters_to_display = getenv("PVFS2_COUNTERS_AT_FINALIZE");
+
+    /* write-behind data goes out while state machines can still run */
+    PINT_wbcache_writeback_all();
+    if(perf_counters_to_display && PINT_wbcache_get_pc() &&
+       strstr(perf_counters_to_display, "wbcache"))
+    {
+        gossip_err("%s: DISPLAYING PERF COUNTERS FOR WBCACHE:\n%s",
+            __func__,
+            PINT_perf_generate_text(PINT_wbcache_get_pc(), 4096));
+    }
+    PINT_wbcache_finalize();
+
+    id_gen_safe_finalize();
+
     if(perf_counters_to_display)
     {
         if(PINT_ncache_get_pc() &&
@@ -114,10 +127,11 @@ int PVFS_sys_finalize()
     /* release timer_queue resources, if there are any */
     PINT_timer_queue_finalize();
 
-    BMI_finalize();
-
+    /* the encoder caches BMI buffers, so it has to go first */
     PINT_encode_finalize();
 
+    BMI_finalize();
+
     PINT_client_security_finalize();
 
     PINT_dist_finalize();
@@ -18,6 +18,7 @@
 #include "pvfs2-internal.h"
 #include "acache.h"
 #include "ncache.h"
+#include "wbcache.h"
 #include "client-capcache.h"
 #include "pint-cached-config.h"
 #include "pvfs2-sysint.h"
@@ -68,7 +69,8 @@ typedef enum
     CLIENT_JOB_TIME_MGR_INIT = (1 << 9),
     CLIENT_DIST_INIT         = (1 << 10),
     CLIENT_SECURITY_INIT     = (1 << 11),
-    CLIENT_CAPCACHE_INIT     = (1 << 12)
+    CLIENT_CAPCACHE_INIT     = (1 << 12),
+    CLIENT_WBCACHE_INIT      = (1 << 13)
 } PINT_client_status_flag;
 
 /* PVFS_sys_initialize()
@@ -303,6 +305,15 @@ int PVFS_sys_initialize(uint64_t default_debug_mask)
     }        
     client_status_flag |= CLIENT_NCACHE_INIT;
 
+    /* initialize the write-behind cache; files opt in individually */
+    ret = PINT_wbcache_initialize();
+    if (ret < 0)
+    {
+        gossip_lerr("Error initializing write-behind cache\n");
+        goto error_exit;
+    }
+    client_status_flag |= CLIENT_WBCACHE_INIT;
+
     /* initialize the server configuration manager */
     ret = PINT_server_config_mgr_initialize();
     if (ret < 0)
@@ -364,6 +375,11 @@ error_exit:
         PINT_ncache_finalize();
     }
 
+    if (client_status_flag & CLIENT_WBCACHE_INIT)
+    {
+        PINT_wbcache_finalize();
+    }
+
     if (client_status_flag & CLIENT_ACACHE_INIT)
     {
         PINT_acache_finalize();
@@ -394,14 +410,14 @@ error_exit:
         PINT_req_sched_finalize();
     }
 
-    if (client_status_flag & CLIENT_BMI_INIT)
+    if (client_status_flag & CLIENT_ENCODER_INIT)
     {
-        BMI_finalize();
+        PINT_encode_finalize();
     }
 
-    if (client_status_flag & CLIENT_ENCODER_INIT)
+    if (client_status_flag & CLIENT_BMI_INIT)
     {
-        PINT_encode_finalize();
+        BMI_finalize();
     }
 
     if (client_status_flag & CLIENT_SECURITY_INIT)
@@ -0,0 +1,832 @@
+/*
+ * (C) 2003 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "pvfs2-attr.h"
+#include "wbcache.h"
+#include "acache.h"
+#include "pint-distribution.h"
+#include "pvfs2-dist-simple-stripe.h"
+#include "pint-request.h"
+#include "pint-util.h"
+#include "pvfs2-debug.h"
+#include "gossip.h"
+#include "gen-locks.h"
+#include "quickhash.h"
+#include "security-util.h"
+#include "pvfs2-internal.h"
+#include "client-state-machine.h"
+
+/** \file
+ *  \ingroup wbcache
+ * Implementation of the Write-behind Cache (wbcache) component.
+ */
+
+/* compile time defaults */
+#define WBCACHE_DEFAULT_MEM_LIMIT (16*1024*1024)
+#define WBCACHE_DEFAULT_BUFFER_SIZE PVFS_DIST_SIMPLE_STRIPE_DEFAULT_STRIP_SIZE
+#define WBCACHE_MIN_BUFFER_SIZE 4096
+#define WBCACHE_MAX_BUFFER_SIZE (16*1024*1024)
+#define WBCACHE_MAX_EXTENTS 64
+#define WBCACHE_TABLE_SIZE 61
+
+/* one buffer per file that opted in */
+struct wbcache_entry
+{
+    struct qhash_head hash_link;
+    PVFS_object_ref refn;
+    int refcount;            /**< lookups in progress, protected by table */
+    int released;            /**< removed from the table */
+    gen_mutex_t mutex;       /**< serializes writes and write-back */
+
+    char *buffer;            /**< packed data for all extents */
+    PVFS_size capacity;      /**< allocated size of buffer */
+    PVFS_size used;          /**< bytes of buffer holding data */
+    PVFS_offset window_end;  /**< extents must end at or before this */
+    int extent_count;
+    int32_t extent_len[WBCACHE_MAX_EXTENTS];
+    PVFS_size extent_off[WBCACHE_MAX_EXTENTS];
+    int writes;              /**< application writes in the buffer */
+
+    PVFS_credential credential; /**< used for write-back */
+    int have_credential;
+    int error;               /**< deferred write-back error */
+};
+
+static struct qhash_table *wbcache_table = NULL;
+static gen_mutex_t wbcache_mutex = GEN_MUTEX_INITIALIZER;
+static struct PINT_perf_counter *wbcache_pc = NULL;
+
+/* read without the lock so files that never opted in pay nothing */
+static int wbcache_num_files = 0;
+static PVFS_size wbcache_mem_used = 0;
+static unsigned int wbcache_mem_limit = WBCACHE_DEFAULT_MEM_LIMIT;
+static unsigned int wbcache_buffer_size = 0;
+
+static struct PINT_perf_key wbcache_keys[] =
+{
+    {"WBCACHE_NUM_FILES", PERF_WBCACHE_NUM_FILES, PINT_PERF_PRESERVE},
+    {"WBCACHE_MEM_LIMIT", PERF_WBCACHE_MEM_LIMIT, PINT_PERF_PRESERVE},
+    {"WBCACHE_MEM_USED", PERF_WBCACHE_MEM_USED, PINT_PERF_PRESERVE},
+    {"WBCACHE_WRITES", PERF_WBCACHE_WRITES, 0},
+    {"WBCACHE_WRITE_BYTES", PERF_WBCACHE_WRITE_BYTES, 0},
+    {"WBCACHE_FLUSHES", PERF_WBCACHE_FLUSHES, 0},
+    {"WBCACHE_BYPASSES", PERF_WBCACHE_BYPASSES, 0},
+    {NULL, 0, 0},
+};
+
+static int wbcache_compare_key_entry(const void *key,
+                                     struct qhash_head *link);
+static int wbcache_hash_key(const void *key, int table_size);
+static struct wbcache_entry *wbcache_get(PVFS_object_ref refn);
+static void wbcache_put(struct wbcache_entry *entry);
+static void wbcache_free_entry(struct wbcache_entry *entry);
+static int wbcache_flush_entry(struct wbcache_entry *entry);
+static int wbcache_alloc_buffer(struct wbcache_entry *entry);
+static PVFS_size wbcache_stripe_unit(PVFS_object_ref refn);
+static int wbcache_request_is_contig(PVFS_Request req);
+
+/**
+ * Initializes the wbcache
+ * \return 0 on success, -PVFS_error on failure
+ */
+int PINT_wbcache_initialize(void)
+{
+    gen_mutex_lock(&wbcache_mutex);
+
+    wbcache_table = qhash_init(wbcache_compare_key_entry,
+                               wbcache_hash_key,
+                               WBCACHE_TABLE_SIZE);
+    if (!wbcache_table)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_ENOMEM);
+    }
+
+    wbcache_pc = PINT_perf_initialize(PINT_PERF_COUNTER,
+                                      wbcache_keys,
+                                      client_perf_start_rollover);
+    if (!wbcache_pc)
+    {
+        gossip_err("%s: Error: PINT_perf_initialize failure.\n", __func__);
+        qhash_finalize(wbcache_table);
+        wbcache_table = NULL;
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_ENOMEM);
+    }
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_MEM_LIMIT,
+                    wbcache_mem_limit, PINT_PERF_SET);
+
+    gen_mutex_unlock(&wbcache_mutex);
+    return(0);
+}
+
+/**
+ * Writes back every buffer and turns write-behind off for all files.
+ * Errors can no longer be reported to anyone, so they are only logged.
+ */
+void PINT_wbcache_writeback_all(void)
+{
+    struct wbcache_entry *entry = NULL;
+    struct qhash_head *link = NULL;
+    int i = 0;
+    int ret = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (!wbcache_table)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return;
+    }
+
+    for (i = 0; i < wbcache_table->table_size; i++)
+    {
+        while ((link = qhash_search_and_remove_at_index(
+                    wbcache_table, i)) != NULL)
+        {
+            entry = qhash_entry(link, struct wbcache_entry, hash_link);
+            entry->released = 1;
+            wbcache_num_files--;
+
+            gen_mutex_unlock(&wbcache_mutex);
+            gen_mutex_lock(&entry->mutex);
+            ret = wbcache_flush_entry(entry);
+            if (ret == 0)
+            {
+                ret = entry->error;
+            }
+            if (ret < 0)
+            {
+                gossip_err("%s: lost buffered writes to handle %llu: %d\n",
+                           __func__, llu(entry->refn.handle), ret);
+            }
+            gen_mutex_unlock(&entry->mutex);
+
+            wbcache_put(entry);
+            gen_mutex_lock(&wbcache_mutex);
+        }
+    }
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_NUM_FILES,
+                    wbcache_num_files, PINT_PERF_SET);
+
+    gen_mutex_unlock(&wbcache_mutex);
+    return;
+}
+
+/** Finalizes and destroys the wbcache, writing back any buffers first */
+void PINT_wbcache_finalize(void)
+{
+    PINT_wbcache_writeback_all();
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (!wbcache_table)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return;
+    }
+
+    qhash_finalize(wbcache_table);
+    wbcache_table = NULL;
+
+    PINT_perf_finalize(wbcache_pc);
+    wbcache_pc = NULL;
+
+    gen_mutex_unlock(&wbcache_mutex);
+    return;
+}
+
+/**
+ * Retrieves parameters from the wbcache
+ * \return 0 on success, -PVFS_error on failure
+ */
+int PINT_wbcache_get_info(
+    enum PINT_wbcache_options option, /**< option to read */
+    unsigned int* arg)                /**< output value */
+{
+    int ret = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    switch (option)
+    {
+        case WBCACHE_MEM_LIMIT:
+            *arg = wbcache_mem_limit;
+            break;
+        case WBCACHE_BUFFER_SIZE:
+            *arg = wbcache_buffer_size;
+            break;
+        default:
+            ret = -PVFS_EINVAL;
+            break;
+    }
+    gen_mutex_unlock(&wbcache_mutex);
+
+    return(ret);
+}
+
+/**
+ * Sets optional parameters in the wbcache.  Changes apply to buffers
+ * allocated afterwards.
+ * \return 0 on success, -PVFS_error on failure
+ */
+int PINT_wbcache_set_info(
+    enum PINT_wbcache_options option, /**< option to modify */
+    unsigned int arg)                 /**< input value */
+{
+    int ret = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    switch (option)
+    {
+        case WBCACHE_MEM_LIMIT:
+            wbcache_mem_limit = arg;
+            PINT_perf_count(wbcache_pc, PERF_WBCACHE_MEM_LIMIT,
+                            wbcache_mem_limit, PINT_PERF_SET);
+            break;
+        case WBCACHE_BUFFER_SIZE:
+            if (arg != 0 && (arg < WBCACHE_MIN_BUFFER_SIZE ||
+                             arg > WBCACHE_MAX_BUFFER_SIZE))
+            {
+                ret = -PVFS_EINVAL;
+                break;
+            }
+            wbcache_buffer_size = arg;
+            break;
+        default:
+            ret = -PVFS_EINVAL;
+            break;
+    }
+    gen_mutex_unlock(&wbcache_mutex);
+
+    return(ret);
+}
+
+/**
+ * Turns on write-behind for a file.  Enabling a file twice is harmless.
+ * \return 0 on success, -PVFS_error on failure
+ */
+int PINT_wbcache_enable(PVFS_object_ref refn)
+{
+    struct wbcache_entry *entry = NULL;
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (!wbcache_table)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_EINVAL);
+    }
+    if (qhash_search(wbcache_table, &refn))
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(0);
+    }
+
+    entry = (struct wbcache_entry *)malloc(sizeof(*entry));
+    if (!entry)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_ENOMEM);
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->refn = refn;
+    entry->refcount = 1;
+    gen_mutex_init(&entry->mutex);
+
+    qhash_add(wbcache_table, &entry->refn, &entry->hash_link);
+    wbcache_num_files++;
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_NUM_FILES,
+                    wbcache_num_files, PINT_PERF_SET);
+
+    gen_mutex_unlock(&wbcache_mutex);
+    return(0);
+}
+
+/**
+ * Writes back anything buffered for a file and turns write-behind off
+ * for it; this is the close() of the write-behind layer.
+ * \return 0 on success, otherwise the first error from writing back
+ * data for this file since it was last reported
+ */
+int PINT_wbcache_release(PVFS_object_ref refn)
+{
+    struct wbcache_entry *entry = NULL;
+    struct qhash_head *link = NULL;
+    int ret = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (!wbcache_table ||
+        !(link = qhash_search_and_remove(wbcache_table, &refn)))
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(0);
+    }
+    entry = qhash_entry(link, struct wbcache_entry, hash_link);
+    /* the reference held by the table becomes ours */
+    entry->released = 1;
+    wbcache_num_files--;
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_NUM_FILES,
+                    wbcache_num_files, PINT_PERF_SET);
+    gen_mutex_unlock(&wbcache_mutex);
+
+    gen_mutex_lock(&entry->mutex);
+    ret = wbcache_flush_entry(entry);
+    if (ret == 0)
+    {
+        ret = entry->error;
+    }
+    entry->error = 0;
+    gen_mutex_unlock(&entry->mutex);
+
+    wbcache_put(entry);
+    return(ret);
+}
+
+/**
+ * Offers a write to the wbcache.
+ *
+ * \return 1 if the data was copied into the buffer and the write is
+ * complete, 0 if the caller must perform the write itself (any data
+ * buffered for the file has been written back first so the two do not
+ * reorder), or -PVFS_error if a deferred write-back error is reported
+ */
+int PINT_wbcache_write(
+    PVFS_object_ref refn,
+    PVFS_Request file_req,
+    PVFS_offset file_req_offset,
+    void *buffer,
+    PVFS_Request mem_req,
+    const PVFS_credential *credential)
+{
+    struct wbcache_entry *entry = NULL;
+    PVFS_size len = PINT_REQUEST_TOTAL_BYTES(mem_req);
+    PVFS_offset off = file_req_offset;
+    PVFS_offset last_off = 0;
+    PVFS_offset last_end = 0;
+    int last = 0;
+    int absorbed = 0;
+    int ret = 0;
+
+    if (!wbcache_num_files)
+    {
+        return(0);
+    }
+    entry = wbcache_get(refn);
+    if (!entry)
+    {
+        return(0);
+    }
+
+    gen_mutex_lock(&entry->mutex);
+
+    if (entry->error)
+    {
+        ret = entry->error;
+        entry->error = 0;
+        goto out;
+    }
+
+    if (!wbcache_request_is_contig(mem_req) ||
+        !wbcache_request_is_contig(file_req))
+    {
+        goto bypass;
+    }
+
+    if (entry->extent_count > 0)
+    {
+        last = entry->extent_count - 1;
+        last_off = entry->extent_off[last];
+        last_end = last_off + entry->extent_len[last];
+
+        if (off >= last_off && off + len <= last_end)
+        {
+            /* rewrite of data at the tail of the buffer */
+            memcpy(entry->buffer + entry->used - (last_end - off),
+                   buffer, len);
+            absorbed = 1;
+        }
+        else if (off >= last_end && off + len <= entry->window_end &&
+                 (off == last_end ||
+                  entry->extent_count < WBCACHE_MAX_EXTENTS))
+        {
+            memcpy(entry->buffer + entry->used, buffer, len);
+            entry->used += len;
+            if (off == last_end)
+            {
+                entry->extent_len[last] += (int32_t)len;
+            }
+            else
+            {
+                entry->extent_off[entry->extent_count] = off;
+                entry->extent_len[entry->extent_count] = (int32_t)len;
+                entry->extent_count++;
+            }
+            absorbed = 1;
+        }
+        else
+        {
+            /* cannot append; send what we have and start over */
+            ret = wbcache_flush_entry(entry);
+            if (ret < 0)
+            {
+                /* reported now, so not again later */
+                entry->error = 0;
+                goto out;
+            }
+        }
+    }
+
+    if (!absorbed)
+    {
+        if (!entry->buffer && wbcache_alloc_buffer(entry) < 0)
+        {
+            goto bypass;
+        }
+        /* the window is the stripe unit holding the first byte */
+        entry->window_end = (off / entry->capacity + 1) * entry->capacity;
+        if (off + len > entry->window_end)
+        {
+            goto bypass;
+        }
+        memcpy(entry->buffer, buffer, len);
+        entry->used = len;
+        entry->extent_off[0] = off;
+        entry->extent_len[0] = (int32_t)len;
+        entry->extent_count = 1;
+        entry->writes = 0;
+
+        if (entry->have_credential)
+        {
+            PINT_cleanup_credential(&entry->credential);
+            entry->have_credential = 0;
+        }
+        ret = PINT_copy_credential(credential, &entry->credential);
+        if (ret < 0)
+        {
+            entry->used = 0;
+            entry->extent_count = 0;
+            goto out;
+        }
+        entry->have_credential = 1;
+    }
+
+    entry->writes++;
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_WRITES, 1, PINT_PERF_ADD);
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_WRITE_BYTES, len,
+                    PINT_PERF_ADD);
+
+    /* a full stripe unit will not grow any further */
+    last = entry->extent_count - 1;
+    if (entry->extent_off[last] + entry->extent_len[last] ==
+        entry->window_end)
+    {
+        ret = wbcache_flush_entry(entry);
+        if (ret < 0)
+        {
+            /* this write itself succeeded as far as the caller knows */
+            entry->error = ret;
+        }
+    }
+    ret = 1;
+    goto out;
+
+bypass:
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_BYPASSES, 1, PINT_PERF_ADD);
+    ret = wbcache_flush_entry(entry);
+    if (ret < 0)
+    {
+        entry->error = 0;
+    }
+
+out:
+    gen_mutex_unlock(&entry->mutex);
+    wbcache_put(entry);
+    return(ret);
+}
+
+/**
+ * Writes back anything buffered for a file, as part of PVFS_sys_flush().
+ * \return 0 on success, otherwise the first error from writing back
+ * data for this file since it was last reported
+ */
+int PINT_wbcache_flush(PVFS_object_ref refn)
+{
+    struct wbcache_entry *entry = NULL;
+    int ret = 0;
+
+    if (!wbcache_num_files)
+    {
+        return(0);
+    }
+    entry = wbcache_get(refn);
+    if (!entry)
+    {
+        return(0);
+    }
+
+    gen_mutex_lock(&entry->mutex);
+    ret = wbcache_flush_entry(entry);
+    if (ret == 0)
+    {
+        ret = entry->error;
+    }
+    entry->error = 0;
+    gen_mutex_unlock(&entry->mutex);
+
+    wbcache_put(entry);
+    return(ret);
+}
+
+/**
+ * Writes back anything buffered for a file before an operation that
+ * must observe it (read, truncate, size query).  Errors are kept for
+ * the next write, flush or release instead of failing that operation.
+ */
+void PINT_wbcache_writeback(PVFS_object_ref refn)
+{
+    struct wbcache_entry *entry = NULL;
+
+    if (!wbcache_num_files)
+    {
+        return;
+    }
+    entry = wbcache_get(refn);
+    if (!entry)
+    {
+        return;
+    }
+
+    gen_mutex_lock(&entry->mutex);
+    wbcache_flush_entry(entry);
+    gen_mutex_unlock(&entry->mutex);
+
+    wbcache_put(entry);
+}
+
+struct PINT_perf_counter* PINT_wbcache_get_pc(void)
+{
+    return wbcache_pc;
+}
+
+static int wbcache_compare_key_entry(const void *key,
+                                     struct qhash_head *link)
+{
+    const PVFS_object_ref *real_key = (const PVFS_object_ref *)key;
+    struct wbcache_entry *entry = NULL;
+
+    entry = qhash_entry(link, struct wbcache_entry, hash_link);
+    if (real_key->handle == entry->refn.handle &&
+        real_key->fs_id == entry->refn.fs_id)
+    {
+        return(1);
+    }
+
+    return(0);
+}
+
+static int wbcache_hash_key(const void *key, int table_size)
+{
+    const PVFS_object_ref *real_key = (const PVFS_object_ref *)key;
+
+    return((int)(real_key->handle % table_size));
+}
+
+/* looks up a file and takes a reference on its entry */
+static struct wbcache_entry *wbcache_get(PVFS_object_ref refn)
+{
+    struct wbcache_entry *entry = NULL;
+    struct qhash_head *link = NULL;
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (wbcache_table && (link = qhash_search(wbcache_table, &refn)))
+    {
+        entry = qhash_entry(link, struct wbcache_entry, hash_link);
+        entry->refcount++;
+    }
+    gen_mutex_unlock(&wbcache_mutex);
+
+    return(entry);
+}
+
+/* drops a reference; the last one after a release frees the entry */
+static void wbcache_put(struct wbcache_entry *entry)
+{
+    int last = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    entry->refcount--;
+    last = (entry->released && entry->refcount == 0);
+    if (last && entry->buffer)
+    {
+        wbcache_mem_used -= entry->capacity;
+        PINT_perf_count(wbcache_pc, PERF_WBCACHE_MEM_USED,
+                        wbcache_mem_used, PINT_PERF_SET);
+    }
+    gen_mutex_unlock(&wbcache_mutex);
+
+    if (last)
+    {
+        wbcache_free_entry(entry);
+    }
+}
+
+static void wbcache_free_entry(struct wbcache_entry *entry)
+{
+    if (entry->have_credential)
+    {
+        PINT_cleanup_credential(&entry->credential);
+    }
+    free(entry->buffer);
+    gen_mutex_destroy(&entry->mutex);
+    free(entry);
+}
+
+/* Sends the buffered extents as one write and empties the buffer.  On
+ * failure the data is dropped and the error is also recorded for later
+ * reporting.  Called with the entry mutex held.
+ */
+static int wbcache_flush_entry(struct wbcache_entry *entry)
+{
+    PVFS_Request file_req = PVFS_BYTE;
+    PVFS_Request mem_req = NULL;
+    PVFS_offset file_req_offset = 0;
+    PVFS_sysresp_io resp;
+    PVFS_sys_op_id op_id;
+    int error = 0;
+    int ret = 0;
+
+    if (entry->extent_count == 0)
+    {
+        return(0);
+    }
+
+    gossip_debug(GOSSIP_CLIENT_DEBUG, "%s: handle %llu: %d writes, "
+                 "%d extents, %lld bytes\n", __func__,
+                 llu(entry->refn.handle), entry->writes,
+                 entry->extent_count, lld(entry->used));
+
+    if (entry->extent_count == 1)
+    {
+        file_req_offset = entry->extent_off[0];
+    }
+    else
+    {
+        ret = PVFS_Request_hindexed(entry->extent_count,
+                                    entry->extent_len,
+                                    entry->extent_off,
+                                    PVFS_BYTE,
+                                    &file_req);
+        if (ret != 0)
+        {
+            ret = -PVFS_ENOMEM;
+            goto out;
+        }
+    }
+    ret = PVFS_Request_contiguous((int32_t)entry->used, PVFS_BYTE,
+                                  &mem_req);
+    if (ret != 0)
+    {
+        ret = -PVFS_ENOMEM;
+        goto out;
+    }
+
+    memset(&resp, 0, sizeof(resp));
+    ret = PINT_client_io_post(entry->refn, file_req, file_req_offset,
+                              entry->buffer, mem_req, &entry->credential,
+                              &resp, PVFS_IO_WRITE, &op_id,
+                              PVFS_HINT_NULL, NULL);
+    if (ret == 0)
+    {
+        ret = PVFS_sys_wait(op_id, "io", &error);
+        PINT_sys_release(op_id);
+        if (ret == 0)
+        {
+            ret = error;
+        }
+    }
+    if (ret == 0 && resp.total_completed != entry->used)
+    {
+        ret = -PVFS_EIO;
+    }
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_FLUSHES, 1, PINT_PERF_ADD);
+
+out:
+    if (mem_req)
+    {
+        PVFS_Request_free(&mem_req);
+    }
+    if (file_req != PVFS_BYTE)
+    {
+        PVFS_Request_free(&file_req);
+    }
+    if (ret < 0)
+    {
+        gossip_debug(GOSSIP_CLIENT_DEBUG, "%s: handle %llu: write-back "
+                     "failed: %d\n", __func__, llu(entry->refn.handle), ret);
+        if (!entry->error)
+        {
+            entry->error = ret;
+        }
+    }
+    entry->used = 0;
+    entry->extent_count = 0;
+    entry->writes = 0;
+    return(ret);
+}
+
+/* Allocates the buffer for a file if the memory cap allows it.
+ * Called with the entry mutex held.
+ */
+static int wbcache_alloc_buffer(struct wbcache_entry *entry)
+{
+    PVFS_size size = 0;
+
+    gen_mutex_lock(&wbcache_mutex);
+    size = wbcache_buffer_size;
+    gen_mutex_unlock(&wbcache_mutex);
+    if (size == 0)
+    {
+        size = wbcache_stripe_unit(entry->refn);
+    }
+
+    gen_mutex_lock(&wbcache_mutex);
+    if (wbcache_mem_used + size > wbcache_mem_limit)
+    {
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_ENOMEM);
+    }
+    wbcache_mem_used += size;
+    PINT_perf_count(wbcache_pc, PERF_WBCACHE_MEM_USED,
+                    wbcache_mem_used, PINT_PERF_SET);
+    gen_mutex_unlock(&wbcache_mutex);
+
+    entry->buffer = (char *)malloc(size);
+    if (!entry->buffer)
+    {
+        gen_mutex_lock(&wbcache_mutex);
+        wbcache_mem_used -= size;
+        PINT_perf_count(wbcache_pc, PERF_WBCACHE_MEM_USED,
+                        wbcache_mem_used, PINT_PERF_SET);
+        gen_mutex_unlock(&wbcache_mutex);
+        return(-PVFS_ENOMEM);
+    }
+    entry->capacity = size;
+    return(0);
+}
+
+/* the distribution's block size for one datafile, if attributes are
+ * cached; the default strip size otherwise
+ */
+static PVFS_size wbcache_stripe_unit(PVFS_object_ref refn)
+{
+    PVFS_object_attr attr;
+    PVFS_size size = 0;
+    PVFS_size unit = WBCACHE_DEFAULT_BUFFER_SIZE;
+    int attr_status = 0;
+    int size_status = 0;
+    int ret = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    ret = PINT_acache_get_cached_entry(refn, &attr, &attr_status,
+                                       &size, &size_status);
+    if (ret == 0 && attr_status == 0)
+    {
+        if ((attr.mask & PVFS_ATTR_META_DIST) && attr.u.meta.dist &&
+            attr.u.meta.dist->methods->get_blksize)
+        {
+            unit = attr.u.meta.dist->methods->get_blksize(
+                attr.u.meta.dist->params, 1);
+        }
+        PINT_free_object_attr(&attr);
+    }
+
+    if (unit < WBCACHE_MIN_BUFFER_SIZE)
+    {
+        unit = WBCACHE_MIN_BUFFER_SIZE;
+    }
+    if (unit > WBCACHE_MAX_BUFFER_SIZE)
+    {
+        unit = WBCACHE_MAX_BUFFER_SIZE;
+    }
+    return(unit);
+}
+
+/* contiguous, starting at the beginning of the buffer or offset */
+static int wbcache_request_is_contig(PVFS_Request req)
+{
+    return(req->num_contig_chunks == 1 && req->lb == 0 &&
+           req->ub - req->lb == req->aggregate_size);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
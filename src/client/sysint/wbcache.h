@@ -0,0 +1,110 @@
+/*
+ * (C) 2003 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+#ifndef __WBCACHE_H
+#define __WBCACHE_H
+
+#include "pvfs2-types.h"
+#include "pvfs2-request.h"
+#include "pint-perf-counter.h"
+
+/** \defgroup wbcache Write-behind Cache (wbcache)
+ *
+ * The wbcache absorbs small writes to files that have opted in with
+ * PVFS_sys_write_behind_enable() and sends them to the servers later as
+ * a single I/O request.  Each such file gets one buffer covering at most
+ * one stripe unit of the file (or the configured buffer size).  Writes
+ * that are contiguous in memory and in the file, and that land at or
+ * after the end of the data already buffered within that window, are
+ * copied into the buffer; consecutive writes are merged, and forward
+ * strided writes are kept as separate extents that go out as one
+ * indexed file request.
+ *
+ * The buffer is written back when:
+ * - it covers the whole window
+ * - a write arrives that cannot be absorbed (it is flushed first)
+ * - the file is read, truncated, or its size is requested
+ * - PVFS_sys_flush() or PVFS_sys_write_behind_release() is called
+ * - the system interface is finalized
+ * .
+ *
+ * Write-back errors are deferred: they are returned by the next write,
+ * flush or release on that file, as with close() after NFS writes.
+ * The total memory used by buffers is capped; when the cap is reached
+ * writes to additional files simply go straight to the servers.
+ *
+ * @{
+ */
+
+/** \file
+ * Declarations for the Write-behind Cache (wbcache) component.
+ */
+
+enum PINT_wbcache_options
+{
+    WBCACHE_MEM_LIMIT = 1,   /**< bytes of buffer memory for all files */
+    WBCACHE_BUFFER_SIZE = 2, /**< per file buffer size, 0 = stripe unit */
+};
+
+enum
+{
+    PERF_WBCACHE_NUM_FILES = 0,
+    PERF_WBCACHE_MEM_LIMIT = 1,
+    PERF_WBCACHE_MEM_USED = 2,
+    PERF_WBCACHE_WRITES = 3,
+    PERF_WBCACHE_WRITE_BYTES = 4,
+    PERF_WBCACHE_FLUSHES = 5,
+    PERF_WBCACHE_BYPASSES = 6,
+};
+
+int PINT_wbcache_initialize(void);
+
+void PINT_wbcache_finalize(void);
+
+void PINT_wbcache_writeback_all(void);
+
+int PINT_wbcache_get_info(
+    enum PINT_wbcache_options option,
+    unsigned int* arg);
+
+int PINT_wbcache_set_info(
+    enum PINT_wbcache_options option,
+    unsigned int arg);
+
+int PINT_wbcache_enable(
+    PVFS_object_ref refn);
+
+int PINT_wbcache_release(
+    PVFS_object_ref refn);
+
+int PINT_wbcache_write(
+    PVFS_object_ref refn,
+    PVFS_Request file_req,
+    PVFS_offset file_req_offset,
+    void *buffer,
+    PVFS_Request mem_req,
+    const PVFS_credential *credential);
+
+int PINT_wbcache_flush(
+    PVFS_object_ref refn);
+
+void PINT_wbcache_writeback(
+    PVFS_object_ref refn);
+
+struct PINT_perf_counter* PINT_wbcache_get_pc(void);
+
+#endif /* __WBCACHE_H */
+
+/* @} */
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
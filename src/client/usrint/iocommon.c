@@ -449,6 +449,61 @@ int iocommon_parse_serverlist(char *serverlist,
  * parent_ref is a PVFS object so we should be all
  * in PVFS space.
  */
+/**
+ * Translates the mode of a new file, less the user's umask, into PVFS
+ * permission bits
+ */
+static uint32_t iocommon_create_perms(mode_t mode)
+{
+    uint32_t perms = 0;
+    mode_t mode_mask;
+    mode_t user_mode;
+
+    /* Extract the users umask (and restore it to the original value) */
+    mode_mask = umask(0);
+    umask(mode_mask);
+    user_mode = mode & ~mode_mask;
+
+    /* Set file permissions */
+    if (user_mode & S_IXOTH)
+    {
+        perms |= PVFS_O_EXECUTE;
+    }
+    if (user_mode & S_IWOTH)
+    {
+        perms |= PVFS_O_WRITE;
+    }
+    if (user_mode & S_IROTH)
+    {
+        perms |= PVFS_O_READ;
+    }
+    if (user_mode & S_IXGRP)
+    {
+        perms |= PVFS_G_EXECUTE;
+    }
+    if (user_mode & S_IWGRP)
+    {
+        perms |= PVFS_G_WRITE;
+    }
+    if (user_mode & S_IRGRP)
+    {
+        perms |= PVFS_G_READ;
+    }
+    if (user_mode & S_IXUSR)
+    {
+        perms |= PVFS_U_EXECUTE;
+    }
+    if (user_mode & S_IWUSR)
+    {
+        perms |= PVFS_U_WRITE;
+    }
+    if (user_mode & S_IRUSR)
+    {
+        perms |= PVFS_U_READ;
+    }
+    return perms;
+}
+
 int iocommon_create_file(const char *filename,
                          mode_t mode,
                          PVFS_hint file_creation_param,
@@ -457,8 +512,6 @@ int iocommon_create_file(const char *filename,
 {
     int rc = 0;
     int orig_errno = errno;
-    mode_t mode_mask;
-    mode_t user_mode;
     PVFS_sys_attr attr;
     PVFS_credential *credential;
     PVFS_sysresp_create resp_create;
@@ -595,48 +648,7 @@ int iocommon_create_file(const char *filename,
         }
     }
 
-    /* Extract the users umask (and restore it to the original value) */
-    mode_mask = umask(0);
-    umask(mode_mask);
-    user_mode = mode & ~mode_mask;
-
-    /* Set file permissions */
-    if (user_mode & S_IXOTH)
-    {
-        attr.perms |= PVFS_O_EXECUTE;
-    }
-    if (user_mode & S_IWOTH)
-    {
-        attr.perms |= PVFS_O_WRITE;
-    }
-    if (user_mode & S_IROTH)
-    {
-        attr.perms |= PVFS_O_READ;
-    }
-    if (user_mode & S_IXGRP)
-    {
-        attr.perms |= PVFS_G_EXECUTE;
-    }
-    if (user_mode & S_IWGRP)
-    {
-        attr.perms |= PVFS_G_WRITE;
-    }
-    if (user_mode & S_IRGRP)
-    {
-        attr.perms |= PVFS_G_READ;
-    }
-    if (user_mode & S_IXUSR)
-    {
-        attr.perms |= PVFS_U_EXECUTE;
-    }
-    if (user_mode & S_IWUSR)
-    {
-        attr.perms |= PVFS_U_WRITE;
-    }
-    if (user_mode & S_IRUSR)
-    {
-        attr.perms |= PVFS_U_READ;
-    }
+    attr.perms = iocommon_create_perms(mode);
 
     /* Set credential */
     rc = iocommon_cred(&credential);
@@ -670,6 +682,97 @@ errorout:
     return rc;
 }
 
+/**
+ * Create several files in one directory with one PVFS_sys_create_list
+ * call.  errors[i] gets 0 or the errno of file i; if any file failed
+ * -1 is returned with errno set from the first failure.
+ */
+int iocommon_create_list(char **names,
+                         int count,
+                         mode_t mode,
+                         PVFS_object_ref parent_ref,
+                         PVFS_object_ref *refs,
+                         int *errors)
+{
+    int rc = 0;
+    int orig_errno = errno;
+    int first_error = 0;
+    int i;
+    PVFS_sys_attr attr;
+    PVFS_credential *credential;
+    PVFS_sysresp_create_list resp_list;
+
+    gossip_debug(GOSSIP_USRINT_DEBUG,
+                 "iocommon_create_list: called with %d files\n", count);
+
+    /* Initialize */
+    PVFS_INIT(pvfs_sys_init);
+    memset(&attr, 0, sizeof(attr));
+    memset(&resp_list, 0, sizeof(resp_list));
+
+    attr.owner = geteuid();
+    attr.group = getegid();
+    attr.atime = time(NULL);
+    attr.mtime = attr.atime;
+    attr.ctime = attr.atime;
+    attr.mask = PVFS_ATTR_SYS_ALL_SETABLE;
+    attr.perms = iocommon_create_perms(mode);
+
+    /* Set credential */
+    rc = iocommon_cred(&credential);
+    if (rc != 0)
+    {
+        goto errorout;
+    }
+
+    /* Contact server */
+    errno = 0;
+    rc = PVFS_sys_create_list(names,
+                              count,
+                              parent_ref,
+                              attr,
+                              credential,
+                              NULL,
+                              &resp_list,
+                              NULL,
+                              NULL);
+    IOCOMMON_CHECK_ERR(rc);
+
+    for (i = 0; i < count; i++)
+    {
+        rc = resp_list.error_array[i];
+        refs[i] = resp_list.ref_array[i];
+        errors[i] = 0;
+        if (rc < 0)
+        {
+            if (IS_PVFS_NON_ERRNO_ERROR(-rc))
+            {
+                errors[i] = EIO;
+            }
+            else if (IS_PVFS_ERROR(-rc))
+            {
+                errors[i] = PINT_errno_mapping[(-rc) & 0x7f];
+            }
+            if (!first_error)
+            {
+                first_error = errors[i];
+            }
+        }
+    }
+    free(resp_list.ref_array);
+    free(resp_list.error_array);
+
+    rc = 0;
+    if (first_error)
+    {
+        errno = first_error;
+        rc = -1;
+    }
+
+errorout:
+    return rc;
+}
+
 /**
  * OK we tried to open a file and may have run into a symbolic link that
  * points to NON-PVFS space or something equally weird so we will call
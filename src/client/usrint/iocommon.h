@@ -131,6 +131,16 @@ extern int iocommon_create_file(const char *filename,
                                 PVFS_object_ref parent_ref,
                                 PVFS_object_ref *ref);
 
+/*
+ * Create several files in one directory via the PVFS system interface
+ */
+extern int iocommon_create_list(char **names,
+                                int count,
+                                mode_t file_permission,
+                                PVFS_object_ref parent_ref,
+                                PVFS_object_ref *refs,
+                                int *errors);
+
 
 /* pvfs_open implementation, return file info in fd */
 /* assumes path is fully qualified */
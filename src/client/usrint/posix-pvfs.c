@@ -393,6 +393,63 @@ int pvfs_creat64(const char *path, mode_t mode)
     return pvfs_open64(path, O_RDWR | O_CREAT | O_EXCL, mode);
 }
 
+/**
+ * pvfs_creat_list creates count empty files named by names in the
+ * directory path, with one request per metadata server rather than one
+ * create per file.  errors[i] gets 0 or the errno of file i.  Returns 0
+ * if every file was created, otherwise -1 with errno set from the first
+ * file that failed.
+ */
+int pvfs_creat_list(const char *path, int count, char **names,
+                    mode_t mode, int *errors)
+{
+    int rc;
+    char *newpath;
+    PVFS_object_ref dir_ref;
+    PVFS_object_ref *refs;
+
+    gossip_debug(GOSSIP_USRINT_DEBUG, "pvfs_creat_list: called with %s\n",
+                 path);
+    if (count < 1 || !names || !errors)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    newpath = PVFS_qualify_path(path);
+    if (!newpath)
+    {
+        return -1;
+    }
+    refs = malloc(count * sizeof(PVFS_object_ref));
+    if (!refs)
+    {
+        errno = ENOMEM;
+        rc = -1;
+        goto errorout;
+    }
+    rc = iocommon_lookup(newpath,
+                         PVFS2_LOOKUP_LINK_FOLLOW,
+                         NULL,
+                         &dir_ref,
+                         NULL,
+                         NULL);
+    if (rc < 0)
+    {
+        goto errorout;
+    }
+    rc = iocommon_create_list(names, count, (mode & 07777), dir_ref,
+                              refs, errors);
+
+errorout:
+    free(refs);
+    if (newpath != path)
+    {
+        /* This should only happen if path was not a PVFS_path */
+        PVFS_free_expanded(newpath);
+    }
+    return rc;
+}
+
 /**
  * pvfs_unlink
  */
@@ -54,6 +54,10 @@ extern int pvfs_creat(const char *path, mode_t mode);
 
 extern int pvfs_creat64(const char *path, mode_t mode);
 
+/* pvfs_creat_list creates several files in one directory at once */
+extern int pvfs_creat_list(const char *path, int count, char **names,
+                           mode_t mode, int *errors);
+
 /* pvfs_unlink */
 extern int pvfs_unlink (const char *path);
 
@@ -51,6 +51,7 @@
 #include <apr_base64.h>
 #include <apr_want.h>
 #include <apr_thread_proc.h>
+#include <apr_general.h>
 
 #include <ap_provider.h>
 #include <httpd.h>
@@ -205,6 +206,17 @@ const char *EXT_ATTR_S3_OWNER_ID           = "user.s3.owner.id";
 const char *EXT_ATTR_S3_OWNER_DISPLAY_NAME = "user.s3.owner.display-name";
 const char *EXT_ATTR_S3_ENTITY_TAG         = "user.s3.entity-tag";
 const char *EXT_ATTR_S3_SIZE               = "user.s3.size";
+const char *EXT_ATTR_S3_UPLOAD_KEY         = "user.s3.upload.key";
+const char *EXT_ATTR_S3_UPLOAD_PART_SIZE   = "user.s3.upload.part-size";
+const char *EXT_ATTR_S3_UPLOAD_PART        = "user.s3.upload.part.";
+
+/* object data is moved to and from PVFS2 this many bytes at a time */
+#define ORANGEFS_S3_IO_SIZE (4*1024*1024)
+/* how much request body to ask the input filters for at once */
+#define ORANGEFS_S3_BRIGADE_SIZE (64*1024)
+/* hidden directory in each bucket holding multipart uploads in progress */
+#define ORANGEFS_S3_UPLOAD_DIR ".s3-multipart"
+#define ORANGEFS_S3_MAX_PARTS 10000
 
 const int PERM_S3_FULL_CONTROL 	= 1;
 const int PERM_S3_WRITE		= 2;
@@ -441,32 +453,165 @@ static char * orangefs_s3_bin_to_hex(apr_pool_t *pool,
 }
 
 /*
-   This routine will write the contents of the POST data to a PVFS2 object and
-   return the contents MD5 sum.
+  struct orangefs_s3_io
+
+    One non-blocking PVFS2 read or write.  Object data is moved with two
+    of these, so the next buffer is being read or written in PVFS2 while 
+    the previous one is going to or coming from the client.
+ */
+typedef struct {
+  char *buf;
+  apr_size_t len;
+  PVFS_offset offset;
+  PVFS_Request mem_req;
+  PVFS_sysresp_io resp_io;
+  PVFS_sys_op_id op_id;
+  int pending;
+} orangefs_s3_io;
+
+/*
+   Starts reading or writing io->len bytes at io->offset through io->buf.
+   The operation must be finished with orangefs_s3_io_wait().
+  
+   Returns 0 on success, a negative PVFS2 error otherwise.
+ */
+static int orangefs_s3_io_post(orangefs_s3_request *req, 
+                               PVFS_object_ref *ref, 
+                               orangefs_s3_io *io, 
+                               enum PVFS_io_type type, 
+                               PVFS_hint hints)
+{
+  int rc;
+
+  io->pending = 0;
+  io->op_id = -1;
+  memset(&io->resp_io, 0, sizeof(PVFS_sysresp_io));
+
+  rc = PVFS_Request_contiguous(io->len, PVFS_BYTE, &io->mem_req);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_Request_contiguous returned rc %d.", rc);
+    return rc;
+  }
+
+  rc = PVFS_isys_io(*ref, PVFS_BYTE, io->offset, io->buf, io->mem_req, 
+                    req->credentials, &io->resp_io, type, &io->op_id, 
+                    hints, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_isys_io returned rc %d.", rc);
+    PVFS_Request_free(&io->mem_req);
+    return rc;
+  }
+
+  io->pending = 1;
+  return 0;
+}
+
+/*
+   Waits for an operation started by orangefs_s3_io_post(), if any.  The
+   number of bytes moved is left in io->resp_io.total_completed.
+  
+   Returns 0 on success, a negative PVFS2 error otherwise.
+ */
+static int orangefs_s3_io_wait(orangefs_s3_io *io)
+{
+  int count, error = 0, rc = 0;
+
+  if (!io->pending) {
+    return 0;
+  }
+  io->pending = 0;
+
+  /* an op_id of -1 means the operation finished as it was posted */
+  if (io->op_id != -1) {
+    do {
+      count = 1;
+      rc = PVFS_sys_testsome(&io->op_id, &count, NULL, &error, 100);
+    } while (rc == 0 && count == 0);
+  }
+
+  PVFS_Request_free(&io->mem_req);
+
+  if (rc < 0) {
+    error = rc;
+  }
+  if (error < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS2 I/O at offset %lld returned rc %d.", 
+                 (long long)io->offset, error);
+  }
+  return error;
+}
+
+/*
+   Writes the filled buffer io[*cur] and switches *cur to the other buffer,
+   once the write previously started from it has finished.
+  
+   Returns 0 on success, -1 on error.
+ */
+static int orangefs_s3_write_flush(orangefs_s3_request *req, 
+                                   PVFS_object_ref *ref, 
+                                   PVFS_hint hints, 
+                                   orangefs_s3_io *io, 
+                                   int *cur)
+{
+  orangefs_s3_io *next = &io[1 - *cur];
+
+  if (next->pending && (orangefs_s3_io_wait(next) < 0 || 
+                        next->resp_io.total_completed != next->len)) {
+    return -1;
+  }
+
+  if (orangefs_s3_io_post(req, ref, &io[*cur], PVFS_IO_WRITE, hints) < 0) {
+    return -1;
+  }
+
+  next->offset = io[*cur].offset + io[*cur].len;
+  next->len = 0;
+  *cur = 1 - *cur;
+
+  return 0;
+}
+
+/*
+   This routine will write the contents of the POST data to a PVFS2 object,
+   starting at offset, and return the contents size and MD5 sum.  Data is
+   gathered into ORANGEFS_S3_IO_SIZE buffers; one is written while the
+   next is filled from the client.
+
+   Returns 0 on success, -1 on error.
  */
 static int orangefs_s3_write_post_data_ref(orangefs_s3_request *req, 
                                            PVFS_object_ref *ref, 
                                            PVFS_hint hints, 
+                                           PVFS_offset offset, 
                                            size_t *size, 
                                            unsigned char *md5)
 {
   apr_status_t status;
   int end = 0;
-  apr_size_t bytes;
+  apr_size_t bytes, n;
   const char *buf;
   apr_bucket *b;
   apr_bucket_brigade *bb;
-  PVFS_Request mem_req, file_req;
-  PVFS_sysresp_io resp_io;
-  size_t offset = 0;
+  orangefs_s3_io io[2];
   apr_md5_ctx_t md5_ctx;
-  int rc;
+  int cur = 0;
+  int rc = 0;
 
   if (debug_orangefs_s3) {
     ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL,
                  "orangefs_s3_write_post_data_ref:");
   }
 
+  *size = 0;
+
+  memset(io, 0, sizeof(io));
+  io[0].buf = apr_palloc(req->pool, ORANGEFS_S3_IO_SIZE);
+  io[1].buf = apr_palloc(req->pool, ORANGEFS_S3_IO_SIZE);
+  io[0].offset = offset;
+
   /* initialize the bucket brigade from the request */
   bb = apr_brigade_create(req->r->pool, req->r->connection->bucket_alloc);
 
@@ -475,10 +620,10 @@ static int orangefs_s3_write_post_data_ref(orangefs_s3_request *req,
   /* loop over each bucket until we get an EOS */
   do {
     status = ap_get_brigade(req->r->input_filters, bb, AP_MODE_READBYTES,
-                            APR_BLOCK_READ, 4096);
+                            APR_BLOCK_READ, ORANGEFS_S3_BRIGADE_SIZE);
     if (status == APR_SUCCESS) {
       for (b = APR_BRIGADE_FIRST(bb);
-           b!= APR_BRIGADE_SENTINEL(bb);
+           b!= APR_BRIGADE_SENTINEL(bb) && rc == 0;
            b = APR_BUCKET_NEXT(b)) {
 
         /* check for EOS */
@@ -492,35 +637,126 @@ static int orangefs_s3_write_post_data_ref(orangefs_s3_request *req,
 
         /* read into buf */
         status = apr_bucket_read(b, &buf, &bytes, APR_BLOCK_READ);
-        if (status == APR_SUCCESS) {
-          file_req = PVFS_BYTE;
-          rc = PVFS_Request_contiguous(bytes, PVFS_BYTE, &mem_req);
-          if (rc < 0) {
-            ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                         "PVFS_sys_resolve returned %d.", rc);
-            return -1;
-          }
-
-          rc = PVFS_sys_write(*ref, file_req, offset, (void *)buf, mem_req,
-                              req->credentials, &resp_io, hints);
-
-          offset += bytes;
-
-          PVFS_Request_free(&mem_req);
+        if (status != APR_SUCCESS) {
+          rc = -1;
+          break;
+        }
 
-          apr_md5_update(&md5_ctx, buf, bytes);
+        apr_md5_update(&md5_ctx, buf, bytes);
+        *size += bytes;
 
-        } else {
-          return -1;
+        /* copy into the current buffer, writing it out whenever full */
+        while (bytes > 0) {
+          n = ORANGEFS_S3_IO_SIZE - io[cur].len;
+          if (n > bytes) {
+            n = bytes;
+          }
+          memcpy(io[cur].buf + io[cur].len, buf, n);
+          io[cur].len += n;
+          buf += n;
+          bytes -= n;
+
+          if (io[cur].len == ORANGEFS_S3_IO_SIZE) {
+            rc = orangefs_s3_write_flush(req, ref, hints, io, &cur);
+            if (rc < 0) {
+              break;
+            }
+          }
         }
       }
     }
 
     apr_brigade_cleanup(bb);
-  } while (!end && (status == APR_SUCCESS));
+  } while (!end && (status == APR_SUCCESS) && rc == 0);
+
+  if (rc == 0 && status != APR_SUCCESS) {
+    rc = -1;
+  }
+
+  /* write whatever is left over, then wait for both buffers */
+  if (rc == 0 && io[cur].len > 0) {
+    rc = orangefs_s3_write_flush(req, ref, hints, io, &cur);
+  }
+  for (cur = 0; cur < 2; cur++) {
+    if (io[cur].pending && (orangefs_s3_io_wait(&io[cur]) < 0 || 
+                            io[cur].resp_io.total_completed != io[cur].len)) {
+      rc = -1;
+    }
+  }
 
   apr_md5_final(md5, &md5_ctx);
-  *size = offset;
+
+  return rc;
+}
+
+/*
+   Copies length bytes at src_offset in one PVFS2 object to dst_offset in
+   another.  The IO servers move the data between themselves when the two
+   layouts line up; otherwise it comes through this process.
+  
+   Returns 0 on success, -1 on error.
+ */
+static int orangefs_s3_copy_range(orangefs_s3_request *req, 
+                                  PVFS_object_ref *src, 
+                                  PVFS_offset src_offset, 
+                                  PVFS_object_ref *dst, 
+                                  PVFS_offset dst_offset, 
+                                  PVFS_size length, 
+                                  PVFS_hint hints)
+{
+  orangefs_s3_io io;
+  PVFS_sysresp_copy_range resp_copy;
+  PVFS_size done = 0;
+  int rc;
+
+  memset(&resp_copy, 0, sizeof(resp_copy));
+  rc = PVFS_sys_copy_range(*src, src_offset, *dst, dst_offset, length, 
+                           req->credentials, &resp_copy, hints);
+  if (rc == 0) {
+    if (resp_copy.total_copied != length) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "orangefs_s3_copy_range: short copy of %lld bytes.", 
+                   (long long)resp_copy.total_copied);
+      return -1;
+    }
+    return 0;
+  }
+  if (rc != -PVFS_EOPNOTSUPP) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_copy_range returned rc %d.", rc);
+    return -1;
+  }
+
+  memset(&io, 0, sizeof(io));
+  io.buf = apr_palloc(req->pool, ORANGEFS_S3_IO_SIZE);
+
+  while (done < length) {
+    io.len = ORANGEFS_S3_IO_SIZE;
+    if ((PVFS_size)io.len > length - done) {
+      io.len = length - done;
+    }
+
+    io.offset = src_offset + done;
+    if (orangefs_s3_io_post(req, src, &io, PVFS_IO_READ, hints) < 0 ||
+        orangefs_s3_io_wait(&io) < 0) {
+      return -1;
+    }
+    if (io.resp_io.total_completed != io.len) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "orangefs_s3_copy_range: short read at %lld.", 
+                   (long long)io.offset);
+      return -1;
+    }
+
+    io.offset = dst_offset + done;
+    if (orangefs_s3_io_post(req, dst, &io, PVFS_IO_WRITE, hints) < 0 ||
+        orangefs_s3_io_wait(&io) < 0 ||
+        io.resp_io.total_completed != io.len) {
+      return -1;
+    }
+
+    done += io.len;
+  }
 
   return 0;
 }
@@ -568,19 +804,6 @@ static int orangefs_s3_authorized(orangefs_s3_request *req,
   return rc;
 }
 
-static int orangefs_s3_copy_object(orangefs_s3_request *req, 
-                                   char *bucket, 
-                                   char *path, 
-                                   char *source)
-{
-
-  if (debug_orangefs_s3) {
-    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL,"orangefs_s3_copy_object:");
-  }
-
-  return OK;
-}
-
 static int orangefs_s3_delete_object(orangefs_s3_request *req, 
                                      char *bucket, 
                                      char *path)
@@ -668,317 +891,1256 @@ static PVFS_object_ref * orangefs_s3_mkdir_p(orangefs_s3_request *req,
     entry_name = apr_pstrdup(req->pool, path + 1);
   }
 
-  /* make the parent, recursively */
-  parent_ref = orangefs_s3_mkdir_p(req, fsid, parent_path);
-  if (!parent_ref) {
-    return NULL;
-  }
+  /* make the parent, recursively */
+  parent_ref = orangefs_s3_mkdir_p(req, fsid, parent_path);
+  if (!parent_ref) {
+    return NULL;
+  }
+
+  /* now make the entry */
+  attr.owner = req->credentials->userid;
+  attr.group = req->credentials->group_array[0];
+  attr.perms = mode;
+  attr.mask = (PVFS_ATTR_SYS_ALL_SETABLE);
+
+  memset(&mkdir_response, 0, sizeof(PVFS_sysresp_mkdir));
+  rc = PVFS_sys_mkdir(entry_name, *parent_ref, attr, 
+                      req->credentials, &mkdir_response, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_mkdir() returned %d.", rc);
+    return NULL;
+  }
+
+  /* assign the S3 owner attributes */
+  key.buffer = (void*) apr_pstrdup(req->pool, EXT_ATTR_S3_OWNER_ID);
+  key.buffer_sz = strlen(key.buffer) + 1;
+  val.buffer = apr_pcalloc(req->pool, BUFSIZ);
+  sprintf(val.buffer, "%d", req->credentials->userid);
+  val.buffer_sz = strlen(val.buffer) + 1;
+
+  rc = PVFS_sys_seteattr(mkdir_response.ref, req->credentials, 
+                         &key, &val, 0, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_seteattr() for owner id returned rc %d.", rc);
+  }
+
+  key.buffer = (void*)EXT_ATTR_S3_OWNER_DISPLAY_NAME;
+  key.buffer_sz = strlen(key.buffer) + 1;
+  val.buffer = req->cn;
+  val.buffer_sz = strlen(val.buffer) + 1;
+
+  rc = PVFS_sys_seteattr(mkdir_response.ref, req->credentials, 
+                         &key, &val, 0, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_seteattr() for owner display name returned rc %d.", 
+                 rc);
+  }
+
+  rc = PVFS_sys_lookup(fsid, path, req->credentials, resp_lookup, 
+                       PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  if (rc == 0) {
+    return &resp_lookup->ref;
+  }
+
+  return NULL;
+}
+
+/*
+   Splits an object path within a bucket into the PVFS2 path of its 
+   parent directory and its entry name.
+ */
+static void orangefs_s3_split_path(orangefs_s3_request *req, 
+                                   char *bucket, 
+                                   char *path, 
+                                   char **parent_path, 
+                                   char **entry_name)
+{
+  char *ptr;
+
+  *parent_path = 
+    apr_pstrcat(req->pool, req->conf->pvfs_path, "/", bucket, NULL);
+
+  /* walk backwards from the end to find the last '/' */
+  for (ptr = path + strlen(path) -1; (ptr > path) && (*ptr != '/'); ptr--);
+
+  if (ptr > path) {
+    *entry_name = apr_pstrdup(req->pool, ptr + 1);
+    *parent_path = apr_pstrcat(req->pool, *parent_path, 
+                               apr_pstrndup(req->pool, path, 
+                               (ptr - path)), NULL);
+  } else {
+    *entry_name = apr_pstrdup(req->pool, path + 1);
+  }
+}
+
+/*
+   Creates an empty object named entry_name in the parent directory.
+  
+   Returns 0 on success, a negative PVFS2 error otherwise.
+ */
+static int orangefs_s3_create_object(orangefs_s3_request *req, 
+                                     PVFS_object_ref *parent_ref, 
+                                     char *entry_name, 
+                                     PVFS_hint hints, 
+                                     PVFS_object_ref *ref)
+{
+  PVFS_sysresp_create resp_create;
+  PVFS_sys_dist *new_dist = NULL;
+  PVFS_sys_attr attr;
+  int rc;
+
+  /* fill out our attr */
+  memset(&attr, 0, sizeof(PVFS_sys_attr));
+  attr.owner = req->credentials->userid;
+  attr.group = req->credentials->group_array[0];
+  attr.perms = 256;
+  attr.mask = (PVFS_ATTR_SYS_ALL_SETABLE);
+  attr.dfile_count = 0;
+
+  memset(&resp_create, 0, sizeof(PVFS_sysresp_create));
+  rc = PVFS_sys_create(entry_name, *parent_ref, attr, req->credentials, 
+                       new_dist, &resp_create, NULL, hints);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_create of %s returned %d.", entry_name, rc);
+    return rc;
+  }
+
+  *ref = resp_create.ref;
+  return 0;
+}
+
+/*
+   Sets a string valued extended attribute on a PVFS2 object.
+ */
+static int orangefs_s3_set_xattr(orangefs_s3_request *req, 
+                                 PVFS_object_ref *ref, 
+                                 const char *name, 
+                                 const char *value)
+{
+  PVFS_ds_keyval key, val;
+  int rc;
+
+  key.buffer = apr_pstrdup(req->pool, name);
+  key.buffer_sz = strlen(key.buffer) + 1;
+  val.buffer = apr_pstrdup(req->pool, value);
+  val.buffer_sz = strlen(val.buffer) + 1;
+
+  rc = PVFS_sys_seteattr(*ref, req->credentials, &key, &val, 0, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_seteattr() for %s returned rc %d.", name, rc);
+  }
+
+  return rc;
+}
+
+/*
+   Reads a string valued extended attribute of a PVFS2 object into
+   *value, allocated from the request pool.
+ */
+static int orangefs_s3_get_xattr(orangefs_s3_request *req, 
+                                 PVFS_object_ref *ref, 
+                                 const char *name, 
+                                 char **value)
+{
+  PVFS_ds_keyval key, val;
+  int rc;
+
+  key.buffer = apr_pstrdup(req->pool, name);
+  key.buffer_sz = strlen(key.buffer) + 1;
+  val.buffer = apr_pcalloc(req->pool, 4096 + 1);
+  val.buffer_sz = 4096;
+
+  rc = PVFS_sys_geteattr(*ref, req->credentials, &key, &val, NULL);
+  if (rc < 0) {
+    return rc;
+  }
+
+  *value = val.buffer;
+  return 0;
+}
+
+/*
+   Records the S3 entity tag, size and owner of a newly written object.
+ */
+static void orangefs_s3_set_object_attrs(orangefs_s3_request *req, 
+                                         PVFS_object_ref *ref, 
+                                         const char *etag, 
+                                         size_t size)
+{
+  orangefs_s3_set_xattr(req, ref, EXT_ATTR_S3_ENTITY_TAG, etag);
+  orangefs_s3_set_xattr(req, ref, EXT_ATTR_S3_SIZE, 
+                        apr_psprintf(req->pool, "%lu", (unsigned long)size));
+  orangefs_s3_set_xattr(req, ref, EXT_ATTR_S3_OWNER_ID, 
+                        apr_psprintf(req->pool, "%d", 
+                                     req->credentials->userid));
+  if (req->cn) {
+    orangefs_s3_set_xattr(req, ref, EXT_ATTR_S3_OWNER_DISPLAY_NAME, req->cn);
+  }
+}
+
+static int orangefs_s3_put_object(orangefs_s3_request *req, 
+                                  char *bucket, 
+                                  char *path)
+{
+  char *entry_name, *parent_path, *entry_path;
+  PVFS_sysresp_lookup resp_lookup;
+  PVFS_object_ref *parent_ref;
+  PVFS_object_ref ref;
+  PVFS_hint hints = NULL;
+  unsigned char md5[APR_MD5_DIGESTSIZE];
+  char *etag;
+  size_t size = 0;
+  int existed = 0;
+  int rc;
+
+  if (debug_orangefs_s3) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "orangefs_s3_put_object for bucket %s path %s.", bucket, path);
+  }
+
+  PVFS_hint_import_env(&hints);
+
+  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
+                           bucket, path, NULL);
+
+  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->credentials, 
+                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  if (rc == 0) {
+    /* file already exists */
+    ref = resp_lookup.ref;
+    existed = 1;
+  } else {
+    /* does not exist, need to create it */
+    orangefs_s3_split_path(req, bucket, path, &parent_path, &entry_name);
+
+    parent_ref = orangefs_s3_mkdir_p(req, req->conf->fsid, parent_path);
+    if (parent_ref == NULL) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "Unable to get or create parent directory %s", parent_path);
+      PVFS_hint_free(&hints);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    /* need to create the entry */
+    rc = orangefs_s3_create_object(req, parent_ref, entry_name, hints, &ref);
+    if (rc < 0) {
+      PVFS_hint_free(&hints);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+  }
+
+  /* now we need to write the PUT/POST data */
+  memset(md5, 0, APR_MD5_DIGESTSIZE);
+  rc = orangefs_s3_write_post_data_ref(req, &ref, hints, 0, &size, md5);
+  if (rc == 0 && existed) {
+    /* drop whatever was past the end of the new contents */
+    rc = PVFS_sys_truncate(ref, size, req->credentials, hints);
+    if (rc < 0) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "PVFS_sys_truncate returned rc %d.", rc);
+    }
+  }
+  PVFS_hint_free(&hints);
+  if (rc < 0) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+
+  etag = orangefs_s3_bin_to_hex(req->pool, md5, APR_MD5_DIGESTSIZE);
+
+  /* write out etag response header */
+  apr_table_setn(req->r->headers_out, "ETag", 
+                 apr_pstrcat(req->pool, "\"", etag, "\"", NULL));
+
+  orangefs_s3_set_object_attrs(req, &ref, etag, size);
+
+  return OK;
+}
+
+/*
+   Parses a "bytes=first-last", "bytes=first-" or "bytes=-suffix" Range
+   header against an object of size bytes.
+  
+   Returns 1 and the range to send, 0 if the header should be ignored and
+   the whole object sent, or -1 if the range can not be satisfied.
+ */
+static int orangefs_s3_parse_range(const char *range, 
+                                   PVFS_size size, 
+                                   PVFS_offset *first, 
+                                   PVFS_size *length)
+{
+  const char *ptr;
+  char *end;
+  apr_int64_t start, last;
+
+  if (strncasecmp(range, "bytes=", 6) != 0) {
+    return 0;
+  }
+  ptr = range + 6;
+  while (apr_isspace(*ptr)) {
+    ptr++;
+  }
+
+  /* several ranges need a multipart response; let httpd's byterange 
+     filter cut those out of the whole object */
+  if (strchr(ptr, ',')) {
+    return 0;
+  }
+
+  if (*ptr == '-') {
+    /* the last 'suffix' bytes */
+    last = apr_strtoi64(ptr + 1, &end, 10);
+    if (end == ptr + 1 || *end != '\0' || last < 0) {
+      return 0;
+    }
+    if (last == 0 || size == 0) {
+      return -1;
+    }
+    if (last > size) {
+      last = size;
+    }
+    *first = size - last;
+    *length = last;
+    return 1;
+  }
+
+  start = apr_strtoi64(ptr, &end, 10);
+  if (end == ptr || *end != '-' || start < 0) {
+    return 0;
+  }
+  ptr = end + 1;
+  if (*ptr == '\0') {
+    last = size - 1;
+  } else {
+    last = apr_strtoi64(ptr, &end, 10);
+    if (end == ptr || *end != '\0' || last < start) {
+      return 0;
+    }
+  }
+
+  if (start >= size) {
+    return -1;
+  }
+  if (last >= size) {
+    last = size - 1;
+  }
+
+  *first = start;
+  *length = last - start + 1;
+  return 1;
+}
+
+/*
+   Sends length bytes of a PVFS2 object starting at offset to the client.
+   Each ORANGEFS_S3_IO_SIZE buffer is handed to the output filters in a heap
+   bucket, without copying, while the next one is being read.
+  
+   Returns 0 on success, -1 if nothing could be sent, or 1 if the response 
+   was cut short after data had gone out.
+ */
+static int orangefs_s3_send_object(orangefs_s3_request *req, 
+                                   PVFS_object_ref *ref, 
+                                   PVFS_hint hints, 
+                                   PVFS_offset offset, 
+                                   PVFS_size length)
+{
+  apr_bucket_alloc_t *ba = req->r->connection->bucket_alloc;
+  apr_bucket_brigade *bb;
+  apr_bucket *b;
+  apr_status_t status;
+  orangefs_s3_io io[2];
+  apr_size_t done;
+  int cur = 0;
+  int sent = 0;
+  int rc = 0;
+
+  memset(io, 0, sizeof(io));
+  bb = apr_brigade_create(req->r->pool, ba);
+
+  /* start the first read */
+  if (length > 0) {
+    io[cur].len = (length < ORANGEFS_S3_IO_SIZE) ? 
+                  (apr_size_t)length : ORANGEFS_S3_IO_SIZE;
+    io[cur].buf = malloc(io[cur].len);
+    io[cur].offset = offset;
+    if (!io[cur].buf || 
+        orangefs_s3_io_post(req, ref, &io[cur], PVFS_IO_READ, hints) < 0) {
+      free(io[cur].buf);
+      return -1;
+    }
+  }
+
+  while (io[cur].pending) {
+    orangefs_s3_io *next = &io[1 - cur];
+
+    if (orangefs_s3_io_wait(&io[cur]) < 0) {
+      free(io[cur].buf);
+      rc = -1;
+      break;
+    }
+
+    done = io[cur].resp_io.total_completed;
+    if (done == 0) {
+      /* the object got shorter since we looked at it */
+      free(io[cur].buf);
+      rc = -1;
+      break;
+    }
+    offset += done;
+    length -= done;
+
+    /* start reading the next buffer before sending this one */
+    if (length > 0) {
+      next->len = (length < ORANGEFS_S3_IO_SIZE) ? 
+                  (apr_size_t)length : ORANGEFS_S3_IO_SIZE;
+      next->buf = malloc(next->len);
+      next->offset = offset;
+      if (!next->buf || 
+          orangefs_s3_io_post(req, ref, next, PVFS_IO_READ, hints) < 0) {
+        free(next->buf);
+        next->buf = NULL;
+        rc = -1;
+      }
+    }
+
+    /* the brigade frees the buffer once it has been sent */
+    b = apr_bucket_heap_create(io[cur].buf, done, free, ba);
+    io[cur].buf = NULL;
+    APR_BRIGADE_INSERT_TAIL(bb, b);
+    status = ap_pass_brigade(req->r->output_filters, bb);
+    apr_brigade_cleanup(bb);
+    sent = 1;
+
+    if (status != APR_SUCCESS) {
+      /* the client went away; finish the read in flight and stop */
+      ap_log_error(APLOG_MARK,APLOG_ERR,status,NULL, 
+                   "orangefs_s3_send_object: ap_pass_brigade failed.");
+      if (next->pending) {
+        orangefs_s3_io_wait(next);
+      }
+      free(next->buf);
+      return 1;
+    }
+    if (rc < 0) {
+      break;
+    }
+
+    cur = 1 - cur;
+  }
+
+  if (rc < 0) {
+    return sent ? 1 : -1;
+  }
+
+  b = apr_bucket_eos_create(ba);
+  APR_BRIGADE_INSERT_TAIL(bb, b);
+  ap_pass_brigade(req->r->output_filters, bb);
+  apr_brigade_cleanup(bb);
+
+  return 0;
+}
+
+static int orangefs_s3_get_object(orangefs_s3_request *req, 
+                                  char *bucket, 
+                                  char *path)
+{
+  char *entry_path;
+  PVFS_sysresp_lookup resp_lookup;
+  PVFS_sysresp_getattr resp_getattr;
+  PVFS_object_ref *ref;
+  PVFS_hint hints = NULL;
+  PVFS_offset first = 0;
+  PVFS_size size, length;
+  const char *range;
+  char *etag;
+  int rc;
+
+  if (debug_orangefs_s3) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "orangefs_s3_get_object for bucket %s path %s.", bucket, path);
+  }
+
+  if (req->params) {
+    apr_array_header_t *arr;
+
+    arr = apr_hash_get(req->params, "acl", APR_HASH_KEY_STRING);
+    if (arr) {
+    }
+
+    arr = apr_hash_get(req->params, "torrent", APR_HASH_KEY_STRING);
+    if (arr) {
+    }
+  }
+
+  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
+                           bucket, path, NULL);
+
+  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->root, 
+                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+
+  if (rc < 0) {
+    /* no such file */
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_lookup for %s returned %d.", entry_path, rc);
+    return HTTP_NOT_FOUND;
+  }
+
+  ref = &resp_lookup.ref;
+
+  memset(&resp_getattr, 0, sizeof(PVFS_sysresp_getattr));
+  rc = PVFS_sys_getattr(*ref, PVFS_ATTR_SYS_SIZE, req->credentials, 
+                        &resp_getattr, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_getattr for %s returned %d.", entry_path, rc);
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+  size = resp_getattr.attr.size;
+  length = size;
+
+  if (orangefs_s3_get_xattr(req, ref, EXT_ATTR_S3_ENTITY_TAG, &etag) >= 0) {
+    apr_table_setn(req->r->headers_out, "ETag", 
+                   apr_pstrcat(req->pool, "\"", etag, "\"", NULL));
+  }
+
+  apr_table_setn(req->r->headers_out, "Accept-Ranges", "bytes");
+
+  /* send only the part of the object asked for, if any */
+  range = apr_table_get(req->r->headers_in, "Range");
+  if (range) {
+    rc = orangefs_s3_parse_range(range, size, &first, &length);
+    if (rc < 0) {
+      apr_table_setn(req->r->headers_out, "Content-Range", 
+                     apr_psprintf(req->pool, "bytes */%" APR_INT64_T_FMT, 
+                                  (apr_int64_t)size));
+      return HTTP_RANGE_NOT_SATISFIABLE;
+    }
+    if (rc > 0) {
+      req->r->status = HTTP_PARTIAL_CONTENT;
+      apr_table_setn(req->r->headers_out, "Content-Range", 
+                     apr_psprintf(req->pool, "bytes %" APR_INT64_T_FMT "-%" 
+                                  APR_INT64_T_FMT "/%" APR_INT64_T_FMT, 
+                                  (apr_int64_t)first, 
+                                  (apr_int64_t)(first + length - 1), 
+                                  (apr_int64_t)size));
+    }
+  }
+
+  ap_set_content_length(req->r, length);
+
+  /* if it's a HEAD request, return without content */
+  if (req->r->header_only) {
+    return OK;
+  }
+
+  PVFS_hint_import_env(&hints);
+  rc = orangefs_s3_send_object(req, ref, hints, first, length);
+  PVFS_hint_free(&hints);
+  if (rc < 0) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+  if (rc > 0) {
+    /* the length we promised was not sent; don't reuse the connection */
+    req->r->connection->keepalive = AP_CONN_CLOSE;
+  }
+
+  return OK;
+}
+
+/*
+   Returns the first value of a query string parameter, or NULL.
+ */
+static char *orangefs_s3_param(orangefs_s3_request *req, const char *name)
+{
+  apr_array_header_t *arr;
+
+  if (req->params == NULL) {
+    return NULL;
+  }
+
+  arr = apr_hash_get(req->params, name, APR_HASH_KEY_STRING);
+  if (arr == NULL || arr->nelts < 1) {
+    return NULL;
+  }
+
+  return ((char **)arr->elts)[0];
+}
+
+static int orangefs_s3_error(orangefs_s3_request *req, 
+                             int status, 
+                             const char *code, 
+                             const char *message, 
+                             const char *resource)
+{
+  ap_rprintf(req->r, "<Error>");
+  ap_rprintf(req->r, "  <Code>%s</Code>", code);
+  ap_rprintf(req->r, "  <Message>%s</Message>", message);
+  ap_rprintf(req->r, "  <Resource>%s</Resource>", resource);
+  ap_rprintf(req->r, "</Error>");
+
+  return status;
+}
+
+/*
+   Copies the object named by the x-amz-copy-source header, 
+   "[/]bucket/key", to bucket and path (PUT with x-amz-copy-source).  The 
+   data is copied by the IO servers where the layouts allow it.
+ */
+static int orangefs_s3_copy_object(orangefs_s3_request *req, 
+                                   char *bucket, 
+                                   char *path, 
+                                   char *source)
+{
+  char *src_bucket, *src_path, *entry_name, *parent_path, *entry_path;
+  char *etag, *ptr;
+  PVFS_sysresp_lookup resp_lookup;
+  PVFS_sysresp_getattr resp_getattr;
+  PVFS_object_ref *parent_ref;
+  PVFS_object_ref src_ref, ref;
+  PVFS_hint hints = NULL;
+  PVFS_size size;
+  char scratch_time[26];
+  struct tm *time;
+  int existed = 0;
+  int rc;
+
+  if (debug_orangefs_s3) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "orangefs_s3_copy_object for bucket %s path %s from %s.", 
+                 bucket, path, source);
+  }
+
+  /* "[/]bucket/key[?versionId=...]", url encoded */
+  src_bucket = apr_pstrdup(req->pool, source);
+  if ((ptr = strchr(src_bucket, '?'))) {
+    *ptr = '\0';
+  }
+  ap_unescape_url(src_bucket);
+  while (*src_bucket == '/') {
+    src_bucket++;
+  }
+  ptr = strchr(src_bucket, '/');
+  if (ptr == NULL || *src_bucket == '\0' || ptr[1] == '\0') {
+    return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidArgument", 
+                             "Copy Source must mention the source bucket "
+                             "and key.", source);
+  }
+  src_path = apr_pstrdup(req->pool, ptr);
+  *ptr = '\0';
+
+  PVFS_hint_import_env(&hints);
+
+  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
+                           src_bucket, src_path, NULL);
+  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->credentials, 
+                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  if (rc < 0) {
+    PVFS_hint_free(&hints);
+    return orangefs_s3_error(req, HTTP_NOT_FOUND, "NoSuchKey", 
+                             "The specified key does not exist.", source);
+  }
+  src_ref = resp_lookup.ref;
+
+  memset(&resp_getattr, 0, sizeof(PVFS_sysresp_getattr));
+  rc = PVFS_sys_getattr(src_ref, PVFS_ATTR_SYS_ALL_NOHINT, req->credentials,
+                        &resp_getattr, NULL);
+  if (rc < 0 || resp_getattr.attr.objtype != PVFS_TYPE_METAFILE) {
+    PVFS_hint_free(&hints);
+    return orangefs_s3_error(req, HTTP_NOT_FOUND, "NoSuchKey", 
+                             "The specified key does not exist.", source);
+  }
+  size = resp_getattr.attr.size;
+
+  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
+                           bucket, path, NULL);
+
+  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->credentials, 
+                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  if (rc == 0) {
+    ref = resp_lookup.ref;
+    existed = 1;
+  } else {
+    orangefs_s3_split_path(req, bucket, path, &parent_path, &entry_name);
+
+    parent_ref = orangefs_s3_mkdir_p(req, req->conf->fsid, parent_path);
+    if (parent_ref == NULL) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "Unable to get or create parent directory %s", parent_path);
+      PVFS_hint_free(&hints);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    rc = orangefs_s3_create_object(req, parent_ref, entry_name, hints, &ref);
+    if (rc < 0) {
+      PVFS_hint_free(&hints);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+  }
+
+  /* copying an object onto itself only rewrites its attributes */
+  rc = 0;
+  if (ref.handle != src_ref.handle || ref.fs_id != src_ref.fs_id) {
+    if (existed) {
+      rc = PVFS_sys_truncate(ref, 0, req->credentials, hints);
+      if (rc < 0) {
+        ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                     "PVFS_sys_truncate returned rc %d.", rc);
+      }
+    }
+    if (rc == 0 && size > 0) {
+      rc = orangefs_s3_copy_range(req, &src_ref, 0, &ref, 0, size, hints);
+    }
+  }
+  PVFS_hint_free(&hints);
+  if (rc < 0) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+
+  /* same bytes, same MD5 */
+  if (orangefs_s3_get_xattr(req, &src_ref, EXT_ATTR_S3_ENTITY_TAG, 
+                            &etag) < 0) {
+    etag = "";
+  }
+  orangefs_s3_set_object_attrs(req, &ref, etag, (size_t)size);
+
+  time = localtime((const time_t*)&resp_getattr.attr.mtime);
+  strftime(scratch_time, 26, "%FT%H:%M:%S.000Z", time);
+
+  ap_rprintf(req->r, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+  ap_rprintf(req->r, "<CopyObjectResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">");
+  ap_rprintf(req->r,   "<LastModified>%s</LastModified>", scratch_time);
+  ap_rprintf(req->r,   "<ETag>&quot;%s&quot;</ETag>", etag);
+  ap_rprintf(req->r, "</CopyObjectResult>");
+
+  return OK;
+}
+
+/*
+   Multipart uploads
+
+   An upload in progress is an object named by its upload id in the 
+   bucket's ORANGEFS_S3_UPLOAD_DIR directory.  Part N is written straight 
+   into it at offset (N - 1) * S, where S is the size of part 1, so parts 
+   sent in parallel land where they belong and completing the upload is 
+   just a rename.  A part that arrives before part 1 has said what S is 
+   gets its own object, "<upload id>.<N>", and is copied into place when
+   the upload is completed.  As on S3, every part but the last must be the
+   same size.
+
+   Each part is recorded in an attribute of the upload object as 
+   "<size> <offset written at, or -1 if staged> <MD5 in hex>".
+ */
+
+/*
+   Finds the upload object for upload_id and checks that it belongs to the
+   object at path.
+ */
+static int orangefs_s3_lookup_upload(orangefs_s3_request *req, 
+                                     char *bucket, 
+                                     char *path, 
+                                     char *upload_id, 
+                                     PVFS_object_ref *dir_ref, 
+                                     PVFS_object_ref *ref)
+{
+  PVFS_sysresp_lookup resp_lookup;
+  char *dir_path, *key = NULL;
+  const char *ptr;
+  int rc;
+
+  /* the id is used as a file name, so it must be one we made */
+  for (ptr = upload_id; apr_isxdigit(*ptr); ptr++);
+  if (*ptr != '\0' || ptr == upload_id) {
+    return orangefs_s3_error(req, HTTP_NOT_FOUND, "NoSuchUpload", 
+                             "The specified upload does not exist.", path);
+  }
+
+  dir_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", bucket, 
+                         "/", ORANGEFS_S3_UPLOAD_DIR, NULL);
+
+  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+  rc = PVFS_sys_lookup(req->conf->fsid, dir_path, req->root, &resp_lookup,
+                       PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  if (rc == 0) {
+    *dir_ref = resp_lookup.ref;
+
+    memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+    rc = PVFS_sys_ref_lookup(req->conf->fsid, upload_id, *dir_ref, 
+                             req->root, &resp_lookup, 
+                             PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+  }
+  if (rc == 0) {
+    *ref = resp_lookup.ref;
+    rc = orangefs_s3_get_xattr(req, ref, EXT_ATTR_S3_UPLOAD_KEY, &key);
+  }
+  if (rc < 0 || strcmp(key, path) != 0) {
+    return orangefs_s3_error(req, HTTP_NOT_FOUND, "NoSuchUpload", 
+                             "The specified upload does not exist.", path);
+  }
+
+  return OK;
+}
+
+/*
+   Removes the staged parts, "<upload id>.<N>", of an upload.
+ */
+static void orangefs_s3_remove_staged_parts(orangefs_s3_request *req, 
+                                            PVFS_object_ref *dir_ref, 
+                                            char *upload_id)
+{
+  PVFS_sysresp_readdir resp_readdir;
+  PVFS_ds_position token = PVFS_READDIR_START;
+  apr_array_header_t *names;
+  char *prefix;
+  int prefix_len;
+  int i, rc;
+
+  prefix = apr_pstrcat(req->pool, upload_id, ".", NULL);
+  prefix_len = strlen(prefix);
+  names = apr_array_make(req->pool, 8, sizeof(char *));
+
+  /* collect the names first; removing them would upset the token */
+  do {
+    memset(&resp_readdir, 0, sizeof(PVFS_sysresp_readdir));
+    rc = PVFS_sys_readdir(*dir_ref, token, 60, req->root, 
+                          &resp_readdir, NULL);
+    if (rc < 0) {
+      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                   "PVFS_sys_readdir returned %d.", rc);
+      break;
+    }
+
+    for (i = 0; i < resp_readdir.pvfs_dirent_outcount; i++) {
+      if (strncmp(resp_readdir.dirent_array[i].d_name, 
+                  prefix, prefix_len) == 0) {
+        *(char **)apr_array_push(names) = 
+          apr_pstrdup(req->pool, resp_readdir.dirent_array[i].d_name);
+      }
+    }
+    free(resp_readdir.dirent_array);
 
-  /* now make the entry */
-  attr.owner = req->credentials->userid;
-  attr.group = req->credentials->group_array[0];
-  attr.perms = mode;
-  attr.mask = (PVFS_ATTR_SYS_ALL_SETABLE);
+    token = resp_readdir.token;
+  } while (token != PVFS_READDIR_END && resp_readdir.pvfs_dirent_outcount);
 
-  memset(&mkdir_response, 0, sizeof(PVFS_sysresp_mkdir));
-  rc = PVFS_sys_mkdir(entry_name, *parent_ref, attr, 
-                      req->credentials, &mkdir_response, NULL);
-  if (rc < 0) {
-    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "PVFS_sys_mkdir() returned %d.", rc);
-    return NULL;
+  for (i = 0; i < names->nelts; i++) {
+    PVFS_sys_remove(((char **)names->elts)[i], *dir_ref, 
+                    req->credentials, NULL);
   }
+}
 
-  /* assign the S3 owner attributes */
-  key.buffer = (void*) apr_pstrdup(req->pool, EXT_ATTR_S3_OWNER_ID);
-  key.buffer_sz = strlen(key.buffer) + 1;
-  val.buffer = apr_pcalloc(req->pool, BUFSIZ);
-  sprintf(val.buffer, "%d", req->credentials->userid);
-  val.buffer_sz = strlen(val.buffer) + 1;
+/*
+   Starts a multipart upload (POST ?uploads).
+ */
+static int orangefs_s3_initiate_upload(orangefs_s3_request *req, 
+                                       char *bucket, 
+                                       char *path)
+{
+  PVFS_object_ref *dir_ref;
+  PVFS_object_ref ref;
+  unsigned char id[16];
+  char *dir_path, *upload_id;
+  int rc;
 
-  rc = PVFS_sys_seteattr(mkdir_response.ref, req->credentials, 
-                         &key, &val, 0, NULL);
-  if (rc < 0) {
+  if (debug_orangefs_s3) {
     ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "PVFS_sys_seteattr() for owner id returned rc %d.", rc);
+                 "orangefs_s3_initiate_upload for bucket %s path %s.", 
+                 bucket, path);
   }
 
-  key.buffer = (void*)EXT_ATTR_S3_OWNER_DISPLAY_NAME;
-  key.buffer_sz = strlen(key.buffer) + 1;
-  val.buffer = req->cn;
-  val.buffer_sz = strlen(val.buffer) + 1;
+  dir_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", bucket, 
+                         "/", ORANGEFS_S3_UPLOAD_DIR, NULL);
+  dir_ref = orangefs_s3_mkdir_p(req, req->conf->fsid, dir_path);
+  if (dir_ref == NULL) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
 
-  rc = PVFS_sys_seteattr(mkdir_response.ref, req->credentials, 
-                         &key, &val, 0, NULL);
+  if (apr_generate_random_bytes(id, sizeof(id)) != APR_SUCCESS) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+  upload_id = orangefs_s3_bin_to_hex(req->pool, id, sizeof(id));
+
+  rc = orangefs_s3_create_object(req, dir_ref, upload_id, NULL, &ref);
   if (rc < 0) {
-    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "PVFS_sys_seteattr() for owner display name returned rc %d.", 
-                 rc);
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
 
-  rc = PVFS_sys_lookup(fsid, path, req->credentials, resp_lookup, 
-                       PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
-  if (rc == 0) {
-    return &resp_lookup->ref;
+  rc = orangefs_s3_set_xattr(req, &ref, EXT_ATTR_S3_UPLOAD_KEY, path);
+  if (rc < 0) {
+    PVFS_sys_remove(upload_id, *dir_ref, req->credentials, NULL);
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
 
-  return NULL;
+  ap_rprintf(req->r, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+  ap_rprintf(req->r, "<InitiateMultipartUploadResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">");
+  ap_rprintf(req->r,   "<Bucket>%s</Bucket>", bucket);
+  ap_rprintf(req->r,   "<Key>%s</Key>", path + 1);
+  ap_rprintf(req->r,   "<UploadId>%s</UploadId>", upload_id);
+  ap_rprintf(req->r, "</InitiateMultipartUploadResult>");
+
+  return OK;
 }
 
-static int orangefs_s3_put_object(orangefs_s3_request *req, 
-                                  char *bucket, 
-                                  char *path)
+/*
+   Writes one part of a multipart upload (PUT ?partNumber=N&uploadId=ID).
+ */
+static int orangefs_s3_upload_part(orangefs_s3_request *req, 
+                                   char *bucket, 
+                                   char *path, 
+                                   char *upload_id, 
+                                   char *part_number)
 {
-  char *entry_name, *parent_path, *entry_path;
-  PVFS_sysresp_lookup resp_lookup;
-  PVFS_sysresp_create resp_create;
-  PVFS_object_ref *parent_ref;
-  PVFS_object_ref *ref;
-  PVFS_ds_keyval key, val;
-  PVFS_sys_dist *new_dist = NULL;
-  PVFS_sys_attr attr;
+  PVFS_object_ref dir_ref, ref, part_ref;
+  PVFS_object_ref *target;
   PVFS_hint hints = NULL;
+  PVFS_offset offset = -1;
+  apr_int64_t length, part_size = 0;
   unsigned char md5[APR_MD5_DIGESTSIZE];
-  char tmp[1024];
+  const char *content_length;
+  char *value, *etag, *part_name;
   size_t size = 0;
-  char *ptr;
-  int rc, i;
+  int part;
+  int rc;
 
   if (debug_orangefs_s3) {
     ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "orangefs_s3_put_object for bucket %s path %s.", bucket, path);
+                 "orangefs_s3_upload_part %s of %s for bucket %s path %s.", 
+                 part_number, upload_id, bucket, path);
   }
 
-  PVFS_hint_import_env(&hints);
+  part = atoi(part_number);
+  if (part < 1 || part > ORANGEFS_S3_MAX_PARTS) {
+    return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidArgument", 
+                             "Part number must be between 1 and 10000.", 
+                             path);
+  }
 
-  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
-                           bucket, path, NULL);
+  rc = orangefs_s3_lookup_upload(req, bucket, path, upload_id, 
+                                 &dir_ref, &ref);
+  if (rc != OK) {
+    return rc;
+  }
 
-  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
-  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->credentials, 
-                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
-  if (rc == 0) {
-    /* file already exists */
-    ref = &resp_lookup.ref;
-  } else {
-    /* does not exist, need to create it */
-    entry_name = apr_pstrdup(req->pool, path);
-    entry_name++;
-
-    /* fill out our attr */
-    attr.owner = req->credentials->userid;
-    attr.group = req->credentials->group_array[0];
-    attr.perms = 256;
-    attr.mask = (PVFS_ATTR_SYS_ALL_SETABLE);
-    attr.dfile_count = 0;
-
-    parent_path = 
-      apr_pstrcat(req->pool, req->conf->pvfs_path, "/", bucket, NULL);
-
-    /* walk backwards from the end to find the last '/' */
-    for (ptr = path + strlen(path) -1; (ptr > path) && (*ptr != '/'); ptr--);
-
-    if (ptr > path) {
-      entry_name = apr_pstrdup(req->pool, ptr + 1);
-      parent_path = apr_pstrcat(req->pool, parent_path, 
-                                apr_pstrndup(req->pool, path, 
-                                (ptr - path)), NULL);
-    } else {
-      entry_name = apr_pstrdup(req->pool, path + 1);
-    }
-    
-    parent_ref = orangefs_s3_mkdir_p(req, req->conf->fsid, parent_path);
-    if (parent_ref == NULL) {
-      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                   "Unable to get or create parent directory %s", parent_path);
-      return HTTP_INTERNAL_SERVER_ERROR;
-    }
+  content_length = apr_table_get(req->r->headers_in, "Content-Length");
+  if (content_length == NULL) {
+    return HTTP_LENGTH_REQUIRED;
+  }
+  length = apr_atoi64(content_length);
 
-    /* need to create the entry */
-    rc = PVFS_sys_create(entry_name, *parent_ref, attr, req->credentials, 
-                         new_dist, &resp_create, NULL, hints);
+  /* part 1 says how big all the others but the last are */
+  if (part == 1) {
+    part_size = length;
+    rc = orangefs_s3_set_xattr(req, &ref, EXT_ATTR_S3_UPLOAD_PART_SIZE, 
+                               apr_psprintf(req->pool, "%" APR_INT64_T_FMT,
+                                            part_size));
     if (rc < 0) {
-      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                   "PVFS_sys_create returned %d.", rc);
       return HTTP_INTERNAL_SERVER_ERROR;
     }
-
-    ref = &resp_create.ref;
+  } else if (orangefs_s3_get_xattr(req, &ref, EXT_ATTR_S3_UPLOAD_PART_SIZE,
+                                   &value) == 0) {
+    part_size = apr_atoi64(value);
+    if (length > part_size) {
+      return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidPart", 
+                               "All parts but the last must be the size "
+                               "of part 1.", path);
+    }
   }
 
-  /* now we need to write the PUT/POST data */
-  memset(md5, 0, APR_MD5_DIGESTSIZE);
-  rc = orangefs_s3_write_post_data_ref(req, ref, hints, &size, md5);
+  PVFS_hint_import_env(&hints);
 
-  /* convert md5sum to hex string */
-  {
-    char hexval[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 
-                        'a', 'b', 'c', 'd', 'e', 'f' };
-  
-    memset(tmp, 0, APR_MD5_DIGESTSIZE*2+1); 
-    for (i = 0; i < APR_MD5_DIGESTSIZE; i++) {
-      tmp[i*2] = hexval[(md5[i] >> 4) & 0xf];
-      tmp[(i*2)+1] = hexval[md5[i] & 0x0f];
+  if (part == 1 || part_size > 0) {
+    /* straight into place */
+    offset = (PVFS_offset)(part - 1) * part_size;
+    target = &ref;
+  } else {
+    /* we don't know where it goes yet; keep it on the side */
+    part_name = apr_psprintf(req->pool, "%s.%d", upload_id, part);
+    PVFS_sys_remove(part_name, dir_ref, req->credentials, NULL);
+    rc = orangefs_s3_create_object(req, &dir_ref, part_name, hints, 
+                                   &part_ref);
+    if (rc < 0) {
+      PVFS_hint_free(&hints);
+      return HTTP_INTERNAL_SERVER_ERROR;
     }
+    target = &part_ref;
   }
 
-  key.buffer = (void*)EXT_ATTR_S3_ENTITY_TAG;
-  key.buffer_sz = strlen(key.buffer) + 1;
-  val.buffer = tmp;
-  val.buffer_sz = strlen(val.buffer) + 1;
-
-  rc = PVFS_sys_seteattr(*ref, req->credentials, &key, &val, 0, NULL);
+  memset(md5, 0, APR_MD5_DIGESTSIZE);
+  rc = orangefs_s3_write_post_data_ref(req, target, hints, 
+                                       (offset < 0) ? 0 : offset, 
+                                       &size, md5);
+  PVFS_hint_free(&hints);
   if (rc < 0) {
-
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
- 
-  /* write out etag response header */
-  apr_table_setn(req->r->headers_out, "ETag", 
-                 apr_pstrcat(req->pool, "\"", tmp, "\"", NULL));
-
-  key.buffer = (void*)EXT_ATTR_S3_SIZE;
-  key.buffer_sz = strlen(key.buffer) + 1;
-  sprintf(tmp, "%lu", size);
-  val.buffer = tmp;
-  val.buffer_sz = strlen(val.buffer) + 1;
-
-  rc = PVFS_sys_seteattr(*ref, req->credentials, &key, &val, 0, NULL);
-  if (rc < 0) {
-
+  if ((apr_int64_t)size != length) {
+    return orangefs_s3_error(req, HTTP_BAD_REQUEST, "IncompleteBody", 
+                             "The request body is not Content-Length "
+                             "bytes long.", path);
   }
 
-  key.buffer = (void*)EXT_ATTR_S3_OWNER_ID;
-  key.buffer_sz = strlen(key.buffer) + 1;
-  val.buffer = apr_pcalloc(req->pool, BUFSIZ);
-  sprintf(val.buffer, "%d", req->credentials->userid);
-  val.buffer_sz = strlen(val.buffer) + 1;
+  etag = orangefs_s3_bin_to_hex(req->pool, md5, APR_MD5_DIGESTSIZE);
 
-  rc = PVFS_sys_seteattr(*ref, req->credentials, &key, &val, 0, NULL);
+  rc = orangefs_s3_set_xattr(req, &ref, 
+                             apr_psprintf(req->pool, "%s%d", 
+                                          EXT_ATTR_S3_UPLOAD_PART, part),
+                             apr_psprintf(req->pool, "%lu %" 
+                                          APR_INT64_T_FMT " %s", 
+                                          (unsigned long)size, 
+                                          (apr_int64_t)offset, etag));
   if (rc < 0) {
-
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
 
-  key.buffer = (void*)EXT_ATTR_S3_OWNER_DISPLAY_NAME;
-  key.buffer_sz = strlen(key.buffer) + 1;
-  val.buffer = req->cn;
-  val.buffer_sz = strlen(val.buffer) + 1;
-
-  rc = PVFS_sys_seteattr(*ref, req->credentials, &key, &val, 0, NULL);
-  if (rc < 0) {
-
-  }
+  apr_table_setn(req->r->headers_out, "ETag", 
+                 apr_pstrcat(req->pool, "\"", etag, "\"", NULL));
 
   return OK;
 }
 
-static int orangefs_s3_get_object(orangefs_s3_request *req, 
-                                  char *bucket, 
-                                  char *path)
+/*
+   Finishes a multipart upload (POST ?uploadId=ID), putting the listed 
+   parts together as the object at path.
+ */
+static int orangefs_s3_complete_upload(orangefs_s3_request *req, 
+                                       char *bucket, 
+                                       char *path, 
+                                       char *upload_id)
 {
-  char *entry_path;
+  PVFS_object_ref dir_ref, ref, part_ref;
+  PVFS_object_ref *parent_ref;
   PVFS_sysresp_lookup resp_lookup;
-  PVFS_Request mem_req, file_req;
-  PVFS_sysresp_io resp_io;
-  PVFS_object_ref *ref;
+  PVFS_ds_keyval key;
   PVFS_hint hints = NULL;
-  PVFS_ds_keyval k, v;
-  char buffer[4096];
-  char buffer2[256];
-  size_t offset = 0;
-  int rc;
+  apr_array_header_t *parts;
+  apr_md5_ctx_t md5_ctx;
+  unsigned char md5[APR_MD5_DIGESTSIZE];
+  apr_int64_t part_size, size, written, offset = 0;
+  char *body, *ptr, *value, *etag, *parent_path, *entry_name;
+  char hex[APR_MD5_DIGESTSIZE * 2 + 1];
+  apr_size_t body_sz;
+  int part, prev = 0;
+  int i, j, rc;
 
   if (debug_orangefs_s3) {
     ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "orangefs_s3_get_object for bucket %s path %s.", bucket, path);
+                 "orangefs_s3_complete_upload %s for bucket %s path %s.", 
+                 upload_id, bucket, path);
   }
 
-  if (req->params) {
-    apr_array_header_t *arr;
+  rc = orangefs_s3_lookup_upload(req, bucket, path, upload_id, 
+                                 &dir_ref, &ref);
+  if (rc != OK) {
+    return rc;
+  }
 
-    arr = apr_hash_get(req->params, "acl", APR_HASH_KEY_STRING);
-    if (arr) {
+  /* the body lists the parts to use, in order */
+  if (!orangefs_s3_load_post_data(req->r, &body, &body_sz) || !body) {
+    return orangefs_s3_error(req, HTTP_BAD_REQUEST, "MalformedXML", 
+                             "The list of parts is missing.", path);
+  }
+  parts = apr_array_make(req->pool, 16, sizeof(int));
+  for (ptr = strstr(body, "<PartNumber>"); ptr; 
+       ptr = strstr(ptr, "<PartNumber>")) {
+    ptr += strlen("<PartNumber>");
+    part = atoi(ptr);
+    if (part <= prev) {
+      return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidPartOrder", 
+                               "The list of parts was not in ascending "
+                               "order.", path);
     }
+    *(int *)apr_array_push(parts) = part;
+    prev = part;
+  }
+  if (parts->nelts == 0 || 
+      orangefs_s3_get_xattr(req, &ref, EXT_ATTR_S3_UPLOAD_PART_SIZE, 
+                            &value) < 0) {
+    return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidPart", 
+                             "Part 1 has not been uploaded.", path);
+  }
+  part_size = apr_atoi64(value);
 
-    arr = apr_hash_get(req->params, "torrent", APR_HASH_KEY_STRING);
-    if (arr) {
+  PVFS_hint_import_env(&hints);
+  apr_md5_init(&md5_ctx);
+
+  for (i = 0; i < parts->nelts; i++) {
+    part = ((int *)parts->elts)[i];
+
+    if (orangefs_s3_get_xattr(req, &ref, 
+                              apr_psprintf(req->pool, "%s%d", 
+                                           EXT_ATTR_S3_UPLOAD_PART, part),
+                              &value) < 0 || 
+        sscanf(value, "%" APR_INT64_T_FMT " %" APR_INT64_T_FMT " %32s", 
+               &size, &written, hex) != 3 || 
+        strlen(hex) != APR_MD5_DIGESTSIZE * 2) {
+      PVFS_hint_free(&hints);
+      return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidPart", 
+                               "One or more of the parts could not be "
+                               "found.", path);
     }
-  }
 
-  entry_path = apr_pstrcat(req->pool, req->conf->pvfs_path, "/", 
-                           bucket, path, NULL);
+    /* every part but the last is the same size, so each one can only 
+       go in one place */
+    if (size > part_size || 
+        (i < parts->nelts - 1 && size != part_size) ||
+        (written >= 0 && written != offset) ||
+        offset != (apr_int64_t)(part - 1) * part_size) {
+      PVFS_hint_free(&hints);
+      return orangefs_s3_error(req, HTTP_BAD_REQUEST, "InvalidPart", 
+                               "All parts but the last must be the size "
+                               "of part 1, with none missing.", path);
+    }
 
-  memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
-  rc = PVFS_sys_lookup(req->conf->fsid, entry_path, req->root, 
-                       &resp_lookup, PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+    if (written < 0) {
+      /* staged before we knew where it went; copy it in now */
+      memset(&resp_lookup, 0, sizeof(PVFS_sysresp_lookup));
+      rc = PVFS_sys_ref_lookup(req->conf->fsid, 
+                               apr_psprintf(req->pool, "%s.%d", 
+                                            upload_id, part), 
+                               dir_ref, req->root, &resp_lookup, 
+                               PVFS2_LOOKUP_LINK_NO_FOLLOW, NULL);
+      part_ref = resp_lookup.ref;
+      if (rc < 0 || 
+          orangefs_s3_copy_range(req, &part_ref, 0, &ref, offset, size, 
+                                 hints) < 0) {
+        PVFS_hint_free(&hints);
+        return HTTP_INTERNAL_SERVER_ERROR;
+      }
+    }
+
+    /* the entity tag is the MD5 of the parts' MD5s */
+    for (j = 0; j < APR_MD5_DIGESTSIZE; j++) {
+      unsigned int byte;
+      sscanf(hex + j * 2, "%2x", &byte);
+      md5[j] = byte;
+    }
+    apr_md5_update(&md5_ctx, md5, APR_MD5_DIGESTSIZE);
+
+    offset += size;
+  }
 
+  rc = PVFS_sys_truncate(ref, offset, req->credentials, hints);
+  PVFS_hint_free(&hints);
   if (rc < 0) {
-    /* no such file */
     ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                 "PVFS_sys_lookup for %s returned %d.", entry_path, rc);
-    return HTTP_NOT_FOUND;
+                 "PVFS_sys_truncate returned rc %d.", rc);
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
 
-  ref = &resp_lookup.ref;
-  PVFS_hint_import_env(&hints);
+  apr_md5_final(md5, &md5_ctx);
+  etag = apr_psprintf(req->pool, "%s-%d", 
+                      orangefs_s3_bin_to_hex(req->pool, md5, 
+                                             APR_MD5_DIGESTSIZE), 
+                      parts->nelts);
+
+  /* drop the upload's bookkeeping before it becomes the object */
+  orangefs_s3_remove_staged_parts(req, &dir_ref, upload_id);
+  for (i = -2; i < parts->nelts; i++) {
+    if (i == -2) {
+      key.buffer = apr_pstrdup(req->pool, EXT_ATTR_S3_UPLOAD_KEY);
+    } else if (i == -1) {
+      key.buffer = apr_pstrdup(req->pool, EXT_ATTR_S3_UPLOAD_PART_SIZE);
+    } else {
+      key.buffer = apr_psprintf(req->pool, "%s%d", EXT_ATTR_S3_UPLOAD_PART,
+                                ((int *)parts->elts)[i]);
+    }
+    key.buffer_sz = strlen(key.buffer) + 1;
+    PVFS_sys_deleattr(ref, req->credentials, &key, NULL);
+  }
 
-  k.buffer = (void*)EXT_ATTR_S3_SIZE;
-  k.buffer_sz = strlen(k.buffer) + 1;
-  v.buffer = buffer;
-  v.buffer_sz = 4096;
+  /* and move it into place, replacing any object already there */
+  orangefs_s3_split_path(req, bucket, path, &parent_path, &entry_name);
+  parent_ref = orangefs_s3_mkdir_p(req, req->conf->fsid, parent_path);
+  if (parent_ref == NULL) {
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
+  PVFS_sys_remove(entry_name, *parent_ref, req->credentials, NULL);
 
-  memset(buffer, 0, 4096);
-  rc = PVFS_sys_geteattr(resp_lookup.ref, req->credentials, &k, &v, NULL);
-  if (rc >= 0) {
-    memset(buffer2, 0, 256);
-    memcpy(buffer2, buffer, v.read_sz);
-    apr_table_setn(req->r->headers_out, "Content-Length", 
-                   apr_pstrdup(req->pool, (char*)buffer2));
+  rc = PVFS_sys_rename(upload_id, dir_ref, entry_name, *parent_ref, 
+                       req->credentials, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_rename returned rc %d.", rc);
+    return HTTP_INTERNAL_SERVER_ERROR;
   }
 
-  k.buffer = (void*)EXT_ATTR_S3_ENTITY_TAG;
-  k.buffer_sz = strlen(k.buffer) + 1;
-  v.buffer = buffer;
-  v.buffer_sz = 4096;
+  orangefs_s3_set_object_attrs(req, &ref, etag, (size_t)offset);
 
-  memset(buffer, 0, 4096);
-  rc = PVFS_sys_geteattr(resp_lookup.ref, req->credentials, &k, &v, NULL);
-  if (rc >= 0) {
-    memset(buffer2, 0, 256);
-    memcpy(buffer2, buffer, v.read_sz);
-    apr_table_setn(req->r->headers_out, "ETag", 
-                   apr_pstrcat(req->pool, "\"", (char*)buffer2, "\"", NULL));
+  ap_rprintf(req->r, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+  ap_rprintf(req->r, "<CompleteMultipartUploadResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">");
+  ap_rprintf(req->r,   "<Bucket>%s</Bucket>", bucket);
+  ap_rprintf(req->r,   "<Key>%s</Key>", path + 1);
+  ap_rprintf(req->r,   "<ETag>&quot;%s&quot;</ETag>", etag);
+  ap_rprintf(req->r, "</CompleteMultipartUploadResult>");
+
+  return OK;
+}
+
+/*
+   Throws away a multipart upload (DELETE ?uploadId=ID).
+ */
+static int orangefs_s3_abort_upload(orangefs_s3_request *req, 
+                                    char *bucket, 
+                                    char *path, 
+                                    char *upload_id)
+{
+  PVFS_object_ref dir_ref, ref;
+  int rc;
+
+  if (debug_orangefs_s3) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "orangefs_s3_abort_upload %s for bucket %s path %s.", 
+                 upload_id, bucket, path);
   }
 
-  /* if it's a HEAD request, return without content */
-  if (strcmp(req->r->method, "HEAD") == 0) {
-    return OK;
+  rc = orangefs_s3_lookup_upload(req, bucket, path, upload_id, 
+                                 &dir_ref, &ref);
+  if (rc != OK) {
+    return rc;
   }
 
-  do {
-    file_req = PVFS_BYTE;
-    rc = PVFS_Request_contiguous(4096, PVFS_BYTE, &mem_req);
-    if (rc < 0) {
-      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                   "PVFS_Request_contiguous returned rc %d.", rc);
-      return HTTP_INTERNAL_SERVER_ERROR;
-    }
+  orangefs_s3_remove_staged_parts(req, &dir_ref, upload_id);
 
-    rc = PVFS_sys_read(*ref, file_req, offset, buffer, mem_req, 
-                       req->credentials, &resp_io, hints);
-    if (rc < 0) {
-      ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
-                   "PVFS_sys_read returned rc %d.", rc);
-      return HTTP_INTERNAL_SERVER_ERROR;
-    }
+  rc = PVFS_sys_remove(upload_id, dir_ref, req->credentials, NULL);
+  if (rc < 0) {
+    ap_log_error(APLOG_MARK,APLOG_ERR,0,NULL, 
+                 "PVFS_sys_remove returned %d.", rc);
+    return HTTP_INTERNAL_SERVER_ERROR;
+  }
 
-    offset += resp_io.total_completed;
+  return OK;
+}
 
-    ap_rwrite(buffer, resp_io.total_completed, req->r);
-  } while (resp_io.total_completed > 0);
+/*
+   Dispatches the multipart upload requests for an object.
+ */
+static int orangefs_s3_multipart(orangefs_s3_request *req, 
+                                 char *bucket, 
+                                 char *path)
+{
+  char *upload_id = orangefs_s3_param(req, "uploadId");
+  char *part_number = orangefs_s3_param(req, "partNumber");
 
-  PVFS_Request_free(&mem_req);
+  if (upload_id == NULL) {
+    if (req->r->method_number == M_POST) {
+      return orangefs_s3_initiate_upload(req, bucket, path);
+    }
+  } else if (req->r->method_number == M_PUT && part_number) {
+    return orangefs_s3_upload_part(req, bucket, path, upload_id, 
+                                   part_number);
+  } else if (req->r->method_number == M_POST) {
+    return orangefs_s3_complete_upload(req, bucket, path, upload_id);
+  } else if (req->r->method_number == M_DELETE) {
+    return orangefs_s3_abort_upload(req, bucket, path, upload_id);
+  }
 
-  return OK;
+  return HTTP_METHOD_NOT_ALLOWED;
 }
 
 static int orangefs_s3_get_bucket_acl(orangefs_s3_request *req, char *bucket)
@@ -1176,13 +2338,19 @@ static void orangefs_s3_get_bucket_recurse(orangefs_s3_request *req,
 
   listInfo = (orangefs_s3_s3_list *)userInfo;
 
-  ap_rprintf(req->r,   "<Contents>");
-
   /* the resource->pvfs_path includes the full bucket path as well, 
      so we need to strip that off */
   s3_path = strstr(resource->pvfs_path, listInfo->bucket) + 
             strlen(listInfo->bucket) + 1;
 
+  /* multipart uploads in progress are not objects yet */
+  if (strncmp(s3_path, ORANGEFS_S3_UPLOAD_DIR "/", 
+              strlen(ORANGEFS_S3_UPLOAD_DIR) + 1) == 0) {
+    return;
+  }
+
+  ap_rprintf(req->r,   "<Contents>");
+
   ap_rprintf(req->r,     "<Key>%s</Key>", s3_path);
 
   time = localtime((const time_t*)&resp_getattr.attr.ctime);
@@ -1699,7 +2867,10 @@ static int orangefs_s3(orangefs_s3_request *req)
                      "Processing s3 object request for bucket %s, object %s.", 
                      bucket, path);
 
-        if (req->r->method_number == M_GET) {
+        if (orangefs_s3_param(req, "uploads") || 
+            orangefs_s3_param(req, "uploadId")) {
+          rc = orangefs_s3_multipart(req, bucket, path);
+        } else if (req->r->method_number == M_GET) {
           rc = orangefs_s3_get_object(req, bucket, path);
         } else if (req->r->method_number == M_PUT) {
           rc = orangefs_s3_put_object(req, bucket, path);
@@ -1739,7 +2910,10 @@ static int orangefs_s3(orangefs_s3_request *req)
                    "Processing s3 object request for bucket %s, object %s.", 
                    bucket, req->r->uri);
 
-      if (req->r->method_number == M_GET) {
+      if (orangefs_s3_param(req, "uploads") || 
+          orangefs_s3_param(req, "uploadId")) {
+        rc = orangefs_s3_multipart(req, bucket, req->r->uri);
+      } else if (req->r->method_number == M_GET) {
         rc = orangefs_s3_get_object(req, bucket, req->r->uri);
       } else if (req->r->method_number == M_PUT) {
         /* check if this a PUT/copy or just a PUT by checking the 
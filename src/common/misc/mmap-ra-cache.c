@@ -7,6 +7,13 @@
 /* This file defines a hash table based cache for the RA_CACHE
  * which does readaheads.  It is only used in the client-core and
  * really this file should be in that directory.
+ *
+ * Each file's demand reads are tracked to detect forward, backward or
+ * fixed-stride access.  The client-core asks for the offsets to read
+ * ahead and keeps that many speculative reads in flight; the number of
+ * buffers (the window) starts at the configured read count, never goes
+ * below one stripe width and is doubled or halved as speculative
+ * buffers turn out to be used or evicted unread.
  */
 
 #include <stdlib.h>
@@ -26,6 +33,7 @@
 #include "gossip.h"
 #include "quicklist.h"
 #include "gen-locks.h"
+#include "pint-sysint-utils.h"
 #include "mmap-ra-cache.h"
 
 static int racache_buf_init(racache_t *racache);
@@ -42,6 +50,27 @@ static int hash_key_compare(const void *key, struct qlist_head *link);
 static void racache_init_buff(racache_buffer_t *buff);
 static void racache_init_file(racache_file_t *file);
 static void racache_buf_cull(racache_t *racache);
+static void racache_track_access(racache_file_t *file,
+                                 PVFS_size offset,
+                                 PVFS_size len);
+static void racache_spec_used(racache_buffer_t *buff);
+static void racache_spec_dropped(racache_buffer_t *buff);
+
+static struct PINT_perf_counter *racache_pc = NULL;
+
+static struct PINT_perf_key racache_keys[] =
+{
+    {"RACACHE_HITS", PERF_RACACHE_HITS, 0},
+    {"RACACHE_WAITS", PERF_RACACHE_WAITS, 0},
+    {"RACACHE_MISSES", PERF_RACACHE_MISSES, 0},
+    {"RACACHE_SPEC_READS", PERF_RACACHE_SPEC_READS, 0},
+    {"RACACHE_SPEC_BYTES", PERF_RACACHE_SPEC_BYTES, 0},
+    {"RACACHE_SPEC_HITS", PERF_RACACHE_SPEC_HITS, 0},
+    {"RACACHE_WASTED_BYTES", PERF_RACACHE_WASTED_BYTES, 0},
+    {"RACACHE_WINDOW_GROWS", PERF_RACACHE_WINDOW_GROWS, 0},
+    {"RACACHE_WINDOW_SHRINKS", PERF_RACACHE_WINDOW_SHRINKS, 0},
+    {NULL, 0, 0},
+};
 
 /* This represents the entire readahead cache */
 static struct racache_s racache =
@@ -117,12 +146,26 @@ int pint_racache_set_pinned(int pinned)
     return 0;
 }
 
+struct PINT_perf_counter *pint_racache_get_pc(void)
+{
+    return racache_pc;
+}
+
 int pint_racache_initialize(int bufcnt, int bufsz, int readcnt, int pinned)
 {
     int ret = -1;
 
     if (!RACACHE_INITIALIZED())
     {
+        racache_pc = PINT_perf_initialize(PINT_PERF_COUNTER,
+                                          racache_keys,
+                                          client_perf_start_rollover);
+        if (!racache_pc)
+        {
+            gossip_err("%s: Error: PINT_perf_initialize failure.\n",
+                       __func__);
+            return -1;
+        }
         if (bufcnt >= 0)
         {
             racache.bufcnt = bufcnt;
@@ -141,6 +184,8 @@ int pint_racache_initialize(int bufcnt, int bufsz, int readcnt, int pinned)
         }
         if (racache_buf_init(&racache) < 0)
         {
+            PINT_perf_finalize(racache_pc);
+            racache_pc = NULL;
             return -1;
         }
 
@@ -150,6 +195,8 @@ int pint_racache_initialize(int bufcnt, int bufsz, int readcnt, int pinned)
         if (!racache.hash_table)
         {
             free(racache.buffarray); /* allocated in buf_init */
+            PINT_perf_finalize(racache_pc);
+            racache_pc = NULL;
             return -1;
         }
 
@@ -174,6 +221,19 @@ static void racache_init_file(racache_file_t *file)
     /* eventually want a way to pass this in from the file */
     file->readcnt = racache.readcnt;
 
+    file->last_offset = 0;
+    file->last_len = 0;
+    file->stride = 0;
+    file->accesses = 0;
+    file->pattern = RACACHE_PATTERN_NONE;
+    file->confidence = 0;
+    /* the read count includes the buffer being read */
+    file->window = (racache.readcnt > 1) ? racache.readcnt - 1 : 0;
+    file->min_window = (file->window > 0) ? 1 : 0;
+    file->stripe_width = 0;
+    file->spec_used = 0;
+    file->spec_wasted = 0;
+
     INIT_QLIST_HEAD(&file->hash_link);
     INIT_QLIST_HEAD(&file->buff_list);
 }
@@ -186,6 +246,8 @@ static void racache_init_buff(racache_buffer_t *buff)
     buff->valid = 0;
     buff->being_freed = 0;
     buff->resizing = 0;
+    buff->speculative = 0;
+    buff->used = 0;
     buff->vfs_cnt = 0;
     buff->file_offset = 0;
     buff->data_sz = 0;
@@ -454,6 +516,8 @@ static racache_buffer_t *racache_buf_get(racache_file_t *racache_file)
             /* very busy cache just do a regular read */
             return NULL;
         }
+        /* an unread readahead buffer is being thrown away */
+        racache_spec_dropped(buff);
         /* remove from prev file's buffer list */
         qlist_del(&buff->buff_link);
     }
@@ -495,6 +559,344 @@ static void racache_buf_lru(racache_buffer_t *buff)
     qlist_add_tail(&buff->buff_lru, &racache.buff_lru);
 }
 
+/* largest window any one file may use */
+static int racache_max_window(void)
+{
+    int max = racache.bufcnt / 2;
+
+    if (max > PVFS2_MAX_RACACHE_READCNT)
+    {
+        max = PVFS2_MAX_RACACHE_READCNT;
+    }
+    return (max > 1) ? max : 1;
+}
+
+/* update the access pattern of a file with a demand read */
+static void racache_track_access(racache_file_t *file,
+                                 PVFS_size offset,
+                                 PVFS_size len)
+{
+    PVFS_size delta = offset - file->last_offset;
+    PVFS_size gap;
+    int pattern = RACACHE_PATTERN_NONE;
+
+    if (file->accesses == 0)
+    {
+        /* no history - treat it as the start of a forward scan */
+        file->pattern = RACACHE_PATTERN_FORWARD;
+        file->confidence = 0;
+        file->accesses++;
+        file->last_offset = offset;
+        file->last_len = len;
+        return;
+    }
+    if (delta == 0)
+    {
+        /* same read again tells us nothing */
+        return;
+    }
+
+    /* reads that skip less than a buffer (page faults skipping a page
+     * or two, say) are served by a scan in that direction; only larger
+     * jumps that repeat are treated as strides
+     */
+    if (delta > 0)
+    {
+        gap = offset - (file->last_offset + file->last_len);
+    }
+    else
+    {
+        gap = file->last_offset - (offset + len);
+    }
+    if (gap < racache.bufsz)
+    {
+        pattern = (delta > 0) ? RACACHE_PATTERN_FORWARD :
+                                RACACHE_PATTERN_BACKWARD;
+    }
+    else if (delta == file->stride)
+    {
+        pattern = RACACHE_PATTERN_STRIDE;
+    }
+
+    if (pattern != RACACHE_PATTERN_NONE && pattern == file->pattern)
+    {
+        file->confidence++;
+    }
+    else
+    {
+        if (pattern != file->pattern)
+        {
+            gossip_debug(GOSSIP_RACACHE_DEBUG,
+                         "racache file %llu pattern %d -> %d\n",
+                         llu(file->refn.handle), file->pattern, pattern);
+        }
+        file->pattern = pattern;
+        file->confidence = (pattern == RACACHE_PATTERN_NONE) ? 0 : 1;
+    }
+    file->stride = delta;
+    file->accesses++;
+    file->last_offset = offset;
+    file->last_len = len;
+}
+
+/* resize the window of a file once an epoch of speculative buffers
+ * have either been used or wasted: grow while all of them are used,
+ * shrink when more than a quarter are thrown away unread
+ */
+static void racache_spec_outcome(racache_file_t *file, int used)
+{
+    int max = racache_max_window();
+
+    if (used)
+    {
+        file->spec_used++;
+    }
+    else
+    {
+        file->spec_wasted++;
+    }
+    if (file->spec_used + file->spec_wasted < RACACHE_WINDOW_EPOCH)
+    {
+        return;
+    }
+
+    if (file->spec_wasted == 0 && file->window > 0 && file->window < max)
+    {
+        file->window *= 2;
+        if (file->window > max)
+        {
+            file->window = max;
+        }
+        PINT_perf_count(racache_pc, PERF_RACACHE_WINDOW_GROWS,
+                        1, PINT_PERF_ADD);
+    }
+    else if (file->spec_wasted * 4 > RACACHE_WINDOW_EPOCH &&
+             file->window > file->min_window)
+    {
+        file->window /= 2;
+        if (file->window < file->min_window)
+        {
+            file->window = file->min_window;
+        }
+        PINT_perf_count(racache_pc, PERF_RACACHE_WINDOW_SHRINKS,
+                        1, PINT_PERF_ADD);
+    }
+    gossip_debug(GOSSIP_RACACHE_DEBUG,
+                 "racache file %llu used %d wasted %d window now %d\n",
+                 llu(file->refn.handle), file->spec_used,
+                 file->spec_wasted, file->window);
+    file->spec_used = 0;
+    file->spec_wasted = 0;
+}
+
+/* a demand read found this buffer */
+static void racache_spec_used(racache_buffer_t *buff)
+{
+    if (!buff->speculative || buff->used)
+    {
+        return;
+    }
+    buff->used = 1;
+    PINT_perf_count(racache_pc, PERF_RACACHE_SPEC_HITS, 1, PINT_PERF_ADD);
+    if (buff->file)
+    {
+        racache_spec_outcome(buff->file, 1);
+    }
+}
+
+/* this buffer is leaving the cache */
+static void racache_spec_dropped(racache_buffer_t *buff)
+{
+    if (!buff->speculative || buff->used)
+    {
+        return;
+    }
+    PINT_perf_count(racache_pc, PERF_RACACHE_WASTED_BYTES,
+                    buff->valid ? buff->data_sz : buff->buff_sz,
+                    PINT_PERF_ADD);
+    if (buff->file)
+    {
+        racache_spec_outcome(buff->file, 0);
+    }
+}
+
+/* account for a buffer get_block is about to have read */
+static void racache_new_block(racache_buffer_t *buff,
+                              int readahead_speculative)
+{
+    if (readahead_speculative)
+    {
+        buff->speculative = 1;
+        PINT_perf_count(racache_pc, PERF_RACACHE_SPEC_READS,
+                        1, PINT_PERF_ADD);
+        PINT_perf_count(racache_pc, PERF_RACACHE_SPEC_BYTES,
+                        buff->buff_sz, PINT_PERF_ADD);
+    }
+    else
+    {
+        PINT_perf_count(racache_pc, PERF_RACACHE_MISSES, 1, PINT_PERF_ADD);
+    }
+}
+
+int pint_racache_readahead_offsets(racache_buffer_t *buff,
+                                   PVFS_size *offsets,
+                                   int max)
+{
+    racache_file_t *file;
+    racache_buffer_t *fbuff;
+    PVFS_size eof = -1;
+    PVFS_size base;
+    PVFS_size off;
+    PVFS_size step;
+    int count = 0;
+    int i;
+    int j;
+
+    if (!RACACHE_INITIALIZED() || !buff || max < 1)
+    {
+        return 0;
+    }
+    gen_mutex_lock(&racache.mutex);
+    file = buff->file;
+    if (!file || file->window < 1 || buff->readcnt < 1)
+    {
+        gen_mutex_unlock(&racache.mutex);
+        return 0;
+    }
+    if (file->pattern == RACACHE_PATTERN_NONE ||
+        (file->pattern == RACACHE_PATTERN_STRIDE && file->confidence < 1))
+    {
+        /* random access - readahead would only be wasted */
+        gen_mutex_unlock(&racache.mutex);
+        return 0;
+    }
+    if (!buff->valid && file->confidence < 1)
+    {
+        /* until this read completes we do not know whether it hit EOF,
+         * so only read past it once the pattern is established */
+        gen_mutex_unlock(&racache.mutex);
+        return 0;
+    }
+
+    /* a short buffer marks the end of the file */
+    qlist_for_each_entry(fbuff, &file->buff_list, buff_link)
+    {
+        if (fbuff->valid && fbuff->data_sz < fbuff->buff_sz &&
+            (eof < 0 || fbuff->file_offset + fbuff->data_sz < eof))
+        {
+            eof = fbuff->file_offset + fbuff->data_sz;
+        }
+    }
+
+    switch (file->pattern)
+    {
+    case RACACHE_PATTERN_BACKWARD:
+        step = -buff->buff_sz;
+        break;
+    case RACACHE_PATTERN_STRIDE:
+        step = file->stride;
+        break;
+    default:
+        step = buff->buff_sz;
+        break;
+    }
+
+    /* strides are measured from the last demand read, not the start
+     * of its buffer */
+    base = (file->pattern == RACACHE_PATTERN_STRIDE) ?
+           file->last_offset : buff->file_offset;
+    for (i = 1; i <= file->window && count < max; i++)
+    {
+        off = base + i * step;
+        if (off < 0)
+        {
+            break;
+        }
+        off = pint_racache_buff_offset(off);
+        if (eof >= 0 && off >= eof)
+        {
+            break;
+        }
+        /* strides shorter than a buffer may land in the same one */
+        for (j = 0; j < count; j++)
+        {
+            if (offsets[j] == off)
+            {
+                break;
+            }
+        }
+        if (j == count && off != buff->file_offset)
+        {
+            offsets[count++] = off;
+        }
+    }
+    gen_mutex_unlock(&racache.mutex);
+    return count;
+}
+
+PVFS_size pint_racache_stripe_width(PVFS_object_ref refn)
+{
+    struct qlist_head *hash_link = NULL;
+    racache_file_t *file = NULL;
+    PVFS_size width = -1;
+
+    if (RACACHE_INITIALIZED())
+    {
+        gen_mutex_lock(&racache.mutex);
+        hash_link = qhash_search(racache.hash_table, &refn);
+        if (hash_link)
+        {
+            file = qhash_entry(hash_link, racache_file_t, hash_link);
+            width = file->stripe_width;
+        }
+        gen_mutex_unlock(&racache.mutex);
+    }
+    return width;
+}
+
+int pint_racache_set_stripe_width(PVFS_object_ref refn, PVFS_size width)
+{
+    struct qlist_head *hash_link = NULL;
+    racache_file_t *file = NULL;
+    PVFS_size bufs;
+    int max = racache_max_window();
+
+    if (!RACACHE_INITIALIZED())
+    {
+        return -1;
+    }
+    gen_mutex_lock(&racache.mutex);
+    hash_link = qhash_search(racache.hash_table, &refn);
+    if (!hash_link)
+    {
+        gen_mutex_unlock(&racache.mutex);
+        return -1;
+    }
+    file = qhash_entry(hash_link, racache_file_t, hash_link);
+    if (width <= 0)
+    {
+        file->stripe_width = -1;
+        gen_mutex_unlock(&racache.mutex);
+        return 0;
+    }
+    file->stripe_width = width;
+    /* a read count of one or less turns readahead off */
+    if (file->readcnt > 1)
+    {
+        bufs = (width + racache.bufsz - 1) / racache.bufsz;
+        file->min_window = (bufs < max) ? (int)bufs : max;
+        if (file->window < file->min_window)
+        {
+            file->window = file->min_window;
+        }
+    }
+    gossip_debug(GOSSIP_RACACHE_DEBUG,
+                 "racache file %llu stripe width %lld window %d\n",
+                 llu(file->refn.handle), lld(width), file->window);
+    gen_mutex_unlock(&racache.mutex);
+    return 0;
+}
+
 int pint_racache_get_block(PVFS_object_ref refn,
                            PVFS_size offset,
                            PVFS_size len,
@@ -525,6 +927,11 @@ int pint_racache_get_block(PVFS_object_ref refn,
                                        hash_link);
             assert(racache_file);
 
+            if (!readahead_speculative)
+            {
+                racache_track_access(racache_file, offset, len);
+            }
+
             /* found the file, now search for a buffer */
             qlist_for_each_entry(buff, &racache_file->buff_list, buff_link)
             {
@@ -535,6 +942,14 @@ int pint_racache_get_block(PVFS_object_ref refn,
                     /* data in cache - reset lru and set up return */
                     racache_buf_lru(buff);
                     /* found a matching buffer */
+                    if (!readahead_speculative)
+                    {
+                        PINT_perf_count(racache_pc,
+                                        buff->valid ? PERF_RACACHE_HITS :
+                                                      PERF_RACACHE_WAITS,
+                                        1, PINT_PERF_ADD);
+                        racache_spec_used(buff);
+                    }
                     if (buff->valid)
                     {
                         gossip_debug(GOSSIP_RACACHE_DEBUG,
@@ -615,6 +1030,7 @@ int pint_racache_get_block(PVFS_object_ref refn,
             }
             buff->file = racache_file;
             buff->file_offset = pint_racache_buff_offset(offset);
+            racache_new_block(buff, readahead_speculative);
             gossip_debug(GOSSIP_RACACHE_DEBUG,
                          "racache_get_block offset %llu(%llu) size %llu\n",
                          llu(offset), llu(buff->file_offset),
@@ -661,6 +1077,10 @@ int pint_racache_get_block(PVFS_object_ref refn,
             }
             racache_init_file(rcfile);
             rcfile->refn = refn;
+            if (!readahead_speculative)
+            {
+                racache_track_access(rcfile, offset, len);
+            }
             gossip_debug(GOSSIP_RACACHE_DEBUG, "racache_get_block "
                          "adding new file rec to hash table\n");
             qhash_add(racache.hash_table, &refn, &rcfile->hash_link);
@@ -681,6 +1101,7 @@ int pint_racache_get_block(PVFS_object_ref refn,
             buff->file = rcfile;
             buff->file_offset = pint_racache_buff_offset(offset);
             buff->data_sz = 0;
+            racache_new_block(buff, readahead_speculative);
 
             /* add request to waiting list */
             glink = (gen_link_t *)malloc(sizeof(gen_link_t));
@@ -745,6 +1166,8 @@ int pint_racache_flush(PVFS_object_ref refn)
                              buff->buff_id);
                 /* remove buffer from the lru list */
                 qlist_del(&buff->buff_lru);
+                /* readahead data that was never read is wasted */
+                racache_spec_dropped(buff);
                 /* clear reference to file record */
                 buff->file = NULL;
                 /* check for active requests */
@@ -874,6 +1297,12 @@ int pint_racache_finalize(void)
 
         /* FIXME: race condition here */
         gen_mutex_destroy(&racache.mutex);
+
+        if (racache_pc)
+        {
+            PINT_perf_finalize(racache_pc);
+            racache_pc = NULL;
+        }
         gossip_debug(GOSSIP_RACACHE_DEBUG, "ra_cache_finalized\n");
     }
     return ret;
@@ -9,6 +9,7 @@
 
 #include "quickhash.h"
 #include "pvfs2-internal.h"
+#include "pint-perf-counter.h"
 
 #define PVFS2_DEFAULT_RACACHE_BUFSZ   (2 * 1024 * 1024)
 #define PVFS2_MAX_RACACHE_BUFSZ       (256 * 1024 * 1024)
@@ -30,6 +31,33 @@
 #define RACACHE_READ          3 /* miss - read a new buffer */
 #define RACACHE_POSTED        4 /* miss - read of new buffer POSTED */
 
+/* access patterns detected per file from demand (non-speculative) reads */
+#define RACACHE_PATTERN_NONE      0 /* random, or not enough history */
+#define RACACHE_PATTERN_FORWARD   1 /* each read starts near where the last
+                                     * one ended */
+#define RACACHE_PATTERN_BACKWARD  2 /* each read ends near where the last
+                                     * one started */
+#define RACACHE_PATTERN_STRIDE    3 /* reads a fixed distance apart, at
+                                     * least one buffer */
+
+/* number of speculative buffers that are either used or wasted before
+ * a file's readahead window is resized */
+#define RACACHE_WINDOW_EPOCH      8
+
+/* racache perf counter keys */
+enum
+{
+    PERF_RACACHE_HITS = 0,
+    PERF_RACACHE_WAITS = 1,
+    PERF_RACACHE_MISSES = 2,
+    PERF_RACACHE_SPEC_READS = 3,
+    PERF_RACACHE_SPEC_BYTES = 4,
+    PERF_RACACHE_SPEC_HITS = 5,
+    PERF_RACACHE_WASTED_BYTES = 6,
+    PERF_RACACHE_WINDOW_GROWS = 7,
+    PERF_RACACHE_WINDOW_SHRINKS = 8,
+};
+
 typedef struct gen_link_s
 {
     struct qlist_head link;
@@ -43,6 +71,19 @@ typedef struct racache_file_s
     PVFS_object_ref refn;
     struct qlist_head buff_list; /* list of buffers for this file in cache */
     PVFS_size readcnt;
+    /* access pattern, from demand reads only */
+    PVFS_size last_offset;       /* offset of the previous demand read */
+    PVFS_size last_len;          /* length of the previous demand read */
+    PVFS_size stride;            /* distance between the last two reads */
+    int accesses;                /* demand reads seen so far */
+    int pattern;                 /* RACACHE_PATTERN_* */
+    int confidence;              /* consecutive reads matching pattern */
+    /* readahead window, in buffers beyond the one being read */
+    int window;
+    int min_window;              /* buffers covering one stripe */
+    PVFS_size stripe_width;      /* 0 unknown, -1 could not be found */
+    int spec_used;               /* speculative buffers read this epoch */
+    int spec_wasted;             /* speculative buffers dropped unread */
 } racache_file_t;
 
 /* one for each buffer in cache */
@@ -54,6 +95,8 @@ typedef struct racache_buffer_s
     int valid;                   /* non zero if read into buffer is complete */
     int being_freed;             /* non zero if file has been flushed */
     int resizing;                /* non zero if buffers are resizing */
+    int speculative;             /* non zero if read by a readahead */
+    int used;                    /* non zero once a demand read hit it */
     int buff_id;
     int vfs_cnt;
     PVFS_size file_offset;
@@ -136,6 +179,26 @@ int pint_racache_get_block(PVFS_object_ref refn,
                             racache_buffer_t **rbuf,
                             int *amt_returned);
 
+/*
+ * fill offsets with the file offsets of up to max buffers that should
+ * be read ahead of buff, based on the access pattern and readahead
+ * window of its file.  Offsets already cached are included; the caller
+ * skips them when get_block returns HIT or WAIT.
+ * returns the number of offsets, 0 if no readahead should be done
+ */
+int pint_racache_readahead_offsets(racache_buffer_t *buff,
+                                   PVFS_size *offsets,
+                                   int max);
+
+/* stripe width of a file in bytes: 0 if not yet set, -1 if unknown */
+PVFS_size pint_racache_stripe_width(PVFS_object_ref refn);
+
+/* the readahead window of a file never drops below one stripe width;
+ * pass a width <= 0 to record that it could not be found */
+int pint_racache_set_stripe_width(PVFS_object_ref refn, PVFS_size width);
+
+struct PINT_perf_counter *pint_racache_get_pc(void);
+
 /* remove all cache entries for a given file */
 int pint_racache_flush(PVFS_object_ref refn);
 
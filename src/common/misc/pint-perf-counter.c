@@ -100,6 +100,44 @@ struct PINT_perf_key server_keys[] =
     {"io requests called", PINT_PERF_IO, PINT_PERF_PRESERVE},
     {"small_io requests called", PINT_PERF_SMALL_IO, PINT_PERF_PRESERVE},
     {"readdir requests called", PINT_PERF_READDIR, PINT_PERF_PRESERVE},
+    {"metadata requests queued", PINT_PERF_REQSCHED_META_QUEUED,
+        PINT_PERF_PRESERVE},
+    {"io requests queued", PINT_PERF_REQSCHED_IO_QUEUED, PINT_PERF_PRESERVE},
+    {"mgmt requests queued", PINT_PERF_REQSCHED_MGMT_QUEUED,
+        PINT_PERF_PRESERVE},
+    {"flow buffers allocated", PINT_PERF_FLOW_BUFFERS, PINT_PERF_PRESERVE},
+    {"bytes in flow buffers", PINT_PERF_FLOW_BUFFER_BYTES,
+        PINT_PERF_PRESERVE},
+    {"flow pipeline depth increases", PINT_PERF_FLOW_DEPTH_GROW, 0},
+    {"flow pool bytes in use", PINT_PERF_FLOW_POOL_INUSE, PINT_PERF_PRESERVE},
+    {"flow pool bytes idle", PINT_PERF_FLOW_POOL_CACHED, PINT_PERF_PRESERVE},
+    {"flow pool hits", PINT_PERF_FLOW_POOL_HITS, 0},
+    {"flow pool misses", PINT_PERF_FLOW_POOL_MISSES, 0},
+    {"flow pool waits", PINT_PERF_FLOW_POOL_WAITS, 0},
+    {"bytes sent by flow sendfile", PINT_PERF_FLOW_SENDFILE,
+        PINT_PERF_PRESERVE},
+    {"metadata batches committed", PINT_PERF_META_BATCHES, 0},
+    {"metadata ops batched", PINT_PERF_META_BATCH_OPS, 0},
+    {"metadata batches of 1 op", PINT_PERF_META_BATCH_1, 0},
+    {"metadata batches of 2-7 ops", PINT_PERF_META_BATCH_2_7, 0},
+    {"metadata batches of 8-31 ops", PINT_PERF_META_BATCH_8_31, 0},
+    {"metadata batches of 32+ ops", PINT_PERF_META_BATCH_32, 0},
+    {"metadata batches under 100us", PINT_PERF_META_BATCH_LAT_100US, 0},
+    {"metadata batches 100us-1ms", PINT_PERF_META_BATCH_LAT_1MS, 0},
+    {"metadata batches 1ms-10ms", PINT_PERF_META_BATCH_LAT_10MS, 0},
+    {"metadata batches 10ms+", PINT_PERF_META_BATCH_LAT_SLOW, 0},
+    {"trove read ops queued", PINT_PERF_TROVE_READ_QUEUED,
+        PINT_PERF_PRESERVE},
+    {"trove read ops serviced", PINT_PERF_TROVE_READ_OPS, 0},
+    {"readdirplus requests called", PINT_PERF_READDIRPLUS,
+        PINT_PERF_PRESERVE},
+    {"small I/O batches", PINT_PERF_SMALL_IO_BATCHES, 0},
+    {"small I/O requests batched", PINT_PERF_SMALL_IO_BATCH_OPS, 0},
+    {"small I/O batch regions", PINT_PERF_SMALL_IO_BATCH_SEGS, 0},
+    {"directory splits in progress", PINT_PERF_DIR_SPLITS,
+        PINT_PERF_PRESERVE},
+    {"directory split entries scanned", PINT_PERF_DIR_SPLIT_SCANNED, 0},
+    {"directory split entries moved", PINT_PERF_DIR_SPLIT_MOVED, 0},
     {NULL, 0, 0},
 };
 
@@ -120,6 +158,16 @@ struct PINT_perf_key server_tkeys[] =
     {"io timer", PINT_PERF_TIO, PINT_PERF_PRESERVE},
     {"small_io timer", PINT_PERF_TSMALL_IO, PINT_PERF_PRESERVE},
     {"readdir timer", PINT_PERF_TREADDIR, PINT_PERF_PRESERVE},
+    {"metadata sched wait timer", PINT_PERF_TREQSCHED_META_WAIT,
+        PINT_PERF_PRESERVE},
+    {"io sched wait timer", PINT_PERF_TREQSCHED_IO_WAIT, PINT_PERF_PRESERVE},
+    {"mgmt sched wait timer", PINT_PERF_TREQSCHED_MGMT_WAIT,
+        PINT_PERF_PRESERVE},
+    {"flow pool wait timer", PINT_PERF_TFLOW_POOL_WAIT, PINT_PERF_PRESERVE},
+    {"metadata batch timer", PINT_PERF_TMETA_BATCH, PINT_PERF_PRESERVE},
+    {"readdirplus timer", PINT_PERF_TREADDIRPLUS, PINT_PERF_PRESERVE},
+    {"directory split flip timer", PINT_PERF_TDIR_SPLIT_FLIP,
+        PINT_PERF_PRESERVE},
     {NULL, 0, 0},
 };
 
@@ -70,6 +70,7 @@ static DOTCONF_CB(exit_distribution_context);
 static DOTCONF_CB(get_unexp_req);
 static DOTCONF_CB(get_tcp_buffer_send);
 static DOTCONF_CB(get_tcp_buffer_receive);
+static DOTCONF_CB(get_tcp_progress_threads);
 static DOTCONF_CB(get_tcp_bind_specific);
 static DOTCONF_CB(get_perf_update_interval);
 static DOTCONF_CB(get_perf_update_history);
@@ -98,6 +99,7 @@ static DOTCONF_CB(get_anon_gid);
 static DOTCONF_CB(get_anon_uid);
 
 static DOTCONF_CB(get_handle_recycle_timeout_seconds);
+static DOTCONF_CB(get_handle_checkpoint_seconds);
 static DOTCONF_CB(get_flow_buffer_size_bytes);
 static DOTCONF_CB(get_flow_buffers_per_flow);
 static DOTCONF_CB(get_attr_cache_keywords_list);
@@ -107,6 +109,18 @@ static DOTCONF_CB(get_trove_sync_meta);
 static DOTCONF_CB(get_trove_sync_data);
 static DOTCONF_CB(get_file_stuffing);
 static DOTCONF_CB(get_trove_max_concurrent_io);
+static DOTCONF_CB(get_trove_meta_batch_max_ops);
+static DOTCONF_CB(get_trove_meta_batch_max_latency);
+static DOTCONF_CB(get_trove_meta_read_threads);
+static DOTCONF_CB(get_small_io_coalesce_max_ops);
+static DOTCONF_CB(get_small_io_coalesce_window);
+static DOTCONF_CB(get_server_sm_threads);
+static DOTCONF_CB(get_req_sched_metadata_weight);
+static DOTCONF_CB(get_req_sched_io_weight);
+static DOTCONF_CB(get_req_sched_mgmt_weight);
+static DOTCONF_CB(get_req_sched_max_bypass);
+static DOTCONF_CB(get_flow_buffer_pool_size_mb);
+static DOTCONF_CB(get_flow_sendfile);
 /* Berkeley DB */
 static DOTCONF_CB(get_db_cache_size_bytes);
 static DOTCONF_CB(get_db_cache_type);
@@ -680,6 +694,116 @@ static const configoption_t options[] =
     {"TroveMaxConcurrentIO", ARG_INT, get_trove_max_concurrent_io, NULL,
         CTX_DEFAULTS|CTX_SERVER_OPTIONS,"16"},
 
+    /* Keyval and dspace updates made by metadata operations that Trove
+     * services back to back can be grouped into a single database
+     * transaction.  The operations of such a batch complete only once the
+     * batch has been committed (and synced, if TroveSyncMeta is set).
+     * This option gives the largest number of operations in one batch;
+     * 1 disables batching.
+     */
+    {"TroveMetaBatchMaxOps", ARG_INT, get_trove_meta_batch_max_ops, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"1"},
+
+    /* Upper bound, in microseconds, on how long a metadata batch (see
+     * <a href="#TroveMetaBatchMaxOps">TroveMetaBatchMaxOps</a>) stays
+     * open after its first operation before it is committed.  With the
+     * LMDB backend an open batch holds the write lock of each database
+     * it has written, so other writers to them wait for this long at
+     * most.
+     */
+    {"TroveMetaBatchMaxLatencyUsecs", ARG_INT,
+        get_trove_meta_batch_max_latency, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"2000"},
+
+    /* Number of additional Trove threads that service read-only metadata
+     * operations (keyval reads and iterates, dspace getattrs) concurrently
+     * with each other and with the thread that services updates.  Each
+     * read runs in its own read transaction.  Only the LMDB database
+     * backend supports this; 0 services every operation on the single
+     * Trove thread.
+     */
+    {"TroveMetaReadThreads", ARG_INT, get_trove_meta_read_threads, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"0"},
+
+    /* Small I/O requests (those whose data travels inside the request or
+     * response message) that arrive for the same datafile while another
+     * one is being serviced are queued and then issued to Trove together
+     * as a single sorted and merged list I/O.  This option gives the
+     * largest number of requests serviced by one such operation; 1
+     * disables coalescing.
+     */
+    {"SmallIOCoalesceMaxOps", ARG_INT, get_small_io_coalesce_max_ops, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"1"},
+
+    /* Time, in milliseconds, that the first small I/O request for an idle
+     * datafile waits for others to join it when coalescing (see
+     * <a href="#SmallIOCoalesceMaxOps">SmallIOCoalesceMaxOps</a>) is
+     * enabled.  With 0, requests only coalesce behind an operation that is
+     * already in progress, so an isolated request is not delayed.
+     */
+    {"SmallIOCoalesceWindowMsecs", ARG_INT, get_small_io_coalesce_window,
+        NULL, CTX_DEFAULTS|CTX_SERVER_OPTIONS,"0"},
+
+    /* Number of threads that run server state machines.  With 1, every
+     * state machine step runs on the main server thread.  With more, the
+     * main thread only collects completed jobs and hands each state machine
+     * to one of this many worker threads; all steps of a request (and of
+     * any state machines it starts) run on the same worker, and requests
+     * on the same handle are still ordered by the request scheduler.
+     */
+    {"ServerStateMachineThreads", ARG_INT, get_server_sm_threads, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"1"},
+
+    /* Requests that have to wait in the request scheduler are released
+     * in weighted round robin order across three classes: metadata
+     * operations, bulk I/O (io, small-io, truncate, ...) and management
+     * operations.  Within each class, clients are served round robin.
+     * These options give the number of requests of each class that may be
+     * released per round.  Each weight must be at least 1.
+     */
+    {"ReqSchedMetadataWeight", ARG_INT, get_req_sched_metadata_weight, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"4"},
+
+    /* See the <a href="#ReqSchedMetadataWeight">ReqSchedMetadataWeight</a>
+     * option.
+     */
+    {"ReqSchedIOWeight", ARG_INT, get_req_sched_io_weight, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"4"},
+
+    /* See the <a href="#ReqSchedMetadataWeight">ReqSchedMetadataWeight</a>
+     * option.
+     */
+    {"ReqSchedMgmtWeight", ARG_INT, get_req_sched_mgmt_weight, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"1"},
+
+    /* Read only requests on a handle may run concurrently.  When a request
+     * that modifies the handle is waiting for them to finish, this many
+     * additional read only requests may still be admitted ahead of it
+     * before new readers have to queue behind the writer.  Setting this to
+     * 0 gives strict arrival order.
+     */
+    {"ReqSchedMaxBypass", ARG_INT, get_req_sched_max_bypass, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"16"},
+
+    /* Limits the memory, in megabytes, that flows may hold in network
+     * buffers at once.  Buffers returned by finished flows are kept and
+     * reused by later ones.  A flow that cannot get its first buffer waits
+     * until one is returned.  Setting this to 0 disables the limit and the
+     * reuse of buffers.
+     */
+    {"FlowBufferPoolSizeMB", ARG_INT, get_flow_buffer_pool_size_mb, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"256"},
+
+    /* When set to "yes", data read from a file is sent to clients straight
+     * from the storage file with sendfile() instead of being read into a
+     * flow buffer first.  Only used when the storage method and the network
+     * method of the client both support it (currently the default, alt-aio
+     * and io-uring TroveMethods over TCP); other transfers use flow buffers
+     * as usual.
+     */
+    {"FlowSendfile", ARG_STR, get_flow_sendfile, NULL,
+        CTX_DEFAULTS|CTX_SERVER_OPTIONS,"no"},
+
     /* The gossip interface in OrangeFS allows users to specify different
      * levels of logging for the OrangeFS server.  The output of these
      * different log levels is written to a file, which is specified in
@@ -797,6 +921,15 @@ static const configoption_t options[] =
       {"TCPBufferReceive",ARG_INT, get_tcp_buffer_receive,NULL,
          CTX_DEFAULTS,"0"},
 
+     /* Number of threads dedicated to moving data on TCP connections.
+      * Each thread polls its own share of the connections, which helps
+      * servers with many clients attached.  The default of 0 lets the
+      * server threads that test for network completions poll all of the
+      * sockets themselves.  Requires epoll support.
+      */
+     {"TCPProgressThreads",ARG_INT, get_tcp_progress_threads,NULL,
+         CTX_DEFAULTS|CTX_SERVER_OPTIONS,"0"},
+
      /* If enabled, specifies that the server should bind its port only on
       * the specified address (rather than INADDR_ANY).
       */
@@ -1028,6 +1161,18 @@ static const configoption_t options[] =
     {"HandleRecycleTimeoutSecs", ARG_INT,
          get_handle_recycle_timeout_seconds, NULL, 
          CTX_STORAGEHINTS,"360"},
+
+    /* The handle allocator state is saved to the storage space on clean
+     * shutdown, so that the next startup does not have to scan every
+     * object in the file system to find the handles in use.  It is also
+     * saved every HandleLedgerCheckpointSecs seconds while the server
+     * runs; after a crash the newest such copy is loaded and the scan
+     * runs in the background instead of delaying startup.  0 saves it
+     * only at startup and shutdown.
+     */
+    {"HandleLedgerCheckpointSecs", ARG_INT,
+         get_handle_checkpoint_seconds, NULL,
+         CTX_STORAGEHINTS,"300"},
     
     /* The TROVE layer (server side storage layer) 
      * has an attribute caching component that 
@@ -1159,6 +1304,11 @@ static const configoption_t options[] =
      * for large I/O accesses.  For local storage, including RAID setups,
      * the alt-aio method is recommended.
      *
+     * <c>io-uring</c>  This queues datafile I/O on a Linux io_uring
+     * instance shared by all file systems, with one thread reaping
+     * completions, rather than using a thread per operation as alt-aio
+     * does.  If the kernel does not support io_uring, alt-aio is used.
+     *
      * <c>null-aio</c>  This method is an implementation 
      * that does no disk I/O at all
      * and is only useful for development or debugging purposes.  It can
@@ -1280,6 +1430,17 @@ int PINT_parse_config(struct server_configuration_s *config_obj,
     config_s->client_retry_limit = PVFS2_CLIENT_RETRY_LIMIT_DEFAULT;
     config_s->client_retry_delay_ms = PVFS2_CLIENT_RETRY_DELAY_MS_DEFAULT;
     config_s->trove_max_concurrent_io = 16;
+    config_s->trove_meta_batch_max_ops = 1;
+    config_s->trove_meta_batch_max_latency = 2000;
+    config_s->trove_meta_read_threads = 0;
+    config_s->small_io_coalesce_max_ops = 1;
+    config_s->small_io_coalesce_window = 0;
+    config_s->server_sm_threads = 1;
+    config_s->req_sched_metadata_weight = 4;
+    config_s->req_sched_io_weight = 4;
+    config_s->req_sched_mgmt_weight = 1;
+    config_s->req_sched_max_bypass = 16;
+    config_s->flow_buffer_pool_mb = 256;
     config_s->db_max_size = 536870912;
 
     if (cache_config_files(config_s, global_config_filename))
@@ -1824,6 +1985,18 @@ DOTCONF_CB(get_tcp_buffer_send)
     return NULL;
 }
 
+DOTCONF_CB(get_tcp_progress_threads)
+{
+    struct server_configuration_s *config_s =
+                    (struct server_configuration_s *)cmd->context;
+    if(cmd->data.value < 0)
+    {
+        return("TCPProgressThreads can not be negative.\n");
+    }
+    config_s->tcp_progress_threads = cmd->data.value;
+    return NULL;
+}
+
 DOTCONF_CB(get_tcp_bind_specific)
 {
     struct server_configuration_s *config_s =
@@ -2617,6 +2790,21 @@ DOTCONF_CB(get_handle_recycle_timeout_seconds)
     return NULL;
 }
 
+DOTCONF_CB(get_handle_checkpoint_seconds)
+{
+    struct filesystem_configuration_s *fs_conf = NULL;
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    fs_conf = (struct filesystem_configuration_s *)
+                    PINT_llist_head(config_s->file_systems);
+    assert(fs_conf);
+
+    fs_conf->handle_checkpoint_secs = (int)cmd->data.value;
+
+    return NULL;
+}
+
 static const char * replace_old_keystring(const char * oldkey)
 {
     /* check for old keyval strings */
@@ -2868,6 +3056,229 @@ DOTCONF_CB(get_trove_max_concurrent_io)
     return NULL;
 }
 
+DOTCONF_CB(get_trove_meta_batch_max_ops)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1)
+    {
+        return("TroveMetaBatchMaxOps must be at least 1.\n");
+    }
+    config_s->trove_meta_batch_max_ops = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_trove_meta_batch_max_latency)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 0)
+    {
+        return("TroveMetaBatchMaxLatencyUsecs must not be negative.\n");
+    }
+    config_s->trove_meta_batch_max_latency = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_trove_meta_read_threads)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 0 || cmd->data.value > 64)
+    {
+        return("TroveMetaReadThreads must be between 0 and 64.\n");
+    }
+    config_s->trove_meta_read_threads = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_small_io_coalesce_max_ops)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1)
+    {
+        return("SmallIOCoalesceMaxOps must be at least 1.\n");
+    }
+    config_s->small_io_coalesce_max_ops = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_small_io_coalesce_window)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 0)
+    {
+        return("SmallIOCoalesceWindowMsecs must not be negative.\n");
+    }
+    config_s->small_io_coalesce_window = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_server_sm_threads)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1 || cmd->data.value > 64)
+    {
+        return("ServerStateMachineThreads must be between 1 and 64.\n");
+    }
+    config_s->server_sm_threads = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_req_sched_metadata_weight)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1)
+    {
+        return("ReqSchedMetadataWeight must be at least 1.\n");
+    }
+    config_s->req_sched_metadata_weight = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_req_sched_io_weight)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1)
+    {
+        return("ReqSchedIOWeight must be at least 1.\n");
+    }
+    config_s->req_sched_io_weight = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_req_sched_mgmt_weight)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 1)
+    {
+        return("ReqSchedMgmtWeight must be at least 1.\n");
+    }
+    config_s->req_sched_mgmt_weight = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_req_sched_max_bypass)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 0)
+    {
+        return("ReqSchedMaxBypass must not be negative.\n");
+    }
+    config_s->req_sched_max_bypass = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_flow_buffer_pool_size_mb)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(cmd->data.value < 0)
+    {
+        return("FlowBufferPoolSizeMB must not be negative.\n");
+    }
+    config_s->flow_buffer_pool_mb = cmd->data.value;
+    return NULL;
+}
+
+DOTCONF_CB(get_flow_sendfile)
+{
+    struct server_configuration_s *config_s = 
+                    (struct server_configuration_s *)cmd->context;
+
+    if(config_s->configuration_context == CTX_SERVER_OPTIONS &&
+       config_s->my_server_options == 0)
+    {
+        return NULL;
+    }
+    if(strcasecmp(cmd->data.str, "yes") == 0)
+    {
+        config_s->flow_sendfile = 1;
+    }
+    else if(strcasecmp(cmd->data.str, "no") == 0)
+    {
+        config_s->flow_sendfile = 0;
+    }
+    else
+    {
+        return("FlowSendfile value must be 'yes' or 'no'.\n");
+    }
+    return NULL;
+}
+
 DOTCONF_CB(get_db_cache_size_bytes)
 {
     struct server_configuration_s *config_s = 
@@ -3348,6 +3759,10 @@ DOTCONF_CB(get_trove_method)
     {
         *method = TROVE_METHOD_DBPF_DIRECTIO;
     }
+    else if(!strcmp(cmd->data.str, "io-uring"))
+    {
+        *method = TROVE_METHOD_DBPF_IOURING;
+    }
     else
     {
         return "Error unknown TroveMethod option\n";
@@ -4422,6 +4837,7 @@ static void copy_filesystem(struct filesystem_configuration_s *dest_fs,
 
         dest_fs->handle_recycle_timeout_sec =
             src_fs->handle_recycle_timeout_sec;
+        dest_fs->handle_checkpoint_secs = src_fs->handle_checkpoint_secs;
         dest_fs->attr_cache_size = src_fs->attr_cache_size;
         dest_fs->attr_cache_max_num_elems =
             src_fs->attr_cache_max_num_elems;
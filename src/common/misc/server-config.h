@@ -83,6 +83,7 @@ typedef struct filesystem_configuration_s
       which trove storage backends are available
     */
     struct timeval handle_recycle_timeout_sec;
+    int handle_checkpoint_secs;
     char *attr_cache_keywords;
     int attr_cache_size;
     int attr_cache_max_num_elems;
@@ -184,6 +185,8 @@ typedef struct server_configuration_s
     int tcp_buffer_size_receive;    /* Size of TCP receive buffer, is set
                                        later with setsockopt */
     int tcp_buffer_size_send;       /* Size of TCP send buffer */
+    int tcp_progress_threads;       /* threads polling TCP sockets; 0 to
+                                     * poll from the testing threads */
     int tcp_bind_specific;          /* Flag indicates if we should bind to
                                      * specific server address
                                      */
@@ -217,7 +220,19 @@ typedef struct server_configuration_s
     int trove_max_concurrent_io;    /* allow the number of aio operations to
                                      * be configurable.
                                      */
+    int trove_meta_batch_max_ops;    /* metadata ops per group commit */
+    int trove_meta_batch_max_latency; /* usecs a batch may stay open */
+    int trove_meta_read_threads;     /* threads for read-only metadata ops */
+    int small_io_coalesce_max_ops;   /* small I/O requests per trove op */
+    int small_io_coalesce_window;    /* msecs a lone small I/O waits */
+    int server_sm_threads;           /* threads running state machines */
     int trove_method;
+    int req_sched_metadata_weight;   /* request scheduler class weights */
+    int req_sched_io_weight;
+    int req_sched_mgmt_weight;
+    int req_sched_max_bypass;        /* readers allowed to pass a writer */
+    int flow_buffer_pool_mb;         /* limit on pooled flow buffers */
+    int flow_sendfile;               /* send file data with sendfile() */
 	
     char *keystore_path;             /* location of trusted server public keys */
     char *serverkey_path;            /* location of server private key */
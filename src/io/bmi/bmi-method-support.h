@@ -174,6 +174,18 @@ struct bmi_method_ops
     int (*cancel)(bmi_op_id_t, bmi_context_id);
     const char* (*rev_lookup_unexpected)(bmi_method_addr_p);
     int (*query_addr_range)(bmi_method_addr_p, const char *, int);
+    /* optional: send a list of regions of an open file */
+    int (*post_send_file) (bmi_op_id_t *,
+                           bmi_method_addr_p,
+                           int,
+                           const bmi_size_t *,
+                           const bmi_size_t *,
+                           int,
+                           bmi_size_t,
+                           bmi_msg_tag_t,
+                           void *,
+                           bmi_context_id,
+                           PVFS_hint hints);
 };
 
 
@@ -200,6 +212,8 @@ struct method_op
     int mode;		/* operation mode */
     bmi_context_id context_id;  /* context */
     struct qlist_head op_list_entry;	/* op_list link */
+    struct qlist_head op_addr_link;	/* op_list address index link */
+    struct qlist_head op_match_link;	/* op_list (address, tag) index link */
     struct qlist_head hash_link;	/* hash table link */
     void *method_data;		/* for use by individual methods */
 
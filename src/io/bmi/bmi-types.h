@@ -94,6 +94,12 @@ enum
     BMI_OPTIMISTIC_BUFFER_REG = 14,
     BMI_TCP_CHECK_UNEXPECTED = 15,
     BMI_TRANSPORT_METHODS_STRING = 16,
+    BMI_GET_METH_INDEX = 17,   /**< index of the method serving an address,
+                                 for use with BMI_method_memalloc() */
+    BMI_TCP_PROGRESS_THREADS = 18, /**< number of threads that own and poll
+                                     the TCP sockets; 0 polls from test */
+    BMI_CHECK_SEND_FILE = 19,  /**< see if the method serving an address
+                                 implements BMI_post_send_file() */
 };
 
 enum BMI_io_type
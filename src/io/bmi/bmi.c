@@ -1435,6 +1435,63 @@ int BMI_memfree(BMI_addr_t addr,
     return (ret);
 }
 
+/** Allocates memory that can be used in native mode by the method at
+ *  the given index (see BMI_GET_METH_INDEX).  Unlike BMI_memalloc(), the
+ *  buffer is not tied to the lifetime of any one address.
+ *
+ *  \return Pointer to buffer on success, NULL on failure.
+ */
+void *BMI_method_memalloc(int method_index,
+                          bmi_size_t size,
+                          enum bmi_op_type send_recv)
+{
+    void *new_buffer = NULL;
+    struct bmi_method_ops *method = NULL;
+
+    gen_mutex_lock(&active_method_count_mutex);
+    if (method_index >= 0 && method_index < active_method_count)
+    {
+        method = active_method_table[method_index];
+    }
+    gen_mutex_unlock(&active_method_count_mutex);
+    if (!method)
+    {
+        return (NULL);
+    }
+
+    new_buffer = method->memalloc(size, send_recv);
+    if (new_buffer)
+    {
+       memset(new_buffer,0,size);
+    }
+    return (new_buffer);
+}
+
+/** Frees memory that was allocated with BMI_method_memalloc().
+ *
+ *  \return 0 on success, -errno on failure.
+ */
+int BMI_method_memfree(int method_index,
+                       void *buffer,
+                       bmi_size_t size,
+                       enum bmi_op_type send_recv)
+{
+    struct bmi_method_ops *method = NULL;
+
+    gen_mutex_lock(&active_method_count_mutex);
+    if (method_index >= 0 && method_index < active_method_count)
+    {
+        method = active_method_table[method_index];
+    }
+    gen_mutex_unlock(&active_method_count_mutex);
+    if (!method)
+    {
+        return (bmi_errno_to_pvfs(-EINVAL));
+    }
+
+    return (method->memfree(buffer, size, send_recv));
+}
+
 /** Acknowledge that an unexpected message has been
  * serviced that was returned from BMI_test_unexpected().
  *
@@ -1646,6 +1703,46 @@ int BMI_get_info(BMI_addr_t addr,
             *((void**) inout_parameter) = tmp_ref->method_addr;
             break;
 
+        case BMI_GET_METH_INDEX:
+            gen_mutex_lock(&ref_mutex);
+            tmp_ref = ref_list_search_addr(cur_ref_list, addr);
+            if (!tmp_ref)
+            {
+                gen_mutex_unlock(&ref_mutex);
+                return (bmi_errno_to_pvfs(-EINVAL));
+            }
+            gen_mutex_unlock(&ref_mutex);
+            ret = bmi_errno_to_pvfs(-EINVAL);
+            gen_mutex_lock(&active_method_count_mutex);
+            for (i = 0; i < active_method_count; i++)
+            {
+                if (active_method_table[i] == tmp_ref->interface)
+                {
+                    *((int *) inout_parameter) = i;
+                    ret = 0;
+                    break;
+                }
+            }
+            gen_mutex_unlock(&active_method_count_mutex);
+            if (ret < 0)
+            {
+                return (ret);
+            }
+            break;
+
+        case BMI_CHECK_SEND_FILE:
+            gen_mutex_lock(&ref_mutex);
+            tmp_ref = ref_list_search_addr(cur_ref_list, addr);
+            if (!tmp_ref)
+            {
+                gen_mutex_unlock(&ref_mutex);
+                return (bmi_errno_to_pvfs(-EINVAL));
+            }
+            gen_mutex_unlock(&ref_mutex);
+            *((int *) inout_parameter) =
+                (tmp_ref->interface->post_send_file != NULL);
+            break;
+
         case BMI_GET_UNEXP_SIZE:
             gen_mutex_lock(&ref_mutex);
             tmp_ref = ref_list_search_addr(cur_ref_list, addr);
@@ -2031,6 +2128,66 @@ int BMI_post_send_list(bmi_op_id_t * id,
 }
 
 
+/** Similar to BMI_post_send_list(), except that the message payload is
+ *  taken from a list of (possibly non contiguous) regions of an open
+ *  file rather than from memory.  The receiver sees an ordinary message
+ *  and matches it with any BMI_post_recv() variant.  The caller must
+ *  keep the file descriptor open until the operation completes.
+ *  Regions that extend beyond the end of the file are sent as zeroes.
+ *
+ *  \return 0 on success, 1 on immediate successful completion,
+ *  -BMI_ENOSYS if the method for this address cannot send from a file,
+ *  -errno on other failures.
+ */
+int BMI_post_send_file(bmi_op_id_t * id,
+                       BMI_addr_t dest,
+                       int fd,
+                       const bmi_size_t *offset_list,
+                       const bmi_size_t *size_list,
+                       int list_count,
+                       /* "total_size" is the sum of the size list */
+                       bmi_size_t total_size,
+                       bmi_msg_tag_t tag,
+                       void *user_ptr,
+                       bmi_context_id context_id,
+                       bmi_hint hints)
+{
+    ref_st_p tmp_ref = NULL;
+
+    gossip_debug(GOSSIP_BMI_DEBUG_OFFSETS,
+                 "BMI_post_send_file: addr: %ld, fd: %d, count: %d, "
+                 "total_size: %ld, tag: %d\n",
+                 (long) dest, fd, list_count, (long) total_size, (int) tag);
+
+    *id = 0;
+
+    gen_mutex_lock(&ref_mutex);
+    tmp_ref = ref_list_search_addr(cur_ref_list, dest);
+    if (!tmp_ref)
+    {
+        gen_mutex_unlock(&ref_mutex);
+        return (bmi_errno_to_pvfs(-EPROTO));
+    }
+    gen_mutex_unlock(&ref_mutex);
+
+    if (!tmp_ref->interface->post_send_file)
+    {
+        return (bmi_errno_to_pvfs(-ENOSYS));
+    }
+
+    return tmp_ref->interface->post_send_file(id,
+                                              tmp_ref->method_addr,
+                                              fd,
+                                              offset_list,
+                                              size_list,
+                                              list_count,
+                                              total_size,
+                                              tag,
+                                              user_ptr,
+                                              context_id,
+                                              (PVFS_hint) hints);
+}
+
 /** Similar to BMI_post_recv(), except that the dest buffer is 
  *  replaced by a list of (possibly non contiguous) buffers
  *
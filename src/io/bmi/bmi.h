@@ -115,6 +115,15 @@ int BMI_memfree(BMI_addr_t addr,
 		bmi_size_t size,
 		enum bmi_op_type send_recv);
 
+void *BMI_method_memalloc(int method_index,
+			  bmi_size_t size,
+			  enum bmi_op_type send_recv);
+
+int BMI_method_memfree(int method_index,
+		       void *buffer,
+		       bmi_size_t size,
+		       enum bmi_op_type send_recv);
+
 int BMI_unexpected_free(BMI_addr_t addr,
 		void *buffer);
 
@@ -150,6 +159,19 @@ int BMI_post_send_list(bmi_op_id_t * id,
 		       bmi_context_id context_id,
                        bmi_hint hints);
 
+int BMI_post_send_file(bmi_op_id_t * id,
+		       BMI_addr_t dest,
+		       int fd,
+		       const bmi_size_t *offset_list,
+		       const bmi_size_t *size_list,
+		       int list_count,
+		       /* "total_size" is the sum of the size list */
+		       bmi_size_t total_size,
+		       bmi_msg_tag_t tag,
+		       void *user_ptr,
+		       bmi_context_id context_id,
+                       bmi_hint hints);
+
 int BMI_post_recv_list(bmi_op_id_t * id,
 		       BMI_addr_t src,
 		       void *const *buffer_list,
@@ -1842,7 +1842,7 @@ int BMI_gm_testcontext(int incount,
 {
     int ret = -1;
     method_op_p query_op = NULL;
-    op_list_p tmp_entry = NULL;
+    struct qlist_head *tmp_entry = NULL;
     struct gm_op *gm_op_data = NULL;
 
     *outcount = 0;
@@ -1866,7 +1866,7 @@ int BMI_gm_testcontext(int incount,
     /* this is kind of nasty- look for cancelled rend recvs that we
      * have not reported yet.  Must iterate queue.
      */
-    qlist_for_each(tmp_entry, op_list_array[IND_CANCELLED_REND])
+    qlist_for_each(tmp_entry, &op_list_array[IND_CANCELLED_REND]->ops)
     {
         if(*outcount >= incount)
             break;
@@ -1914,7 +1914,7 @@ int BMI_gm_testcontext(int incount,
     /* this is kind of nasty- look for cancelled rend recvs that we
      * have not reported yet.  Must iterate queue.
      */
-    qlist_for_each(tmp_entry, op_list_array[IND_CANCELLED_REND])
+    qlist_for_each(tmp_entry, &op_list_array[IND_CANCELLED_REND]->ops)
     {
         if(*outcount >= incount)
             break;
@@ -77,6 +77,12 @@ struct tcp_addr
     int dont_reconnect;
     char* peer;
     int peer_type;
+    /* progress thread whose socket collection holds this address, or
+     * -1 if it has not been placed yet */
+    int shard;
+    /* deferred deallocation while progress threads may still see it */
+    unsigned long retire_epoch;
+    struct qlist_head retire_link;
 };
 
 
@@ -27,6 +27,9 @@
 
 #ifdef HAVE_NETDB_H
 #include <netdb.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #endif
 
 #include "bmi-method-support.h"
@@ -52,6 +55,20 @@
 #include "pint-hint.h"
 #include "pint-event.h"
 
+/* socket progress can only be handed to dedicated threads when each of
+ * them can own an epoll set and real locks are available
+ */
+#if defined(__PVFS2_USE_EPOLL__) && defined(__GEN_POSIX_LOCKING__)
+#define BMI_TCP_ENABLE_PROGRESS_THREADS
+#endif
+
+/* payloads can be sent straight out of a file with sendfile(2) where
+ * the platform provides it
+ */
+#ifdef HAVE_SYS_SENDFILE_H
+#define BMI_TCP_ENABLE_SENDFILE
+#endif
+
 static gen_mutex_t interface_mutex = GEN_MUTEX_INITIALIZER;
 static gen_cond_t interface_cond = GEN_COND_INITIALIZER;
 static int sc_test_busy = 0;
@@ -174,6 +191,20 @@ int BMI_tcp_post_recv_list(bmi_op_id_t *id,
                            bmi_context_id context_id,
                            PVFS_hint hints);
 
+#ifdef BMI_TCP_ENABLE_SENDFILE
+int BMI_tcp_post_send_file(bmi_op_id_t *id,
+                           bmi_method_addr_p dest,
+                           int fd,
+                           const bmi_size_t *offset_list,
+                           const bmi_size_t *size_list,
+                           int list_count,
+                           bmi_size_t total_size,
+                           bmi_msg_tag_t tag,
+                           void *user_ptr,
+                           bmi_context_id context_id,
+                           PVFS_hint hints);
+#endif
+
 int BMI_tcp_post_sendunexpected_list(bmi_op_id_t *id,
                                      bmi_method_addr_p dest,
                                      const void *const *buffer_list,
@@ -257,6 +288,12 @@ struct tcp_op
      */
     void *buffer_list_stub;
     bmi_size_t size_list_stub;
+    /* set for sends whose payload comes from regions of a file rather
+     * than from buffer_list (BMI_tcp_post_send_file())
+     */
+    int file_send;
+    int file_fd;
+    const bmi_size_t *file_offset_list;
 };
 
 /* static io vector for use with readv and writev; we can only use
@@ -296,6 +333,19 @@ static int tcp_shutdown_addr(bmi_method_addr_p map);
 
 static int tcp_do_work(int max_idle_time);
 
+static int tcp_do_ready_work(int socket_count,
+                             bmi_method_addr_p *addr_array,
+                             int *status_array);
+
+static int tcp_make_progress(int max_idle_time,
+                             bmi_context_id context_id);
+
+static socket_collection_p tcp_addr_sc(bmi_method_addr_p map);
+
+static void tcp_complete_op(method_op_p op);
+
+static void tcp_complete_unexp(method_op_p op);
+
 static int tcp_do_work_error(bmi_method_addr_p map);
 
 static int tcp_do_work_recv(bmi_method_addr_p map, 
@@ -355,6 +405,18 @@ static int payload_progress(int s,
                             char *enc_hdr,
                             bmi_size_t *env_amt_complete);
 
+#ifdef BMI_TCP_ENABLE_SENDFILE
+static int file_payload_progress(int s,
+                                 int fd,
+                                 const bmi_size_t *offset_list,
+                                 const bmi_size_t *size_list,
+                                 int list_count,
+                                 int *list_index,
+                                 bmi_size_t *current_index_complete,
+                                 char *enc_hdr,
+                                 bmi_size_t *env_amt_complete);
+#endif
+
 #if defined(USE_TRUSTED) && defined(__PVFS2_CLIENT__)
 static int tcp_enable_trusted(struct tcp_addr *tcp_addr_data);
 #endif
@@ -390,6 +452,9 @@ const struct bmi_method_ops bmi_tcp_ops = {
     .cancel = BMI_tcp_cancel,
     .rev_lookup_unexpected = BMI_tcp_addr_rev_lookup_unexpected,
     .query_addr_range = BMI_tcp_query_addr_range,
+#ifdef BMI_TCP_ENABLE_SENDFILE
+    .post_send_file = BMI_tcp_post_send_file,
+#endif
 };
 
 /* module parameters */
@@ -427,6 +492,58 @@ static op_list_p completion_array[BMI_MAX_CONTEXTS] = { NULL };
 /* internal socket collection */
 static socket_collection_p tcp_socket_collection_p = NULL;
 
+/* set once any address has been placed in a socket collection; the
+ * number of progress threads can't change after that
+ */
+static int tcp_sc_used = 0;
+
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+/* In progress thread mode, each thread owns one shard: an epoll set and
+ * the addresses assigned to it.  Threads poll their own set without
+ * holding interface_mutex, then take it to move data.  Callers of the
+ * test functions never poll; they sleep on the condition of the context
+ * (or of the unexpected queue) they are interested in until a progress
+ * thread completes something there.
+ */
+struct tcp_progress_shard
+{
+    int index;
+    pthread_t thread_id;
+    socket_collection_p scp;
+    int addr_count;
+    /* value of tcp_retire_epoch when this thread last started polling */
+    unsigned long poll_epoch;
+};
+
+enum
+{
+    /* how long a progress thread waits in epoll before checking for
+     * shutdown, in milliseconds */
+    TCP_PROGRESS_POLL_TIMEOUT = 100
+};
+
+static struct tcp_progress_shard *tcp_progress_shards = NULL;
+static int tcp_progress_thread_count = 0;
+static int tcp_progress_running = 0;
+static gen_cond_t tcp_completion_cond[BMI_MAX_CONTEXTS];
+static gen_cond_t tcp_unexp_cond = GEN_COND_INITIALIZER;
+
+/* addresses that have been dropped but may still be referenced by the
+ * results of an epoll_wait() in progress on another thread
+ */
+static unsigned long tcp_retire_epoch = 0;
+static QLIST_HEAD(tcp_retired_addr_list);
+
+static int tcp_progress_start(int thread_count);
+static void tcp_progress_stop(void);
+static void *tcp_progress_thread_function(void *ptr);
+static void tcp_reap_retired_addrs(int force);
+#endif
+
+/* passed to tcp_make_progress() by callers waiting on unexpected
+ * messages rather than on a context */
+#define TCP_UNEXP_CONTEXT (-1)
+
 /* tunable parameters */
 enum
 {
@@ -628,6 +745,14 @@ int BMI_tcp_finalize(void)
 
     gen_mutex_lock(&interface_mutex);
 
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    if (tcp_progress_thread_count > 0)
+    {
+        tcp_progress_stop();
+    }
+#endif
+    tcp_sc_used = 0;
+
     /* shut down our listen addr, if we have one */
     if ((tcp_method_params.method_flags & BMI_INIT_SERVER)
             && tcp_method_params.listen_addr)
@@ -1152,6 +1277,45 @@ int BMI_tcp_set_info(int option,
         break;
     }
 
+    case BMI_TCP_PROGRESS_THREADS:
+    {
+        int thread_count = *(int *)inout_parameter;
+
+        if (thread_count < 0)
+        {
+            ret = bmi_tcp_errno_to_pvfs(-EINVAL);
+            break;
+        }
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+        if (thread_count == tcp_progress_thread_count)
+        {
+            ret = 0;
+        }
+        else if (tcp_progress_running || tcp_sc_used)
+        {
+            gossip_err("Error: the number of TCP progress threads can't "
+                       "be changed once connections have been made.\n");
+            ret = bmi_tcp_errno_to_pvfs(-EINVAL);
+        }
+        else
+        {
+            ret = tcp_progress_start(thread_count);
+        }
+#else
+        if (thread_count > 0)
+        {
+            gossip_err("Error: TCP progress threads require epoll and "
+                       "thread support.\n");
+            ret = bmi_tcp_errno_to_pvfs(-ENOSYS);
+        }
+        else
+        {
+            ret = 0;
+        }
+#endif
+        break;
+    }
+
     default:
 	gossip_ldebug(GOSSIP_BMI_DEBUG_TCP,
                       "TCP hint %d not implemented.\n", option);
@@ -1415,7 +1579,7 @@ int BMI_tcp_test(bmi_op_id_t id,
     gen_mutex_lock(&interface_mutex);
 
     /* do some ``real work'' here */
-    ret = tcp_do_work(max_idle_time);
+    ret = tcp_make_progress(max_idle_time, context_id);
     if (ret < 0)
     {
 	gen_mutex_unlock(&interface_mutex);
@@ -1473,7 +1637,7 @@ int BMI_tcp_testsome(int incount,
     gen_mutex_lock(&interface_mutex);
 
     /* do some ``real work'' here */
-    ret = tcp_do_work(max_idle_time);
+    ret = tcp_make_progress(max_idle_time, context_id);
     if (ret < 0)
     {
         gen_mutex_unlock(&interface_mutex);
@@ -1538,7 +1702,7 @@ int BMI_tcp_testunexpected(int incount,
     if (op_list_empty(op_list_array[IND_COMPLETE_RECV_UNEXP]))
     {
         /* do some ``real work'' here */
-        ret = tcp_do_work(max_idle_time);
+        ret = tcp_make_progress(max_idle_time, TCP_UNEXP_CONTEXT);
         if (ret < 0)
         {
             gen_mutex_unlock(&interface_mutex);
@@ -1606,7 +1770,7 @@ int BMI_tcp_testcontext(int incount,
         }
 
         /* do some ``real work'' here */
-        ret = tcp_do_work(max_idle_time);
+        ret = tcp_make_progress(max_idle_time, context_id);
         if (ret < 0)
         {
             gen_mutex_unlock(&interface_mutex);
@@ -1711,6 +1875,114 @@ int BMI_tcp_post_send_list(bmi_op_id_t *id,
 }
 
 
+#ifdef BMI_TCP_ENABLE_SENDFILE
+/* BMI_tcp_post_send_file()
+ *
+ * same as the BMI_tcp_post_send_list() function, except that the
+ * payload is read straight out of regions of an open file with
+ * sendfile() rather than copied from memory.  The operation is always
+ * queued; if no other send is pending on the address it is started
+ * right away and may already be complete by the time the caller tests
+ * for it.
+ *
+ * returns 0 on success, -errno on failure
+ */
+int BMI_tcp_post_send_file(bmi_op_id_t *id,
+                           bmi_method_addr_p dest,
+                           int fd,
+                           const bmi_size_t *offset_list,
+                           const bmi_size_t *size_list,
+                           int list_count,
+                           bmi_size_t total_size,
+                           bmi_msg_tag_t tag,
+                           void *user_ptr,
+                           bmi_context_id context_id,
+                           PVFS_hint hints)
+{
+    struct tcp_msg_header my_header;
+    struct op_list_search_key key;
+    method_op_p new_op = NULL;
+    struct tcp_op *tcp_op_data = NULL;
+    /* enqueue_operation() wants a buffer list; it is never used */
+    void *unused_buffer = NULL;
+    int blocked_flag = 0;
+    int stall_flag = 0;
+    int ret = -1;
+
+    /* clear the id field for safety */
+    *id = 0;
+
+    if (list_count < 1)
+    {
+        return (bmi_tcp_errno_to_pvfs(-EINVAL));
+    }
+
+    /* fill in the TCP-specific message header */
+    if (total_size > TCP_MODE_REND_LIMIT)
+    {
+	gossip_lerr("Error: BMI message too large!\n");
+	return (bmi_tcp_errno_to_pvfs(-EMSGSIZE));
+    }
+
+    if (total_size <= TCP_MODE_EAGER_LIMIT)
+    {
+	my_header.mode = TCP_MODE_EAGER;
+    }
+    else
+    {
+	my_header.mode = TCP_MODE_REND;
+    }
+    my_header.tag = tag;
+    my_header.size = total_size;
+    my_header.magic_nr = BMI_MAGIC_NR;
+    BMI_TCP_ENC_HDR(my_header);
+
+    gen_mutex_lock(&interface_mutex);
+
+    ret = enqueue_operation(op_list_array[IND_SEND],
+                            BMI_SEND,
+                            dest,
+                            &unused_buffer,
+                            size_list,
+                            list_count,
+                            0,
+                            0,
+                            id,
+                            BMI_TCP_INPROGRESS,
+                            my_header,
+                            user_ptr,
+                            my_header.size,
+                            0,
+                            context_id,
+                            0);
+    if (ret < 0)
+    {
+        gen_mutex_unlock(&interface_mutex);
+        return (ret);
+    }
+
+    new_op = (method_op_p)id_gen_fast_lookup(*id);
+    new_op->buffer_list = NULL;
+    tcp_op_data = new_op->method_data;
+    tcp_op_data->file_send = 1;
+    tcp_op_data->file_fd = fd;
+    tcp_op_data->file_offset_list = offset_list;
+
+    /* start sending now unless an earlier send owns the socket */
+    memset(&key, 0, sizeof(struct op_list_search_key));
+    key.method_addr = dest;
+    key.method_addr_yes = 1;
+    if (op_list_search(op_list_array[IND_SEND], &key) == new_op)
+    {
+        ret = work_on_send_op(new_op, &blocked_flag, &stall_flag);
+    }
+
+    gen_mutex_unlock(&interface_mutex);
+    return (ret);
+}
+#endif
+
+
 /* BMI_tcp_post_recv_list()
  *
  * same as the BMI_tcp_post_recv() function, except that it recvs
@@ -1914,7 +2186,7 @@ int BMI_tcp_cancel(bmi_op_id_t id,
     query_op->error_code = -BMI_ECANCEL;
     if (query_op->send_recv == BMI_SEND)
     {
-	BMI_socket_collection_remove_write_bit(tcp_socket_collection_p,
+	BMI_socket_collection_remove_write_bit(tcp_addr_sc(query_op->addr),
 					       query_op->addr);
     }
     op_list_remove(query_op);
@@ -1926,7 +2198,7 @@ int BMI_tcp_cancel(bmi_op_id_t id,
 	tcp_forget_addr(query_op->addr, 0, -BMI_ECANCEL);
     }
 
-    op_list_add(completion_array[query_op->context_id], query_op);
+    tcp_complete_op(query_op);
 
     gen_mutex_unlock(&interface_mutex);
     return (0);
@@ -2249,11 +2521,15 @@ void tcp_forget_addr(bmi_method_addr_p map,
 
     if (tcp_socket_collection_p && tcp_addr_data->socket >= 0)
     {
-	BMI_socket_collection_remove(tcp_socket_collection_p, map);
+	BMI_socket_collection_remove(tcp_addr_sc(map), map);
 	/* perform a test to force the socket collection to act on the remove
 	 * request before continuing
 	 */
-        if (!sc_test_busy)
+        if (!sc_test_busy
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+            && !tcp_progress_running
+#endif
+           )
         {
             BMI_socket_collection_testglobal(tcp_socket_collection_p,
                                              0, 
@@ -2270,6 +2546,19 @@ void tcp_forget_addr(bmi_method_addr_p map,
     
     if (dealloc_flag)
     {
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+        if (tcp_progress_running)
+        {
+            /* a progress thread may be holding this address in the
+             * results of a poll that is still in flight; free it once
+             * every thread has gone back to polling
+             */
+            tcp_addr_data->retire_epoch = ++tcp_retire_epoch;
+            qlist_add_tail(&tcp_addr_data->retire_link,
+                           &tcp_retired_addr_list);
+            return;
+        }
+#endif
 	dealloc_tcp_method_addr(map);
     }
     else
@@ -2302,6 +2591,13 @@ static void dealloc_tcp_method_addr(bmi_method_addr_p map)
 
     tcp_addr_data = map->method_data;
 
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    if (tcp_addr_data->shard > -1 && tcp_progress_shards)
+    {
+        tcp_progress_shards[tcp_addr_data->shard].addr_count--;
+    }
+#endif
+
     /* close the socket, as long as it is not the one we are listening on
      * as a server.
      */
@@ -2360,6 +2656,7 @@ bmi_method_addr_p alloc_tcp_method_addr(void)
     tcp_addr_data->port = -1;
     tcp_addr_data->map = my_method_addr;
     tcp_addr_data->sc_index = -1;
+    tcp_addr_data->shard = -1;
 
     return (my_method_addr);
 }
@@ -2748,10 +3045,10 @@ static int enqueue_operation(op_list_p target_list,
 #endif
 
     /* add the socket to poll on */
-    BMI_socket_collection_add(tcp_socket_collection_p, map);
+    BMI_socket_collection_add(tcp_addr_sc(map), map);
     if (send_recv == BMI_SEND)
     {
-        BMI_socket_collection_add_write_bit(tcp_socket_collection_p, map);
+        BMI_socket_collection_add_write_bit(tcp_addr_sc(map), map);
     }
 
     /* keep up with the operation */
@@ -3096,15 +3393,13 @@ static int tcp_cleanse_addr(bmi_method_addr_p map,
 		if (query_op->mode == TCP_MODE_UNEXP 
                         && query_op->send_recv == BMI_RECV)
 		{
-		    op_list_add(op_list_array[IND_COMPLETE_RECV_UNEXP],
-				query_op);
+		    tcp_complete_unexp(query_op);
 		}
 		else
 		{
 		    ((struct tcp_op *)(query_op->method_data))->tcp_op_state = 
 			    BMI_TCP_COMPLETE;
-		    op_list_add(completion_array[query_op->context_id], 
-                                query_op);
+		    tcp_complete_op(query_op);
 		}
 	    }
 	}
@@ -3149,11 +3444,8 @@ static int tcp_do_work(int max_idle_time)
     bmi_method_addr_p addr_array[TCP_WORK_METRIC];
     int status_array[TCP_WORK_METRIC];
     int socket_count = 0;
-    int i = 0;
-    int stall_flag = 0;
-    int busy_flag = 1;
+    int busy_flag = 0;
     struct timespec req;
-    struct tcp_addr *tcp_addr_data = NULL;
     struct timespec wait_time;
     struct timeval start;
 
@@ -3211,6 +3503,49 @@ static int tcp_do_work(int max_idle_time)
 	return (ret);
     }
 
+    busy_flag = tcp_do_ready_work(socket_count, addr_array, status_array);
+
+    /* IMPORTANT NOTE: if we have set the following flag, then it indicates that
+     * poll() is finding data on our sockets, yet we are not able to move
+     * any of it right now.  This means that the sockets are backlogged, and
+     * BMI is in danger of busy spinning during test functions.  Let's sleep
+     * for a millisecond here in hopes of letting the rest of the system
+     * catch up somehow (either by clearing a backlog in another I/O
+     * component, or by posting more matching BMI recieve operations)
+     */
+    if (busy_flag)
+    {
+	req.tv_sec = 0;
+	req.tv_nsec = 1000;
+        gen_mutex_unlock(&interface_mutex);
+	nanosleep(&req, NULL);
+        gen_mutex_lock(&interface_mutex);
+    }
+
+    /* wake up anyone else who might have been waiting */
+    gen_cond_broadcast(&interface_cond);
+    return (0);
+}
+
+
+/* tcp_do_ready_work()
+ *
+ * works on the addresses that a poll of the socket collection reported
+ * as ready.  Must be called with interface_mutex held.
+ *
+ * returns 1 if the sockets had data that could not be moved yet, 0
+ * otherwise
+ */
+static int tcp_do_ready_work(int socket_count,
+                             bmi_method_addr_p *addr_array,
+                             int *status_array)
+{
+    int ret = -1;
+    int i = 0;
+    int stall_flag = 0;
+    int busy_flag = 1;
+    struct tcp_addr *tcp_addr_data = NULL;
+
     if (socket_count == 0)
     {
 	busy_flag = 0;
@@ -3269,29 +3604,371 @@ static int tcp_do_work(int max_idle_time)
         }
     }
 
-    /* IMPORTANT NOTE: if we have set the following flag, then it indicates that
-     * poll() is finding data on our sockets, yet we are not able to move
-     * any of it right now.  This means that the sockets are backlogged, and
-     * BMI is in danger of busy spinning during test functions.  Let's sleep
-     * for a millisecond here in hopes of letting the rest of the system
-     * catch up somehow (either by clearing a backlog in another I/O
-     * component, or by posting more matching BMI recieve operations)
-     */
-    if (busy_flag)
+    return (busy_flag);
+}
+
+
+/* tcp_make_progress()
+ *
+ * called by the test functions to move things along.  Without progress
+ * threads the caller polls the sockets itself through tcp_do_work().
+ * With them, the caller just waits up to max_idle_time for a progress
+ * thread to complete something on the given context (or on the
+ * unexpected queue if context_id is TCP_UNEXP_CONTEXT).  Must be called
+ * with interface_mutex held.
+ *
+ * returns 0 on success, -errno on failure
+ */
+static int tcp_make_progress(int max_idle_time,
+                             bmi_context_id context_id)
+{
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    gen_cond_t *wait_cond = NULL;
+    struct timespec wait_time;
+
+    if (tcp_progress_running)
     {
-	req.tv_sec = 0;
-	req.tv_nsec = 1000;
+        if (context_id == TCP_UNEXP_CONTEXT)
+        {
+            if (!op_list_empty(op_list_array[IND_COMPLETE_RECV_UNEXP]))
+            {
+                return (0);
+            }
+            wait_cond = &tcp_unexp_cond;
+        }
+        else
+        {
+            if (!op_list_empty(completion_array[context_id]))
+            {
+                return (0);
+            }
+            wait_cond = &tcp_completion_cond[context_id];
+        }
+
+        if (max_idle_time > 0)
+        {
+            clock_gettime(CLOCK_REALTIME, &wait_time);
+            wait_time.tv_sec += max_idle_time / 1000;
+            wait_time.tv_nsec += (max_idle_time % 1000) * 1000000;
+            if (wait_time.tv_nsec >= 1000000000)
+            {
+                wait_time.tv_nsec -= 1000000000;
+                wait_time.tv_sec++;
+            }
+            gen_cond_timedwait(wait_cond, &interface_mutex, &wait_time);
+        }
+        return (0);
+    }
+#endif
+
+    return (tcp_do_work(max_idle_time));
+}
+
+
+/* tcp_complete_op()
+ *
+ * places a finished operation on the completion queue of its context
+ * and wakes up anyone waiting there.
+ *
+ * no return value
+ */
+static void tcp_complete_op(method_op_p op)
+{
+    op_list_add(completion_array[op->context_id], op);
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    if (tcp_progress_running)
+    {
+        gen_cond_broadcast(&tcp_completion_cond[op->context_id]);
+    }
+#endif
+}
+
+
+/* tcp_complete_unexp()
+ *
+ * places a finished unexpected receive on the unexpected queue and
+ * wakes up anyone waiting for it.
+ *
+ * no return value
+ */
+static void tcp_complete_unexp(method_op_p op)
+{
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    int i;
+#endif
+
+    op_list_add(op_list_array[IND_COMPLETE_RECV_UNEXP], op);
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    if (tcp_progress_running)
+    {
+        gen_cond_broadcast(&tcp_unexp_cond);
+        /* testcontext() returns early when unexpected messages are
+         * waiting so that they get picked up promptly; let it */
+        if (check_unexpected)
+        {
+            for (i = 0; i < BMI_MAX_CONTEXTS; i++)
+            {
+                if (completion_array[i])
+                {
+                    gen_cond_broadcast(&tcp_completion_cond[i]);
+                }
+            }
+        }
+    }
+#endif
+}
+
+
+/* tcp_addr_sc()
+ *
+ * finds the socket collection that an address is polled in, placing the
+ * address on the least loaded progress thread the first time it is seen.
+ *
+ * returns pointer to socket collection
+ */
+static socket_collection_p tcp_addr_sc(bmi_method_addr_p map)
+{
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+    struct tcp_addr *tcp_addr_data = map->method_data;
+    int i;
+
+    if (tcp_progress_thread_count > 0)
+    {
+        if (tcp_addr_data->shard < 0)
+        {
+            tcp_addr_data->shard = 0;
+            for (i = 1; i < tcp_progress_thread_count; i++)
+            {
+                if (tcp_progress_shards[i].addr_count <
+                    tcp_progress_shards[tcp_addr_data->shard].addr_count)
+                {
+                    tcp_addr_data->shard = i;
+                }
+            }
+            tcp_progress_shards[tcp_addr_data->shard].addr_count++;
+        }
+        return (tcp_progress_shards[tcp_addr_data->shard].scp);
+    }
+#endif
+
+    tcp_sc_used = 1;
+    return (tcp_socket_collection_p);
+}
+
+#ifdef BMI_TCP_ENABLE_PROGRESS_THREADS
+
+/* tcp_progress_start()
+ *
+ * launches the progress threads.  The first one takes over the existing
+ * socket collection (which holds the listening socket on servers); the
+ * others get collections of their own.  Must be called with
+ * interface_mutex held, before any address has been polled.
+ *
+ * returns 0 on success, -errno on failure
+ */
+static int tcp_progress_start(int thread_count)
+{
+    int i;
+    int ret;
+
+    tcp_progress_shards = (struct tcp_progress_shard *)
+        calloc(thread_count, sizeof(struct tcp_progress_shard));
+    if (!tcp_progress_shards)
+    {
+        return (bmi_tcp_errno_to_pvfs(-ENOMEM));
+    }
+
+    for (i = 0; i < BMI_MAX_CONTEXTS; i++)
+    {
+        gen_cond_init(&tcp_completion_cond[i]);
+    }
+
+    for (i = 0; i < thread_count; i++)
+    {
+        tcp_progress_shards[i].index = i;
+        tcp_progress_shards[i].thread_id = (pthread_t)0;
+        if (i == 0)
+        {
+            tcp_progress_shards[i].scp = tcp_socket_collection_p;
+        }
+        else
+        {
+            tcp_progress_shards[i].scp = BMI_socket_collection_init(-1);
+        }
+        if (!tcp_progress_shards[i].scp)
+        {
+            tcp_progress_thread_count = i;
+            tcp_progress_stop();
+            return (bmi_tcp_errno_to_pvfs(-ENOMEM));
+        }
+    }
+
+    tcp_progress_thread_count = thread_count;
+    tcp_progress_running = 1;
+
+    for (i = 0; i < thread_count; i++)
+    {
+        ret = pthread_create(&tcp_progress_shards[i].thread_id, NULL,
+                             tcp_progress_thread_function,
+                             &tcp_progress_shards[i]);
+        if (ret != 0)
+        {
+            gossip_err("Error: failed to start TCP progress thread: %s\n",
+                       strerror(ret));
+            tcp_progress_shards[i].thread_id = (pthread_t)0;
+            tcp_progress_stop();
+            return (bmi_tcp_errno_to_pvfs(-ret));
+        }
+    }
+
+    gossip_debug(GOSSIP_BMI_DEBUG_TCP,
+                 "Started %d TCP progress threads.\n", thread_count);
+    return (0);
+}
+
+
+/* tcp_progress_stop()
+ *
+ * stops and joins the progress threads, then releases their socket
+ * collections.  Must be called with interface_mutex held; it is dropped
+ * while waiting for the threads to exit.
+ *
+ * no return value
+ */
+static void tcp_progress_stop(void)
+{
+    int i;
+
+    tcp_progress_running = 0;
+
+    gen_mutex_unlock(&interface_mutex);
+    for (i = 0; i < tcp_progress_thread_count; i++)
+    {
+        if (tcp_progress_shards[i].thread_id)
+        {
+            pthread_join(tcp_progress_shards[i].thread_id, NULL);
+        }
+    }
+    gen_mutex_lock(&interface_mutex);
+
+    tcp_reap_retired_addrs(1);
+
+    /* the first collection is tcp_socket_collection_p; leave it alone */
+    for (i = 1; i < tcp_progress_thread_count; i++)
+    {
+        if (tcp_progress_shards[i].scp)
+        {
+            BMI_socket_collection_finalize(tcp_progress_shards[i].scp);
+        }
+    }
+
+    free(tcp_progress_shards);
+    tcp_progress_shards = NULL;
+    tcp_progress_thread_count = 0;
+}
+
+
+/* tcp_progress_thread_function()
+ *
+ * polls one shard of the sockets and does the work that it finds.  The
+ * poll itself happens without interface_mutex so that the threads wait
+ * on their epoll sets in parallel and the caller threads are never
+ * handed the job of polling.
+ *
+ * Note that epoll is used level-triggered: a socket with a rendezvous
+ * message whose receive has not been posted yet is left alone with data
+ * still queued in it, and with edge triggering no further event would
+ * arrive once the receive is posted.
+ */
+static void *tcp_progress_thread_function(void *ptr)
+{
+    struct tcp_progress_shard *shard = ptr;
+    bmi_method_addr_p addr_array[TCP_WORK_METRIC];
+    int status_array[TCP_WORK_METRIC];
+    int socket_count = 0;
+    int busy_flag = 0;
+    int ret;
+    struct timespec req;
+
+    gen_mutex_lock(&interface_mutex);
+    while (tcp_progress_running)
+    {
+        /* anything retired after this point can't show up in our poll */
+        shard->poll_epoch = tcp_retire_epoch;
         gen_mutex_unlock(&interface_mutex);
-	nanosleep(&req, NULL);
+
+        if (busy_flag)
+        {
+            /* see the note in tcp_do_work() */
+            req.tv_sec = 0;
+            req.tv_nsec = 1000;
+            nanosleep(&req, NULL);
+        }
+
+        ret = BMI_socket_collection_testglobal(shard->scp,
+                                               TCP_WORK_METRIC,
+                                               &socket_count,
+                                               addr_array,
+                                               status_array,
+                                               TCP_PROGRESS_POLL_TIMEOUT);
+
         gen_mutex_lock(&interface_mutex);
+        if (ret < 0)
+        {
+            PVFS_perror_gossip("Error: socket collection:", ret);
+            busy_flag = 1;
+            continue;
+        }
+
+        busy_flag = tcp_do_ready_work(socket_count, addr_array,
+                                      status_array);
+        tcp_reap_retired_addrs(0);
     }
+    gen_mutex_unlock(&interface_mutex);
 
-    /* wake up anyone else who might have been waiting */
-    gen_cond_broadcast(&interface_cond);
-    return (0);
+    return (NULL);
 }
 
 
+/* tcp_reap_retired_addrs()
+ *
+ * deallocates dropped addresses once every progress thread has started
+ * a new poll since they were dropped, or unconditionally if force is
+ * set.  Must be called with interface_mutex held.
+ *
+ * no return value
+ */
+static void tcp_reap_retired_addrs(int force)
+{
+    struct tcp_addr *tcp_addr_data = NULL;
+    struct tcp_addr *tmp_addr_data = NULL;
+    unsigned long min_epoch = tcp_retire_epoch;
+    int i;
+
+    for (i = 0; i < tcp_progress_thread_count; i++)
+    {
+        if (tcp_progress_shards[i].poll_epoch < min_epoch)
+        {
+            min_epoch = tcp_progress_shards[i].poll_epoch;
+        }
+    }
+
+    /* the list is kept in retirement order */
+    qlist_for_each_entry_safe(tcp_addr_data, tmp_addr_data,
+                              &tcp_retired_addr_list, retire_link)
+    {
+        if (!force && tcp_addr_data->retire_epoch > min_epoch)
+        {
+            break;
+        }
+        qlist_del(&tcp_addr_data->retire_link);
+        dealloc_tcp_method_addr(tcp_addr_data->map);
+    }
+}
+
+#endif /* BMI_TCP_ENABLE_PROGRESS_THREADS */
+
+
 /* tcp_do_work_send()
  *
  * does work on a TCP address that is ready to send data.
@@ -3397,7 +4074,7 @@ static int handle_new_connection(bmi_method_addr_p map)
 	return (ret);
     }
 
-    BMI_socket_collection_add(tcp_socket_collection_p, new_addr);
+    BMI_socket_collection_add(tcp_addr_sc(new_addr), new_addr);
 
     dealloc_tcp_method_addr(map);
     return (0);
@@ -3744,6 +4421,21 @@ static int work_on_send_op(method_op_p my_method_op,
 	}
     }
 
+#ifdef BMI_TCP_ENABLE_SENDFILE
+    if (tcp_op_data->file_send)
+    {
+        ret = file_payload_progress(tcp_addr_data->socket,
+                                    tcp_op_data->file_fd,
+                                    tcp_op_data->file_offset_list,
+                                    my_method_op->size_list,
+                                    my_method_op->list_count,
+                                    &(my_method_op->list_index),
+                                    &(my_method_op->cur_index_complete),
+                                    tcp_op_data->env.enc_hdr,
+                                    &my_method_op->env_amt_complete);
+    }
+    else
+#endif
     ret = payload_progress(tcp_addr_data->socket,
 	                   my_method_op->buffer_list,
 	                   my_method_op->size_list,
@@ -3776,12 +4468,12 @@ static int work_on_send_op(method_op_p my_method_op,
     {
 	/* we are done */
 	my_method_op->error_code = 0;
-	BMI_socket_collection_remove_write_bit(tcp_socket_collection_p,
-					       my_method_op->addr);
+	BMI_socket_collection_remove_write_bit(
+            tcp_addr_sc(my_method_op->addr), my_method_op->addr);
 	op_list_remove(my_method_op);
 	((struct tcp_op *) (my_method_op->method_data))->tcp_op_state = 
 	        BMI_TCP_COMPLETE;
-	op_list_add(completion_array[my_method_op->context_id], my_method_op);
+	tcp_complete_op(my_method_op);
 	*blocked_flag = 0;
     }
     else
@@ -3860,15 +4552,13 @@ static int work_on_recv_op(method_op_p my_method_op,
 	    my_method_op->error_code = 0;
 	    if (my_method_op->mode == TCP_MODE_UNEXP)
 	    {
-		op_list_add(op_list_array[IND_COMPLETE_RECV_UNEXP],
-			    my_method_op);
+		tcp_complete_unexp(my_method_op);
 	    }
 	    else
 	    {
 		((struct tcp_op *)(my_method_op->method_data))->tcp_op_state = 
 		        BMI_TCP_COMPLETE;
-		op_list_add(completion_array[my_method_op->context_id], 
-                            my_method_op);
+		tcp_complete_op(my_method_op);
 	    }
 	}
     }
@@ -4595,6 +5285,99 @@ static int payload_progress(int s,
 }
 
 
+#ifdef BMI_TCP_ENABLE_SENDFILE
+/* source of padding for file regions that lie past end of file */
+static char tcp_zero_pad[4096];
+
+/* file_payload_progress()
+ *
+ * makes progress on sending the header and file backed payload of a
+ * message posted with BMI_tcp_post_send_file().  Bytes requested beyond
+ * the end of the file are sent as zeroes, so the receiver always gets
+ * exactly the size announced in the header.
+ *
+ * returns amount of payload completed on success, -errno on failure
+ */
+static int file_payload_progress(int s,
+                                 int fd,
+                                 const bmi_size_t *offset_list,
+                                 const bmi_size_t *size_list,
+                                 int list_count,
+                                 int *list_index,
+                                 bmi_size_t *current_index_complete,
+                                 char *enc_hdr,
+                                 bmi_size_t *env_amt_complete)
+{
+    int completed = 0;
+    bmi_size_t remaining;
+    off_t file_off;
+    ssize_t ret;
+
+    /* do we need to send any of the header?  Cork it so that it leaves
+     * in the same segment as the start of the payload
+     */
+    if (*env_amt_complete < TCP_ENC_HDR_SIZE)
+    {
+        ret = send(s, &enc_hdr[*env_amt_complete],
+                   TCP_ENC_HDR_SIZE - *env_amt_complete,
+                   MSG_MORE | MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                return (0);
+            }
+            return (bmi_tcp_errno_to_pvfs(-errno));
+        }
+        *env_amt_complete += ret;
+        if (*env_amt_complete < TCP_ENC_HDR_SIZE)
+        {
+            return (0);
+        }
+    }
+
+    while (*list_index < list_count)
+    {
+        remaining = size_list[*list_index] - *current_index_complete;
+        if (remaining > 0)
+        {
+            file_off = offset_list[*list_index] + *current_index_complete;
+            ret = sendfile(s, fd, &file_off, remaining);
+            if (ret == 0)
+            {
+                /* short file; pad out the rest of this region */
+                if (remaining > (bmi_size_t)sizeof(tcp_zero_pad))
+                {
+                    remaining = sizeof(tcp_zero_pad);
+                }
+                ret = send(s, tcp_zero_pad, remaining,
+                           MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+            if (ret < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK ||
+                    errno == EINTR)
+                {
+                    break;
+                }
+                return (bmi_tcp_errno_to_pvfs(-errno));
+            }
+            completed += ret;
+            *current_index_complete += ret;
+        }
+
+        if (*current_index_complete == size_list[*list_index])
+        {
+            (*list_index)++;
+            *current_index_complete = 0;
+        }
+    }
+
+    return (completed);
+}
+#endif
+
+
 static void bmi_set_sock_buffers(int socket)
 {
     /* Set socket buffer sizes */
@@ -96,6 +96,7 @@ socket_collection_p BMI_socket_collection_init(int new_server_socket)
  */
 void BMI_socket_collection_finalize(socket_collection_p scp)
 {
+    close(scp->epfd);
     free(scp);
     return;
 }
@@ -569,7 +569,7 @@ zoid_server_test_common(int incount, bmi_op_id_t* id_array,
 	/* Testcontext.  */
 	method_op_p op, tmp;
 
-	qlist_for_each_entry_safe(op, tmp, error_ops, op_list_entry)
+	qlist_for_each_entry_safe(op, tmp, &error_ops->ops, op_list_entry)
 	{
 	    if (outcount_used >= outcount_max)
 		break;
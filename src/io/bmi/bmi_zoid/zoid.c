@@ -635,7 +635,7 @@ BMI_zoid_testcontext(int incount, bmi_op_id_t* out_id_array, int* outcount,
 	method_op_p met;
 
 	i = 0;
-	qlist_for_each_entry(met, zoid_ops, op_list_entry)
+	qlist_for_each_entry(met, &zoid_ops->ops, op_list_entry)
 	    tmp_id_array[i++] = met->op_id;
 
 	ret = zoid_test_common(pending_count, tmp_id_array, incount, outcount,
@@ -18,6 +18,8 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <errno.h>
 
 #include "bmi-method-support.h"
@@ -25,6 +27,9 @@
 #include "pvfs2-internal.h"
 #include "gossip.h"
 
+/* sizes of the per-list indexes; must be powers of two */
+#define OP_LIST_ADDR_TABLE_SIZE 64
+#define OP_LIST_MATCH_TABLE_SIZE 256
 
 /***************************************************************
  * Function prototypes
@@ -33,6 +38,10 @@
 static void gossip_print_op(method_op_p print_op);
 static int op_list_cmp_key(struct op_list_search_key *my_key,
 			   method_op_p my_op);
+static int op_list_addr_hash(const void *key, int table_size);
+static int op_list_addr_compare(const void *key, struct qhash_head *link);
+static int op_list_match_hash(const void *key, int table_size);
+static int op_list_match_compare(const void *key, struct qhash_head *link);
 
 /***************************************************************
  * Visible functions
@@ -47,10 +56,10 @@ static int op_list_cmp_key(struct op_list_search_key *my_key,
  */
 void op_list_dump(op_list_p olp)
 {
-    op_list_p tmp_entry = NULL;
+    struct qlist_head *tmp_entry = NULL;
 
     gossip_err("op_list_dump():\n");
-    qlist_for_each(tmp_entry, olp)
+    qlist_for_each(tmp_entry, &olp->ops)
     {
 	gossip_print_op(qlist_entry(tmp_entry, struct method_op,
 				    op_list_entry));
@@ -68,8 +77,8 @@ void op_list_dump(op_list_p olp)
 int op_list_count(op_list_p olp)
 {
     int count = 0;
-    op_list_p tmp_entry = NULL;
-    qlist_for_each(tmp_entry, olp)
+    struct qlist_head *tmp_entry = NULL;
+    qlist_for_each(tmp_entry, &olp->ops)
     {
 	count++;
     }
@@ -86,12 +95,30 @@ int op_list_count(op_list_p olp)
  */
 op_list_p op_list_new(void)
 {
-    struct qlist_head *tmp_op_list = NULL;
+    op_list_p tmp_op_list = NULL;
 
-    tmp_op_list = (struct qlist_head *) malloc(sizeof(struct qlist_head));
-    if (tmp_op_list)
+    tmp_op_list = (op_list_p) malloc(sizeof(struct op_list));
+    if (!tmp_op_list)
     {
-	INIT_QLIST_HEAD(tmp_op_list);
+	return (NULL);
+    }
+    INIT_QLIST_HEAD(&tmp_op_list->ops);
+
+    tmp_op_list->addr_table = qhash_init(op_list_addr_compare,
+	op_list_addr_hash, OP_LIST_ADDR_TABLE_SIZE);
+    if (!tmp_op_list->addr_table)
+    {
+	free(tmp_op_list);
+	return (NULL);
+    }
+
+    tmp_op_list->match_table = qhash_init(op_list_match_compare,
+	op_list_match_hash, OP_LIST_MATCH_TABLE_SIZE);
+    if (!tmp_op_list->match_table)
+    {
+	qhash_finalize(tmp_op_list->addr_table);
+	free(tmp_op_list);
+	return (NULL);
     }
 
     return (tmp_op_list);
@@ -107,11 +134,21 @@ op_list_p op_list_new(void)
 void op_list_add(op_list_p olp,
 		 method_op_p oip)
 {
+    struct op_list_search_key key;
+
     /* note we are adding to tail:
      * most modules will want to preserve FIFO ordering when searching
-     * through op_lists for work to do.
+     * through op_lists for work to do.  qhash_add() also appends to
+     * the tail of its bucket, so each index chain stays in FIFO order
+     * as well.
      */
-    qlist_add_tail(&(oip->op_list_entry), olp);
+    qlist_add_tail(&(oip->op_list_entry), &olp->ops);
+
+    memset(&key, 0, sizeof(key));
+    key.method_addr = oip->addr;
+    key.msg_tag = oip->msg_tag;
+    qhash_add(olp->addr_table, &key, &(oip->op_addr_link));
+    qhash_add(olp->match_table, &key, &(oip->op_match_link));
 }
 
 /*
@@ -123,16 +160,18 @@ void op_list_add(op_list_p olp,
  */
 void op_list_cleanup(op_list_p olp)
 {
-    op_list_p iterator = NULL;
-    op_list_p scratch = NULL;
+    struct qlist_head *iterator = NULL;
+    struct qlist_head *scratch = NULL;
     method_op_p tmp_method_op = NULL;
 
-    qlist_for_each_safe(iterator, scratch, olp)
+    qlist_for_each_safe(iterator, scratch, &olp->ops)
     {
 	tmp_method_op = qlist_entry(iterator, struct method_op,
 				    op_list_entry);
 	bmi_dealloc_method_op(tmp_method_op);
     }
+    qhash_finalize(olp->addr_table);
+    qhash_finalize(olp->match_table);
     free(olp);
     olp = NULL;
 }
@@ -145,7 +184,7 @@ void op_list_cleanup(op_list_p olp)
  */
 int op_list_empty(op_list_p olp)
 {
-    return (qlist_empty(olp));
+    return (qlist_empty(&olp->ops));
 }
 
 
@@ -160,6 +199,8 @@ int op_list_empty(op_list_p olp)
 void op_list_remove(method_op_p oip)
 {
     qlist_del(&(oip->op_list_entry));
+    qhash_del(&(oip->op_addr_link));
+    qhash_del(&(oip->op_match_link));
 }
 
 
@@ -168,13 +209,39 @@ void op_list_remove(method_op_p oip)
  * Searches the operation list based on parameters in the
  * op_list_search_key structure.  Returns first match.
  *
+ * Keys that name an address (and optionally a tag) are resolved through
+ * the hash indexes; only the bucket chain for that address or (address,
+ * tag) pair is walked.  Any other key falls back to a scan of the whole
+ * list.
+ *
  * returns pointer to operation on success, NULL on failure.
  */
 method_op_p op_list_search(op_list_p olp,
 			   struct op_list_search_key *key)
 {
-    op_list_p tmp_entry = NULL;
-    qlist_for_each(tmp_entry, olp)
+    struct qlist_head *tmp_entry = NULL;
+    struct qhash_head *tmp_link = NULL;
+
+    if (key->method_addr_yes && key->msg_tag_yes)
+    {
+	tmp_link = qhash_search(olp->match_table, key);
+	if (!tmp_link)
+	{
+	    return (NULL);
+	}
+	return (qhash_entry(tmp_link, struct method_op, op_match_link));
+    }
+    if (key->method_addr_yes)
+    {
+	tmp_link = qhash_search(olp->addr_table, key);
+	if (!tmp_link)
+	{
+	    return (NULL);
+	}
+	return (qhash_entry(tmp_link, struct method_op, op_addr_link));
+    }
+
+    qlist_for_each(tmp_entry, &olp->ops)
     {
 	if (!(op_list_cmp_key(key, qlist_entry(tmp_entry, struct method_op,
 					       op_list_entry))))
@@ -194,11 +261,11 @@ method_op_p op_list_search(op_list_p olp,
  */
 method_op_p op_list_shownext(op_list_p olp)
 {
-    if (olp->next == olp)
+    if (qlist_empty(&olp->ops))
     {
 	return (NULL);
     }
-    return (qlist_entry(olp->next, struct method_op, op_list_entry));
+    return (qlist_entry(olp->ops.next, struct method_op, op_list_entry));
 }
 
 /****************************************************************
@@ -233,6 +300,66 @@ static int op_list_cmp_key(struct op_list_search_key *my_key,
 }
 
 
+/* op_list_addr_hash()
+ *
+ * hash function for the address index; the key is an
+ * op_list_search_key with method_addr filled in.
+ *
+ * returns index into hash table
+ */
+static int op_list_addr_hash(const void *key, int table_size)
+{
+    const struct op_list_search_key *my_key = key;
+    uint64_t addr = (uint64_t) (uintptr_t) my_key->method_addr;
+
+    return (quickhash_64bit_hash(&addr, table_size));
+}
+
+/* op_list_addr_compare()
+ *
+ * compare function for the address index.  Applies the full search
+ * key so that ops sharing a bucket with the wanted address, or not
+ * matching an op_id restriction, are skipped.
+ *
+ * returns 1 on match, 0 otherwise
+ */
+static int op_list_addr_compare(const void *key, struct qhash_head *link)
+{
+    method_op_p my_op = qhash_entry(link, struct method_op, op_addr_link);
+
+    return (!op_list_cmp_key((struct op_list_search_key *) key, my_op));
+}
+
+/* op_list_match_hash()
+ *
+ * hash function for the (address, tag) index.
+ *
+ * returns index into hash table
+ */
+static int op_list_match_hash(const void *key, int table_size)
+{
+    const struct op_list_search_key *my_key = key;
+    uint64_t match = (uint64_t) (uintptr_t) my_key->method_addr;
+
+    match ^= ((uint64_t) (uint32_t) my_key->msg_tag) << 32;
+    match ^= (uint64_t) (uint32_t) my_key->msg_tag;
+
+    return (quickhash_64bit_hash(&match, table_size));
+}
+
+/* op_list_match_compare()
+ *
+ * compare function for the (address, tag) index
+ *
+ * returns 1 on match, 0 otherwise
+ */
+static int op_list_match_compare(const void *key, struct qhash_head *link)
+{
+    method_op_p my_op = qhash_entry(link, struct method_op, op_match_link);
+
+    return (!op_list_cmp_key((struct op_list_search_key *) key, my_op));
+}
+
 static void gossip_print_op(method_op_p print_op)
 {
 
@@ -7,6 +7,10 @@
 /* linked list implementation based on quicklist; used for storing network
  * operations 
  *
+ * each list also keeps two quickhash indexes over its entries, one keyed
+ * on peer address and one keyed on (address, tag), so that matching an
+ * incoming message does not have to walk every outstanding operation.
+ *
  * this is provided for use by network method implementations
  */
 
@@ -15,10 +19,17 @@
 
 #include "pvfs2-internal.h"
 #include "quicklist.h"
+#include "quickhash.h"
 #include "bmi-types.h"
 #include "bmi-method-support.h"
 
-typedef struct qlist_head *op_list_p;
+struct op_list
+{
+    struct qlist_head ops;	/* all operations, in FIFO order */
+    struct qhash_table *addr_table;	/* operations indexed by address */
+    struct qhash_table *match_table;	/* indexed by (address, tag) */
+};
+typedef struct op_list *op_list_p;
 
 /* these are the search parameters that may be used */
 /* TODO: this is ridiculous; we don't need half of these fields, really;
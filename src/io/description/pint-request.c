@@ -19,6 +19,8 @@ typedef uint32_t u_int32_t;
 #endif
 
 static PVFS_offset PINT_request_disp(PINT_Request *request);
+static int64_t PINT_flat_skip(PINT_Request_state *req, PINT_Request_run *run,
+		PINT_request_file_data *rfdata, int mode);
 
 /* this macro is only used in this file to add a segment to the
  * result list.
@@ -199,8 +201,24 @@ int PINT_process_request(PINT_Request_state *req,
                        lld(mem->final_offset));
                }
 	     }
+		/* flattened request - the next chunk comes from the runs */
+		if (req->flat)
+		{
+			PINT_Request_run *run = &req->flat->runs[req->flat_run];
+			if (req->bytes == 0)
+			{
+				int64_t skip = PINT_flat_skip(req, run, rfdata, mode);
+				req->flat_el += skip;
+				req->type_offset += skip * run->size;
+			}
+			contig_offset = req->cur[0].chunk_offset +
+					(req->cur[0].el * req->flat->extent) + run->offset +
+					(run->stride * req->flat_el) + req->bytes;
+			contig_size = run->size - req->bytes;
+			lvl_flag = 0;
+		}
 		/* NULL type indicates packed data - handle directly */
-		if (req->cur[req->lvl].rq == NULL)
+		else if (req->cur[req->lvl].rq == NULL)
 		{
 			gossip_debug(GOSSIP_REQUEST_DEBUG,"\tnull type\n");
 			contig_offset = req->cur[req->lvl].chunk_offset + req->bytes;
@@ -378,30 +396,51 @@ int PINT_process_request(PINT_Request_state *req,
 			/* we have processed the entire request */
 			break;
 		}
-		/* go to the next block */
-		gossip_debug(GOSSIP_REQUEST_DEBUG,"\tgoing to next block\n");
-		req->cur[req->lvl].blk++;
-		if (req->cur[req->lvl].blk >= req->cur[req->lvl].rq->num_blocks)
+		if (req->flat)
 		{
-			/* that was the last block */
-			req->cur[req->lvl].blk = 0;
-			/* go to next item in sequence chain */
-			gossip_debug(GOSSIP_REQUEST_DEBUG,"\tgoing to next item in sequence chain\n");
-			req->cur[req->lvl].rq = req->cur[req->lvl].rq->sreq;
-			if (req->cur[req->lvl].rq == NULL)
+			/* go to the next chunk, run, or instance of the request */
+			if (++req->flat_el >= req->flat->runs[req->flat_run].count)
 			{
-				/* that was last item in sequence chain */
-				req->cur[req->lvl].rq = req->cur[req->lvl].rqbase;
-				/* go to next element in block of level above */
-				gossip_debug(GOSSIP_REQUEST_DEBUG,
-						"\tgoing to next element in block of level above\n");
-				req->cur[req->lvl].el++;
-				if (req->cur[req->lvl].el >= req->cur[req->lvl].maxel)
+				req->flat_el = 0;
+				if (++req->flat_run >= req->flat->num_runs)
+				{
+					req->flat_run = 0;
+					req->cur[0].el++;
+					if (req->cur[0].el >= req->cur[0].maxel)
+					{
+						req->lvl--;
+						goto return_from_level;
+					}
+				}
+			}
+		}
+		else
+		{
+			/* go to the next block */
+			gossip_debug(GOSSIP_REQUEST_DEBUG,"\tgoing to next block\n");
+			req->cur[req->lvl].blk++;
+			if (req->cur[req->lvl].blk >= req->cur[req->lvl].rq->num_blocks)
+			{
+				/* that was the last block */
+				req->cur[req->lvl].blk = 0;
+				/* go to next item in sequence chain */
+				gossip_debug(GOSSIP_REQUEST_DEBUG,"\tgoing to next item in sequence chain\n");
+				req->cur[req->lvl].rq = req->cur[req->lvl].rq->sreq;
+				if (req->cur[req->lvl].rq == NULL)
 				{
-					/* that was last element in block of level above */
-					req->lvl--;
-					/* go back up a level */
-					goto return_from_level;
+					/* that was last item in sequence chain */
+					req->cur[req->lvl].rq = req->cur[req->lvl].rqbase;
+					/* go to next element in block of level above */
+					gossip_debug(GOSSIP_REQUEST_DEBUG,
+							"\tgoing to next element in block of level above\n");
+					req->cur[req->lvl].el++;
+					if (req->cur[req->lvl].el >= req->cur[req->lvl].maxel)
+					{
+						/* that was last element in block of level above */
+						req->lvl--;
+						/* go back up a level */
+						goto return_from_level;
+					}
 				}
 			}
 		}
@@ -434,6 +473,74 @@ int PINT_process_request(PINT_Request_state *req,
 	return 0;
 }
 
+/* Returns how many chunks of the current run, starting with the */
+/* current one, can be passed over without looking at them one at a */
+/* time: chunks that end before the target offset while skipping, or */
+/* that lie entirely between this server's strips.  PINT_distribute */
+/* would only have added their size to type_offset.  One such chunk */
+/* is always left for the regular path, which then sets eof_flag and */
+/* the rest of the state exactly as before. */
+static int64_t PINT_flat_skip(PINT_Request_state *req, PINT_Request_run *run,
+		PINT_request_file_data *rfdata, int mode)
+{
+	PVFS_offset offset;
+	PVFS_offset loff;
+	int64_t n;
+	int64_t max;
+
+	if (run->size <= 0 || run->stride <= 0 ||
+			run->count - req->flat_el < 3 ||
+			req->final_offset - req->type_offset <= run->size)
+	{
+		return 0;
+	}
+	if (PINT_IS_LOGICAL_SKIP(mode))
+	{
+		if (req->target_offset <= req->type_offset)
+		{
+			return 0;
+		}
+		/* chunks ending before the target */
+		n = (req->target_offset - req->type_offset - 1) / run->size;
+	}
+	else if (!PINT_IS_MEMREQ(mode) && rfdata && rfdata->server_ct > 1 &&
+			rfdata->dist && rfdata->dist->methods && rfdata->dist->params)
+	{
+		offset = req->cur[0].chunk_offset +
+				(req->cur[0].el * req->flat->extent) + run->offset +
+				(run->stride * req->flat_el);
+		loff = (*rfdata->dist->methods->next_mapped_offset)
+				(rfdata->dist->params, rfdata, offset);
+		if (loff == -1 || loff < offset + run->size)
+		{
+			return 0;
+		}
+		/* chunks ending before the next byte on this server */
+		n = (loff - offset - run->size) / run->stride + 1;
+	}
+	else
+	{
+		return 0;
+	}
+	/* stay inside the run and short of final_offset */
+	max = run->count - req->flat_el - 1;
+	if (n - 1 < max)
+	{
+		max = n - 1;
+	}
+	n = (req->final_offset - req->type_offset - 1) / run->size;
+	if (n < max)
+	{
+		max = n;
+	}
+	if (max > 0)
+	{
+		gossip_debug(GOSSIP_REQUEST_DEBUG, "\tpassing over %lld chunks\n",
+				lld(max));
+	}
+	return (max > 0) ? max : 0;
+}
+
 /* this function runs down the ereq list and adds up the offsets */
 /* present in the request records */
 static PVFS_offset PINT_request_disp(PINT_Request *request)
@@ -448,6 +555,187 @@ static PVFS_offset PINT_request_disp(PINT_Request *request)
 	return disp;
 }
 
+/* Flattening walks the request tree once, visiting contiguous chunks in
+ * the same order and with the same tests as PINT_process_request, and
+ * records them as runs.  A level whose element type is contiguous adds
+ * all of its blocks as one run, so vectors cost one step no matter how
+ * many blocks they have.  Requests that need more runs or steps than
+ * the limits below are left to the tree walk.
+ */
+#define PINT_FLAT_MAX_RUNS  1024
+#define PINT_FLAT_MAX_STEPS 65536
+
+int PINT_request_flatten = 1;
+
+struct flat_builder {
+	PINT_Request_flat *flat;
+	int32_t max_runs;          /* runs allocated */
+	int32_t steps;             /* tree steps taken so far */
+	int32_t depth;             /* depth of the request */
+};
+
+/* adds count chunks of size bytes, stride apart, merging them into the */
+/* last run when they continue it */
+static int flat_add_run(struct flat_builder *fb, PVFS_offset offset,
+		PVFS_size size, PVFS_size stride, int64_t count)
+{
+	PINT_Request_flat *flat = fb->flat;
+	PINT_Request_run *last;
+
+	if (flat->num_runs > 0)
+	{
+		last = &flat->runs[flat->num_runs - 1];
+		if (last->size == size)
+		{
+			if (last->count == 1 &&
+					(count == 1 || offset - last->offset == stride))
+			{
+				last->stride = offset - last->offset;
+				last->count += count;
+				return 0;
+			}
+			if (offset == last->offset + (last->count * last->stride) &&
+					(count == 1 || stride == last->stride))
+			{
+				last->count += count;
+				return 0;
+			}
+		}
+	}
+	if (flat->num_runs == fb->max_runs)
+	{
+		PINT_Request_run *runs;
+		if (fb->max_runs >= PINT_FLAT_MAX_RUNS)
+		{
+			return -1;
+		}
+		runs = realloc(flat->runs, 2 * fb->max_runs * sizeof(*runs));
+		if (!runs)
+		{
+			return -1;
+		}
+		flat->runs = runs;
+		fb->max_runs *= 2;
+	}
+	last = &flat->runs[flat->num_runs++];
+	last->offset = offset;
+	last->size = size;
+	last->stride = (count > 1) ? stride : 0;
+	last->count = count;
+	return 0;
+}
+
+/* flattens maxel elements of the sequence chain starting at rqbase, */
+/* the way PINT_process_request handles one level of its stack */
+static int flat_do_level(struct flat_builder *fb, PINT_Request *rqbase,
+		int64_t maxel, PVFS_offset chunk_offset, int32_t lvl)
+{
+	PINT_Request *rq;
+	PVFS_size extent = rqbase->ub - rqbase->lb;
+	int64_t el;
+	int32_t blk;
+
+	/* contiguous data - the whole level is one chunk */
+	if (rqbase->ereq == NULL ||
+			(rqbase->aggregate_size == extent &&
+			 rqbase->ereq->num_contig_chunks == 1))
+	{
+		return flat_add_run(fb, rqbase->offset + chunk_offset +
+				PINT_request_disp(rqbase), maxel * rqbase->aggregate_size,
+				0, 1);
+	}
+	/* the stack visits each level at least once */
+	el = 0;
+	do
+	{
+		for (rq = rqbase; rq; rq = rq->sreq)
+		{
+			if (++fb->steps > PINT_FLAT_MAX_STEPS || !rq->ereq)
+			{
+				return -1;
+			}
+			/* subtype is contiguous - one chunk per block */
+			if (rq->ereq->aggregate_size ==
+					(rq->ereq->ub - rq->ereq->lb) &&
+					rq->ereq->num_contig_chunks == 1)
+			{
+				if (flat_add_run(fb, chunk_offset + (el * extent) +
+						rq->offset + PINT_request_disp(rq),
+						rq->ereq->aggregate_size * rq->num_ereqs,
+						rq->stride,
+						(rq->num_blocks > 1) ? rq->num_blocks : 1) < 0)
+				{
+					return -1;
+				}
+				continue;
+			}
+			/* otherwise go down a level for each block */
+			if (lvl + 1 >= fb->depth)
+			{
+				return -1;
+			}
+			blk = 0;
+			do
+			{
+				if (++fb->steps > PINT_FLAT_MAX_STEPS ||
+						flat_do_level(fb, rq->ereq, rq->num_ereqs,
+							chunk_offset + (el * extent) + rq->offset +
+							(rq->stride * blk), lvl + 1) < 0)
+				{
+					return -1;
+				}
+			} while (++blk < rq->num_blocks);
+		}
+	} while (++el < maxel);
+	return 0;
+}
+
+/* returns the flattened form of one instance of request, or NULL if */
+/* request is contiguous anyway or too irregular to be worth it */
+static PINT_Request_flat *PINT_request_flatten_new(PINT_Request *request)
+{
+	struct flat_builder fb;
+
+	if (!request || !PINT_request_flatten || request->ereq == NULL ||
+			(request->aggregate_size == request->ub - request->lb &&
+			 request->ereq->num_contig_chunks == 1))
+	{
+		return NULL;
+	}
+	fb.flat = malloc(sizeof(*fb.flat));
+	if (!fb.flat)
+	{
+		return NULL;
+	}
+	fb.max_runs = 8;
+	fb.steps = 0;
+	fb.depth = request->depth;
+	fb.flat->extent = request->ub - request->lb;
+	fb.flat->num_runs = 0;
+	fb.flat->runs = malloc(fb.max_runs * sizeof(*fb.flat->runs));
+	if (!fb.flat->runs || flat_do_level(&fb, request, 1, 0, 0) < 0 ||
+			fb.flat->num_runs == 0)
+	{
+		gossip_debug(GOSSIP_REQUEST_DEBUG,
+				"%s: request not flattened (%d steps)\n", __func__, fb.steps);
+		free(fb.flat->runs);
+		free(fb.flat);
+		return NULL;
+	}
+	gossip_debug(GOSSIP_REQUEST_DEBUG, "%s: %d runs from %d steps\n",
+			__func__, fb.flat->num_runs, fb.steps);
+	return fb.flat;
+}
+
+static void PINT_request_flatten_free(PINT_Request_flat *flat)
+{
+	if (flat)
+	{
+		free(flat->runs);
+		free(flat);
+	}
+}
+
 /* This function creates a request state and sets it up to begin */
 /* processing a request */
 struct PINT_Request_state *PINT_new_request_state(PINT_Request *request)
@@ -458,6 +746,7 @@ struct PINT_Request_state *PINT_new_request_state(PINT_Request *request)
 struct PINT_Request_state *PINT_new_request_states(PINT_Request *request, int n)
 {
 	struct PINT_Request_state *reqs;
+	PINT_Request_flat *flat;
 	int rqdepth, i;
 
 	gossip_debug(GOSSIP_REQUEST_DEBUG, "%s n=%d\n", __func__, n);
@@ -478,6 +767,8 @@ struct PINT_Request_state *PINT_new_request_states(PINT_Request *request, int n)
 		gossip_lerr("%s: malloc failed\n", __func__);
 		return NULL;
 	}
+	/* all of the states share one flattened request */
+	flat = PINT_request_flatten_new(request);
 
     for (i=0; i<n; i++)
     {
@@ -490,6 +781,9 @@ struct PINT_Request_state *PINT_new_request_states(PINT_Request *request, int n)
         reqs[i].target_offset = 0;
         reqs[i].final_offset = request->aggregate_size;
         reqs[i].eof_flag = 0;
+        reqs[i].flat = flat;
+        reqs[i].flat_run = 0;
+        reqs[i].flat_el = 0;
 
         reqs[i].cur[0].maxel = 1; /* transfer one instance of request */
         reqs[i].cur[0].el = 0;
@@ -505,11 +799,15 @@ struct PINT_Request_state *PINT_new_request_states(PINT_Request *request, int n)
 /* This function frees request state structures */
 void PINT_free_request_state(PINT_Request_state *req)
 {
-	free(req);
+	PINT_free_request_states(req);
 }
 
 void PINT_free_request_states(PINT_Request_state *reqs)
 {
+	if (reqs)
+	{
+		PINT_request_flatten_free(reqs[0].flat);
+	}
 	free(reqs);
 }
 
@@ -77,6 +77,24 @@ typedef struct PINT_reqstack {
 	PVFS_offset  chunk_offset; /* offset of beginning of current contiguous chunk */
 } PINT_reqstack;           
           
+/* A flattened request lists the contiguous chunks of one instance of a
+ * request type, in the order the element chain stack would visit them,
+ * as runs of equally sized chunks at a constant stride.  Request states
+ * that have one step through the runs instead of walking the tree.
+ */
+typedef struct PINT_Request_run {
+	PVFS_offset  offset;       /* offset of the first chunk */
+	PVFS_size    size;         /* size of each chunk */
+	PVFS_size    stride;       /* distance from one chunk to the next */
+	int64_t      count;        /* number of chunks */
+} PINT_Request_run;
+
+typedef struct PINT_Request_flat {
+	PVFS_size    extent;       /* distance between instances (ub - lb) */
+	int32_t      num_runs;     /* number of runs */
+	PINT_Request_run *runs;    /* the runs, in processing order */
+} PINT_Request_flat;
+
 typedef struct PINT_Request_state { 
 	struct PINT_reqstack *cur; /* request element chain stack */
 	int32_t      lvl;          /* level in element chain */
@@ -85,6 +103,9 @@ typedef struct PINT_Request_state {
 	PVFS_offset  target_offset;/* first type offset to process */
 	PVFS_offset  final_offset; /* last type offset to process */
 	PVFS_boolean eof_flag;     /* is file at end of flile */
+	PINT_Request_flat *flat;   /* flattened request, NULL to walk the tree */
+	int32_t      flat_run;     /* run being processed if flattened */
+	int64_t      flat_el;      /* chunk within that run */
 } PINT_Request_state;           
 /* NOTE - I think buf_offset is superceded by type_offset
  * and start_offset can be completely replced with last_offset
@@ -115,6 +136,9 @@ struct PINT_Request_state *PINT_new_request_states(PINT_Request *request,
                                                    int n);
 void PINT_free_request_states(PINT_Request_state *reqs);
 
+/* request states flatten their request when this is nonzero (default) */
+extern int PINT_request_flatten;
+
 /* generate offset length pairs from request and dist */
 int PINT_process_request(PINT_Request_state *req,
 		PINT_Request_state *mem,
@@ -199,6 +223,8 @@ void PINT_dump_request(struct PINT_Request *req);
 	((reqp)->cur[0].rq) = ((reqp)->cur[0].rqbase);\
 	((reqp)->cur[0].blk) = 0;\
 	((reqp)->cur[0].chunk_offset) = 0;\
+	((reqp)->flat_run) = 0;\
+	((reqp)->flat_el) = 0;\
 	}while(0)
 
 /* this one DOES zero the start_offset 
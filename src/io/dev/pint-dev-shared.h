@@ -49,8 +49,9 @@
 #define PVFS2_BUFMAP_DEFAULT_TOTAL_SIZE \
 (PVFS2_BUFMAP_DEFAULT_DESC_COUNT * PVFS2_BUFMAP_DEFAULT_DESC_SIZE)
 
-/* Sane maximum values for these parameters (128 MB) */
-#define PVFS2_BUFMAP_MAX_TOTAL_SIZE      (128ULL * (1024 * 1024))
+/* Sane maximum values for these parameters (1 GB) - enough for a
+ * descriptor per concurrent I/O on large nodes, see --desc-count */
+#define PVFS2_BUFMAP_MAX_TOTAL_SIZE      (1024ULL * (1024 * 1024))
 
 /* log to base 2 when we know that number is a power of 2 */
 static inline int LOG2(int number)
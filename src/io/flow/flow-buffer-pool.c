@@ -0,0 +1,705 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/* server-wide pool of BMI buffers shared by all flows; see
+ * flow-buffer-pool.h for an overview
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "gossip.h"
+#include "quicklist.h"
+#include "quickhash.h"
+#include "gen-locks.h"
+#include "pvfs2-internal.h"
+#include "pvfs2-debug.h"
+#include "pint-perf-counter.h"
+#include "flow-buffer-pool.h"
+
+/* size classes are powers of two from 4K to 64M; larger buffers are
+ * allocated directly and never cached
+ */
+#define POOL_MIN_SHIFT 12
+#define POOL_CLASS_COUNT 15
+#define POOL_MAX_NODES 8
+#define POOL_HASH_SIZE 1021
+
+/* one buffer, either handed out (in the in-use table) or idle (on its
+ * bucket's free list and on the pool-wide lru list)
+ */
+struct pool_buffer
+{
+    void *buffer;
+    bmi_size_t alloc_size;
+    int method;
+    enum bmi_op_type send_recv;
+    int size_class;             /* -1 if never cached */
+    int node;
+    struct pool_bucket *bucket;
+    struct qlist_head hash_link;
+    struct qlist_head free_link;
+    struct qlist_head lru_link;
+};
+
+/* idle buffers with the same method, direction and size class */
+struct pool_bucket
+{
+    int method;
+    enum bmi_op_type send_recv;
+    int size_class;
+    struct qlist_head free_list[POOL_MAX_NODES];
+    struct qlist_head link;
+};
+
+static gen_mutex_t pool_mutex = GEN_MUTEX_INITIALIZER;
+static int pool_initialized = 0;
+static PVFS_size pool_max_bytes = 0;
+static PVFS_size pool_inuse_bytes = 0;
+static PVFS_size pool_cached_bytes = 0;
+static struct qhash_table *pool_inuse_table = NULL;
+static QLIST_HEAD(pool_bucket_list);
+static QLIST_HEAD(pool_lru_list);
+static QLIST_HEAD(pool_wait_list);
+
+static int hash_buffer(const void *key, int table_size);
+static int hash_buffer_compare(const void *key, struct qlist_head *link);
+
+/* pool_node()
+ *
+ * NUMA node of the calling thread.  Buffers are first touched by the
+ * thread that allocates them, so preferring buffers from the caller's
+ * node keeps flow data local to the cpu that processes it.
+ */
+static int pool_node(void)
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+
+    if(syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+    {
+        return((int)(node % POOL_MAX_NODES));
+    }
+#endif
+    return(0);
+}
+
+static int pool_size_class(bmi_size_t size)
+{
+    int size_class = 0;
+
+    while(size_class < POOL_CLASS_COUNT &&
+          ((bmi_size_t)1 << (POOL_MIN_SHIFT + size_class)) < size)
+    {
+        size_class++;
+    }
+    return(size_class < POOL_CLASS_COUNT ? size_class : -1);
+}
+
+static struct pool_bucket *pool_find_bucket(int method,
+                                            enum bmi_op_type send_recv,
+                                            int size_class,
+                                            int create)
+{
+    struct pool_bucket *bucket;
+    int i;
+
+    qlist_for_each_entry(bucket, &pool_bucket_list, link)
+    {
+        if(bucket->method == method && bucket->send_recv == send_recv &&
+           bucket->size_class == size_class)
+        {
+            return(bucket);
+        }
+    }
+    if(!create)
+    {
+        return(NULL);
+    }
+
+    bucket = malloc(sizeof(*bucket));
+    if(!bucket)
+    {
+        return(NULL);
+    }
+    bucket->method = method;
+    bucket->send_recv = send_recv;
+    bucket->size_class = size_class;
+    for(i = 0; i < POOL_MAX_NODES; i++)
+    {
+        INIT_QLIST_HEAD(&bucket->free_list[i]);
+    }
+    qlist_add_tail(&bucket->link, &pool_bucket_list);
+    return(bucket);
+}
+
+static void pool_update_counters(void)
+{
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_POOL_INUSE,
+                    pool_inuse_bytes, PINT_PERF_SET);
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_POOL_CACHED,
+                    pool_cached_bytes, PINT_PERF_SET);
+}
+
+/* pool_evict_locked()
+ *
+ * moves the least recently used idle buffer onto the given list so
+ * that it can be freed once the pool lock is dropped
+ *
+ * returns 1 if a buffer was evicted, 0 if there were none
+ */
+static int pool_evict_locked(struct qlist_head *free_list)
+{
+    struct pool_buffer *buf;
+
+    if(qlist_empty(&pool_lru_list))
+    {
+        return(0);
+    }
+    buf = qlist_entry(pool_lru_list.next, struct pool_buffer, lru_link);
+    qlist_del(&buf->lru_link);
+    qlist_del(&buf->free_link);
+    pool_cached_bytes -= buf->alloc_size;
+    qlist_add_tail(&buf->free_link, free_list);
+    return(1);
+}
+
+static void pool_free_list(struct qlist_head *free_list)
+{
+    struct pool_buffer *buf, *tmp;
+
+    qlist_for_each_entry_safe(buf, tmp, free_list, free_link)
+    {
+        qlist_del(&buf->free_link);
+        BMI_method_memfree(buf->method, buf->buffer, buf->alloc_size,
+                           buf->send_recv);
+        free(buf);
+    }
+}
+
+/* pool_take_locked()
+ *
+ * finds an idle buffer for the request, or reserves room for a new one
+ * (evicting idle buffers of other classes if needed).  A reserved entry
+ * comes back with a NULL buffer field and must be filled in by
+ * pool_fill() after the pool lock is released.  If force is set the
+ * pool limit is ignored.
+ *
+ * returns the entry, or NULL if the pool limit has been reached
+ */
+static struct pool_buffer *pool_take_locked(int method,
+                                            bmi_size_t size,
+                                            enum bmi_op_type send_recv,
+                                            int force,
+                                            struct qlist_head *evicted)
+{
+    struct pool_buffer *buf = NULL;
+    struct pool_bucket *bucket = NULL;
+    int size_class = -1;
+    bmi_size_t alloc_size = size;
+    int node;
+    int i;
+
+    if(pool_max_bytes > 0)
+    {
+        size_class = pool_size_class(size);
+    }
+
+    if(size_class >= 0)
+    {
+        alloc_size = (bmi_size_t)1 << (POOL_MIN_SHIFT + size_class);
+        bucket = pool_find_bucket(method, send_recv, size_class, 1);
+        if(!bucket)
+        {
+            return(NULL);
+        }
+
+        /* prefer a buffer from the local node, then any node */
+        node = pool_node();
+        for(i = 0; i < POOL_MAX_NODES; i++)
+        {
+            struct qlist_head *list =
+                &bucket->free_list[(node + i) % POOL_MAX_NODES];
+            if(!qlist_empty(list))
+            {
+                buf = qlist_entry(list->next, struct pool_buffer,
+                                  free_link);
+                qlist_del(&buf->free_link);
+                qlist_del(&buf->lru_link);
+                pool_cached_bytes -= buf->alloc_size;
+                pool_inuse_bytes += buf->alloc_size;
+                PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_POOL_HITS,
+                                1, PINT_PERF_ADD);
+                return(buf);
+            }
+        }
+
+        /* make room by dropping idle buffers of other classes */
+        while(pool_inuse_bytes + pool_cached_bytes + alloc_size >
+              pool_max_bytes && pool_evict_locked(evicted))
+            ;
+
+        /* if nothing is outstanding then nothing will come back to wait
+         * for; let an oversized request through rather than hang
+         */
+        if(pool_inuse_bytes + pool_cached_bytes + alloc_size >
+           pool_max_bytes && pool_inuse_bytes > 0 && !force)
+        {
+            return(NULL);
+        }
+    }
+
+    buf = malloc(sizeof(*buf));
+    if(!buf)
+    {
+        return(NULL);
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->alloc_size = alloc_size;
+    buf->method = method;
+    buf->send_recv = send_recv;
+    buf->size_class = size_class;
+    buf->bucket = bucket;
+    pool_inuse_bytes += alloc_size;
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_POOL_MISSES,
+                    1, PINT_PERF_ADD);
+    return(buf);
+}
+
+/* pool_fill()
+ *
+ * allocates memory for an entry reserved by pool_take_locked() and
+ * records it in the in-use table; called without the pool lock held.
+ * Send buffers are cleared: a trove read that stops short at the end
+ * of a datafile leaves the rest of the buffer as it was, and that is
+ * sent too, so it must not hold another flow's data.
+ *
+ * returns 0 on success, -PVFS_ENOMEM on failure (the reservation is
+ * released)
+ */
+static int pool_fill(struct pool_buffer *buf)
+{
+    if(!buf->buffer)
+    {
+        buf->node = pool_node();
+        buf->buffer = BMI_method_memalloc(buf->method, buf->alloc_size,
+                                          buf->send_recv);
+        if(!buf->buffer)
+        {
+            gen_mutex_lock(&pool_mutex);
+            pool_inuse_bytes -= buf->alloc_size;
+            pool_update_counters();
+            gen_mutex_unlock(&pool_mutex);
+            free(buf);
+            return(-PVFS_ENOMEM);
+        }
+    }
+    if(buf->send_recv == BMI_SEND)
+    {
+        memset(buf->buffer, 0, buf->alloc_size);
+    }
+
+    gen_mutex_lock(&pool_mutex);
+    qhash_add(pool_inuse_table, buf->buffer, &buf->hash_link);
+    pool_update_counters();
+    gen_mutex_unlock(&pool_mutex);
+    return(0);
+}
+
+/* pool_grant_locked()
+ *
+ * hands out buffers to queued waiters in arrival order, stopping at the
+ * first one that cannot be satisfied; granted waiters are moved to the
+ * given list along with their reserved entries
+ */
+static void pool_grant_locked(struct qlist_head *granted,
+                              struct qlist_head *evicted)
+{
+    struct PINT_flow_buffer_waiter *waiter;
+    struct pool_buffer *buf;
+
+    while(!qlist_empty(&pool_wait_list))
+    {
+        waiter = qlist_entry(pool_wait_list.next,
+                             struct PINT_flow_buffer_waiter, link);
+        buf = pool_take_locked(waiter->method, waiter->size,
+                               waiter->send_recv, 0, evicted);
+        if(!buf)
+        {
+            break;
+        }
+        qlist_del(&waiter->link);
+        waiter->queued = 0;
+        waiter->buffer = buf;
+        qlist_add_tail(&waiter->link, granted);
+    }
+}
+
+/* pool_run_granted()
+ *
+ * completes grants collected by pool_grant_locked() and notifies the
+ * waiters; called without the pool lock held.  A waiter whose memory
+ * could not be allocated is notified with the error rather than queued
+ * again, since nothing would be sure to wake it, and the waiters behind
+ * it are given the reservation it released.
+ */
+static void pool_run_granted(struct qlist_head *granted)
+{
+    struct PINT_flow_buffer_waiter *waiter, *tmp;
+    struct pool_buffer *buf;
+    int ret;
+    int failed = 0;
+
+    qlist_for_each_entry_safe(waiter, tmp, granted, link)
+    {
+        qlist_del(&waiter->link);
+        buf = waiter->buffer;
+        ret = pool_fill(buf);
+        if(ret < 0)
+        {
+            gossip_err("Error: failed to allocate a %lld byte flow "
+                       "buffer.\n", lld(waiter->size));
+            waiter->buffer = NULL;
+            waiter->error = ret;
+            failed = 1;
+        }
+        else
+        {
+            waiter->buffer = buf->buffer;
+        }
+        PINT_perf_timer_end(PINT_server_tpc, PINT_PERF_TFLOW_POOL_WAIT,
+                            &waiter->wait_start);
+        waiter->granted(waiter);
+    }
+
+    if(failed)
+    {
+        PINT_flow_buffer_wake();
+    }
+}
+
+/** Sets up the flow buffer pool with the given memory limit.
+ *
+ *  \return 0 on success, -PVFS_error on failure
+ */
+int PINT_flow_buffer_pool_initialize(PVFS_size max_bytes)
+{
+    gen_mutex_lock(&pool_mutex);
+    if(pool_initialized)
+    {
+        gen_mutex_unlock(&pool_mutex);
+        return(0);
+    }
+    pool_inuse_table = qhash_init(hash_buffer_compare, hash_buffer,
+                                  POOL_HASH_SIZE);
+    if(!pool_inuse_table)
+    {
+        gen_mutex_unlock(&pool_mutex);
+        return(-PVFS_ENOMEM);
+    }
+    pool_max_bytes = max_bytes;
+    pool_inuse_bytes = 0;
+    pool_cached_bytes = 0;
+    pool_initialized = 1;
+    gen_mutex_unlock(&pool_mutex);
+
+    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flow buffer pool initialized, "
+                 "limit %lld bytes\n", lld(max_bytes));
+    return(0);
+}
+
+/** Releases all idle buffers and shuts down the pool.  All flows must
+ *  have completed.
+ */
+void PINT_flow_buffer_pool_finalize(void)
+{
+    struct pool_bucket *bucket, *tmp;
+    QLIST_HEAD(evicted);
+
+    gen_mutex_lock(&pool_mutex);
+    if(!pool_initialized)
+    {
+        gen_mutex_unlock(&pool_mutex);
+        return;
+    }
+    while(pool_evict_locked(&evicted))
+        ;
+    if(pool_inuse_bytes > 0 || !qlist_empty(&pool_wait_list))
+    {
+        gossip_err("Warning: flow buffer pool finalized with %lld bytes "
+                   "still in use.\n", lld(pool_inuse_bytes));
+    }
+    INIT_QLIST_HEAD(&pool_wait_list);
+    pool_initialized = 0;
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+
+    qlist_for_each_entry_safe(bucket, tmp, &pool_bucket_list, link)
+    {
+        qlist_del(&bucket->link);
+        free(bucket);
+    }
+    qhash_finalize(pool_inuse_table);
+    pool_inuse_table = NULL;
+}
+
+/** Changes the memory limit of the pool.  Idle buffers beyond the new
+ *  limit are released; a limit of 0 turns off caching and admission
+ *  control.
+ */
+void PINT_flow_buffer_pool_set_size(PVFS_size max_bytes)
+{
+    QLIST_HEAD(evicted);
+
+    gen_mutex_lock(&pool_mutex);
+    pool_max_bytes = max_bytes;
+    while((pool_max_bytes == 0 && pool_cached_bytes > 0) ||
+          pool_inuse_bytes + pool_cached_bytes > pool_max_bytes)
+    {
+        if(!pool_evict_locked(&evicted))
+        {
+            break;
+        }
+    }
+    pool_update_counters();
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+
+    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flow buffer pool limit set to "
+                 "%lld bytes\n", lld(max_bytes));
+
+    PINT_flow_buffer_wake();
+}
+
+/** Gets a buffer of at least size bytes usable by the BMI method that
+ *  serves addr.  Never blocks.
+ *
+ *  \return pointer to the buffer, or NULL if the pool limit has been
+ *  reached or memory could not be allocated
+ */
+void *PINT_flow_buffer_get(BMI_addr_t addr,
+                           bmi_size_t size,
+                           enum bmi_op_type send_recv)
+{
+    struct pool_buffer *buf;
+    int method;
+    QLIST_HEAD(evicted);
+
+    if(BMI_get_info(addr, BMI_GET_METH_INDEX, &method) < 0)
+    {
+        return(NULL);
+    }
+
+    gen_mutex_lock(&pool_mutex);
+    /* don't jump ahead of flows that are already waiting */
+    if(!qlist_empty(&pool_wait_list))
+    {
+        gen_mutex_unlock(&pool_mutex);
+        return(NULL);
+    }
+    buf = pool_take_locked(method, size, send_recv, 0, &evicted);
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+
+    if(!buf || pool_fill(buf) < 0)
+    {
+        return(NULL);
+    }
+    return(buf->buffer);
+}
+
+/** Gets a buffer as described by the waiter, queueing the waiter if
+ *  the pool limit has been reached.  Receive buffers are not held to
+ *  the limit.
+ *
+ *  \return 0 if the buffer was granted immediately (and stored in
+ *  waiter->buffer), 1 if the waiter was queued, -PVFS_error on failure
+ */
+int PINT_flow_buffer_wait(struct PINT_flow_buffer_waiter *waiter)
+{
+    struct pool_buffer *buf = NULL;
+    int ret;
+    QLIST_HEAD(evicted);
+
+    ret = BMI_get_info(waiter->addr, BMI_GET_METH_INDEX, &waiter->method);
+    if(ret < 0)
+    {
+        return(ret);
+    }
+
+    waiter->buffer = NULL;
+    waiter->error = 0;
+    waiter->queued = 0;
+    waiter->wait_start.tv_sec = 0;
+    waiter->wait_start.tv_nsec = 0;
+
+    gen_mutex_lock(&pool_mutex);
+    if(waiter->send_recv == BMI_RECV)
+    {
+        /* never hold up a receive; see flow-buffer-pool.h */
+        buf = pool_take_locked(waiter->method, waiter->size,
+                               waiter->send_recv, 1, &evicted);
+    }
+    else if(qlist_empty(&pool_wait_list))
+    {
+        buf = pool_take_locked(waiter->method, waiter->size,
+                               waiter->send_recv, 0, &evicted);
+    }
+    if(!buf)
+    {
+        waiter->queued = 1;
+        qlist_add_tail(&waiter->link, &pool_wait_list);
+        PINT_perf_timer_start(&waiter->wait_start);
+        PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_POOL_WAITS,
+                        1, PINT_PERF_ADD);
+        gen_mutex_unlock(&pool_mutex);
+        pool_free_list(&evicted);
+        gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flow buffer pool full, "
+                     "queueing waiter %p\n", waiter);
+        return(1);
+    }
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+
+    ret = pool_fill(buf);
+    if(ret < 0)
+    {
+        return(ret);
+    }
+    waiter->buffer = buf->buffer;
+    return(0);
+}
+
+/** Removes a waiter from the queue if it has not been granted a buffer
+ *  yet.
+ *
+ *  \return 1 if the waiter was removed, 0 if it was no longer queued
+ */
+int PINT_flow_buffer_cancel_wait(struct PINT_flow_buffer_waiter *waiter)
+{
+    int ret = 0;
+
+    gen_mutex_lock(&pool_mutex);
+    if(waiter->queued)
+    {
+        qlist_del(&waiter->link);
+        waiter->queued = 0;
+        ret = 1;
+    }
+    gen_mutex_unlock(&pool_mutex);
+
+    if(ret)
+    {
+        PINT_perf_timer_end(PINT_server_tpc, PINT_PERF_TFLOW_POOL_WAIT,
+                            &waiter->wait_start);
+    }
+    return(ret);
+}
+
+/** Returns a buffer obtained from PINT_flow_buffer_get() or
+ *  PINT_flow_buffer_wait().  If wake is set, waiters that can now be
+ *  satisfied are granted buffers and notified from this thread, so the
+ *  caller must not hold locks that a waiter's callback might need.
+ */
+void PINT_flow_buffer_put(void *buffer, int wake)
+{
+    struct qlist_head *hash_link;
+    struct pool_buffer *buf;
+    QLIST_HEAD(evicted);
+    QLIST_HEAD(granted);
+
+    gen_mutex_lock(&pool_mutex);
+    hash_link = qhash_search_and_remove(pool_inuse_table, buffer);
+    if(!hash_link)
+    {
+        gen_mutex_unlock(&pool_mutex);
+        gossip_err("Error: flow buffer %p not from the flow buffer "
+                   "pool.\n", buffer);
+        return;
+    }
+    buf = qlist_entry(hash_link, struct pool_buffer, hash_link);
+    pool_inuse_bytes -= buf->alloc_size;
+
+    if(buf->size_class >= 0 && pool_max_bytes > 0 &&
+       pool_inuse_bytes + pool_cached_bytes + buf->alloc_size <=
+       pool_max_bytes)
+    {
+        qlist_add(&buf->free_link, &buf->bucket->free_list[buf->node]);
+        qlist_add_tail(&buf->lru_link, &pool_lru_list);
+        pool_cached_bytes += buf->alloc_size;
+    }
+    else
+    {
+        qlist_add_tail(&buf->free_link, &evicted);
+    }
+
+    if(wake)
+    {
+        pool_grant_locked(&granted, &evicted);
+    }
+    pool_update_counters();
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+    pool_run_granted(&granted);
+}
+
+/** Grants buffers to queued waiters if the pool has room for them.
+ *  Same locking caveats as PINT_flow_buffer_put().
+ */
+void PINT_flow_buffer_wake(void)
+{
+    QLIST_HEAD(evicted);
+    QLIST_HEAD(granted);
+
+    gen_mutex_lock(&pool_mutex);
+    if(!pool_initialized || qlist_empty(&pool_wait_list))
+    {
+        gen_mutex_unlock(&pool_mutex);
+        return;
+    }
+    pool_grant_locked(&granted, &evicted);
+    pool_update_counters();
+    gen_mutex_unlock(&pool_mutex);
+
+    pool_free_list(&evicted);
+    pool_run_granted(&granted);
+}
+
+static int hash_buffer(const void *key, int table_size)
+{
+    unsigned long tmp = (unsigned long)key;
+
+    return((int)((tmp >> POOL_MIN_SHIFT) % table_size));
+}
+
+static int hash_buffer_compare(const void *key, struct qlist_head *link)
+{
+    struct pool_buffer *buf = qlist_entry(link, struct pool_buffer,
+                                          hash_link);
+
+    return(buf->buffer == key);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,73 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/* This header contains the interface to the server-wide pool of network
+ * buffers used by flow protocols.  Buffers are allocated through the BMI
+ * method that will use them (so that methods which register memory only do
+ * so once), grouped into power of two size classes, and kept on free lists
+ * per NUMA node.  The pool enforces a byte limit: once it is reached,
+ * callers either make do with the buffers they already hold or queue up
+ * until another flow returns a buffer.  Only senders are queued; a
+ * receiver's data is already on its way, and leaving it unread would hold
+ * up everything behind it on the same connection, so PINT_flow_buffer_wait()
+ * grants receive buffers right away even past the limit.
+ */
+
+#ifndef __FLOW_BUFFER_POOL_H
+#define __FLOW_BUFFER_POOL_H
+
+#include "pvfs2-internal.h"
+#include "quicklist.h"
+#include "bmi.h"
+
+/* default limit on the memory held by the pool; 0 disables pooling */
+#define PINT_FLOW_BUFFER_POOL_DEFAULT_SIZE (256*1024*1024LL)
+
+/* describes a caller waiting for a buffer.  When one becomes available
+ * it is stored in the buffer field and the granted function is called,
+ * without any pool locks held, from whichever thread returned it.  If
+ * the memory could not be allocated, granted is called with a NULL
+ * buffer and the error set.
+ */
+struct PINT_flow_buffer_waiter
+{
+    BMI_addr_t addr;
+    bmi_size_t size;
+    enum bmi_op_type send_recv;
+    void *buffer;
+    int error;
+    void (*granted)(struct PINT_flow_buffer_waiter *waiter);
+    void *user_ptr;
+
+    /* private to the pool */
+    int queued;
+    int method;
+    struct timespec wait_start;
+    struct qlist_head link;
+};
+
+int PINT_flow_buffer_pool_initialize(PVFS_size max_bytes);
+void PINT_flow_buffer_pool_finalize(void);
+void PINT_flow_buffer_pool_set_size(PVFS_size max_bytes);
+
+void *PINT_flow_buffer_get(BMI_addr_t addr,
+                           bmi_size_t size,
+                           enum bmi_op_type send_recv);
+int PINT_flow_buffer_wait(struct PINT_flow_buffer_waiter *waiter);
+int PINT_flow_buffer_cancel_wait(struct PINT_flow_buffer_waiter *waiter);
+void PINT_flow_buffer_put(void *buffer, int wake);
+void PINT_flow_buffer_wake(void);
+
+#endif /* __FLOW_BUFFER_POOL_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
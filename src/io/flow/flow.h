@@ -79,7 +79,9 @@ enum flow_state
 /* supported setinfo types */
 enum flow_setinfo_option
 {
-    FLOWPROTO_DATA_SYNC_MODE = 1
+    FLOWPROTO_DATA_SYNC_MODE = 1,
+    FLOWPROTO_BUFFER_POOL_SIZE = 2,
+    FLOWPROTO_SENDFILE = 3
 };
 
 /* supported getinfo types */
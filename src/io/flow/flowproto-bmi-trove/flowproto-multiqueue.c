@@ -22,6 +22,7 @@
 #include "trove.h"
 #include "thread-mgr.h"
 #include "pint-perf-counter.h"
+#include "src/io/flow/flow-buffer-pool.h"
 #include "pvfs2-internal.h"
 
 /* the following buffer settings are used by default if none are specified in
@@ -30,14 +31,40 @@
 #define BUFFERS_PER_FLOW 8
 #define BUFFER_SIZE (256*1024)
 
+/* per-flow adaptation limits.  Flows that move less data than the
+ * configured buffer size get a buffer rounded up to MIN_BUFFER_SIZE
+ * instead; since the whole flow still fits in one buffer on both ends this
+ * does not change how the stream is split into messages.  The pipeline
+ * depth starts at the configured count (or less, for small or fragmented
+ * requests) and may grow up to BUFFERS_GROWTH_FACTOR times that, bounded
+ * by MAX_BUFFERS_PER_FLOW, when one stage keeps finding the other idle.
+ */
+#define MIN_BUFFER_SIZE (4*1024)
+#define SMALL_REGION_SIZE (64*1024)
+#define SMALL_REGION_DEPTH 2
+#define BUFFERS_GROWTH_FACTOR 4
+#define MAX_BUFFERS_PER_FLOW 64
+#define GROW_STALL_THRESHOLD 2
+
 #define MAX_REGIONS 64
 
+#ifdef __PVFS2_TROVE_SUPPORT__
+#define FLOW_BUFFER_COUNT(__flow_d, __op)                             \
+do {                                                                  \
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_BUFFERS, 1, __op); \
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_BUFFER_BYTES,      \
+                    (__flow_d)->buffer_size, __op);                   \
+} while(0)
+#else
+#define FLOW_BUFFER_COUNT(__flow_d, __op) do{}while(0)
+#endif
+
 #define FLOW_CLEANUP_CANCEL_PATH(__flow_data, __cancel_path)          \
 do {                                                                  \
     struct flow_descriptor *__flow_d = (__flow_data)->parent;         \
     gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flowproto completing %p\n",\
                  __flow_d);                                           \
-    cleanup_buffers(__flow_data);                                     \
+    cleanup_buffers(__flow_data, !(__cancel_path));                   \
     __flow_d = (__flow_data)->parent;                                 \
     free(__flow_data);                                                \
     __flow_d->release(__flow_d);                                      \
@@ -72,8 +99,15 @@ struct fp_queue_item
     struct qlist_head list_link;
     flow_descriptor *parent;
     struct PINT_thread_mgr_bmi_callback bmi_callback;
+    int file_send;              /* payload is sent from the bstream file */
+    bmi_size_t *file_offsets;   /* bstream regions of the current message */
+    bmi_size_t *file_sizes;
+    int file_regions_max;       /* allocated length of the region arrays */
 };
 
+/* a queue item is in use once it has a buffer or sends from a file */
+#define Q_ITEM_IN_USE(__q_item) ((__q_item)->buffer || (__q_item)->file_send)
+
 /* fp_private_data is information specific to this flow protocol, stored
  * in flow descriptor but hidden from caller
  */
@@ -92,6 +126,14 @@ struct fp_private_data
     void *intermediate;
     int cleanup_pending_count;
     int req_proc_done;
+    int depth;          /* number of prealloc_array entries in use */
+    int max_depth;      /* length of prealloc_array */
+    int stalls;         /* completions that found the other stage idle */
+    int started;        /* set once the flow has been admitted */
+    void *reserved_buffer; /* pool buffer granted at admission */
+    struct PINT_flow_buffer_waiter pool_waiter;
+    int send_fd;        /* bstream descriptor for sendfile flows */
+    void *send_fd_ref;  /* trove reference pinning send_fd, NULL if unused */
 
     struct qlist_head src_list;
     struct qlist_head dest_list;
@@ -102,6 +144,10 @@ struct fp_private_data
 
 static bmi_context_id global_bmi_context = -1;
 static void cleanup_buffers(
+    struct fp_private_data *flow_data,
+    int wake);
+static void size_flow(
+    flow_descriptor *flow_d,
     struct fp_private_data *flow_data);
 static void handle_io_error(
     PVFS_error error_code,
@@ -138,6 +184,43 @@ static void trove_read_callback_fn(void *user_ptr,
                                    PVFS_error error_code);
 static void trove_write_callback_fn(void *user_ptr,
                                     PVFS_error error_code);
+static void start_trove_flow(struct fp_private_data *flow_data);
+static void pool_granted_fn(struct PINT_flow_buffer_waiter *waiter);
+static int setup_file_send(struct fp_private_data *flow_data);
+static int post_file_send(struct fp_queue_item *q_item,
+                          struct fp_private_data *flow_data);
+
+/* send trove data to the network with sendfile() when possible */
+static int flow_sendfile_enabled = 0;
+
+/* get_flow_buffer()
+ *
+ * takes the buffer reserved when the flow was admitted, or another one
+ * from the shared pool if it is not over its limit
+ *
+ * returns pointer to buffer, NULL if none is available
+ */
+static inline void *get_flow_buffer(struct fp_private_data *flow_data,
+                                    BMI_addr_t addr,
+                                    enum bmi_op_type send_recv)
+{
+    void *buffer = flow_data->reserved_buffer;
+
+    if(buffer)
+    {
+        flow_data->reserved_buffer = NULL;
+    }
+    else
+    {
+        buffer = PINT_flow_buffer_get(addr, flow_data->parent->buffer_size,
+                                      send_recv);
+    }
+    if(buffer)
+    {
+        FLOW_BUFFER_COUNT(flow_data->parent, PINT_PERF_ADD);
+    }
+    return(buffer);
+}
 
 /* wrappers that let us acquire locks or use return values in different
  * ways, depending on if the function is triggered from an external thread
@@ -326,6 +409,15 @@ int fp_multiqueue_initialize(int flowproto_id)
         return(ret);
     }
     PINT_thread_mgr_trove_getcontext(&global_trove_context);
+
+    ret = PINT_flow_buffer_pool_initialize(
+        PINT_FLOW_BUFFER_POOL_DEFAULT_SIZE);
+    if(ret < 0)
+    {
+        PINT_thread_mgr_trove_stop();
+        PINT_thread_mgr_bmi_stop();
+        return(ret);
+    }
 #endif
 
     return(0);
@@ -346,6 +438,7 @@ int fp_multiqueue_finalize(void)
         struct qlist_head *tmp_link = NULL, *scratch_link = NULL;
 
         PINT_thread_mgr_trove_stop();
+        PINT_flow_buffer_pool_finalize();
 
         gen_mutex_lock(&id_sync_mode_mutex);
         qlist_for_each_safe(tmp_link, scratch_link, &s_id_sync_mode_list)
@@ -446,6 +539,16 @@ int fp_multiqueue_setinfo(flow_descriptor *flow_d,
             }
         }
         break;
+        case FLOWPROTO_BUFFER_POOL_SIZE:
+            assert(parameter);
+            PINT_flow_buffer_pool_set_size(*(PVFS_size *)parameter);
+            ret = 0;
+            break;
+        case FLOWPROTO_SENDFILE:
+            assert(parameter);
+            flow_sendfile_enabled = *(int *)parameter;
+            ret = 0;
+            break;
 #endif
         default:
             break;
@@ -464,12 +567,32 @@ int fp_multiqueue_cancel(flow_descriptor  *flow_d)
     struct fp_private_data *flow_data = PRIVATE_FLOW(flow_d);
 
     gossip_err("%s: flow proto cancel called on %p\n", __func__, flow_d);
+#ifdef __PVFS2_TROVE_SUPPORT__
+    if(PINT_flow_buffer_cancel_wait(&flow_data->pool_waiter))
+    {
+        /* still waiting for a buffer, so nothing has been posted yet */
+        gossip_debug(GOSSIP_CANCEL_DEBUG,
+                     "%s: called on flow waiting for a buffer.\n",
+                     __func__);
+        flow_d->error_code = -(PVFS_ECANCEL|PVFS_ERROR_FLOW);
+        flow_d->state = FLOW_COMPLETE;
+        FLOW_CLEANUP_CANCEL_PATH(flow_data, 1);
+        return(0);
+    }
+#endif
     gen_mutex_lock(&flow_data->parent->flow_mutex);
     /*
       if the flow is already marked as complete, then there is nothing
       to do
     */
-    if(flow_d->state != FLOW_COMPLETE)
+    if(flow_d->state != FLOW_COMPLETE && !flow_data->started)
+    {
+        /* granted a buffer but not running yet; start_trove_flow() will
+         * see the error and complete the flow
+         */
+        flow_d->error_code = -(PVFS_ECANCEL|PVFS_ERROR_FLOW);
+    }
+    else if(flow_d->state != FLOW_COMPLETE)
     {
         gossip_debug(GOSSIP_CANCEL_DEBUG,
                      "%s: called on active flow, %lld bytes transferred.\n",
@@ -508,6 +631,9 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
 {
     struct fp_private_data *flow_data = NULL;
     int i;
+#ifdef __PVFS2_TROVE_SUPPORT__
+    int ret;
+#endif
 
     gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flowproto posting %p\n",
                  flow_d);
@@ -557,17 +683,10 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
             PINT_REQUEST_TOTAL_BYTES(flow_d->mem_req));
     }
 
-    if(flow_d->buffer_size < 1)
-    {
-        flow_d->buffer_size = BUFFER_SIZE;
-    }
-    if(flow_d->buffers_per_flow < 1)
-    {
-        flow_d->buffers_per_flow = BUFFERS_PER_FLOW;
-    }
-        
+    size_flow(flow_d, flow_data);
+
     flow_data->prealloc_array = (struct fp_queue_item*)
-                malloc(flow_d->buffers_per_flow*sizeof(struct fp_queue_item));
+                malloc(flow_data->max_depth*sizeof(struct fp_queue_item));
     if(!flow_data->prealloc_array)
     {
         free(flow_data);
@@ -575,8 +694,8 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
     }
     memset(flow_data->prealloc_array,
            0,
-           flow_d->buffers_per_flow*sizeof(struct fp_queue_item));
-    for(i = 0; i < flow_d->buffers_per_flow; i++)
+           flow_data->max_depth*sizeof(struct fp_queue_item));
+    for(i = 0; i < flow_data->max_depth; i++)
     {
         flow_data->prealloc_array[i].parent = flow_d;
         flow_data->prealloc_array[i].bmi_callback.data = 
@@ -587,13 +706,14 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
     if(flow_d->src.endpoint_id == BMI_ENDPOINT &&
         flow_d->dest.endpoint_id == MEM_ENDPOINT)
     {
+        flow_data->started = 1;
         flow_data->prealloc_array[0].buffer = flow_d->dest.u.mem.buffer;
         flow_data->prealloc_array[0].bmi_callback.fn =
                         bmi_to_mem_callback_wrapper;
         /* put all of the buffers on empty list, we don't really do any
          * queueing for this type of flow
          */
-        for(i=0; i<flow_d->buffers_per_flow; i++)
+        for(i=0; i<flow_data->max_depth; i++)
         {
             qlist_add_tail(&flow_data->prealloc_array[i].list_link,
                            &flow_data->empty_list);
@@ -613,13 +733,14 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
     else if(flow_d->src.endpoint_id == MEM_ENDPOINT &&
             flow_d->dest.endpoint_id == BMI_ENDPOINT)
     {
+        flow_data->started = 1;
         flow_data->prealloc_array[0].buffer = flow_d->src.u.mem.buffer;
         flow_data->prealloc_array[0].bmi_callback.fn =
                      mem_to_bmi_callback_wrapper;
         /* put all of the buffers on empty list, we don't really do any
          * queueing for this type of flow
          */
-        for(i = 0; i < flow_d->buffers_per_flow; i++)
+        for(i = 0; i < flow_data->max_depth; i++)
         {
             qlist_add_tail(&flow_data->prealloc_array[i].list_link,
                            &flow_data->empty_list);
@@ -637,12 +758,90 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
         }
     }
 #ifdef __PVFS2_TROVE_SUPPORT__
+    else if(flow_d->src.endpoint_id == TROVE_ENDPOINT &&
+            setup_file_send(flow_data))
+    {
+        /* data goes straight from the bstream to the socket, so the
+         * flow does not need any buffers and is not subject to
+         * admission control
+         */
+        start_trove_flow(flow_data);
+    }
+    else if(flow_d->src.endpoint_id == TROVE_ENDPOINT ||
+            flow_d->dest.endpoint_id == TROVE_ENDPOINT)
+    {
+        /* admission control: a flow needs at least one buffer from the
+         * shared pool before it can start.  If none is available it is
+         * queued and started by pool_granted_fn() once another flow
+         * returns one.  Flows receiving from BMI are always let in.
+         */
+        if(flow_d->src.endpoint_id == BMI_ENDPOINT)
+        {
+            flow_data->pool_waiter.addr = flow_d->src.u.bmi.address;
+            flow_data->pool_waiter.send_recv = BMI_RECV;
+        }
+        else
+        {
+            flow_data->pool_waiter.addr = flow_d->dest.u.bmi.address;
+            flow_data->pool_waiter.send_recv = BMI_SEND;
+        }
+        flow_data->pool_waiter.size = flow_d->buffer_size;
+        flow_data->pool_waiter.granted = pool_granted_fn;
+        flow_data->pool_waiter.user_ptr = flow_data;
+
+        PINT_flow_buffer_wake();
+        ret = PINT_flow_buffer_wait(&flow_data->pool_waiter);
+        if(ret < 0)
+        {
+            free(flow_data->prealloc_array);
+            free(flow_data);
+            return(ret);
+        }
+        if(ret == 1)
+        {
+            gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
+                         "flowproto %p waiting for a buffer\n", flow_d);
+            return(0);
+        }
+        flow_data->reserved_buffer = flow_data->pool_waiter.buffer;
+        start_trove_flow(flow_data);
+    }
+#endif
+    else
+    {
+        return(-ENOSYS);
+    }
+
+    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flowproto posted %p\n",
+                 flow_d);
+    return (0);
+}
+
+#ifdef __PVFS2_TROVE_SUPPORT__
+/* start_trove_flow()
+ *
+ * begins processing of an admitted flow between bmi and trove
+ *
+ * no return value
+ */
+static void start_trove_flow(struct fp_private_data *flow_data)
+{
+    flow_descriptor *flow_d = flow_data->parent;
+    int i;
+
+    gen_mutex_lock(&flow_data->parent->flow_mutex);
+    flow_data->started = 1;
+
+    if(flow_d->error_code != 0)
+    {
+        /* cancelled before starting, or no buffer could be allocated */
+        flow_d->state = FLOW_COMPLETE;
+    }
     else if(flow_d->src.endpoint_id == TROVE_ENDPOINT &&
             flow_d->dest.endpoint_id == BMI_ENDPOINT)
     {
-        flow_data->initial_posts = flow_d->buffers_per_flow;
-        gen_mutex_lock(&flow_data->parent->flow_mutex);
-        for(i = 0; i < flow_d->buffers_per_flow; i++)
+        flow_data->initial_posts = flow_data->depth;
+        for(i = 0; i < flow_data->depth; i++)
         {
             gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
                 "flowproto-multiqueue forcing bmi_send_callback_fn.\n");
@@ -653,24 +852,14 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
                 break;
             }
         }
-        if(flow_data->parent->state == FLOW_COMPLETE)
-        {
-            gen_mutex_unlock(&flow_data->parent->flow_mutex);
-            FLOW_CLEANUP(flow_data);
-        }
-        else
-        {
-            gen_mutex_unlock(&flow_data->parent->flow_mutex);
-        }
     }
-    else if(flow_d->src.endpoint_id == BMI_ENDPOINT &&
-            flow_d->dest.endpoint_id == TROVE_ENDPOINT)
+    else
     {
         /* only post one outstanding recv at a time; easier to manage */
         flow_data->initial_posts = 1;
 
         /* place remaining buffers on "empty" queue */
-        for(i = 1; i < flow_d->buffers_per_flow; i++)
+        for(i = 1; i < flow_data->depth; i++)
         {
             qlist_add_tail(&flow_data->prealloc_array[i].list_link,
                            &flow_data->empty_list);
@@ -680,30 +869,205 @@ int fp_multiqueue_post(flow_descriptor  *flow_d)
                         &flow_data->prealloc_array[0];
         gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
             "flowproto-multiqueue forcing trove_write_callback_fn.\n");
-        gen_mutex_lock(&flow_data->parent->flow_mutex);
         trove_write_callback_fn(&(flow_data->prealloc_array[0].result_chain), 0);
-        if(flow_data->parent->state == FLOW_COMPLETE)
+    }
+
+    if(flow_data->parent->state == FLOW_COMPLETE)
+    {
+        gen_mutex_unlock(&flow_data->parent->flow_mutex);
+        FLOW_CLEANUP(flow_data);
+    }
+    else
+    {
+        gen_mutex_unlock(&flow_data->parent->flow_mutex);
+    }
+}
+
+/* pool_granted_fn()
+ *
+ * called by the buffer pool when a queued flow has been given a buffer,
+ * or could not be because the allocation failed
+ *
+ * no return value
+ */
+static void pool_granted_fn(struct PINT_flow_buffer_waiter *waiter)
+{
+    struct fp_private_data *flow_data = waiter->user_ptr;
+
+    if(waiter->error)
+    {
+        gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
+                     "flowproto %p failed to get a buffer: %d\n",
+                     flow_data->parent, waiter->error);
+        gen_mutex_lock(&flow_data->parent->flow_mutex);
+        if(flow_data->parent->error_code == 0)
         {
-            gen_mutex_unlock(&flow_data->parent->flow_mutex);
-            FLOW_CLEANUP(flow_data);
+            flow_data->parent->error_code = waiter->error;
         }
-        else
+        gen_mutex_unlock(&flow_data->parent->flow_mutex);
+    }
+    else
+    {
+        gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
+                     "flowproto %p granted a buffer\n", flow_data->parent);
+        flow_data->reserved_buffer = waiter->buffer;
+    }
+    /* start_trove_flow() completes a flow that has an error */
+    start_trove_flow(flow_data);
+}
+
+/* setup_file_send()
+ *
+ * checks whether a trove to bmi flow can send straight from the bstream
+ * file, and if so pins the file descriptor for the life of the flow
+ *
+ * returns 1 if the flow will use BMI_post_send_file(), 0 otherwise
+ */
+static int setup_file_send(struct fp_private_data *flow_data)
+{
+    flow_descriptor *flow_d = flow_data->parent;
+    int supported = 0;
+    int ret;
+
+    if(!flow_sendfile_enabled)
+    {
+        return(0);
+    }
+
+    ret = BMI_get_info(flow_d->dest.u.bmi.address, BMI_CHECK_SEND_FILE,
+                       &supported);
+    if(ret < 0 || !supported)
+    {
+        return(0);
+    }
+
+    ret = trove_bstream_fd_get(flow_d->src.u.trove.coll_id,
+                               flow_d->src.u.trove.handle,
+                               &flow_data->send_fd,
+                               &flow_data->send_fd_ref);
+    if(ret < 0)
+    {
+        /* storage method cannot provide one; use flow buffers */
+        flow_data->send_fd_ref = NULL;
+        return(0);
+    }
+
+    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
+                 "flowproto %p sending from fd %d\n", flow_d,
+                 flow_data->send_fd);
+    return(1);
+}
+
+/* post_file_send()
+ *
+ * posts the message described by a processed queue item as a send
+ * straight out of the bstream file.  Regions are posted as soon as they
+ * are processed, so sends go out in sequence order without waiting on
+ * trove.
+ *
+ * returns 1 if flow completes, 0 otherwise
+ */
+static int post_file_send(struct fp_queue_item *q_item,
+                          struct fp_private_data *flow_data)
+{
+    struct result_chain_entry *result_tmp;
+    struct result_chain_entry *old_result_tmp;
+    bmi_size_t *tmp_offsets;
+    bmi_size_t *tmp_sizes;
+    int count = 0;
+    int i;
+    int ret;
+
+    for(result_tmp = &q_item->result_chain; result_tmp;
+        result_tmp = result_tmp->next)
+    {
+        count += result_tmp->result.segs;
+    }
+
+    if(count > q_item->file_regions_max)
+    {
+        tmp_offsets = (bmi_size_t *)realloc(q_item->file_offsets,
+                                            count * sizeof(bmi_size_t));
+        if(tmp_offsets)
         {
-            gen_mutex_unlock(&flow_data->parent->flow_mutex);
+            q_item->file_offsets = tmp_offsets;
+        }
+        tmp_sizes = (bmi_size_t *)realloc(q_item->file_sizes,
+                                          count * sizeof(bmi_size_t));
+        if(tmp_sizes)
+        {
+            q_item->file_sizes = tmp_sizes;
         }
+        if(!tmp_offsets || !tmp_sizes)
+        {
+            gossip_err("%s: I/O error occurred\n", __func__);
+            handle_io_error(-PVFS_ENOMEM, q_item, flow_data);
+            return(flow_data->parent->state == FLOW_COMPLETE);
+        }
+        q_item->file_regions_max = count;
     }
-#endif
-    else
+
+    /* flatten the result chain into one region list */
+    count = 0;
+    result_tmp = &q_item->result_chain;
+    do{
+        for(i = 0; i < result_tmp->result.segs; i++)
+        {
+            q_item->file_offsets[count] = result_tmp->result.offset_array[i];
+            q_item->file_sizes[count] = result_tmp->result.size_array[i];
+            count++;
+        }
+        old_result_tmp = result_tmp;
+        result_tmp = result_tmp->next;
+        if(old_result_tmp != &q_item->result_chain)
+        {
+            free(old_result_tmp);
+        }
+    } while(result_tmp);
+    q_item->result_chain.next = NULL;
+    q_item->result_chain_count = 0;
+
+    qlist_del(&q_item->list_link);
+    qlist_add_tail(&q_item->list_link, &flow_data->dest_list);
+
+    assert(q_item->seq == flow_data->next_seq_to_send);
+    flow_data->dest_pending++;
+    flow_data->next_seq_to_send++;
+    if(q_item->last)
     {
-        return(-ENOSYS);
+        flow_data->initial_posts = 0;
+        flow_data->dest_last_posted = 1;
     }
 
-    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG, "flowproto posted %p\n",
-                 flow_d);
-    return (0);
+    ret = BMI_post_send_file(&q_item->posted_id,
+                             q_item->parent->dest.u.bmi.address,
+                             flow_data->send_fd,
+                             q_item->file_offsets,
+                             q_item->file_sizes,
+                             count,
+                             q_item->buffer_used,
+                             q_item->parent->tag,
+                             &q_item->bmi_callback,
+                             global_bmi_context,
+                             (bmi_hint)q_item->parent->hints);
+    if(ret < 0)
+    {
+        gossip_err("%s: I/O error occurred\n", __func__);
+        handle_io_error(ret, q_item, flow_data);
+        return(flow_data->parent->state == FLOW_COMPLETE);
+    }
+
+    PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_SENDFILE,
+                    q_item->buffer_used, PINT_PERF_ADD);
+
+    if(ret == 1)
+    {
+        /* immediate completion; trigger callback ourselves */
+        return(bmi_send_callback_fn(q_item, q_item->buffer_used, 0, 0));
+    }
+    return(0);
 }
 
-#ifdef __PVFS2_TROVE_SUPPORT__
 /* bmi_recv_callback_fn()
  *
  * function to be called upon completion of a BMI recv operation
@@ -795,6 +1159,25 @@ static void bmi_recv_callback_fn(void *user_ptr,
         }
     } while(result_tmp);
 
+    /* if every buffer is tied up in a trove write then bmi is outpacing
+     * trove; bring another buffer into the pipeline so that the next recv
+     * does not have to wait for the disk
+     */
+    if(!PINT_REQUEST_DONE(q_item->parent->file_req_state)
+        && qlist_empty(&flow_data->src_list)
+        && qlist_empty(&flow_data->empty_list)
+        && flow_data->depth < flow_data->max_depth
+        && ++flow_data->stalls >= GROW_STALL_THRESHOLD)
+    {
+        qlist_add_tail(
+            &flow_data->prealloc_array[flow_data->depth].list_link,
+            &flow_data->empty_list);
+        flow_data->depth++;
+        flow_data->stalls = 0;
+        PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_DEPTH_GROW,
+                        1, PINT_PERF_ADD);
+    }
+
     /* do we need to repost another recv? */
 
     if((!PINT_REQUEST_DONE(q_item->parent->file_req_state)) 
@@ -808,12 +1191,19 @@ static void bmi_recv_callback_fn(void *user_ptr,
 
         if(!q_item->buffer)
         {
-            /* if the q_item has not been used, allocate a buffer */
-            q_item->buffer = BMI_memalloc(
-                            q_item->parent->src.u.bmi.address,
-                            q_item->parent->buffer_size, BMI_RECV);
-            /* TODO: error handling */
-            assert(q_item->buffer);
+            /* if the q_item has not been used, get a buffer */
+            q_item->buffer = get_flow_buffer(flow_data,
+                                             q_item->parent->src.u.bmi.address,
+                                             BMI_RECV);
+            if(!q_item->buffer)
+            {
+                /* the pool is full; the next recv will be posted when
+                 * one of the trove writes in flight completes
+                 */
+                qlist_del(&q_item->list_link);
+                qlist_add(&q_item->list_link, &flow_data->empty_list);
+                return;
+            }
             q_item->bmi_callback.fn = bmi_recv_callback_wrapper;
         }
         
@@ -927,6 +1317,7 @@ static void trove_read_callback_fn(void *user_ptr,
     struct result_chain_entry *old_result_tmp;
     int done = 0;
     struct qlist_head *tmp_link;
+    struct fp_queue_item *tmp_item;
 
     q_item = result_tmp->q_item;
 
@@ -950,6 +1341,12 @@ static void trove_read_callback_fn(void *user_ptr,
         return;
     }
 
+    /* no sends in flight means bmi has been waiting on trove */
+    if(flow_data->next_seq_to_send > 0 && flow_data->dest_pending == 0)
+    {
+        flow_data->stalls++;
+    }
+
     /* remove from current queue */
     qlist_del(&q_item->list_link);
     /* add to dest queue */
@@ -970,17 +1367,24 @@ static void trove_read_callback_fn(void *user_ptr,
 
     /* while we hold dest lock, look for next seq no. to send */
     do{
+        /* only take a match from the dest list; a q_item whose send
+         * completed immediately may already be back on the src list
+         * with the next seq no. and its trove read still in flight,
+         * which happens whenever the flow is down to a single buffer
+         */
+        q_item = NULL;
         qlist_for_each(tmp_link, &flow_data->dest_list)
         {
-            q_item = qlist_entry(tmp_link, struct fp_queue_item,
-                                 list_link);
-            if(q_item->seq == flow_data->next_seq_to_send)
+            tmp_item = qlist_entry(tmp_link, struct fp_queue_item,
+                                   list_link);
+            if(tmp_item->seq == flow_data->next_seq_to_send)
             {
+                q_item = tmp_item;
                 break;
             }
         }
 
-        if(q_item->seq == flow_data->next_seq_to_send)
+        if(q_item)
         {
             flow_data->dest_pending++;
             assert(q_item->buffer_used);
@@ -1100,6 +1504,11 @@ static int bmi_send_callback_fn(void *user_ptr,
     else
     {
         flow_data->dest_pending--;
+        /* no trove reads in flight means trove has been waiting on bmi */
+        if(qlist_empty(&flow_data->src_list))
+        {
+            flow_data->stalls++;
+        }
     }
 
 #if 0
@@ -1134,28 +1543,72 @@ static int bmi_send_callback_fn(void *user_ptr,
      */
     if(flow_data->req_proc_done)
     {
-        if(q_item->buffer)
+        if(Q_ITEM_IN_USE(q_item))
         {
             qlist_del(&q_item->list_link);
         }
         return(0);
     }
 
-    if(q_item->buffer)
+    /* one stage keeps finding the other idle; deepen the pipeline by
+     * starting another queue item just as fp_multiqueue_post() does
+     */
+    if(!initial_call_flag &&
+       flow_data->stalls >= GROW_STALL_THRESHOLD &&
+       flow_data->depth < flow_data->max_depth)
+    {
+        flow_data->stalls = 0;
+        flow_data->initial_posts++;
+        flow_data->depth++;
+        PINT_perf_count(PINT_server_pc, PINT_PERF_FLOW_DEPTH_GROW,
+                        1, PINT_PERF_ADD);
+        ret = bmi_send_callback_fn(
+            &flow_data->prealloc_array[flow_data->depth - 1], 0, 0, 1);
+        if(ret == 1)
+        {
+            return(1);
+        }
+        if(!Q_ITEM_IN_USE(&flow_data->prealloc_array[flow_data->depth - 1]))
+        {
+            /* no buffer to be had from the pool */
+            flow_data->depth--;
+        }
+        if(flow_data->req_proc_done)
+        {
+            if(Q_ITEM_IN_USE(q_item))
+            {
+                qlist_del(&q_item->list_link);
+            }
+            return(0);
+        }
+    }
+
+    if(Q_ITEM_IN_USE(q_item))
     {
         /* if this q_item has been used before, remove it from its 
          * current queue */
         qlist_del(&q_item->list_link);
     }
+    else if(flow_data->send_fd_ref)
+    {
+        /* sends straight from the bstream; no buffer needed */
+        q_item->file_send = 1;
+        q_item->bmi_callback.fn = bmi_send_callback_wrapper;
+    }
     else
     {
-        /* if the q_item has not been used, allocate a buffer */
-        q_item->buffer = BMI_memalloc(
-                        q_item->parent->dest.u.bmi.address,
-                        q_item->parent->buffer_size, BMI_SEND);
-
-        /* TODO: error handling */
-        assert(q_item->buffer);
+        /* if the q_item has not been used, get a buffer */
+        q_item->buffer = get_flow_buffer(flow_data,
+                                         q_item->parent->dest.u.bmi.address,
+                                         BMI_SEND);
+        if(!q_item->buffer)
+        {
+            /* the pool is full; leave this q_item unused and carry on
+             * with the buffers the flow already has
+             */
+            assert(initial_call_flag);
+            return(0);
+        }
         q_item->bmi_callback.fn = bmi_send_callback_wrapper;
     }
 
@@ -1239,7 +1692,7 @@ static int bmi_send_callback_fn(void *user_ptr,
 
     if(bytes_processed == 0)
     {        
-        if(q_item->buffer)
+        if(Q_ITEM_IN_USE(q_item))
         {
             qlist_del(&q_item->list_link);
         }
@@ -1286,6 +1739,11 @@ static int bmi_send_callback_fn(void *user_ptr,
 
     assert(q_item->buffer_used);
 
+    if(q_item->file_send)
+    {
+        return(post_file_send(q_item, flow_data));
+    }
+
     result_tmp = &q_item->result_chain;
     do{
         assert(q_item->buffer_used);
@@ -1430,12 +1888,18 @@ static void trove_write_callback_fn(void *user_ptr, PVFS_error error_code)
     }
     else
     {
-        /* if the q_item has not been used, allocate a buffer */
-        q_item->buffer = BMI_memalloc(q_item->parent->src.u.bmi.address,
-                                      q_item->parent->buffer_size,
-                                      BMI_RECV);
-        /* TODO: error handling */
-        assert(q_item->buffer);
+        /* if the q_item has not been used, get a buffer; the first one
+         * was reserved when the flow was admitted
+         */
+        q_item->buffer = get_flow_buffer(flow_data,
+                                         q_item->parent->src.u.bmi.address,
+                                         BMI_RECV);
+        if(!q_item->buffer)
+        {
+            gossip_err("%s: I/O error occurred\n", __func__);
+            handle_io_error(-PVFS_ENOMEM, q_item, flow_data);
+            return;
+        }
         q_item->bmi_callback.fn = bmi_recv_callback_wrapper;
     }
 
@@ -1553,13 +2017,142 @@ static void trove_write_callback_fn(void *user_ptr, PVFS_error error_code)
 };
 #endif
 
+/* size_flow()
+ *
+ * chooses the buffer size and pipeline depth for a flow from the
+ * configured defaults, the amount of data the flow can move and the
+ * number of contiguous regions in its file datatype
+ *
+ * no return value
+ */
+static void size_flow(flow_descriptor *flow_d,
+                      struct fp_private_data *flow_data)
+{
+    PVFS_size bound;
+    PVFS_size needed;
+    PVFS_size rounded;
+    int32_t regions;
+
+    if(flow_d->buffer_size < 1)
+    {
+        flow_d->buffer_size = BUFFER_SIZE;
+    }
+    if(flow_d->buffers_per_flow < 1)
+    {
+        flow_d->buffers_per_flow = BUFFERS_PER_FLOW;
+    }
+
+    flow_data->depth = flow_d->buffers_per_flow;
+    flow_data->max_depth = flow_d->buffers_per_flow * BUFFERS_GROWTH_FACTOR;
+    if(flow_data->max_depth > MAX_BUFFERS_PER_FLOW)
+    {
+        flow_data->max_depth = MAX_BUFFERS_PER_FLOW;
+    }
+    if(flow_data->max_depth < flow_data->depth)
+    {
+        flow_data->max_depth = flow_data->depth;
+    }
+
+    /* memory endpoints only ever use the first queue item */
+    if(flow_d->src.endpoint_id == MEM_ENDPOINT ||
+       flow_d->dest.endpoint_id == MEM_ENDPOINT)
+    {
+        flow_data->depth = 1;
+        flow_data->max_depth = 1;
+    }
+
+    /* the flow never moves more than this many bytes; the client and
+     * server both derive it from the memory datatype size
+     */
+    if(flow_d->aggregate_size > -1)
+    {
+        bound = flow_d->aggregate_size;
+    }
+    else
+    {
+        bound = PINT_REQUEST_TOTAL_BYTES(flow_d->mem_req);
+    }
+
+    /* a flow that fits in one buffer is sent as a single message
+     * whatever the buffer size, so it is safe for either end to shrink
+     * its buffer without the other one doing the same
+     */
+    if(bound < flow_d->buffer_size)
+    {
+        rounded = ((bound + MIN_BUFFER_SIZE - 1) / MIN_BUFFER_SIZE) *
+            MIN_BUFFER_SIZE;
+        if(rounded < MIN_BUFFER_SIZE)
+        {
+            rounded = MIN_BUFFER_SIZE;
+        }
+        if(rounded < flow_d->buffer_size)
+        {
+            flow_d->buffer_size = rounded;
+        }
+    }
+
+    /* never keep more queue items than buffers worth of data */
+    needed = (bound + flow_d->buffer_size - 1) / flow_d->buffer_size;
+    if(needed < 1)
+    {
+        needed = 1;
+    }
+    if(needed < flow_data->max_depth)
+    {
+        flow_data->max_depth = needed;
+    }
+    if(flow_data->depth > flow_data->max_depth)
+    {
+        flow_data->depth = flow_data->max_depth;
+    }
+
+    /* heavily strided requests start with a shallow pipeline and only
+     * grow it if trove or bmi turn out to be waiting on each other
+     */
+    if(flow_d->file_req)
+    {
+        regions = PINT_REQUEST_NUM_CONTIG(flow_d->file_req);
+        if(regions > 1 &&
+           (PINT_REQUEST_TOTAL_BYTES(flow_d->file_req) / regions) <
+            SMALL_REGION_SIZE &&
+           flow_data->depth > SMALL_REGION_DEPTH)
+        {
+            flow_data->depth = SMALL_REGION_DEPTH;
+        }
+    }
+
+    gossip_debug(GOSSIP_FLOW_PROTO_DEBUG,
+                 "flowproto sized %p: buffer_size: %d, depth: %d, "
+                 "max depth: %d, bound: %lld\n", flow_d,
+                 flow_d->buffer_size, flow_data->depth,
+                 flow_data->max_depth, lld(bound));
+}
+
+/* put_flow_buffer()
+ *
+ * returns a buffer obtained with get_flow_buffer() to the shared pool.
+ * wake must be 0 if the caller holds locks that a flow started by the
+ * pool might need (i.e. on the cancel path).
+ *
+ * no return value
+ */
+static void put_flow_buffer(struct fp_private_data *flow_data,
+                            void *buffer,
+                            int wake)
+{
+#ifdef __PVFS2_TROVE_SUPPORT__
+    PINT_flow_buffer_put(buffer, wake);
+    FLOW_BUFFER_COUNT(flow_data->parent, PINT_PERF_SUB);
+#endif
+}
+
 /* cleanup_buffers()
  *
  * releases any resources consumed during flow processing
  *
  * no return value
  */
-static void cleanup_buffers(struct fp_private_data *flow_data)
+static void cleanup_buffers(struct fp_private_data *flow_data, int wake)
 {
     int i;
     struct result_chain_entry *result_tmp;
@@ -1568,14 +2161,12 @@ static void cleanup_buffers(struct fp_private_data *flow_data)
     if(flow_data->parent->src.endpoint_id == BMI_ENDPOINT &&
         flow_data->parent->dest.endpoint_id == TROVE_ENDPOINT)
     {
-        for(i = 0; i < flow_data->parent->buffers_per_flow; i++)
+        for(i = 0; i < flow_data->max_depth; i++)
         {
             if(flow_data->prealloc_array[i].buffer)
             {
-                BMI_memfree(flow_data->parent->src.u.bmi.address,
-                            flow_data->prealloc_array[i].buffer,
-                            flow_data->parent->buffer_size,
-                            BMI_RECV);
+                put_flow_buffer(flow_data,
+                                flow_data->prealloc_array[i].buffer, wake);
             }
             result_tmp = &(flow_data->prealloc_array[i].result_chain);
             do{
@@ -1593,15 +2184,15 @@ static void cleanup_buffers(struct fp_private_data *flow_data)
     else if(flow_data->parent->src.endpoint_id == TROVE_ENDPOINT &&
             flow_data->parent->dest.endpoint_id == BMI_ENDPOINT)
     {
-        for(i = 0; i < flow_data->parent->buffers_per_flow; i++)
+        for(i = 0; i < flow_data->max_depth; i++)
         {
             if(flow_data->prealloc_array[i].buffer)
             {
-                BMI_memfree(flow_data->parent->dest.u.bmi.address,
-                            flow_data->prealloc_array[i].buffer,
-                            flow_data->parent->buffer_size,
-                            BMI_SEND);
+                put_flow_buffer(flow_data,
+                                flow_data->prealloc_array[i].buffer, wake);
             }
+            free(flow_data->prealloc_array[i].file_offsets);
+            free(flow_data->prealloc_array[i].file_sizes);
             result_tmp = &(flow_data->prealloc_array[i].result_chain);
             do{
                 old_result_tmp = result_tmp;
@@ -1638,6 +2229,23 @@ static void cleanup_buffers(struct fp_private_data *flow_data)
         }
     }
 
+#ifdef __PVFS2_TROVE_SUPPORT__
+    if(flow_data->send_fd_ref)
+    {
+        trove_bstream_fd_put(flow_data->parent->src.u.trove.coll_id,
+                             flow_data->send_fd_ref);
+        flow_data->send_fd_ref = NULL;
+    }
+#endif
+
+    if(flow_data->reserved_buffer)
+    {
+        /* admitted, but finished without needing the buffer */
+        FLOW_BUFFER_COUNT(flow_data->parent, PINT_PERF_ADD);
+        put_flow_buffer(flow_data, flow_data->reserved_buffer, wake);
+        flow_data->reserved_buffer = NULL;
+    }
+
     free(flow_data->prealloc_array);
 }
 
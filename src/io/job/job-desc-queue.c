@@ -12,6 +12,12 @@
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 
 #include "job-desc-queue.h"
 #include "gossip.h"
@@ -23,6 +29,8 @@
 typedef enum job_type job_type_t;
 #endif
 
+static void job_completion_q_wake(struct job_completion_q *cq);
+
 /***************************************************************
  * Visible functions
  */
@@ -228,6 +236,223 @@ void job_desc_q_dump(job_desc_q_p jdqp)
     return;
 }
 
+/* job_completion_q_init()
+ *
+ * sets up the locks and an empty inbox and done list for a completion
+ * queue; the caller marks the context open
+ *
+ * no return value
+ */
+void job_completion_q_init(struct job_completion_q *cq)
+{
+    cq->inbox = NULL;
+    INIT_QLIST_HEAD(&cq->done);
+    gen_mutex_init(&cq->mutex);
+    cq->seq = 0;
+    cq->sleeping = 0;
+#ifndef __linux__
+    gen_mutex_init(&cq->wait_mutex);
+    gen_cond_init(&cq->wait_cond);
+#endif
+    cq->open = 0;
+}
+
+/* job_completion_q_cleanup()
+ *
+ * releases any job descs still sitting in a completion queue.  The
+ * queue itself is not freed, since completing threads may still look
+ * at it after the context has been closed.
+ *
+ * no return value
+ */
+void job_completion_q_cleanup(struct job_completion_q *cq)
+{
+    struct qlist_head *iterator = NULL;
+    struct qlist_head *scratch = NULL;
+    struct job_desc *tmp_job_desc = NULL;
+
+    job_completion_q_drain(cq);
+    qlist_for_each_safe(iterator, scratch, &cq->done)
+    {
+        tmp_job_desc = qlist_entry(iterator, struct job_desc,
+                job_desc_q_link);
+        free(tmp_job_desc);
+    }
+    INIT_QLIST_HEAD(&cq->done);
+    cq->open = 0;
+}
+
+/* job_completion_q_claim()
+ *
+ * marks a job as completed, for completion paths that can race with
+ * each other (e.g. a cancel and a normal completion)
+ *
+ * returns 1 if the caller now owns the completion, 0 if the job had
+ * already been completed
+ */
+int job_completion_q_claim(struct job_desc *desc)
+{
+    int expected = 0;
+
+    return (__atomic_compare_exchange_n(&desc->completed_flag, &expected,
+        1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+/* job_completion_q_push()
+ *
+ * marks a job as completed and adds it to a completion queue.  Does not
+ * take any locks, so it may be called from any thread, including
+ * callbacks that run while a tester holds the queue mutex.  The caller
+ * must not touch the job desc afterwards; a tester may already have
+ * released it.
+ *
+ * no return value
+ */
+void job_completion_q_push(struct job_completion_q *cq,
+                           struct job_desc *desc)
+{
+    struct job_desc *head;
+
+    __atomic_store_n(&desc->completed_flag, 1, __ATOMIC_RELAXED);
+    head = __atomic_load_n(&cq->inbox, __ATOMIC_RELAXED);
+    do
+    {
+        desc->completion_next = head;
+    } while (!__atomic_compare_exchange_n(&cq->inbox, &head, desc, 1,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    /* pairs with setting the sleeping flag in job_completion_q_wait():
+     * either the tester sees the new seq or we see the flag.  Clearing
+     * the flag means only the first push after a tester goes to sleep
+     * pays for a wakeup.
+     */
+    __atomic_add_fetch(&cq->seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&cq->sleeping, __ATOMIC_SEQ_CST) &&
+        __atomic_exchange_n(&cq->sleeping, 0, __ATOMIC_SEQ_CST))
+    {
+        job_completion_q_wake(cq);
+    }
+}
+
+/* job_completion_q_drain()
+ *
+ * moves everything pushed so far onto the done list, oldest first.
+ * Must be called with the queue mutex held.
+ *
+ * no return value
+ */
+void job_completion_q_drain(struct job_completion_q *cq)
+{
+    struct job_desc *list;
+    struct job_desc *next;
+    struct job_desc *oldest = NULL;
+
+    if (!__atomic_load_n(&cq->inbox, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+    list = __atomic_exchange_n(&cq->inbox, NULL, __ATOMIC_ACQUIRE);
+
+    /* the inbox is a stack; reverse it to keep completion order */
+    while (list)
+    {
+        next = list->completion_next;
+        list->completion_next = oldest;
+        oldest = list;
+        list = next;
+    }
+    while (oldest)
+    {
+        next = oldest->completion_next;
+        oldest->completion_next = NULL;
+        oldest->completion_queued = 1;
+        job_desc_q_add(&cq->done, oldest);
+        oldest = next;
+    }
+}
+
+/* job_completion_q_seq()
+ *
+ * samples the completion counter; take the sample before draining and
+ * pass it to job_completion_q_wait() so that a push between the drain
+ * and the wait is not missed
+ *
+ * returns the current counter value
+ */
+int job_completion_q_seq(struct job_completion_q *cq)
+{
+    return (__atomic_load_n(&cq->seq, __ATOMIC_SEQ_CST));
+}
+
+/* job_completion_q_wait()
+ *
+ * sleeps until something is pushed after seq was sampled, or until
+ * abstime (gettimeofday() clock) passes.  A NULL abstime waits forever.
+ * Must be called without the queue mutex held.
+ *
+ * returns 0 when woken, EINTR or ETIMEDOUT otherwise
+ */
+int job_completion_q_wait(struct job_completion_q *cq,
+                          int seq,
+                          const struct timespec *abstime)
+{
+    int ret = 0;
+
+    __atomic_store_n(&cq->sleeping, 1, __ATOMIC_SEQ_CST);
+#ifdef __linux__
+    /* returns EAGAIN right away if seq has already moved on */
+    if (syscall(SYS_futex, &cq->seq,
+                FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+                seq, abstime, NULL, FUTEX_BITSET_MATCH_ANY) < 0)
+    {
+        if (errno == ETIMEDOUT || errno == EINTR)
+        {
+            ret = errno;
+        }
+    }
+#else
+    gen_mutex_lock(&cq->wait_mutex);
+    if (__atomic_load_n(&cq->seq, __ATOMIC_SEQ_CST) == seq)
+    {
+        if (abstime)
+        {
+            ret = gen_cond_timedwait(&cq->wait_cond, &cq->wait_mutex,
+                                     abstime);
+        }
+        else
+        {
+            ret = gen_cond_wait(&cq->wait_cond, &cq->wait_mutex);
+        }
+    }
+    gen_mutex_unlock(&cq->wait_mutex);
+#endif
+
+    return (ret);
+}
+
+/***************************************************************
+ * Internal utility functions
+ */
+
+/* job_completion_q_wake()
+ *
+ * wakes every thread sleeping on a completion queue; they may be
+ * waiting for different jobs
+ *
+ * no return value
+ */
+static void job_completion_q_wake(struct job_completion_q *cq)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &cq->seq, FUTEX_WAKE_PRIVATE, INT_MAX,
+            NULL, NULL, 0);
+#else
+    gen_mutex_lock(&cq->wait_mutex);
+    gen_cond_broadcast(&cq->wait_cond);
+    gen_mutex_unlock(&cq->wait_mutex);
+#endif
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -11,6 +11,8 @@
 #ifndef __JOB_DESC_QUEUE_H
 #define __JOB_DESC_QUEUE_H
 
+#include <time.h>
+
 #include "pvfs2-internal.h"
 #include "quicklist.h"
 #include "job.h"
@@ -18,6 +20,7 @@
 #include "trove-types.h"
 #include "src/server/request-scheduler/request-scheduler.h"
 #include "thread-mgr.h"
+#include "gen-locks.h"
 
 /* describes BMI operations */
 struct bmi_desc
@@ -144,10 +147,33 @@ struct job_desc
     struct qlist_head job_desc_q_link;	/* queue link */
     struct qlist_head job_time_link;	/* queue link */
     void* time_bucket;
+
+    struct job_desc *completion_next;   /* link in a completion inbox */
+    int completion_queued;      /* moved to the context's done list? */
 };
 
 typedef struct qlist_head *job_desc_q_p;
 
+/* completion queue for one job context.  Threads that complete jobs
+ * push them onto the inbox with a compare-and-swap and never block;
+ * threads testing the context move everything in the inbox onto the
+ * done list while holding the mutex, so they only contend with each
+ * other.  seq is bumped on every push and is what testers sleep on.
+ */
+struct job_completion_q
+{
+    int open;                       /* context is in use */
+    struct job_desc *inbox;         /* pushed jobs, newest first */
+    struct qlist_head done;         /* drained jobs, in completion order */
+    gen_mutex_t mutex;              /* held by testers of the context */
+    int seq;                        /* completion counter (futex word) */
+    int sleeping;                   /* set when a tester may be asleep */
+#ifndef __linux__
+    gen_mutex_t wait_mutex;
+    gen_cond_t wait_cond;
+#endif
+};
+
 struct job_desc *alloc_job_desc(int type);
 void dealloc_job_desc(struct job_desc *jd);
 job_desc_q_p job_desc_q_new(void);
@@ -159,6 +185,17 @@ int job_desc_q_empty(job_desc_q_p jdqp);
 struct job_desc *job_desc_q_shownext(job_desc_q_p jdqp);
 void job_desc_q_dump(job_desc_q_p jdqp);
 
+void job_completion_q_init(struct job_completion_q *cq);
+void job_completion_q_cleanup(struct job_completion_q *cq);
+int job_completion_q_claim(struct job_desc *desc);
+void job_completion_q_push(struct job_completion_q *cq,
+                           struct job_desc *desc);
+void job_completion_q_drain(struct job_completion_q *cq);
+int job_completion_q_seq(struct job_completion_q *cq);
+int job_completion_q_wait(struct job_completion_q *cq,
+                          int seq,
+                          const struct timespec *abstime);
+
 #endif /* __JOB_DESC_QUEUE_H */
 
 /*
@@ -35,7 +35,7 @@ static TROVE_context_id global_trove_context = -1;
 #endif
 
 /* queues of pending jobs */
-static job_desc_q_p completion_queue_array[JOB_MAX_CONTEXTS] = {NULL};
+static struct job_completion_q completion_queue_array[JOB_MAX_CONTEXTS];
 static int completion_error = 0;
 static job_desc_q_p bmi_unexp_queue = NULL;
 static int bmi_unexp_pending_count = 0;
@@ -46,18 +46,20 @@ static job_desc_q_p dev_unexp_queue = NULL;
 #ifdef __PVFS2_CLIENT__
 static int dev_unexp_pending_count = 0;
 #endif
-/* locks for internal queues */
+/* locks for internal queues; each completion queue has its own lock,
+ * and context_mutex only covers opening and closing contexts
+ */
 static gen_mutex_t bmi_unexp_mutex = GEN_MUTEX_INITIALIZER;
 static gen_mutex_t dev_unexp_mutex = GEN_MUTEX_INITIALIZER;
-static gen_mutex_t completion_mutex = GEN_MUTEX_INITIALIZER;
+static gen_mutex_t context_mutex = GEN_MUTEX_INITIALIZER;
+/* the request scheduler keeps no locks of its own; this serializes
+ * callers when server state machines run on more than one thread
+ */
+static gen_mutex_t req_sched_mutex = GEN_MUTEX_INITIALIZER;
 
 static int initialized = 0;
 static gen_mutex_t initialized_mutex = GEN_MUTEX_INITIALIZER;
 
-#ifdef __PVFS2_JOB_THREADED__
-static pthread_cond_t completion_cond = PTHREAD_COND_INITIALIZER;
-#endif /* __PVFS2_JOB_THREADED__ */
-
 /* number of jobs to test for at once inside of do_one_work_cycle() */
 enum
 {
@@ -140,6 +142,7 @@ static void dev_thread_mgr_unexp_handler(struct PINT_dev_unexp_info* unexp);
 static void trove_thread_mgr_callback(void* data,
     PVFS_error error_code);
 static void flow_callback(flow_descriptor* flow_d, int cancel_path);
+static void job_complete(struct job_desc* jd);
 #ifndef __PVFS2_JOB_THREADED__
 static gen_mutex_t work_cycle_mutex = GEN_MUTEX_INITIALIZER;
 static void do_one_work_cycle_all(int idle_time_ms);
@@ -264,10 +267,10 @@ int job_open_context(job_context_id* context_id)
     int context_index;
 
     /* find an unused context id */
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&context_mutex);
     for(context_index=0; context_index<JOB_MAX_CONTEXTS; context_index++)
     {
-        if(completion_queue_array[context_index] == NULL)
+        if(!completion_queue_array[context_index].open)
         {
             break;
         }
@@ -276,18 +279,14 @@ int job_open_context(job_context_id* context_id)
     if(context_index >= JOB_MAX_CONTEXTS)
     {
         /* we don't have any more available! */
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&context_mutex);
         return(-EBUSY);
     }
 
-    /* create a new completion queue for the context */
-    completion_queue_array[context_index] = job_desc_q_new();
-    if(!completion_queue_array[context_index])
-    {
-        gen_mutex_unlock(&completion_mutex);
-        return(-ENOMEM);
-    }
-    gen_mutex_unlock(&completion_mutex);
+    /* set up the completion queue for the context */
+    job_completion_q_init(&completion_queue_array[context_index]);
+    completion_queue_array[context_index].open = 1;
+    gen_mutex_unlock(&context_mutex);
 
     *context_id = context_index;
     return(0);
@@ -302,18 +301,20 @@ int job_open_context(job_context_id* context_id)
  */
 void job_close_context(job_context_id context_id)
 {
-    gen_mutex_lock(&completion_mutex);
-    if(!completion_queue_array[context_id])
+    struct job_completion_q *cq = &completion_queue_array[context_id];
+
+    gen_mutex_lock(&context_mutex);
+    if(!cq->open)
     {
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&context_mutex);
         return;
     }
 
-    job_desc_q_cleanup(completion_queue_array[context_id]);
-
-    completion_queue_array[context_id] = NULL;
+    gen_mutex_lock(&cq->mutex);
+    job_completion_q_cleanup(cq);
+    gen_mutex_unlock(&cq->mutex);
 
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&context_mutex);
     return;
 }
 
@@ -328,36 +329,51 @@ int job_reset_timeout(job_id_t id, int timeout_sec)
 {
     struct job_desc* query = NULL;
     int ret = -1;
+    int i;
 
-    /* lock completion queue to make sure that a concurrent test call
-     * doesn't pull the job out from under us somehow
+    /* lock every completion queue to make sure that a concurrent test
+     * call doesn't pull the job out from under us somehow; we don't know
+     * which context the job belongs to until we have looked it up
      */
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&context_mutex);
+    for(i=0; i<JOB_MAX_CONTEXTS; i++)
+    {
+        if(completion_queue_array[i].open)
+        {
+            gen_mutex_lock(&completion_queue_array[i].mutex);
+        }
+    }
 
     query = id_gen_safe_lookup(id);
     if(!query)
     {        
         /* this id is not valid */
-        gen_mutex_unlock(&completion_mutex);
-        return(-PVFS_EINVAL);
+        ret = -PVFS_EINVAL;
     }
-
-    if(query->type != JOB_BMI && query->type != JOB_FLOW)
+    else if(query->type != JOB_BMI && query->type != JOB_FLOW)
     {
         /* trying to reset timeouts on a job that doesn't support the
          * concept 
          */
-        gen_mutex_unlock(&completion_mutex);
-        return(-PVFS_EINVAL);
+        ret = -PVFS_EINVAL;
     }
+    else
+    {
+        /* pull the job out of the time mgr (thereby clearing old timer) */
+        job_time_mgr_rem(query);
 
-    /* pull the job out of the time mgr (thereby clearing old timer) */
-    job_time_mgr_rem(query);
-
-    /* put it back into the time mgr with new value */
-    ret = job_time_mgr_add(query, timeout_sec);
+        /* put it back into the time mgr with new value */
+        ret = job_time_mgr_add(query, timeout_sec);
+    }
 
-    gen_mutex_unlock(&completion_mutex);
+    for(i=JOB_MAX_CONTEXTS-1; i>=0; i--)
+    {
+        if(completion_queue_array[i].open)
+        {
+            gen_mutex_unlock(&completion_queue_array[i].mutex);
+        }
+    }
+    gen_mutex_unlock(&context_mutex);
 
     return(ret);
 }
@@ -412,6 +428,13 @@ int job_bmi_send(PVFS_BMI_addr_t addr,
 
     jd->hints = hints;
 
+    /* with server state machines running on worker threads, the main
+     * loop can collect (and free) the job as soon as it is posted, so it
+     * goes under timeout control and its id is handed out first
+     */
+    *id = jd->job_id;
+    job_time_mgr_add(jd, timeout_sec);
+
     /* post appropriate type of send */
     if (!send_unexpected)
     {
@@ -432,6 +455,7 @@ int job_bmi_send(PVFS_BMI_addr_t addr,
         /* error posting */
         out_status_p->error_code = ret;
         out_status_p->status_user_tag = status_user_tag;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
@@ -443,6 +467,7 @@ int job_bmi_send(PVFS_BMI_addr_t addr,
         out_status_p->error_code = 0;
         out_status_p->status_user_tag = status_user_tag;
         out_status_p->actual_size = size;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (ret);
@@ -451,10 +476,9 @@ int job_bmi_send(PVFS_BMI_addr_t addr,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     bmi_pending_count++;
 
-    return(job_time_mgr_add(jd, timeout_sec));
+    return(0);
 }
 
 
@@ -509,6 +533,10 @@ int job_bmi_send_list(PVFS_BMI_addr_t addr,
 
     jd->hints = hints;
 
+    /* before posting; see job_bmi_send() */
+    *id = jd->job_id;
+    job_time_mgr_add(jd, timeout_sec);
+
     /* post appropriate type of send */
     if (!send_unexpected)
     {
@@ -531,6 +559,7 @@ int job_bmi_send_list(PVFS_BMI_addr_t addr,
         /* error posting */
         out_status_p->error_code = ret;
         out_status_p->status_user_tag = status_user_tag;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
@@ -542,6 +571,7 @@ int job_bmi_send_list(PVFS_BMI_addr_t addr,
         out_status_p->error_code = 0;
         out_status_p->status_user_tag = status_user_tag;
         out_status_p->actual_size = total_size;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (ret);
@@ -550,9 +580,8 @@ int job_bmi_send_list(PVFS_BMI_addr_t addr,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     bmi_pending_count++;
-    return(job_time_mgr_add(jd, timeout_sec));
+    return(0);
 }
 
 /* job_bmi_recv()
@@ -600,6 +629,9 @@ int job_bmi_recv(PVFS_BMI_addr_t addr,
     jd->bmi_callback.data = (void*)jd;
     user_ptr_internal = &jd->bmi_callback;
 
+    /* before posting; see job_bmi_send() */
+    *id = jd->job_id;
+    job_time_mgr_add(jd, timeout_sec);
 
     ret = BMI_post_recv(&(jd->u.bmi.id), addr, buffer, size,
                         &(jd->u.bmi.actual_size), buffer_type, tag,
@@ -611,6 +643,7 @@ int job_bmi_recv(PVFS_BMI_addr_t addr,
         /* error posting */
         out_status_p->error_code = ret;
         out_status_p->status_user_tag = status_user_tag;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
@@ -622,6 +655,7 @@ int job_bmi_recv(PVFS_BMI_addr_t addr,
         out_status_p->error_code = 0;
         out_status_p->status_user_tag = status_user_tag;
         out_status_p->actual_size = jd->u.bmi.actual_size;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (ret);
@@ -630,10 +664,9 @@ int job_bmi_recv(PVFS_BMI_addr_t addr,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     bmi_pending_count++;
 
-    return(job_time_mgr_add(jd, timeout_sec));
+    return(0);
 }
 
 
@@ -686,6 +719,10 @@ int job_bmi_recv_list(PVFS_BMI_addr_t addr,
     jd->bmi_callback.data = (void*)jd;
     user_ptr_internal = &jd->bmi_callback;
 
+    /* before posting; see job_bmi_send() */
+    *id = jd->job_id;
+    job_time_mgr_add(jd, timeout_sec);
+
     ret = BMI_post_recv_list(&(jd->u.bmi.id), addr, buffer_list,
                              size_list, list_count, total_expected_size,
                              &(jd->u.bmi.actual_size), buffer_type, tag,
@@ -696,6 +733,7 @@ int job_bmi_recv_list(PVFS_BMI_addr_t addr,
         /* error posting */
         out_status_p->error_code = ret;
         out_status_p->status_user_tag = status_user_tag;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
@@ -707,6 +745,7 @@ int job_bmi_recv_list(PVFS_BMI_addr_t addr,
         out_status_p->error_code = 0;
         out_status_p->status_user_tag = status_user_tag;
         out_status_p->actual_size = jd->u.bmi.actual_size;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (ret);
@@ -715,10 +754,9 @@ int job_bmi_recv_list(PVFS_BMI_addr_t addr,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     bmi_pending_count++;
 
-    return(job_time_mgr_add(jd, timeout_sec));
+    return(0);
 }
 
 /* job_bmi_unexp()
@@ -818,19 +856,7 @@ int job_bmi_unexp_cancel(job_id_t id)
     bmi_unexp_pending_count--;
     gen_mutex_unlock(&bmi_unexp_mutex);
 
-    gen_mutex_lock(&completion_mutex);
-    /* set completed flag while holding queue lock */
-    jd->completed_flag = 1;
-    if (completion_queue_array[jd->context_id])
-    {
-        job_desc_q_add(completion_queue_array[jd->context_id], jd);
-    }
-
-#ifdef __PVFS2_JOB_THREADED__
-    /* wake up anyone waiting for completion */
-    pthread_cond_signal(&completion_cond);
-#endif
-    gen_mutex_unlock(&completion_mutex);
+    job_complete(jd);
 
     return 0;
 }
@@ -846,14 +872,18 @@ int job_bmi_cancel(job_id_t id, job_context_id context_id)
 {
     struct job_desc* query = NULL;
     int ret = -1;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
 
-    gen_mutex_lock(&completion_mutex);
+    /* a tester of this context is the only one that can release the job
+     * desc; hold off testers while we use it
+     */
+    gen_mutex_lock(&cq->mutex);
 
     query = id_gen_safe_lookup(id);
     if (!query || query->completed_flag)
     {
         /* job has already completed, no cancellation needed */
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&cq->mutex);
         return(0);
     }
 
@@ -863,7 +893,7 @@ int job_bmi_cancel(job_id_t id, job_context_id context_id)
     ret = PINT_thread_mgr_bmi_cancel(
         query->u.bmi.id, &(query->bmi_callback));
 
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&cq->mutex);
 
     return(ret);
 }
@@ -1049,6 +1079,7 @@ int job_dev_write_list(void** buffer_list,
 int job_req_sched_post(enum PVFS_server_op op,
                        PVFS_fs_id fs_id,
                        PVFS_handle handle,
+                       PVFS_BMI_addr_t client_addr,
                        enum PINT_server_req_access_type access_type,
                        enum PINT_server_sched_policy sched_policy,
                        void *user_ptr,
@@ -1081,8 +1112,11 @@ int job_req_sched_post(enum PVFS_server_op op,
     jd->context_id = context_id;
     jd->status_user_tag = status_user_tag;
 
+    gen_mutex_lock(&req_sched_mutex);
     ret = PINT_req_sched_post(
-        op, fs_id, handle, access_type, sched_policy, jd, &(jd->u.req_sched.id));
+        op, fs_id, handle, client_addr, access_type, sched_policy, jd,
+        &(jd->u.req_sched.id));
+    gen_mutex_unlock(&req_sched_mutex);
 
     if (ret < 0)
     {
@@ -1133,7 +1167,9 @@ int job_req_sched_change_mode(enum PVFS_server_mode mode,
     jd->context_id = context_id;
     jd->status_user_tag = status_user_tag;
 
+    gen_mutex_lock(&req_sched_mutex);
     ret = PINT_req_sched_change_mode(mode, jd, &(jd->u.req_sched.id));
+    gen_mutex_unlock(&req_sched_mutex);
     if (ret < 0)
     {
         /* error posting */
@@ -1191,7 +1227,13 @@ int job_req_sched_post_timer(int msecs,
     jd->context_id = context_id;
     jd->status_user_tag = status_user_tag;
 
+    /* before posting; see job_bmi_send() */
+    if (id)
+        *id = jd->job_id;
+
+    gen_mutex_lock(&req_sched_mutex);
     ret = PINT_req_sched_post_timer(msecs, jd, &(jd->u.req_sched.id));
+    gen_mutex_unlock(&req_sched_mutex);
 
     if (ret < 0)
     {
@@ -1216,9 +1258,6 @@ int job_req_sched_post_timer(int msecs,
     /* if we hit this point, job did not immediately complete-
      * queue to test later
      */
-    if (id)
-        *id = jd->job_id;
-
     return (0);
 }
 
@@ -1267,8 +1306,10 @@ int job_req_sched_release(job_id_t in_completed_id,
         return 1;
     }
 
+    gen_mutex_lock(&req_sched_mutex);
     ret = PINT_req_sched_release(match_jd->u.req_sched.id, jd,
                                  &(jd->u.req_sched.id));
+    gen_mutex_unlock(&req_sched_mutex);
 
     /* delete the old req sched job desc; it is no longer needed */
     dealloc_job_desc(match_jd);
@@ -1339,12 +1380,17 @@ int job_flow(flow_descriptor * flow_d,
     flow_d->user_ptr = jd;
     flow_d->callback = flow_callback;
 
+    /* before posting; see job_bmi_send() */
+    *id = jd->job_id;
+    job_time_mgr_add(jd, timeout_sec);
+
     /* post the flow */
     ret = PINT_flow_post(flow_d);
     if (ret < 0)
     {
         out_status_p->error_code = ret;
         out_status_p->status_user_tag = status_user_tag;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
@@ -1355,18 +1401,18 @@ int job_flow(flow_descriptor * flow_d,
         out_status_p->error_code = 0;
         out_status_p->status_user_tag = status_user_tag;
         out_status_p->actual_size = flow_d->total_transferred;
+        job_time_mgr_rem(jd);
         dealloc_job_desc(jd);
         jd = NULL;
         return (1);
     }
 
     /* queue up the job desc. for later completion */
-    *id = jd->job_id;
     flow_pending_count++;
     gossip_debug(GOSSIP_FLOW_DEBUG, "Job flows in progress (post time): %d\n",
             flow_pending_count);
 
-    return(job_time_mgr_add(jd, timeout_sec));
+    return(0);
 }
 
 /* job_flow_cancel()
@@ -1382,15 +1428,16 @@ int job_flow_cancel(job_id_t id, job_context_id context_id)
 {
     struct job_desc* query = NULL;
     int ret = -1;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
 
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&cq->mutex);
 
     query = id_gen_safe_lookup(id);
 
     if (!query || query->completed_flag)
     {
         /* job has already completed, no cancellation needed */
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&cq->mutex);
         return(0);
     }
 
@@ -1400,7 +1447,7 @@ int job_flow_cancel(job_id_t id, job_context_id context_id)
      */
     ret = PINT_flow_cancel(query->u.flow.flow_d);
 
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&cq->mutex);
 
     return(ret);
 }
@@ -1450,6 +1497,8 @@ int job_trove_bstream_write_list(TROVE_coll_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_bstream_write_list(coll_id, handle,
                                    mem_offset_array, mem_size_array,
@@ -1492,7 +1541,6 @@ int job_trove_bstream_write_list(TROVE_coll_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1543,6 +1591,8 @@ int job_trove_bstream_read_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_bstream_read_list(coll_id, handle,
                                   mem_offset_array, mem_size_array,
@@ -1583,7 +1633,6 @@ int job_trove_bstream_read_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1627,6 +1676,8 @@ int job_trove_bstream_flush(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_bstream_flush(coll_id, handle, flags, user_ptr_internal,
                               global_trove_context, &(jd->u.trove.id), hints);
@@ -1656,7 +1707,6 @@ int job_trove_bstream_flush(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1708,6 +1758,8 @@ int job_trove_keyval_read(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_read(coll_id, handle, key_p, val_p, flags,
                             jd->u.trove.vtag, user_ptr_internal,
@@ -1741,7 +1793,6 @@ int job_trove_keyval_read(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1795,6 +1846,8 @@ int job_trove_keyval_read_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_read_list(coll_id, handle, key_array, val_array,
                                  err_array, count, flags, jd->u.trove.vtag,
@@ -1829,7 +1882,6 @@ int job_trove_keyval_read_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1881,6 +1933,8 @@ int job_trove_keyval_write(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_write(coll_id, handle, key_p, val_p, flags,
                              jd->u.trove.vtag, user_ptr_internal,
@@ -1915,7 +1969,6 @@ int job_trove_keyval_write(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -1968,6 +2021,8 @@ int job_trove_keyval_write_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     gossip_debug(GOSSIP_JOB_DEBUG, "job_trove_keyval_write_list() posting trove_keyval_write_list()\n");
     ret = trove_keyval_write_list(coll_id,
@@ -2010,7 +2065,6 @@ int job_trove_keyval_write_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2052,6 +2106,8 @@ int job_trove_keyval_remove_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_remove_list(coll_id, handle,
                              key_array, val_array, error_array,
@@ -2089,7 +2145,6 @@ int job_trove_keyval_remove_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2133,6 +2188,8 @@ int job_trove_keyval_flush(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_flush(coll_id, handle, flags, user_ptr_internal,
                              global_trove_context, &(jd->u.trove.id), hints);
@@ -2164,7 +2221,6 @@ int job_trove_keyval_flush(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2210,6 +2266,8 @@ int job_trove_keyval_get_handle_info(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_get_handle_info(
         coll_id,
@@ -2246,7 +2304,6 @@ int job_trove_keyval_get_handle_info(PVFS_fs_id coll_id,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2298,6 +2355,8 @@ int job_trove_dspace_getattr(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_getattr(coll_id,
                                handle, out_ds_attr_ptr, 0 /* flags */ ,
@@ -2331,7 +2390,6 @@ int job_trove_dspace_getattr(PVFS_fs_id coll_id,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2385,6 +2443,8 @@ int job_trove_dspace_getattr_list(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_getattr_list(coll_id,
                                nhandles,
@@ -2421,7 +2481,6 @@ int job_trove_dspace_getattr_list(PVFS_fs_id coll_id,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2471,6 +2530,8 @@ int job_trove_dspace_setattr(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_setattr(coll_id, handle, ds_attr_p,
                                flags,
@@ -2504,7 +2565,6 @@ int job_trove_dspace_setattr(PVFS_fs_id coll_id,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2555,6 +2615,8 @@ int job_trove_bstream_resize(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_bstream_resize(coll_id, handle, &size,
                                flags,
@@ -2588,7 +2650,6 @@ int job_trove_bstream_resize(PVFS_fs_id coll_id,
     /* if we fall to this point, the job did not immediately complete and
      * we must queue up to test it later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2662,6 +2723,8 @@ int job_trove_keyval_remove(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_remove(coll_id, handle, key_p, val_p, flags,
                               jd->u.trove.vtag, user_ptr_internal,
@@ -2695,7 +2758,6 @@ int job_trove_keyval_remove(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2773,6 +2835,8 @@ int job_trove_keyval_iterate(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_iterate(coll_id, handle,
                                &(jd->u.trove.position), key_array, val_array,
@@ -2810,7 +2874,6 @@ int job_trove_keyval_iterate(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2865,6 +2928,8 @@ int job_trove_keyval_iterate_keys(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_iterate_keys(coll_id, handle,
                                &(jd->u.trove.position), key_array,
@@ -2902,7 +2967,6 @@ int job_trove_keyval_iterate_keys(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -2953,6 +3017,8 @@ int job_trove_dspace_iterate_handles(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_iterate_handles(coll_id,
                                &(jd->u.trove.position), handle_array,
@@ -2990,7 +3056,6 @@ int job_trove_dspace_iterate_handles(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3044,6 +3109,8 @@ int job_trove_dspace_create(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_create(coll_id,
                               handle_extent_array,
@@ -3081,7 +3148,6 @@ int job_trove_dspace_create(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3133,6 +3199,8 @@ int job_trove_dspace_create_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_create_list(coll_id,
                               handle_extent_array,
@@ -3171,7 +3239,6 @@ int job_trove_dspace_create_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3220,6 +3287,8 @@ int job_trove_dspace_remove_list(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_remove_list(coll_id,
                               handle_array, 
@@ -3257,7 +3326,6 @@ int job_trove_dspace_remove_list(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3308,6 +3376,8 @@ int job_trove_dspace_remove(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_remove(coll_id,
                               handle, flags,
@@ -3341,7 +3411,6 @@ int job_trove_dspace_remove(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3390,6 +3459,8 @@ int job_trove_dspace_verify(PVFS_fs_id coll_id,
 
 
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_dspace_verify(coll_id,
                               handle, &jd->u.trove.type,
@@ -3425,7 +3496,6 @@ int job_trove_dspace_verify(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3444,14 +3514,15 @@ int job_trove_dspace_cancel(PVFS_fs_id coll_id,
 {
     struct job_desc* query = NULL;
     int ret = -1;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
 
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&cq->mutex);
 
     query = id_gen_safe_lookup(id);
     if (!query || query->completed_flag)
     {
         /* job has already completed, no cancellation needed */
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&cq->mutex);
         return(0);
     }
 
@@ -3460,7 +3531,7 @@ int job_trove_dspace_cancel(PVFS_fs_id coll_id,
     ret = PINT_thread_mgr_trove_cancel(
         query->u.trove.id, coll_id, &(query->trove_callback));
 
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&cq->mutex);
 
     return(ret);
 }
@@ -3505,6 +3576,8 @@ int job_trove_fs_create(char *collname,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_collection_create(collname, new_coll_id, user_ptr_internal,
         &(jd->u.trove.id));
@@ -3536,7 +3609,6 @@ int job_trove_fs_create(char *collname,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3680,6 +3752,8 @@ int job_trove_fs_seteattr(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_collection_seteattr(coll_id, key_p, val_p, flags,
                                     user_ptr_internal, global_trove_context,
@@ -3712,7 +3786,6 @@ int job_trove_fs_seteattr(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3760,6 +3833,8 @@ int job_trove_fs_geteattr(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_collection_geteattr(coll_id, key_p, val_p, flags,
                                     user_ptr_internal, global_trove_context,
@@ -3792,7 +3867,6 @@ int job_trove_fs_geteattr(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3841,6 +3915,8 @@ int job_trove_fs_deleattr(PVFS_fs_id coll_id,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_collection_deleattr(coll_id, key_p, flags,
                                     user_ptr_internal, global_trove_context,
@@ -3873,7 +3949,6 @@ int job_trove_fs_deleattr(PVFS_fs_id coll_id,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
 
     return (0);
@@ -3908,16 +3983,7 @@ int job_null(
     jd->status_user_tag = status_user_tag;
     jd->u.null_info.error_code = error_code;
 
-    gen_mutex_lock(&completion_mutex);
-    job_desc_q_add(completion_queue_array[jd->context_id],
-        jd);
-    /* set completed flag while holding queue lock */
-    jd->completed_flag = 1;
-#ifdef __PVFS2_JOB_THREADED__
-    /* wake up anyone waiting for completion */
-    pthread_cond_signal(&completion_cond);
-#endif
-    gen_mutex_unlock(&completion_mutex);
+    job_complete(jd);
 
     return(0);
 }
@@ -3971,6 +4037,8 @@ int job_testsome(job_id_t * id_array,
     struct timeval start;
     int original_count = *inout_count_p;
     int pthread_ret = -1;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
+    int seq;
 
     /* use this as a chance to do a cheap test on the request
      * scheduler
@@ -3990,43 +4058,50 @@ int job_testsome(job_id_t * id_array,
         }
         pthread_timeout.tv_sec = start.tv_sec + timeout_ms / 1000;
         pthread_timeout.tv_nsec = (start.tv_usec + ((timeout_ms % 1000)*1000))*1000;
-        if (pthread_timeout.tv_nsec > 1000000000)
+        if (pthread_timeout.tv_nsec >= 1000000000)
         {
             pthread_timeout.tv_nsec = pthread_timeout.tv_nsec - 1000000000;
             pthread_timeout.tv_sec++;
         }
     }
 
-    /* check for completed jobs */
-    gen_mutex_lock(&completion_mutex);
+    /* check for completed jobs; sample the completion counter before
+     * looking so that anything pushed afterwards ends the wait
+     */
     pthread_ret = 0;
-    while(((ret = completion_query_some(id_array,
-        inout_count_p,
-        out_index_array,
-        returned_user_ptr_array,
-        out_status_array_p)) == 0) &&
-        ((pthread_ret == EINTR) || (pthread_ret == 0)))
+    while(1)
     {
+        seq = job_completion_q_seq(cq);
+        gen_mutex_lock(&cq->mutex);
+        job_completion_q_drain(cq);
+        ret = completion_query_some(id_array,
+            inout_count_p,
+            out_index_array,
+            returned_user_ptr_array,
+            out_status_array_p);
+        gen_mutex_unlock(&cq->mutex);
+
+        if(ret != 0 || (pthread_ret != EINTR && pthread_ret != 0))
+        {
+            break;
+        }
         *inout_count_p = original_count;
 
         if(timeout_ms > 0)
         {
-            pthread_ret = pthread_cond_timedwait(&completion_cond,
-                &completion_mutex,
-                &pthread_timeout);
+            pthread_ret = job_completion_q_wait(cq, seq, &pthread_timeout);
         }
         else if(timeout_ms == 0)
         {
             pthread_ret = ETIMEDOUT;
+            break;
         }
         else
         {
             /* block indefinitely */
-            pthread_ret = pthread_cond_wait(&completion_cond,
-                &completion_mutex);
+            pthread_ret = job_completion_q_wait(cq, seq, NULL);
         }
     }
-    gen_mutex_unlock(&completion_mutex);
 
     if(ret == 0)
     {
@@ -4035,7 +4110,7 @@ int job_testsome(job_id_t * id_array,
         if ((pthread_ret != 0) && (pthread_ret != EINTR) && (pthread_ret !=
             EINVAL) && pthread_ret != ETIMEDOUT)
         {
-            /* pthread_cond_wait() gave a weird return code; pass along to
+            /* the wait gave a weird return code; pass along to
              * caller
              */
             ret = pthread_ret;
@@ -4067,6 +4142,7 @@ int job_testsome(job_id_t * id_array,
     struct timeval end;
     int original_count = *inout_count_p;
     int time_exhaust_flag = 0;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
 
     /* use this as a chance to do a cheap test on the request
      * scheduler
@@ -4079,13 +4155,14 @@ int job_testsome(job_id_t * id_array,
     /* check before we do anything else to see if the completion queue
      * has anything in it
      */
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&cq->mutex);
+    job_completion_q_drain(cq);
     ret = completion_query_some(id_array,
                                  inout_count_p,
                                  out_index_array,
                                  returned_user_ptr_array,
                                  out_status_array_p);
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&cq->mutex);
     /* return here on error or completion */
     if (ret < 0)
     {
@@ -4132,13 +4209,14 @@ int job_testsome(job_id_t * id_array,
         }
 
         /* check queue now to see if anything is done */
-        gen_mutex_lock(&completion_mutex);
+        gen_mutex_lock(&cq->mutex);
+        job_completion_q_drain(cq);
         ret = completion_query_some(id_array,
                                      inout_count_p,
                                      out_index_array,
                                      returned_user_ptr_array,
                                      out_status_array_p);
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&cq->mutex);
         /* return here on error or completion */
         if (ret < 0)
         {
@@ -4211,6 +4289,8 @@ int job_testcontext(job_id_t * out_id_array_p,
     struct timeval start;
     int original_count = *inout_count_p;
     int pthread_ret = -1;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
+    int seq;
 
     /* use this as a chance to do a cheap test on the request
      * scheduler
@@ -4230,42 +4310,49 @@ int job_testcontext(job_id_t * out_id_array_p,
         }
         pthread_timeout.tv_sec = start.tv_sec + timeout_ms / 1000;
         pthread_timeout.tv_nsec = (start.tv_usec + ((timeout_ms % 1000)*1000))*1000;
-        if (pthread_timeout.tv_nsec > 1000000000)
+        if (pthread_timeout.tv_nsec >= 1000000000)
         {
             pthread_timeout.tv_nsec = pthread_timeout.tv_nsec - 1000000000;
             pthread_timeout.tv_sec++;
         }
     }
 
-    /* check for completed jobs */
-    gen_mutex_lock(&completion_mutex);
+    /* check for completed jobs; sample the completion counter before
+     * looking so that anything pushed afterwards ends the wait
+     */
     pthread_ret = 0;
-    while(((ret = completion_query_context(out_id_array_p,
+    while(1)
+    {
+        seq = job_completion_q_seq(cq);
+        gen_mutex_lock(&cq->mutex);
+        job_completion_q_drain(cq);
+        ret = completion_query_context(out_id_array_p,
                              inout_count_p,
                              returned_user_ptr_array,
-                             out_status_array_p, context_id)) == 0) &&
-                             ((pthread_ret == EINTR) || (pthread_ret == 0)))
-    {
+                             out_status_array_p, context_id);
+        gen_mutex_unlock(&cq->mutex);
+
+        if(ret != 0 || (pthread_ret != EINTR && pthread_ret != 0))
+        {
+            break;
+        }
         *inout_count_p = original_count;
 
         if(timeout_ms > 0)
         {
-            pthread_ret = pthread_cond_timedwait(&completion_cond,
-                &completion_mutex,
-                &pthread_timeout);
+            pthread_ret = job_completion_q_wait(cq, seq, &pthread_timeout);
         }
         else if(timeout_ms == 0)
         {
             pthread_ret = ETIMEDOUT;
+            break;
         }
         else
         {
             /* block indefinitely */
-            pthread_ret = pthread_cond_wait(&completion_cond,
-                &completion_mutex);
+            pthread_ret = job_completion_q_wait(cq, seq, NULL);
         }
     }
-    gen_mutex_unlock(&completion_mutex);
 
     if(ret == 0)
     {
@@ -4274,7 +4361,7 @@ int job_testcontext(job_id_t * out_id_array_p,
         if ((pthread_ret != 0) && (pthread_ret != EINTR) && (pthread_ret !=
             EINVAL) && pthread_ret != ETIMEDOUT)
         {
-            /* pthread_cond_wait() gave a weird return code; pass along to
+            /* the wait gave a weird return code; pass along to
              * caller
              */
             ret = pthread_ret;
@@ -4306,6 +4393,7 @@ int job_testcontext(job_id_t * out_id_array_p,
     struct timeval end;
     int original_count = *inout_count_p;
     int time_exhaust_flag = 0;
+    struct job_completion_q *cq = &completion_queue_array[context_id];
 
     /* use this as a chance to do a cheap test on the request
      * scheduler
@@ -4318,12 +4406,13 @@ int job_testcontext(job_id_t * out_id_array_p,
     /* check before we do anything else to see if the completion queue
      * has anything in it
      */
-    gen_mutex_lock(&completion_mutex);
+    gen_mutex_lock(&cq->mutex);
+    job_completion_q_drain(cq);
     ret = completion_query_context(out_id_array_p,
                                  inout_count_p,
                                  returned_user_ptr_array,
                                  out_status_array_p, context_id);
-    gen_mutex_unlock(&completion_mutex);
+    gen_mutex_unlock(&cq->mutex);
     /* return here on error or completion */
     if (ret < 0)
     {
@@ -4370,13 +4459,14 @@ int job_testcontext(job_id_t * out_id_array_p,
         }
 
         /* check queue now to see if anything is done */
-        gen_mutex_lock(&completion_mutex);
+        gen_mutex_lock(&cq->mutex);
+        job_completion_q_drain(cq);
         ret = completion_query_context(out_id_array_p,
                                      inout_count_p,
                                      returned_user_ptr_array,
                                      out_status_array_p,
                                      context_id);
-        gen_mutex_unlock(&completion_mutex);
+        gen_mutex_unlock(&cq->mutex);
         /* return here on error or completion */
         if (ret < 0)
         {
@@ -4500,6 +4590,7 @@ static void precreate_pool_get_thread_mgr_callback_unlocked(
     PVFS_error error_code)
 {
     struct precreate_pool_get_trove* tmp_trove = data;
+    struct job_desc* jd = NULL;
     
     gen_mutex_lock(&initialized_mutex);
     if(initialized == 0)
@@ -4529,21 +4620,14 @@ static void precreate_pool_get_thread_mgr_callback_unlocked(
     /* is this job done? */
     if(tmp_trove->jd->u.precreate_pool.trove_pending == 0)
     {
-        gen_mutex_lock(&completion_mutex);
-
-        /* set job descriptor fields and put into completion queue */
-        tmp_trove->jd->u.precreate_pool.error_code = 0;
-        job_desc_q_add(completion_queue_array[tmp_trove->jd->context_id], 
-                       tmp_trove->jd);
-        /* set completed flag while holding queue lock */
-        tmp_trove->jd->completed_flag = 1;
-
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        free(tmp_trove->jd->u.precreate_pool.data);
-        gen_mutex_unlock(&completion_mutex);
+        /* set job descriptor fields and put into completion queue; the
+         * trove array is freed first since it holds tmp_trove itself
+         */
+        jd = tmp_trove->jd;
+        jd->u.precreate_pool.error_code = 0;
+        free(jd->u.precreate_pool.data);
+        jd->u.precreate_pool.data = NULL;
+        job_complete(jd);
         return;
     }
 
@@ -4573,25 +4657,16 @@ static void precreate_pool_iterate_callback(
     }
     gen_mutex_unlock(&initialized_mutex);
 
-    gen_mutex_lock(&completion_mutex);
-    if (tmp_desc->completed_flag == 0)
+    if (job_completion_q_claim(tmp_desc))
     {
         /* set job descriptor fields and put into completion queue */
         tmp_desc->u.precreate_pool.error_code = error_code;
         free(tmp_desc->u.precreate_pool.key_array);
-        job_desc_q_add(completion_queue_array[tmp_desc->context_id], 
-                       tmp_desc);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
 
         trove_pending_count--;
 
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
+        job_complete(tmp_desc);
     }
-    gen_mutex_unlock(&completion_mutex);
 
     return;
 }
@@ -4653,18 +4728,10 @@ static void precreate_pool_fill_thread_mgr_callback(
         gossip_err("Error: unable to write all precreated handles to pool.\n");
         gossip_err("Warning: fsck may be needed to recover stranded handles.\n");
         free(jd->u.precreate_pool.key_array);
-        gen_mutex_lock(&completion_mutex);
 
         /* set job descriptor fields and put into completion queue */
         jd->u.precreate_pool.error_code = error_code;
-        job_desc_q_add(completion_queue_array[jd->context_id], jd);
-        /* set completed flag while holding queue lock */
-        jd->completed_flag = 1;
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(jd);
         return;
     }
 
@@ -4743,20 +4810,10 @@ static void precreate_pool_fill_thread_mgr_callback(
         jd->u.precreate_pool.precreate_handle_count)
     {
         free(jd->u.precreate_pool.key_array);
-        gen_mutex_lock(&completion_mutex);
 
         /* set job descriptor fields and put into completion queue */
         jd->u.precreate_pool.error_code = 0;
-        job_desc_q_add(completion_queue_array[jd->context_id], 
-                       jd);
-        /* set completed flag while holding queue lock */
-        jd->completed_flag = 1;
-
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(jd);
         return;
     }
 
@@ -4805,18 +4862,9 @@ static void precreate_pool_fill_thread_mgr_callback(
     {
         gossip_err("Error: unable to write all precreated handles to pool.\n");
         gossip_err("Warning: fsck may be needed to recover stranded handles.\n");
-        gen_mutex_lock(&completion_mutex);
-
         /* set job descriptor fields and put into completion queue */
         jd->u.precreate_pool.error_code = ret;
-        job_desc_q_add(completion_queue_array[jd->context_id], jd);
-        /* set completed flag while holding queue lock */
-        jd->completed_flag = 1;
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(jd);
         return;
     }
     else if(ret == 1)
@@ -4857,15 +4905,10 @@ static void trove_thread_mgr_callback(
     }
     gen_mutex_unlock(&initialized_mutex);
 
-    gen_mutex_lock(&completion_mutex);
-    if (tmp_desc->completed_flag == 0)
+    if (job_completion_q_claim(tmp_desc))
     {
         /* set job descriptor fields and put into completion queue */
         tmp_desc->u.trove.state = error_code;
-        job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-                       tmp_desc);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
 
 /* the value of trove_pending_count is only used in the non-threaded
  * situation. so, to prevent reported data races from helgrind, we
@@ -4875,12 +4918,8 @@ static void trove_thread_mgr_callback(
         trove_pending_count--;
 #endif
 
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
+        job_complete(tmp_desc);
     }
-    gen_mutex_unlock(&completion_mutex);
 }
 
 /* bmi_thread_mgr_callback()
@@ -4907,25 +4946,16 @@ static void bmi_thread_mgr_callback(
     }
     gen_mutex_unlock(&initialized_mutex);
 
-    gen_mutex_lock(&completion_mutex);
-    if (tmp_desc->completed_flag == 0)
+    if (job_completion_q_claim(tmp_desc))
     {
         /* set job descriptor fields and put into completion queue */
         tmp_desc->u.bmi.error_code = error_code;
         tmp_desc->u.bmi.actual_size = actual_size;
-        job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-                       tmp_desc);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
 
         bmi_pending_count--;
 
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
+        job_complete(tmp_desc);
     }
-    gen_mutex_unlock(&completion_mutex);
 }
 
 /* bmi_thread_mgr_unexp_handler()
@@ -4961,20 +4991,7 @@ static void bmi_thread_mgr_unexp_handler(
         gen_mutex_unlock(&bmi_unexp_mutex);
         /* set appropriate fields and store in completed queue */
         *(tmp_desc->u.bmi_unexp.info) = *unexp;
-        gen_mutex_lock(&completion_mutex);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
-        if (completion_queue_array[tmp_desc->context_id])
-        {
-            job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-                           tmp_desc);
-        }
-
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(tmp_desc);
     }
     else
     {
@@ -5008,20 +5025,7 @@ static void dev_thread_mgr_unexp_handler(struct PINT_dev_unexp_info* unexp)
         gen_mutex_unlock(&dev_unexp_mutex);
         /* set appropriate fields and store in completed queue */
         *(tmp_desc->u.dev_unexp.info) = *unexp;
-        gen_mutex_lock(&completion_mutex);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
-        if (completion_queue_array[tmp_desc->context_id])
-        {
-            job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-                           tmp_desc);
-        }
-
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(tmp_desc);
     }
     else
     {
@@ -5124,8 +5128,10 @@ static int do_one_test_cycle_req_sched(void)
     struct job_desc *tmp_desc = NULL;
 
 
+    gen_mutex_lock(&req_sched_mutex);
     ret = PINT_req_sched_testworld(&count, id_array,
                                    user_ptr_array, error_code_array);
+    gen_mutex_unlock(&req_sched_mutex);
 
     if (ret < 0)
     {
@@ -5141,12 +5147,7 @@ static int do_one_test_cycle_req_sched(void)
         tmp_desc = (struct job_desc *) user_ptr_array[i];
         /* set appropriate fields and place in completed queue */
         tmp_desc->u.req_sched.error_code = error_code_array[i];
-        gen_mutex_lock(&completion_mutex);
-        /* set completed flag while holding queue lock */
-        tmp_desc->completed_flag = 1;
-        job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-            tmp_desc);
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(tmp_desc);
     }
 
     return (0);
@@ -5155,6 +5156,8 @@ static int do_one_test_cycle_req_sched(void)
 
 /*
  * Appears to return <0 if problem, 0 if not done, 1 if done.
+ * Only sees jobs of the context whose completion queue the caller has
+ * drained.
  */
 static int completion_query_some(job_id_t * id_array,
                                  int *inout_count_p,
@@ -5190,11 +5193,14 @@ static int completion_query_some(job_id_t * id_array,
         return (-EINVAL);
     }
 
-    /* don't do anything unless all of the target ops are done */
+    /* don't do anything unless all of the target ops are done.  A job
+     * only counts once it has been drained onto the done list; the
+     * completed flag is set a moment before it is pushed.
+     */
     for(i=0; i<incount; i++)
     {
         tmp_desc = id_gen_safe_lookup(id_array[i]);
-        if(tmp_desc && tmp_desc->completed_flag)
+        if(tmp_desc && tmp_desc->completion_queued)
         {
             done_count++;
         }
@@ -5209,7 +5215,7 @@ static int completion_query_some(job_id_t * id_array,
     for(i=0; i<incount; i++)
     {
         tmp_desc = id_gen_safe_lookup(id_array[i]);
-        if(tmp_desc && tmp_desc->completed_flag)
+        if(tmp_desc && tmp_desc->completion_queued)
         {
             if(returned_user_ptr_array)
             {
@@ -5223,6 +5229,7 @@ static int completion_query_some(job_id_t * id_array,
                     &(out_status_array_p[*inout_count_p]));
             }
             job_desc_q_remove(tmp_desc);
+            tmp_desc->completion_queued = 0;
             if (tmp_desc->type == JOB_REQ_SCHED &&
                 tmp_desc->u.req_sched.post_flag == 1)
             {
@@ -5272,7 +5279,7 @@ static int completion_query_context(job_id_t * out_id_array_p,
     }
     while (*inout_count_p < incount && (query =
                                         job_desc_q_shownext(
-                                        completion_queue_array[context_id])))
+                                        &completion_queue_array[context_id].done)))
     {
         assert(query);
 
@@ -5287,6 +5294,7 @@ static int completion_query_context(job_id_t * out_id_array_p,
         }
         out_id_array_p[*inout_count_p] = query->job_id;
         job_desc_q_remove(query);
+        query->completion_queued = 0;
         (*inout_count_p)++;
         /* special case for request scheduler */
         if (query->type == JOB_REQ_SCHED && query->u.req_sched.post_flag == 1)
@@ -5364,6 +5372,27 @@ static void do_one_work_cycle_all(int idle_time_ms)
 }
 #endif
 
+/* job_complete()
+ *
+ * hands a finished job to the completion queue of its context.  Never
+ * blocks; the job desc must not be touched afterwards since a tester
+ * may release it right away.
+ *
+ * no return value
+ */
+static void job_complete(struct job_desc* jd)
+{
+    struct job_completion_q *cq = &completion_queue_array[jd->context_id];
+
+    if(!cq->open)
+    {
+        /* nobody will ever test for it */
+        jd->completed_flag = 1;
+        return;
+    }
+    job_completion_q_push(cq, jd);
+}
+
 /* flow_callback()
  *
  * function to be called upon completion of flows
@@ -5383,28 +5412,15 @@ static void flow_callback(flow_descriptor* flow_d, int cancel_path)
     }
     gen_mutex_unlock(&initialized_mutex);
 
-    /* set job descriptor fields and put into completion queue */
-
-    /* if this is being triggered directly from PINT_flow_cancel(), then the
-     * completion mutex is already held by the caller; skip the mutex.
-     */
-    if(!cancel_path)
-        gen_mutex_lock(&completion_mutex);
-    job_desc_q_add(completion_queue_array[tmp_desc->context_id],
-                   tmp_desc);
-    /* set completed flag while holding queue lock */
-    tmp_desc->completed_flag = 1;
-
     flow_pending_count--;
     gossip_debug(GOSSIP_FLOW_DEBUG, "Job flows in progress (callback time): %d\n",
             flow_pending_count);
 
-#ifdef __PVFS2_JOB_THREADED__
-    /* wake up anyone waiting for completion */
-    pthread_cond_signal(&completion_cond);
-#endif
-    if(!cancel_path)
-        gen_mutex_unlock(&completion_mutex);
+    /* put into completion queue.  This takes no locks, so it is safe
+     * when triggered directly from PINT_flow_cancel() with the
+     * completion queue mutex held by the caller.
+     */
+    job_complete(tmp_desc);
 
     return;
 }
@@ -5448,20 +5464,9 @@ int job_precreate_pool_fill_signal_error(
         qlist_del(&jd_checker->job_desc_q_link);
 
         gossip_debug(GOSSIP_FLOW_DEBUG, "job_precreate_pool_fill_signal_error() waking up a get_handles() caller.\n");
-        gen_mutex_lock(&completion_mutex);
-
         /* set job descriptor fields and put into completion queue */
         jd_checker->u.precreate_pool.error_code = error_code;
-        job_desc_q_add(completion_queue_array[jd_checker->context_id], 
-                       jd_checker);
-        /* set completed flag while holding queue lock */
-        jd_checker->completed_flag = 1;
-
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);
+        job_complete(jd_checker);
     }
     gen_mutex_unlock(&precreate_pool_mutex);
 
@@ -5917,15 +5922,8 @@ static void precreate_pool_get_handles_try_post(struct job_desc* jd)
     if(!tmp_trove_array)
     {
         gen_mutex_unlock(&precreate_pool_mutex);
-        gen_mutex_lock(&completion_mutex);        
         jd->u.precreate_pool.error_code = -PVFS_ENOMEM;
-        job_desc_q_add(completion_queue_array[jd->context_id], jd);
-        jd->completed_flag = 1;
-#ifdef __PVFS2_JOB_THREADED__
-        /* wake up anyone waiting for completion */
-        pthread_cond_signal(&completion_cond);
-#endif
-        gen_mutex_unlock(&completion_mutex);        
+        job_complete(jd);
         return;
 
     }
@@ -5964,15 +5962,8 @@ static void precreate_pool_get_handles_try_post(struct job_desc* jd)
                 free(tmp_trove_array);
                 gen_mutex_unlock(&precreate_pool_mutex);
 
-                gen_mutex_lock(&completion_mutex);        
                 jd->u.precreate_pool.error_code = -PVFS_EINVAL;
-                job_desc_q_add(completion_queue_array[jd->context_id], jd);
-                jd->completed_flag = 1;
-        #ifdef __PVFS2_JOB_THREADED__
-                /* wake up anyone waiting for completion */
-                pthread_cond_signal(&completion_cond);
-        #endif
-                gen_mutex_unlock(&completion_mutex);        
+                job_complete(jd);
                 return;
             }
         }
@@ -6033,15 +6024,8 @@ static void precreate_pool_get_handles_try_post(struct job_desc* jd)
                 free(tmp_trove_array);
                 gen_mutex_unlock(&precreate_pool_mutex);
 
-                gen_mutex_lock(&completion_mutex);        
                 jd->u.precreate_pool.error_code = -PVFS_EINVAL;
-                job_desc_q_add(completion_queue_array[jd->context_id], jd);
-                jd->completed_flag = 1;
-        #ifdef __PVFS2_JOB_THREADED__
-                /* wake up anyone waiting for completion */
-                pthread_cond_signal(&completion_cond);
-        #endif
-                gen_mutex_unlock(&completion_mutex);        
+                job_complete(jd);
                 return;
             }
         }
@@ -6093,15 +6077,7 @@ static void precreate_pool_get_handles_try_post(struct job_desc* jd)
                     qlist_del(&jd_checker->job_desc_q_link);
 
                     /* move waiting job to completion queue */
-                    gen_mutex_lock(&completion_mutex);        
-                    job_desc_q_add(completion_queue_array[jd->context_id],
-                                   jd_checker);
-                    jd->completed_flag = 1;
-#ifdef __PVFS2_JOB_THREADED__
-                    /* wake up anyone waiting for completion */
-                    pthread_cond_signal(&completion_cond);
-#endif
-                    gen_mutex_unlock(&completion_mutex);        
+                    job_complete(jd_checker);
                 }
             }
         }
@@ -6285,6 +6261,8 @@ int job_precreate_pool_iterate_handles(PVFS_fs_id fsid,
     jd->trove_callback.data = (void*)jd;
     user_ptr_internal = &jd->trove_callback;
 
+    *id = jd->job_id;
+
 #ifdef __PVFS2_TROVE_SUPPORT__
     ret = trove_keyval_iterate_keys(fsid,
                                     pool->pool_handle,
@@ -6332,7 +6310,6 @@ int job_precreate_pool_iterate_handles(PVFS_fs_id fsid,
     /* if we fall through to this point, the job did not
      * immediately complete and we must queue up to test later
      */
-    *id = jd->job_id;
     trove_pending_count++;
     gen_mutex_unlock(&precreate_pool_mutex);
 
@@ -187,6 +187,7 @@ int job_dev_write_list(void** buffer_list,
 int job_req_sched_post(enum PVFS_server_op op,
                        PVFS_fs_id fs_id,
                        PVFS_handle handle,
+                       PVFS_BMI_addr_t client_addr,
                        enum PINT_server_req_access_type access_type,
                        enum PINT_server_sched_policy sched_policy,
 		       void *user_ptr,
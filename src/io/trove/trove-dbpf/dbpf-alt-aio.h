@@ -31,6 +31,9 @@ extern "C" {
 #include "dbpf.h"
 #include "aio.h"
 
+/* also used by methods that fall back to alt-aio */
+extern struct dbpf_aio_ops alt_aio_ops;
+
 #if defined(__cplusplus)
 }
 #endif
@@ -26,6 +26,8 @@ static struct qhash_table *s_key_to_attr_table = NULL;
 static char **s_cacheable_keyword_array = NULL;
 static int s_cacheable_keyword_array_size = 0;
 static int s_current_num_cache_elems = 0;
+static uint64_t s_fill_generation = 0;
+static int s_fill_blocked = 0;
 
 #define DBPF_ATTR_CACHE_INITIALIZED() \
 (s_key_to_attr_table)
@@ -138,6 +140,34 @@ int dbpf_attr_cache_initialize(
     return ret;
 }
 
+uint64_t dbpf_attr_cache_fill_generation(void)
+{
+    return s_fill_generation;
+}
+
+int dbpf_attr_cache_fill_allowed(uint64_t generation)
+{
+    return (!s_fill_blocked && generation == s_fill_generation);
+}
+
+void dbpf_attr_cache_updated(int uncommitted)
+{
+    s_fill_generation++;
+    if (uncommitted)
+    {
+        s_fill_blocked = 1;
+    }
+}
+
+void dbpf_attr_cache_committed(void)
+{
+    if (s_fill_blocked)
+    {
+        s_fill_generation++;
+        s_fill_blocked = 0;
+    }
+}
+
 int dbpf_attr_cache_finalize(void)
 {
     int ret = -1, i = 0, j = 0;
@@ -95,6 +95,22 @@ int dbpf_attr_cache_remove(
     TROVE_object_ref key);
 int dbpf_attr_cache_finalize(void);
 
+/*
+  With TroveMetaReadThreads, a read may run while the trove thread
+  updates the same object, and must not then put the older value it
+  read into the cache.  A reader takes the fill generation before it
+  reads the database, and fills the cache with what it read only if
+  dbpf_attr_cache_fill_allowed() says no update happened since.  Writers
+  call dbpf_attr_cache_updated() after each update that touches cached
+  objects, with uncommitted set if the update is part of an open
+  metadata batch, and dbpf_attr_cache_committed() once that batch is
+  committed.  All four are called with dbpf_attr_cache_mutex held.
+*/
+uint64_t dbpf_attr_cache_fill_generation(void);
+int dbpf_attr_cache_fill_allowed(uint64_t generation);
+void dbpf_attr_cache_updated(int uncommitted);
+void dbpf_attr_cache_committed(void);
+
 
 /***********************************************
  * dbpf-attr-cache keyval related methods
@@ -582,7 +582,8 @@ int dbpf_bstream_flush(TROVE_coll_id coll_id,
                         flags,
                         context_id);
     q_op_p->op.hints = hints;
-    *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+    *out_op_id_p = q_op_p->op.id;
+    dbpf_queued_op_queue(q_op_p);
     return 0;
 }
 
@@ -630,6 +631,54 @@ int dbpf_bstream_validate(TROVE_coll_id coll_id,
     return -TROVE_ENOSYS;
 }
 
+/* dbpf_bstream_fd_get()
+ *
+ * Pins the buffered read descriptor for a bstream in the open cache and
+ * hands it back to the caller, who may then move data out of it without
+ * going through a trove read (e.g. sendfile() in the BMI layer).  The
+ * returned reference must be released with dbpf_bstream_fd_put().
+ */
+int dbpf_bstream_fd_get(TROVE_coll_id coll_id,
+                        TROVE_handle handle,
+                        int *out_fd_p,
+                        void **out_ref_p)
+{
+    int ret = -TROVE_EINVAL;
+    struct open_cache_ref *ref = NULL;
+
+    if (dbpf_collection_find_registered(coll_id) == NULL)
+    {
+        return -TROVE_EINVAL;
+    }
+
+    ref = (struct open_cache_ref *)malloc(sizeof(struct open_cache_ref));
+    if (ref == NULL)
+    {
+        return -TROVE_ENOMEM;
+    }
+
+    ret = dbpf_open_cache_get(coll_id, handle, DBPF_FD_BUFFERED_READ, ref);
+    if (ret < 0)
+    {
+        free(ref);
+        return ret;
+    }
+
+    *out_fd_p = ref->fd;
+    *out_ref_p = ref;
+    return 0;
+}
+
+void dbpf_bstream_fd_put(TROVE_coll_id coll_id,
+                         void *ref)
+{
+    if (ref)
+    {
+        dbpf_open_cache_put((struct open_cache_ref *)ref);
+        free(ref);
+    }
+}
+
 static int dbpf_bstream_read_list(TROVE_coll_id coll_id,
                                   TROVE_handle handle,
                                   char **mem_offset_array,
@@ -888,7 +937,8 @@ inline int dbpf_bstream_rw_list(TROVE_coll_id coll_id,
 
 #ifndef __PVFS2_TROVE_AIO_THREADED__
 
-    *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+    *out_op_id_p = q_op_p->op.id;
+    dbpf_queued_op_queue(q_op_p);
 
 #else
     op_p = &q_op_p->op;
@@ -1450,7 +1500,8 @@ int dbpf_bstream_resize(TROVE_coll_id coll_id,
     /* initialize the op-specific members */
     q_op_p->op.u.b_resize.size = *inout_size_p;
     q_op_p->op.u.b_resize.queued_op_ptr = q_op_p;
-    *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+    *out_op_id_p = q_op_p->op.id;
+    dbpf_queued_op_queue(q_op_p);
 
     return 0;
 }
@@ -1464,7 +1515,9 @@ struct TROVE_bstream_ops dbpf_bstream_ops =
     dbpf_bstream_read_list,
     dbpf_bstream_write_list,
     dbpf_bstream_flush,
-    dbpf_bstream_cancel
+    dbpf_bstream_cancel,
+    dbpf_bstream_fd_get,
+    dbpf_bstream_fd_put
 };
 
 /*
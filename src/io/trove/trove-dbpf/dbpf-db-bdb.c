@@ -179,6 +179,32 @@ int dbpf_db_sync(struct dbpf_db *db)
     return db_error(db->db->sync(db->db, 0));
 }
 
+/* Berkeley DB is opened without a transactional environment here, so
+ * writes already go straight to the shared cache; a batch only has to
+ * defer the sync, which the caller does. */
+int dbpf_db_batch_begin(void)
+{
+    return 0;
+}
+
+int dbpf_db_batch_commit(void)
+{
+    return 0;
+}
+
+/* Nothing is held back from the database by a batch. */
+unsigned long dbpf_db_batch_writes(void)
+{
+    return 0;
+}
+
+/* The databases are opened without an environment, and so without the
+ * locking that would keep a reader away from pages being written. */
+int dbpf_db_concurrent_reads(void)
+{
+    return 0;
+}
+
 int dbpf_db_get(struct dbpf_db *db, struct dbpf_data *key,
     struct dbpf_data *val)
 {
@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 #include <gossip.h>
@@ -21,13 +22,27 @@ extern filesystem_configuration_s *cfg_fs;
 struct dbpf_db {
     MDB_env *env;
     MDB_dbi dbi;
+    MDB_txn *batch_txn;         /* open batch write transaction, if any */
+    int batch_linked;           /* on the batch_dbs list */
+    struct dbpf_db *batch_next;
 };
 
 struct dbpf_cursor {
     MDB_cursor *cursor;
     MDB_txn *txn;
+    int batched;                /* txn belongs to the open batch */
 };
 
+/* State of the batch opened by dbpf_db_batch_begin. These are written
+ * only by the batching thread, which holds batch_mutex for as long as
+ * the batch is open; other threads read batch_open and batch_thread
+ * just to find out that they are not that thread. */
+static gen_mutex_t batch_mutex = GEN_MUTEX_INITIALIZER;
+static int batch_open = 0;
+static pthread_t batch_thread;
+static struct dbpf_db *batch_dbs = NULL;
+static unsigned long batch_writes = 0;
+
 static int db_error(int e)
 {
     /* values greater than zero are errno values */
@@ -55,6 +70,47 @@ static int db_error(int e)
     return DBPF_ERROR_UNKNOWN;
 }
 
+static int in_batch(void)
+{
+    return batch_open && pthread_equal(batch_thread, pthread_self());
+}
+
+/* Get the batch write transaction of *db*, beginning it on first use. */
+static int batch_txn(struct dbpf_db *db, MDB_txn **txn)
+{
+    int r;
+    if (!db->batch_txn)
+    {
+        r = mdb_txn_begin(db->env, NULL, 0, &db->batch_txn);
+        if (r)
+        {
+            db->batch_txn = NULL;
+            return r;
+        }
+        if (!db->batch_linked)
+        {
+            db->batch_linked = 1;
+            db->batch_next = batch_dbs;
+            batch_dbs = db;
+        }
+    }
+    *txn = db->batch_txn;
+    return 0;
+}
+
+/* Commit the batch transaction of *db* early, if it has one. */
+static int batch_commit_db(struct dbpf_db *db)
+{
+    int r;
+    if (!db->batch_txn)
+    {
+        return 0;
+    }
+    r = mdb_txn_commit(db->batch_txn);
+    db->batch_txn = NULL;
+    return r;
+}
+
 static int ds_attr_compare(const MDB_val *a, const MDB_val *b)
 {
     TROVE_handle *handle_a = (TROVE_handle *)a->mv_data;
@@ -118,7 +174,7 @@ int dbpf_db_open(char *name, int compare, struct dbpf_db **db,
     MDB_txn *txn;
     int r;
 
-    *db = malloc(sizeof **db);
+    *db = calloc(1, sizeof **db);
     if (!*db)
     {
         gossip_err("%s:Error allocating space\n",__func__);
@@ -227,6 +283,19 @@ int dbpf_db_open(char *name, int compare, struct dbpf_db **db,
 
 int dbpf_db_close(struct dbpf_db *db)
 {
+    struct dbpf_db **dbp;
+    if (db->batch_linked)
+    {
+        batch_commit_db(db);
+        for (dbp = &batch_dbs; *dbp; dbp = &(*dbp)->batch_next)
+        {
+            if (*dbp == db)
+            {
+                *dbp = db->batch_next;
+                break;
+            }
+        }
+    }
     mdb_env_close(db->env);
     free(db);
     return 0;
@@ -234,9 +303,69 @@ int dbpf_db_close(struct dbpf_db *db)
 
 int dbpf_db_sync(struct dbpf_db *db)
 {
+    int r;
+    /* A sync must cover the writes already made by this thread, so
+     * commit them first; later writes start a new batch transaction. */
+    if (in_batch())
+    {
+        r = batch_commit_db(db);
+        if (r)
+        {
+            return db_error(r);
+        }
+    }
     return db_error(mdb_env_sync(db->env, 0));
 }
 
+int dbpf_db_batch_begin(void)
+{
+    /* a second batch would only wait on the write transactions of the
+     * first, so refuse it rather than let two threads interleave */
+    if (gen_mutex_trylock(&batch_mutex))
+    {
+        return TROVE_EBUSY;
+    }
+    batch_thread = pthread_self();
+    batch_open = 1;
+    return 0;
+}
+
+int dbpf_db_batch_commit(void)
+{
+    struct dbpf_db *db, *next;
+    int r, ret = 0;
+
+    for (db = batch_dbs; db; db = next)
+    {
+        next = db->batch_next;
+        r = batch_commit_db(db);
+        if (r && !ret)
+        {
+            gossip_err("%s: batch commit failed: %s\n", __func__,
+                mdb_strerror(r));
+            ret = db_error(r);
+        }
+        db->batch_linked = 0;
+        db->batch_next = NULL;
+    }
+    batch_dbs = NULL;
+    batch_open = 0;
+    gen_mutex_unlock(&batch_mutex);
+    return ret;
+}
+
+unsigned long dbpf_db_batch_writes(void)
+{
+    return batch_writes;
+}
+
+/* Each read runs in its own read transaction, which sees a snapshot
+ * that a concurrent writer does not disturb. */
+int dbpf_db_concurrent_reads(void)
+{
+    return 1;
+}
+
 int dbpf_db_get(struct dbpf_db *db, struct dbpf_data *key,
     struct dbpf_data *val)
 {
@@ -247,6 +376,18 @@ int dbpf_db_get(struct dbpf_db *db, struct dbpf_data *key,
     db_key.mv_size = key->len;
     db_key.mv_data = key->data;
 
+    if (in_batch() && db->batch_txn)
+    {
+        r = mdb_get(db->batch_txn, db->dbi, &db_key, &db_data);
+        if (r)
+        {
+            return db_error(r);
+        }
+        memcpy(val->data, db_data.mv_data, val->len);
+        val->len = db_data.mv_size;
+        return 0;
+    }
+
     r = mdb_txn_begin(db->env, NULL, MDB_RDONLY, &txn);
     if (r)
     {
@@ -258,14 +399,15 @@ int dbpf_db_get(struct dbpf_db *db, struct dbpf_data *key,
         mdb_txn_abort(txn);
         return db_error(r);
     }
+    /* the data is only valid while the transaction is; once it ends a
+     * writer may reuse the page */
+    memcpy(val->data, db_data.mv_data, val->len);
+    val->len = db_data.mv_size;
     r = mdb_txn_commit(txn);
     if (r)
     {
         return db_error(r);
     }
-
-    memcpy(val->data, db_data.mv_data, val->len);
-    val->len = db_data.mv_size;
     return 0;
 }
 
@@ -281,6 +423,17 @@ int dbpf_db_put(struct dbpf_db *db, struct dbpf_data *key,
     db_data.mv_size = val->len;
     db_data.mv_data = val->data;
 
+    if (in_batch())
+    {
+        r = batch_txn(db, &txn);
+        if (r)
+        {
+            return db_error(r);
+        }
+        batch_writes++;
+        return db_error(mdb_put(txn, db->dbi, &db_key, &db_data, 0));
+    }
+
     r = mdb_txn_begin(db->env, NULL, 0, &txn);
     if (r)
     {
@@ -312,6 +465,17 @@ int dbpf_db_putonce(struct dbpf_db *db, struct dbpf_data *key,
     db_data.mv_size = val->len;
     db_data.mv_data = val->data;
 
+    if (in_batch())
+    {
+        r = batch_txn(db, &txn);
+        if (r)
+        {
+            return db_error(r);
+        }
+        batch_writes++;
+        return db_error(mdb_put(txn, db->dbi, &db_key, &db_data, MDB_NOOVERWRITE));
+    }
+
     r = mdb_txn_begin(db->env, NULL, 0, &txn);
     if (r)
     {
@@ -340,6 +504,17 @@ int dbpf_db_del(struct dbpf_db *db, struct dbpf_data *key)
     db_key.mv_size = key->len;
     db_key.mv_data = key->data;
 
+    if (in_batch())
+    {
+        r = batch_txn(db, &txn);
+        if (r)
+        {
+            return db_error(r);
+        }
+        batch_writes++;
+        return db_error(mdb_del(txn, db->dbi, &db_key, NULL));
+    }
+
     r = mdb_txn_begin(db->env, NULL, 0, &txn);
     if (r)
     {
@@ -368,6 +543,26 @@ int dbpf_db_cursor(struct dbpf_db *db, struct dbpf_cursor **dbc, int rdonly)
         return db_error(errno);
     }
 
+    /* Inside a batch, write cursors and any cursor on a database the
+     * batch has already written use the batch transaction. */
+    (*dbc)->batched = in_batch() && (!rdonly || db->batch_txn);
+    if ((*dbc)->batched)
+    {
+        r = batch_txn(db, &(*dbc)->txn);
+        if (r)
+        {
+            free(*dbc);
+            return db_error(r);
+        }
+        r = mdb_cursor_open((*dbc)->txn, db->dbi, &(*dbc)->cursor);
+        if (r)
+        {
+            free(*dbc);
+            return db_error(r);
+        }
+        return 0;
+    }
+
     r = mdb_txn_begin(db->env, NULL, rdonly ? MDB_RDONLY : 0, &(*dbc)->txn);
     if (r)
     {
@@ -388,6 +583,11 @@ int dbpf_db_cursor_close(struct dbpf_cursor *dbc)
 {
     int r;
     mdb_cursor_close(dbc->cursor);
+    if (dbc->batched)
+    {
+        free(dbc);
+        return 0;
+    }
     r = mdb_txn_commit(dbc->txn);
     if (r)
     {
@@ -441,5 +641,9 @@ int dbpf_db_cursor_get(struct dbpf_cursor *dbc, struct dbpf_data *key,
 
 int dbpf_db_cursor_del(struct dbpf_cursor *dbc)
 {
+    if (dbc->batched)
+    {
+        batch_writes++;
+    }
     return db_error(mdb_cursor_del(dbc->cursor, 0));
 }
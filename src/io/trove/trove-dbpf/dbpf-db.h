@@ -49,6 +49,34 @@ int dbpf_db_close(dbpf_db *);
 /* dbpf_db_sync(db): Update the on-disk copy of database *db*. */
 int dbpf_db_sync(dbpf_db *);
 
+/* dbpf_db_batch_begin(): Start grouping the writes made by the calling
+ * thread into one transaction per database, until the next
+ * dbpf_db_batch_commit. Reads and cursors of the calling thread see the
+ * grouped writes before they are committed, so anything it reads back
+ * is lost if the commit fails; other threads do not see them until the
+ * commit. With LMDB each grouped transaction holds the write lock of its
+ * database, so a write to that database from any other thread blocks
+ * until the commit: keep batches short, and never wait inside one on a
+ * thread that may write. Only one batch may be open at a time; returns
+ * TROVE_EBUSY if another thread has one open. */
+int dbpf_db_batch_begin(void);
+
+/* dbpf_db_batch_commit(): Commit the writes grouped since
+ * dbpf_db_batch_begin and stop grouping. All transactions are committed
+ * even if one fails; the first error is returned. */
+int dbpf_db_batch_commit(void);
+
+/* dbpf_db_batch_writes(): Return a count of the writes grouped into
+ * batches so far, which only the batching thread may rely on. A change
+ * across a call means the call wrote something that is lost if the
+ * batch is not committed. */
+unsigned long dbpf_db_batch_writes(void);
+
+/* dbpf_db_concurrent_reads(): Return true if reads and read-only
+ * cursors may be used by several threads at once, concurrently with
+ * one thread that writes. */
+int dbpf_db_concurrent_reads(void);
+
 /* dbpf_db_get(db, key, val): Retrieve value for *key* in *db* into
  * *val*. */
 int dbpf_db_get(dbpf_db *, struct dbpf_data *, struct dbpf_data *);
@@ -31,6 +31,7 @@
 #include "dbpf-op-queue.h"
 #include "dbpf-attr-cache.h"
 #include "dbpf-open-cache.h"
+#include "dbpf-sync.h"
 
 #define TROVE_DEFAULT_DB_PAGESIZE 512
 
@@ -237,6 +238,31 @@ static int dbpf_dspace_create_op_svc(struct dbpf_op *op_p)
             op_p->coll_p->coll_id, &op_p->u.d_create.extent_array);
     }
 
+    /*
+      a ledger loaded from a working snapshot may hand out handles
+      created after the snapshot was taken until its background scan
+      catches up.  such a handle is in use, so leave it out of the
+      ledger and take another.
+    */
+    while ((new_handle != TROVE_HANDLE_NULL) &&
+           !(op_p->flags & TROVE_FORCE_REQUESTED_HANDLE) &&
+           (ret = dbpf_dspace_create_store_handle(
+               op_p->coll_p, op_p->u.d_create.type, new_handle)) ==
+           -TROVE_EEXIST)
+    {
+        if ((op_p->u.d_create.extent_array.extent_count == 1) &&
+            (cur_extent.first == cur_extent.last) &&
+            (cur_extent.first == TROVE_HANDLE_NULL))
+        {
+            new_handle = trove_handle_alloc(op_p->coll_p->coll_id);
+        }
+        else
+        {
+            new_handle = trove_handle_alloc_from_range(
+                op_p->coll_p->coll_id, &op_p->u.d_create.extent_array);
+        }
+    }
+
     gossip_debug(GOSSIP_TROVE_DEBUG, "[%d extents] -- new_handle is %llu "
                  "(cur_extent is %llu - %llu)\n",
                  op_p->u.d_create.extent_array.extent_count,
@@ -252,8 +278,11 @@ static int dbpf_dspace_create_op_svc(struct dbpf_op *op_p)
         return(-TROVE_ENOSPC);
     }
 
-    ret = dbpf_dspace_create_store_handle(op_p->coll_p, op_p->u.d_create.type,
-        new_handle);
+    if (op_p->flags & TROVE_FORCE_REQUESTED_HANDLE)
+    {
+        ret = dbpf_dspace_create_store_handle(op_p->coll_p,
+            op_p->u.d_create.type, new_handle);
+    }
     if(ret < 0)
     {
         trove_handle_free(op_p->coll_p->coll_id, new_handle);
@@ -389,6 +418,13 @@ static int dbpf_dspace_create_list_op_svc(struct dbpf_op *op_p)
         ret = dbpf_dspace_create_store_handle(op_p->coll_p, 
             op_p->u.d_create.type,
             new_handle);
+
+        /* see dbpf_dspace_create_op_svc */
+        if (ret == -TROVE_EEXIST)
+        {
+            i--;
+            continue;
+        }
         if(ret < 0)
         {
             /* release any handles we grabbed so far */
@@ -454,7 +490,8 @@ static int dbpf_dspace_remove_list(TROVE_coll_id coll_id,
     q_op_p->op.u.d_remove_list.handle_array = handle_array;
     q_op_p->op.u.d_remove_list.error_p = error_array;
 
-    *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+    *out_op_id_p = q_op_p->op.id;
+    dbpf_queued_op_queue(q_op_p);
 
     return 0;
 }
@@ -532,6 +569,7 @@ static int remove_one_handle(TROVE_object_ref ref,
     /* if this attr is in the dbpf attr cache, remove it */
     gen_mutex_lock(&dbpf_attr_cache_mutex);
     dbpf_attr_cache_remove(ref);
+    dbpf_attr_cache_updated(dbpf_sync_batch_is_open());
     gen_mutex_unlock(&dbpf_attr_cache_mutex);
 
     /* remove bstream if it exists.  Not a fatal
@@ -1148,7 +1186,8 @@ static int dbpf_dspace_getattr_list(TROVE_coll_id coll_id,
     q_op_p->op.u.d_getattr_list.attr_p = ds_attr_p;
     q_op_p->op.u.d_getattr_list.error_p = error_array;
 
-    *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+    *out_op_id_p = q_op_p->op.id;
+    dbpf_queued_op_queue(q_op_p);
 
     return 0;
 }
@@ -1235,6 +1274,7 @@ int dbpf_dspace_attr_set(struct dbpf_collection *coll_p,
     /* now that the disk is updated, update the cache if necessary */
     gen_mutex_lock(&dbpf_attr_cache_mutex);
     dbpf_attr_cache_ds_attr_update_cached_data(ref, attr);
+    dbpf_attr_cache_updated(dbpf_sync_batch_is_open());
     gen_mutex_unlock(&dbpf_attr_cache_mutex);
 
     return 0;
@@ -1262,6 +1302,7 @@ int dbpf_dspace_attr_get(struct dbpf_collection *coll_p,
                          TROVE_ds_attributes *attr)
 {
     struct dbpf_data key, data;
+    uint64_t generation;
     int ret;
 
     key.data = &ref.handle;
@@ -1270,6 +1311,10 @@ int dbpf_dspace_attr_get(struct dbpf_collection *coll_p,
     data.data = attr;
     data.len = sizeof(*attr);
 
+    gen_mutex_lock(&dbpf_attr_cache_mutex);
+    generation = dbpf_attr_cache_fill_generation();
+    gen_mutex_unlock(&dbpf_attr_cache_mutex);
+
     ret = dbpf_db_get(coll_p->ds_db, &key, &data);
     if (ret)
     {
@@ -1306,7 +1351,10 @@ int dbpf_dspace_attr_get(struct dbpf_collection *coll_p,
 
     /* add retrieved ds_attr to dbpf_attr cache here */
     gen_mutex_lock(&dbpf_attr_cache_mutex);
-    dbpf_attr_cache_insert(ref, attr);
+    if (dbpf_attr_cache_fill_allowed(generation))
+    {
+        dbpf_attr_cache_insert(ref, attr);
+    }
     gen_mutex_unlock(&dbpf_attr_cache_mutex);
 
     return 0;
@@ -145,7 +145,7 @@ int PINT_dbpf_keyval_pcache_lookup(
     PINT_dbpf_keyval_pcache *pcache,
     TROVE_handle handle,
     TROVE_ds_position pos,
-    const void ** keyname,
+    void * keyname,
     int * length)
 {
     struct PINT_tcache_entry *entry;
@@ -177,10 +177,12 @@ int PINT_dbpf_keyval_pcache_lookup(
         gen_mutex_unlock(&pcache->mutex);
         return ret;
     }
-    gen_mutex_unlock(&pcache->mutex);
 
-    *keyname = ((struct dbpf_keyval_pcache_entry *)entry->payload)->keyname;
     *length = ((struct dbpf_keyval_pcache_entry *)entry->payload)->keylen;
+    memcpy(keyname,
+           ((struct dbpf_keyval_pcache_entry *)entry->payload)->keyname,
+           *length);
+    gen_mutex_unlock(&pcache->mutex);
 
     gossip_debug(GOSSIP_DBPF_KEYVAL_DEBUG,
                  "Trove KeyVal pcache lookup succeeded: "
@@ -26,11 +26,14 @@ typedef struct PINT_dbpf_keyval_pcache_s
 PINT_dbpf_keyval_pcache * PINT_dbpf_keyval_pcache_initialize(void);
 void PINT_dbpf_keyval_pcache_finalize(PINT_dbpf_keyval_pcache * cache);
 
+/* copies the key name into keyname, which must hold PVFS_NAME_MAX
+ * bytes; the entry itself may be replaced as soon as the lock is
+ * dropped */
 int PINT_dbpf_keyval_pcache_lookup(
     PINT_dbpf_keyval_pcache *pcache,
     TROVE_handle handle,
     TROVE_ds_position pos,
-    const void ** keyname,
+    void * keyname,
     int * length);
 
 int PINT_dbpf_keyval_pcache_insert( 
@@ -33,6 +33,7 @@
 #include "dbpf-op-queue.h"
 #include "dbpf-attr-cache.h"
 #include "dbpf-keyval-pcache.h"
+#include "dbpf-sync.h"
 #include "gossip.h"
 #include "pvfs2-internal.h"
 #include "pint-perf-counter.h"
@@ -41,6 +42,8 @@
  * the new layout of the position token.
  */
 static uint16_t readdir_session = 0;
+/* iterates may be serviced by several trove threads at once */
+static gen_mutex_t readdir_session_mutex = GEN_MUTEX_INITIALIZER;
 
 extern int synccount;
 
@@ -192,6 +195,7 @@ static int dbpf_keyval_read_op_svc(struct dbpf_op *op_p)
     TROVE_object_ref ref = {op_p->handle, op_p->coll_p->coll_id};
     struct dbpf_keyval_db_entry key_entry;
     struct dbpf_data key, data;
+    uint64_t generation;
     int ret;
 
     key_entry.handle = op_p->handle;
@@ -212,6 +216,10 @@ static int dbpf_keyval_read_op_svc(struct dbpf_op *op_p)
     data.data = op_p->u.k_read.val->buffer;
     data.len = op_p->u.k_read.val->buffer_sz;
 
+    gen_mutex_lock(&dbpf_attr_cache_mutex);
+    generation = dbpf_attr_cache_fill_generation();
+    gen_mutex_unlock(&dbpf_attr_cache_mutex);
+
     ret = dbpf_db_get(op_p->coll_p->keyval_db, &key, &data);
     if (ret != 0)
     {
@@ -242,7 +250,13 @@ static int dbpf_keyval_read_op_svc(struct dbpf_op *op_p)
     if(!(op_p->flags & TROVE_BINARY_KEY))
     {
         gen_mutex_lock(&dbpf_attr_cache_mutex);
-        if (dbpf_attr_cache_elem_set_data_based_on_key(
+        if (!dbpf_attr_cache_fill_allowed(generation))
+        {
+            gossip_debug(
+                GOSSIP_DBPF_ATTRCACHE_DEBUG,"** NOT caching data retrieved "
+                "during an update (key is %s)\n", (char *)key_entry.key);
+        }
+        else if (dbpf_attr_cache_elem_set_data_based_on_key(
                 ref, key_entry.key,
                 op_p->u.k_read.val->buffer, data.len))
         {
@@ -481,6 +495,7 @@ static int dbpf_keyval_write_op_svc(struct dbpf_op *op_p)
                     (char *)key_entry.key);
             }
         }
+        dbpf_attr_cache_updated(dbpf_sync_batch_is_open());
         gen_mutex_unlock(&dbpf_attr_cache_mutex);
     }
 
@@ -851,9 +866,11 @@ static int dbpf_keyval_iterate_op_svc(struct dbpf_op *op_p)
         {
             *op_p->u.k_iterate.position_p = count-1;
             /* store a session identifier in the second 16 bits */
+            gen_mutex_lock(&readdir_session_mutex);
             tmp_pos += readdir_session;
-            *op_p->u.k_iterate.position_p += (tmp_pos << 32);
             readdir_session++;
+            gen_mutex_unlock(&readdir_session_mutex);
+            *op_p->u.k_iterate.position_p += (tmp_pos << 32);
         }
         else
         {
@@ -1389,6 +1406,7 @@ static int dbpf_keyval_write_list_op_svc(struct dbpf_op *op_p)
                         (char *)key_entry.key);
                 }
             }
+            dbpf_attr_cache_updated(dbpf_sync_batch_is_open());
             gen_mutex_unlock(&dbpf_attr_cache_mutex);
         }
     }
@@ -1483,7 +1501,8 @@ int PINT_dbpf_keyval_iterate(dbpf_db *db,
     skey.buffer_sz = PVFS_NAME_MAX;
     key = &skey;
 
-    ret = dbpf_db_cursor(db, &dbc, 0);
+    /* only the remove callback modifies the database */
+    ret = dbpf_db_cursor(db, &dbc, callback == NULL);
     if (ret != 0)
     {
         gossip_debug(GOSSIP_DBPF_KEYVAL_DEBUG,
@@ -1709,14 +1728,15 @@ static int dbpf_keyval_iterate_skip_to_position(
 {
     int ret = 0;
     TROVE_keyval_s key;
+    char keybuffer[PVFS_NAME_MAX];
 
     assert(pos != TROVE_ITERATE_START);
 
     memset(&key, 0, sizeof(TROVE_keyval_s));
+    key.buffer = keybuffer;
 
     ret = PINT_dbpf_keyval_pcache_lookup(
-        pcache, handle, pos, 
-        (const void **)&key.buffer, &key.buffer_sz);
+        pcache, handle, pos, key.buffer, &key.buffer_sz);
     if(ret == -PVFS_ENOENT)
     {
         /* if the lookup fails (because the server was restarted)
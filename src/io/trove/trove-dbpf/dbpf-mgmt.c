@@ -35,6 +35,7 @@
 #include "dbpf-bstream.h"
 #include "dbpf-thread.h"
 #include "dbpf-attr-cache.h"
+#include "dbpf-uring-aio.h"
 #include "trove-ledger.h"
 #include "trove-handle-mgmt.h"
 #include "gossip.h"
@@ -179,6 +180,14 @@ int dbpf_collection_setinfo(TROVE_method_id method_id,
             ret = trove_set_handle_timeout(
                 coll_id, context_id, (struct timeval *)parameter);
             break;
+        case TROVE_COLLECTION_HANDLE_CHECKPOINT:
+            gossip_debug(GOSSIP_TROVE_DEBUG, 
+                         "dbpf collection %d - Setting handle ledger "
+                         "checkpoint interval to %d seconds\n",
+                         (int) coll_id, *(int *)parameter);
+            ret = trove_set_handle_checkpoint(
+                coll_id, context_id, *(int *)parameter);
+            break;
         case TROVE_COLLECTION_ATTR_CACHE_KEYWORDS:
             gossip_debug(GOSSIP_TROVE_DEBUG, 
                          "dbpf collection %d - Setting cache keywords "
@@ -659,6 +668,7 @@ int dbpf_finalize(void)
     int ret = -TROVE_EINVAL;
 
     dbpf_thread_finalize();
+    dbpf_uring_finalize();
     dbpf_open_cache_finalize();
     gen_mutex_lock(&dbpf_attr_cache_mutex);
     dbpf_attr_cache_finalize();
@@ -1360,6 +1370,12 @@ int dbpf_collection_clear(TROVE_coll_id coll_id)
     int ret;
     struct dbpf_collection *coll_p = dbpf_collection_find_registered(coll_id);
 
+    /* save the handle ledger while the collection can still be written */
+    if (coll_p != NULL)
+    {
+        trove_handle_mgmt_flush(coll_id);
+    }
+
     dbpf_collection_deregister(coll_p);
 
     if( coll_p == NULL )
@@ -14,7 +14,12 @@
 /* the queue that stores pending serviceable operations */
 QLIST_HEAD(dbpf_op_queue);
 
-/* lock to be obtained before manipulating dbpf_op_queue */
+/* read-only metadata ops, while the read threads are running */
+QLIST_HEAD(dbpf_read_op_queue);
+int dbpf_read_op_queue_depth = 0;
+
+/* lock to be obtained before manipulating dbpf_op_queue or
+ * dbpf_read_op_queue */
 gen_mutex_t dbpf_op_queue_mutex = GEN_MUTEX_INITIALIZER;
 
 extern dbpf_op_queue_p dbpf_completion_queue_array[TROVE_MAX_CONTEXTS];
@@ -23,8 +28,33 @@ extern gen_mutex_t dbpf_completion_queue_array_mutex[TROVE_MAX_CONTEXTS];
 #ifdef __PVFS2_TROVE_THREADED__
 extern pthread_cond_t dbpf_op_incoming_cond;
 extern pthread_cond_t dbpf_op_completed_cond;
+extern pthread_cond_t dbpf_read_op_incoming_cond;
+extern int dbpf_read_threads_running;
 #endif
 
+/* true if the op belongs on dbpf_read_op_queue */
+static int dbpf_op_is_pooled_read(dbpf_queued_op_t *q_op_p)
+{
+#ifdef __PVFS2_TROVE_THREADED__
+    return (dbpf_read_threads_running &&
+            DBPF_OP_IS_READ_ONLY(q_op_p->op.type, q_op_p->op.flags));
+#else
+    return 0;
+#endif
+}
+
+/* account for an op leaving dbpf_read_op_queue; dbpf_op_queue_mutex
+ * must be held */
+static void dbpf_read_op_queue_removed(dbpf_queued_op_t *q_op_p)
+{
+    if (dbpf_op_is_pooled_read(q_op_p))
+    {
+        dbpf_read_op_queue_depth--;
+        PINT_perf_count(PINT_server_pc, PINT_PERF_TROVE_READ_QUEUED,
+                        1, PINT_PERF_SUB);
+    }
+}
+
 /* dbpf_queued_op_put_and_dequeue()
  *
  * Assumption: we already have gotten responsibility for the op by
@@ -50,6 +80,7 @@ void dbpf_queued_op_put_and_dequeue(dbpf_queued_op_t *q_op_p)
     assert((q_op_p->op.state == OP_IN_SERVICE) ||
            (q_op_p->op.state == OP_COMPLETED));
     dbpf_op_queue_remove(q_op_p);
+    dbpf_read_op_queue_removed(q_op_p);
     gen_mutex_unlock(&dbpf_op_queue_mutex);
     q_op_p->op.state = OP_DEQUEUED;
 }
@@ -209,8 +240,19 @@ TROVE_op_id dbpf_queued_op_queue(dbpf_queued_op_t *q_op_p)
 TROVE_op_id dbpf_queued_op_queue_nolock(dbpf_queued_op_t *q_op_p)
 {
     TROVE_op_id tmp_id = 0;
+    int pooled_read = dbpf_op_is_pooled_read(q_op_p);
 
-    dbpf_op_queue_add(&dbpf_op_queue, q_op_p);
+    if (pooled_read)
+    {
+        dbpf_op_queue_add(&dbpf_read_op_queue, q_op_p);
+        dbpf_read_op_queue_depth++;
+        PINT_perf_count(PINT_server_pc, PINT_PERF_TROVE_READ_QUEUED,
+                        1, PINT_PERF_ADD);
+    }
+    else
+    {
+        dbpf_op_queue_add(&dbpf_op_queue, q_op_p);
+    }
 
     gen_mutex_lock(&q_op_p->mutex);
     q_op_p->op.state = OP_QUEUED;
@@ -225,7 +267,8 @@ TROVE_op_id dbpf_queued_op_queue_nolock(dbpf_queued_op_t *q_op_p)
       wake up our operation thread if it's sleeping to let
       it know that a new op is available for servicing
     */
-    pthread_cond_signal(&dbpf_op_incoming_cond);
+    pthread_cond_signal(pooled_read ? &dbpf_read_op_incoming_cond :
+                        &dbpf_op_incoming_cond);
 #endif
 
     return tmp_id;
@@ -257,6 +300,7 @@ void dbpf_queued_op_dequeue_nolock(dbpf_queued_op_t *q_op_p)
     assert(q_op_p->op.state != OP_IN_SERVICE);
 
     dbpf_op_queue_remove(q_op_p);
+    dbpf_read_op_queue_removed(q_op_p);
 
     q_op_p->op.state = OP_DEQUEUED;
 
@@ -362,7 +406,11 @@ int dbpf_queue_or_service(
     }
     else
     {
-        *out_op_id_p = dbpf_queued_op_queue(q_op_p);
+        /* out_op_id_p usually points into a job descriptor, which another
+         * thread may free as soon as the queued op completes
+         */
+        *out_op_id_p = q_op_p->op.id;
+        dbpf_queued_op_queue(q_op_p);
         ret = 0;
     }
 
@@ -66,6 +66,9 @@ typedef struct
 
     PINT_op_id mgr_op_id;
     struct qlist_head link;
+
+    /* servicing the op wrote to an open metadata batch */
+    int batch_wrote;
 } dbpf_queued_op_t;
 
 dbpf_queued_op_t *dbpf_queued_op_alloc(void);
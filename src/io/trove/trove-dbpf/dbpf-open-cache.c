@@ -30,6 +30,7 @@
 #include "gossip.h"
 #include "quicklist.h"
 #include "dbpf-open-cache.h"
+#include "dbpf-uring-aio.h"
 #include "pvfs2-internal.h"
 
 #define OPEN_CACHE_SIZE 64
@@ -563,6 +564,11 @@ static int open_fd(
     }
 #endif
 
+    if(*fd >= 0)
+    {
+        dbpf_uring_register_fd(*fd);
+    }
+
     return ((*fd < 0) ? -trove_errno_to_trove_error(errno) : 0);
 }
 
@@ -714,6 +720,7 @@ static void close_fd(
 {
     gossip_debug(GOSSIP_DBPF_OPEN_CACHE_DEBUG,
         "dbpf_open_cache closing fd %d of type %d\n", fd, type);
+    dbpf_uring_unregister_fd(fd);
     close(fd);
 }
 
@@ -4,12 +4,15 @@
  * See COPYING in top-level directory.
  */
 
+#include <time.h>
+
 #include "dbpf-op-queue.h"
 #include "pvfs2-internal.h"
 #include "gossip.h"
 #include "pint-perf-counter.h"
 #include "dbpf-sync.h"
 #include "dbpf-thread.h"
+#include "dbpf-attr-cache.h"
 
 enum s_sync_context_e
 {
@@ -24,6 +27,27 @@ static dbpf_sync_context_t
 extern dbpf_op_queue_p dbpf_completion_queue_array[TROVE_MAX_CONTEXTS];
 extern gen_mutex_t dbpf_completion_queue_array_mutex[TROVE_MAX_CONTEXTS];
 extern pthread_cond_t dbpf_op_completed_cond;
+extern gen_mutex_t dbpf_attr_cache_mutex;
+extern int TROVE_meta_batch_max_ops;
+extern int TROVE_meta_batch_max_latency;
+
+/* most databases a single batch will sync without repeating itself */
+#define DBPF_BATCH_MAX_SYNC_DBS 16
+
+/*
+ * Group commit.  While the trove thread works through the op queue,
+ * the keyval and dspace writes of the ops it services go into one
+ * database transaction per database (see dbpf_db_batch_begin()).  Ops
+ * that modify metadata are parked on batch_ops instead of completing,
+ * and are all completed once the batch has been committed and, for
+ * TROVE_SYNC ops on collections with meta sync enabled, synced.  Only
+ * the trove thread writes this state.
+ */
+static int batch_open = 0;
+static int batch_count = 0;
+static struct timespec batch_start;
+static struct timespec batch_timer;
+static QLIST_HEAD(batch_ops);
 
 static int dbpf_sync_db(
     dbpf_db * dbp, 
@@ -368,6 +392,207 @@ int dbpf_sync_coalesce_dequeue(
     return 0;
 }
 
+int dbpf_sync_batch_enabled(void)
+{
+    return TROVE_meta_batch_max_ops > 1;
+}
+
+void dbpf_sync_batch_begin(void)
+{
+    if (batch_open || !dbpf_sync_batch_enabled())
+    {
+        return;
+    }
+    if (dbpf_db_batch_begin() != 0)
+    {
+        return;
+    }
+    batch_open = 1;
+    batch_count = 0;
+}
+
+int dbpf_sync_batch_is_open(void)
+{
+    return batch_open;
+}
+
+static int64_t batch_elapsed_usecs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return ((int64_t)(now.tv_sec - batch_start.tv_sec) * 1000000 +
+            (now.tv_nsec - batch_start.tv_nsec) / 1000);
+}
+
+static void batch_count_perf(int count, int64_t usecs)
+{
+    int size_key, lat_key;
+
+    if (count == 1)
+        size_key = PINT_PERF_META_BATCH_1;
+    else if (count < 8)
+        size_key = PINT_PERF_META_BATCH_2_7;
+    else if (count < 32)
+        size_key = PINT_PERF_META_BATCH_8_31;
+    else
+        size_key = PINT_PERF_META_BATCH_32;
+
+    if (usecs < 100)
+        lat_key = PINT_PERF_META_BATCH_LAT_100US;
+    else if (usecs < 1000)
+        lat_key = PINT_PERF_META_BATCH_LAT_1MS;
+    else if (usecs < 10000)
+        lat_key = PINT_PERF_META_BATCH_LAT_10MS;
+    else
+        lat_key = PINT_PERF_META_BATCH_LAT_SLOW;
+
+    PINT_perf_count(PINT_server_pc, PINT_PERF_META_BATCHES, 1, PINT_PERF_ADD);
+    PINT_perf_count(PINT_server_pc, PINT_PERF_META_BATCH_OPS, count,
+                    PINT_PERF_ADD);
+    PINT_perf_count(PINT_server_pc, size_key, 1, PINT_PERF_ADD);
+    PINT_perf_count(PINT_server_pc, lat_key, 1, PINT_PERF_ADD);
+    PINT_perf_timer_end(PINT_server_tpc, PINT_PERF_TMETA_BATCH, &batch_timer);
+}
+
+/*
+ * Commits the open batch, syncs the databases its ops asked to have
+ * synced, and completes the ops.  If the commit or a sync fails, every
+ * op that had succeeded is completed with that error instead, since its
+ * update may not be on disk.
+ */
+int dbpf_sync_batch_commit(int *outcount)
+{
+    dbpf_db *synced[DBPF_BATCH_MAX_SYNC_DBS];
+    int nsynced = 0;
+    dbpf_queued_op_t *qop_p, *tmp;
+    dbpf_db *dbp;
+    int sync_context_type;
+    int ret, i, count;
+
+    if (!batch_open)
+    {
+        return 0;
+    }
+    batch_open = 0;
+    ret = dbpf_db_batch_commit();
+
+    /* the read threads may cache what they read again */
+    gen_mutex_lock(&dbpf_attr_cache_mutex);
+    dbpf_attr_cache_committed();
+    gen_mutex_unlock(&dbpf_attr_cache_mutex);
+    if (ret != 0)
+    {
+        ret = -ret;
+    }
+    count = batch_count;
+    if (count == 0)
+    {
+        return ret;
+    }
+
+    qlist_for_each_entry(qop_p, &batch_ops, link)
+    {
+        if (ret != 0)
+        {
+            break;
+        }
+        if (!(qop_p->op.flags & TROVE_SYNC) ||
+            !qop_p->op.coll_p->meta_sync_enabled)
+        {
+            continue;
+        }
+        /* any op may have written to the batch; only keyval ops use
+         * the keyval database */
+        sync_context_type = DBPF_OP_IS_KEYVAL(qop_p->op.type) ?
+            COALESCE_CONTEXT_KEYVAL : COALESCE_CONTEXT_DSPACE;
+        dbp = (sync_context_type == COALESCE_CONTEXT_KEYVAL) ?
+            qop_p->op.coll_p->keyval_db : qop_p->op.coll_p->ds_db;
+        for (i = 0; i < nsynced; i++)
+        {
+            if (synced[i] == dbp)
+            {
+                break;
+            }
+        }
+        if (i < nsynced)
+        {
+            continue;
+        }
+        ret = dbpf_sync_db(dbp, sync_context_type,
+            &sync_array[sync_context_type][qop_p->op.context_id]);
+        if (nsynced < DBPF_BATCH_MAX_SYNC_DBS)
+        {
+            synced[nsynced++] = dbp;
+        }
+    }
+
+    gossip_debug(GOSSIP_DBPF_COALESCE_DEBUG,
+                 "[SYNC_COALESCE]: batch of %d ops committed, %d dbs "
+                 "synced, ret %d\n", count, nsynced, ret);
+
+    batch_count_perf(count, batch_elapsed_usecs());
+
+    qlist_for_each_entry_safe(qop_p, tmp, &batch_ops, link)
+    {
+        qlist_del(&qop_p->link);
+        if (ret != 0 && qop_p->state == 0)
+        {
+            qop_p->state = ret;
+        }
+        dbpf_queued_op_complete(qop_p, OP_COMPLETED);
+        (*outcount)++;
+    }
+    batch_count = 0;
+
+    return 0;
+}
+
+/*
+ * Returns nonzero if the open batch holds ops and has been open for at
+ * least the configured latency bound.
+ */
+int dbpf_sync_batch_expired(void)
+{
+    return (batch_open && batch_count > 0 &&
+            batch_elapsed_usecs() >= TROVE_meta_batch_max_latency);
+}
+
+/*
+ * Called by the trove thread in place of dbpf_sync_coalesce() for each
+ * op it finishes while a batch is open.  Ops that neither modify
+ * metadata nor wrote to the batch complete right away; the others join
+ * the batch, which is committed here once it is full or has been open
+ * for the configured latency bound.
+ */
+int dbpf_sync_batch_add(dbpf_queued_op_t *qop_p, int retcode, int *outcount)
+{
+    int ret;
+
+    if (!batch_open ||
+        (!DBPF_OP_DOES_SYNC(qop_p->op.type) && !qop_p->batch_wrote))
+    {
+        return dbpf_sync_coalesce(qop_p, retcode, outcount);
+    }
+
+    qop_p->state = retcode;
+    if (batch_count == 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC_RAW, &batch_start);
+        PINT_perf_timer_start(&batch_timer);
+    }
+    qlist_add_tail(&qop_p->link, &batch_ops);
+    batch_count++;
+
+    if (batch_count >= TROVE_meta_batch_max_ops || dbpf_sync_batch_expired())
+    {
+        ret = dbpf_sync_batch_commit(outcount);
+        dbpf_sync_batch_begin();
+        return ret;
+    }
+    return 0;
+}
+
 void dbpf_queued_op_set_sync_high_watermark(
     int high, struct dbpf_collection* coll)
 {
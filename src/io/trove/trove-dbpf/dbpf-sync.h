@@ -31,6 +31,13 @@ int dbpf_sync_coalesce(dbpf_queued_op_t *qop_p, int retcode, int * outcount);
 int dbpf_sync_coalesce_dequeue(dbpf_queued_op_t *qop_p);
 int dbpf_sync_coalesce_enqueue(dbpf_queued_op_t *qop_p);
 
+int dbpf_sync_batch_enabled(void);
+void dbpf_sync_batch_begin(void);
+int dbpf_sync_batch_is_open(void);
+int dbpf_sync_batch_expired(void);
+int dbpf_sync_batch_add(dbpf_queued_op_t *qop_p, int retcode, int * outcount);
+int dbpf_sync_batch_commit(int * outcount);
+
 
 void dbpf_queued_op_set_sync_high_watermark(int high, struct dbpf_collection* coll);
 void dbpf_queued_op_set_sync_low_watermark(int low, struct dbpf_collection* coll);
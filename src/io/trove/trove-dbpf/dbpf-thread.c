@@ -20,8 +20,11 @@
 #include "dbpf-sync.h"
 #include "pint-context.h"
 #include "pint-mgmt.h"
+#include "pint-perf-counter.h"
 
 extern struct qlist_head dbpf_op_queue;
+extern struct qlist_head dbpf_read_op_queue;
+extern int dbpf_read_op_queue_depth;
 extern gen_mutex_t dbpf_op_queue_mutex;
 extern dbpf_op_queue_p dbpf_completion_queue_array[TROVE_MAX_CONTEXTS];
 extern gen_mutex_t dbpf_completion_queue_array_mutex[TROVE_MAX_CONTEXTS];
@@ -31,9 +34,35 @@ static pthread_t dbpf_thread;
 static int dbpf_thread_running = 0;
 pthread_cond_t dbpf_op_incoming_cond = PTHREAD_COND_INITIALIZER;
 pthread_cond_t dbpf_op_completed_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Read threads.  With TroveMetaReadThreads set, read-only metadata ops
+ * (see DBPF_OP_IS_READ_ONLY) are queued on dbpf_read_op_queue instead
+ * of dbpf_op_queue, and a pool of threads services them concurrently,
+ * each in its own database read transaction.  Everything else,
+ * including the metadata batch, stays on the trove thread, which is
+ * the only writer.
+ */
+struct dbpf_read_thread
+{
+    pthread_t thread;
+    int index;
+    uint64_t serviced;          /* ops serviced by this thread */
+    int max_queue_depth;        /* deepest queue it took an op from */
+};
+
+static struct dbpf_read_thread *dbpf_read_threads = NULL;
+static int dbpf_read_thread_count = 0;
+int dbpf_read_threads_running = 0;
+pthread_cond_t dbpf_read_op_incoming_cond = PTHREAD_COND_INITIALIZER;
+
+static void *dbpf_read_thread_function(void *ptr);
+static void dbpf_read_threads_start(void);
+static void dbpf_read_threads_stop(void);
 #endif
 
 extern int TROVE_max_concurrent_io;
+extern int TROVE_meta_read_threads;
 
 int dbpf_thread_initialize(void)
 {
@@ -43,6 +72,7 @@ int dbpf_thread_initialize(void)
 
     pthread_cond_init(&dbpf_op_incoming_cond, NULL);
     pthread_cond_init(&dbpf_op_completed_cond, NULL);
+    pthread_cond_init(&dbpf_read_op_incoming_cond, NULL);
 
     dbpf_thread_running = 1;
     ret = pthread_create(&dbpf_thread, NULL,
@@ -51,6 +81,7 @@ int dbpf_thread_initialize(void)
     {
         gossip_debug(GOSSIP_TROVE_DEBUG,
                      "dbpf_thread_initialize: initialized\n");
+        dbpf_read_threads_start();
     }
     else
     {
@@ -67,9 +98,12 @@ int dbpf_thread_finalize(void)
 {
     int ret = 0;
 #ifdef __PVFS2_TROVE_THREADED__
+    dbpf_read_threads_stop();
+
     dbpf_thread_running = 0;
     ret = pthread_join(dbpf_thread, NULL);
 
+    pthread_cond_destroy(&dbpf_read_op_incoming_cond);
     pthread_cond_destroy(&dbpf_op_completed_cond);
     pthread_cond_destroy(&dbpf_op_incoming_cond);
 #endif
@@ -77,6 +111,158 @@ int dbpf_thread_finalize(void)
     return ret;
 }
 
+#ifdef __PVFS2_TROVE_THREADED__
+static void dbpf_read_threads_start(void)
+{
+    int i, ret;
+
+    if (TROVE_meta_read_threads <= 0)
+    {
+        return;
+    }
+    if (!dbpf_db_concurrent_reads())
+    {
+        gossip_err("Warning: TroveMetaReadThreads is ignored; the "
+                   "database backend does not support concurrent "
+                   "reads.\n");
+        return;
+    }
+
+    dbpf_read_threads = calloc(TROVE_meta_read_threads,
+                               sizeof(*dbpf_read_threads));
+    if (!dbpf_read_threads)
+    {
+        gossip_err("Warning: no memory for trove read threads; "
+                   "servicing all metadata ops on one thread.\n");
+        return;
+    }
+
+    /* ops queued from here on are routed to the read threads */
+    dbpf_read_threads_running = 1;
+    for (i = 0; i < TROVE_meta_read_threads; i++)
+    {
+        dbpf_read_threads[i].index = i;
+        ret = pthread_create(&dbpf_read_threads[i].thread, NULL,
+                             dbpf_read_thread_function,
+                             &dbpf_read_threads[i]);
+        if (ret != 0)
+        {
+            gossip_err("Warning: started only %d of %d trove read "
+                       "threads.\n", i, TROVE_meta_read_threads);
+            break;
+        }
+    }
+    dbpf_read_thread_count = i;
+    if (dbpf_read_thread_count == 0)
+    {
+        dbpf_read_threads_running = 0;
+        free(dbpf_read_threads);
+        dbpf_read_threads = NULL;
+        return;
+    }
+
+    gossip_debug(GOSSIP_TROVE_DEBUG, "dbpf_thread_initialize: started %d "
+                 "read threads\n", dbpf_read_thread_count);
+}
+
+static void dbpf_read_threads_stop(void)
+{
+    int i;
+
+    if (!dbpf_read_threads)
+    {
+        return;
+    }
+
+    gen_mutex_lock(&dbpf_op_queue_mutex);
+    dbpf_read_threads_running = 0;
+    pthread_cond_broadcast(&dbpf_read_op_incoming_cond);
+    gen_mutex_unlock(&dbpf_op_queue_mutex);
+
+    for (i = 0; i < dbpf_read_thread_count; i++)
+    {
+        pthread_join(dbpf_read_threads[i].thread, NULL);
+        gossip_debug(GOSSIP_TROVE_DEBUG, "dbpf read thread %d: %llu ops "
+                     "serviced, max queue depth %d\n", i,
+                     llu(dbpf_read_threads[i].serviced),
+                     dbpf_read_threads[i].max_queue_depth);
+    }
+
+    free(dbpf_read_threads);
+    dbpf_read_threads = NULL;
+    dbpf_read_thread_count = 0;
+}
+
+static void *dbpf_read_thread_function(void *ptr)
+{
+    struct dbpf_read_thread *self = (struct dbpf_read_thread *)ptr;
+    dbpf_queued_op_t *cur_op = NULL;
+    int out_count = 0, ret = 0;
+    struct timeval base;
+    struct timespec wait_time;
+
+    PINT_event_thread_start("TROVE-DBPF-READ");
+    gen_mutex_lock(&dbpf_op_queue_mutex);
+    while (dbpf_read_threads_running)
+    {
+        cur_op = dbpf_op_queue_shownext(&dbpf_read_op_queue);
+        if (!cur_op)
+        {
+            gettimeofday(&base, NULL);
+            wait_time.tv_sec = base.tv_sec +
+                (TROVE_DEFAULT_TEST_TIMEOUT / 1000);
+            wait_time.tv_nsec = base.tv_usec * 1000 +
+                ((TROVE_DEFAULT_TEST_TIMEOUT % 1000) * 1000000);
+            if (wait_time.tv_nsec > 1000000000)
+            {
+                wait_time.tv_nsec = wait_time.tv_nsec - 1000000000;
+                wait_time.tv_sec++;
+            }
+            pthread_cond_timedwait(&dbpf_read_op_incoming_cond,
+                                   &dbpf_op_queue_mutex, &wait_time);
+            continue;
+        }
+
+        if (dbpf_read_op_queue_depth > self->max_queue_depth)
+        {
+            self->max_queue_depth = dbpf_read_op_queue_depth;
+        }
+
+        gen_mutex_lock(&cur_op->mutex);
+        assert(cur_op->op.state == OP_QUEUED);
+        dbpf_queued_op_dequeue_nolock(cur_op);
+        cur_op->op.state = OP_IN_SERVICE;
+        gen_mutex_unlock(&cur_op->mutex);
+        gen_mutex_unlock(&dbpf_op_queue_mutex);
+
+        gossip_debug(GOSSIP_TROVE_OP_DEBUG,"[DBPF READ THREAD %d]: STARTING "
+                     "TROVE SERVICE ROUTINE (%s)\n", self->index,
+                     dbpf_op_type_to_str(cur_op->op.type));
+
+        ret = cur_op->op.svc_fn(&(cur_op->op));
+        self->serviced++;
+        PINT_perf_count(PINT_server_pc, PINT_PERF_TROVE_READ_OPS,
+                        1, PINT_PERF_ADD);
+
+        if (ret == DBPF_OP_COMPLETE || ret < 0)
+        {
+            /* read-only ops do not sync, so this completes the op */
+            dbpf_sync_coalesce(cur_op, (ret == 1 ? 0 : ret), &out_count);
+        }
+        else
+        {
+            dbpf_queued_op_queue(cur_op);
+        }
+
+        gen_mutex_lock(&dbpf_op_queue_mutex);
+    }
+    gen_mutex_unlock(&dbpf_op_queue_mutex);
+
+    PINT_event_thread_stop();
+    return ptr;
+}
+#endif
+
 int synccount = 0;
 
 void *dbpf_thread_function(void *ptr)
@@ -148,6 +334,9 @@ void *dbpf_thread_function(void *ptr)
         }
     }
 
+    /* complete anything still waiting on a metadata batch */
+    dbpf_sync_batch_commit(&out_count);
+
     gossip_debug(GOSSIP_TROVE_DEBUG, "dbpf_thread_function ending\n");
     PINT_event_thread_stop();
 #endif
@@ -157,8 +346,9 @@ void *dbpf_thread_function(void *ptr)
 int dbpf_do_one_work_cycle(int *out_count)
 {
 #ifdef __PVFS2_TROVE_THREADED__
-    int ret = 1;
+    int ret = 1, cycle_ret = 0, queue_empty = 0;
     int max_num_ops_to_service = DBPF_OPS_PER_WORK_CYCLE;
+    unsigned long batch_writes;
     dbpf_queued_op_t *cur_op = NULL;
 #endif
 
@@ -166,6 +356,11 @@ int dbpf_do_one_work_cycle(int *out_count)
     *out_count = 0;
 
 #ifdef __PVFS2_TROVE_THREADED__
+    /* if batching is enabled, metadata updates are grouped into one
+     * transaction that stays open across work cycles while more ops are
+     * queued; see dbpf_sync_batch_add() */
+    dbpf_sync_batch_begin();
+
     do
     {
         /* grab next op from queue and mark it as in service */
@@ -196,7 +391,8 @@ int dbpf_do_one_work_cycle(int *out_count)
         /* if there's no work to be done, return immediately */
         if (cur_op == NULL)
         {
-            return ret;
+            cycle_ret = ret;
+            break;
         }
 
         /* otherwise, service the current operation now */
@@ -204,7 +400,12 @@ int dbpf_do_one_work_cycle(int *out_count)
                      "SERVICE ROUTINE (%s)\n",
                      dbpf_op_type_to_str(cur_op->op.type));
 
+        batch_writes = dbpf_db_batch_writes();
         ret = cur_op->op.svc_fn(&(cur_op->op));
+        if (dbpf_db_batch_writes() != batch_writes)
+        {
+            cur_op->batch_wrote = 1;
+        }
 
         gossip_debug(GOSSIP_TROVE_OP_DEBUG,"[DBPF THREAD]: FINISHED TROVE "
                      "SERVICE ROUTINE (%s) (ret: %d)\n",
@@ -219,10 +420,12 @@ int dbpf_do_one_work_cycle(int *out_count)
              * and move _all_ the ready-to-be-synced operations to the
              * completion queue.
              */
-            ret = dbpf_sync_coalesce(cur_op, (ret == 1 ? 0 : ret), out_count);
+            ret = dbpf_sync_batch_add(cur_op, (ret == 1 ? 0 : ret), out_count);
             if(ret < 0)
             {
-                return ret; /* not sure how to recover from failure here */
+                /* not sure how to recover from failure here */
+                cycle_ret = ret;
+                break;
             }
         }
         else if(ret == -DBPF_ERROR_UNKNOWN || ret == DBPF_ERROR_UNKNOWN)
@@ -231,7 +434,8 @@ int dbpf_do_one_work_cycle(int *out_count)
              * and just return.  Make sure the return code is negative
              * here though.
              */
-            return (ret < 0) ? ret : -ret;
+            cycle_ret = (ret < 0) ? ret : -ret;
+            break;
         }
         else
         {
@@ -253,9 +457,19 @@ int dbpf_do_one_work_cycle(int *out_count)
         }
 
     } while(--max_num_ops_to_service);
-#endif
 
+    gen_mutex_lock(&dbpf_op_queue_mutex);
+    queue_empty = qlist_empty(&dbpf_op_queue);
+    gen_mutex_unlock(&dbpf_op_queue_mutex);
+    if (queue_empty || cycle_ret < 0 || dbpf_sync_batch_expired())
+    {
+        dbpf_sync_batch_commit(out_count);
+    }
+
+    return cycle_ret;
+#else
     return 0;
+#endif
 }
 
 /*
@@ -0,0 +1,796 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/* This is a bstream method that hands the aiocb lists built by
+ * dbpf_bstream_rw_list() to one io_uring instance shared by every
+ * collection, instead of starting a thread per aiocb like alt-aio.  All
+ * of the aiocbs in a list are queued with a single io_uring_enter() call.
+ * One reaper thread waits for completions and runs the notification
+ * callback once every aiocb in a list has finished.
+ *
+ * Descriptors from the open cache are registered with the ring as they
+ * are opened, so that the kernel does not have to look up the file for
+ * each request.  If the kernel (or the build) does not support io_uring,
+ * the alt-aio implementation is used instead.
+ */
+
+#include "pvfs2-internal.h"
+#include "quicklist.h"
+#include "dbpf-alt-aio.h"
+#include "dbpf-uring-aio.h"
+#include "pthread.h"
+#include "dbpf.h"
+#include "gen-locks.h"
+#include <string.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+enum uring_state
+{
+    URING_UNINITIALIZED = 0,
+    URING_RUNNING,
+    URING_FAILED
+};
+
+static gen_mutex_t uring_mutex = GEN_MUTEX_INITIALIZER;
+static enum uring_state uring_state = URING_UNINITIALIZED;
+
+#ifdef HAVE_IO_URING
+
+static int uring_lio_listio(int mode, struct aiocb * const list[],
+                            int nent, struct sigevent *sig);
+static int uring_aio_error(const struct aiocb *aiocbp);
+static ssize_t uring_aio_return(struct aiocb *aiocbp);
+static int uring_aio_cancel(int filedesc, struct aiocb * aiocbp);
+static int uring_aio_suspend(const struct aiocb * const list[], int nent,
+                             const struct timespec * timeout);
+static int uring_aio_read(struct aiocb * aiocbp);
+static int uring_aio_write(struct aiocb * aiocbp);
+static int uring_aio_fsync(int operation, struct aiocb * aiocbp);
+
+static struct dbpf_aio_ops uring_aio_ops;
+
+struct uring_list;
+
+/* one per aiocb; its address is the user_data of the sqe */
+struct uring_req
+{
+    struct aiocb *cb_p;
+    struct iovec iov;
+    struct uring_list *list;
+};
+
+/* one per lio_listio() call */
+struct uring_list
+{
+    struct sigevent *sig;
+    int nent;
+    int submitted;      /* protected by uring_mutex */
+    int remaining;      /* only touched by the reaper once submitted */
+    struct qlist_head list_link;
+    struct uring_req reqs[1];
+};
+
+struct uring_ring
+{
+    int fd;
+    void *sq_ptr;
+    size_t sq_len;
+    void *cq_ptr;
+    size_t cq_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    struct io_uring_cqe *cqes;
+    unsigned cq_mask;
+    unsigned cq_entries;
+};
+
+static struct uring_ring ring;
+static pthread_t uring_reaper;
+/* requests handed to the kernel and not yet reaped */
+static unsigned uring_inflight = 0;
+/* lists with aiocbs that did not fit in the ring yet */
+static QLIST_HEAD(uring_backlog);
+static int uring_files_registered = 0;
+static char uring_fixed[DBPF_URING_MAX_FILES];
+
+static void *uring_reap_thread(void *arg);
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit,
+                              unsigned min_complete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                   flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg,
+                                 unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void uring_unmap(void)
+{
+    if(ring.sqes && ring.sqes != MAP_FAILED)
+    {
+        munmap(ring.sqes, ring.sqes_len);
+    }
+    if(ring.cq_ptr && ring.cq_ptr != MAP_FAILED && ring.cq_ptr != ring.sq_ptr)
+    {
+        munmap(ring.cq_ptr, ring.cq_len);
+    }
+    if(ring.sq_ptr && ring.sq_ptr != MAP_FAILED)
+    {
+        munmap(ring.sq_ptr, ring.sq_len);
+    }
+    if(ring.fd >= 0)
+    {
+        close(ring.fd);
+    }
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = -1;
+}
+
+/* uring_start()
+ *
+ * creates the ring, registers an empty file table with it and starts
+ * the reaper thread.  Called with uring_mutex held.
+ *
+ * returns 0 on success, -errno on failure
+ */
+static int uring_start(void)
+{
+    struct io_uring_params params;
+    int *fds;
+    int ret;
+    int i;
+
+    memset(&ring, 0, sizeof(ring));
+    memset(&params, 0, sizeof(params));
+
+    ring.fd = sys_io_uring_setup(DBPF_URING_QUEUE_DEPTH, &params);
+    if(ring.fd < 0)
+    {
+        return(-errno);
+    }
+
+    ring.sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cq_len = params.cq_off.cqes +
+        params.cq_entries * sizeof(struct io_uring_cqe);
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(ring.cq_len > ring.sq_len)
+        {
+            ring.sq_len = ring.cq_len;
+        }
+        ring.cq_len = ring.sq_len;
+    }
+
+    ring.sq_ptr = mmap(NULL, ring.sq_len, PROT_READ|PROT_WRITE,
+                       MAP_SHARED|MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if(ring.sq_ptr == MAP_FAILED)
+    {
+        goto error_exit;
+    }
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring.cq_ptr = ring.sq_ptr;
+    }
+    else
+    {
+        ring.cq_ptr = mmap(NULL, ring.cq_len, PROT_READ|PROT_WRITE,
+                           MAP_SHARED|MAP_POPULATE, ring.fd,
+                           IORING_OFF_CQ_RING);
+        if(ring.cq_ptr == MAP_FAILED)
+        {
+            goto error_exit;
+        }
+    }
+    ring.sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqes = mmap(NULL, ring.sqes_len, PROT_READ|PROT_WRITE,
+                     MAP_SHARED|MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if(ring.sqes == MAP_FAILED)
+    {
+        goto error_exit;
+    }
+
+    ring.sq_head = (unsigned *)((char *)ring.sq_ptr + params.sq_off.head);
+    ring.sq_tail = (unsigned *)((char *)ring.sq_ptr + params.sq_off.tail);
+    ring.sq_array = (unsigned *)((char *)ring.sq_ptr + params.sq_off.array);
+    ring.sq_mask = *(unsigned *)((char *)ring.sq_ptr +
+                                 params.sq_off.ring_mask);
+    ring.sq_entries = params.sq_entries;
+    ring.sq_local_tail = *ring.sq_tail;
+
+    ring.cq_head = (unsigned *)((char *)ring.cq_ptr + params.cq_off.head);
+    ring.cq_tail = (unsigned *)((char *)ring.cq_ptr + params.cq_off.tail);
+    ring.cqes = (struct io_uring_cqe *)((char *)ring.cq_ptr +
+                                        params.cq_off.cqes);
+    ring.cq_mask = *(unsigned *)((char *)ring.cq_ptr +
+                                 params.cq_off.ring_mask);
+    ring.cq_entries = params.cq_entries;
+
+    /* sparse file table indexed by descriptor; slots are filled in as the
+     * open cache opens files.  Older kernels can't do sparse tables, in
+     * which case we just submit with plain descriptors.
+     */
+    memset(uring_fixed, 0, sizeof(uring_fixed));
+    uring_files_registered = 0;
+    fds = (int *)malloc(DBPF_URING_MAX_FILES * sizeof(int));
+    if(fds)
+    {
+        for(i = 0; i < DBPF_URING_MAX_FILES; i++)
+        {
+            fds[i] = -1;
+        }
+        ret = sys_io_uring_register(ring.fd, IORING_REGISTER_FILES,
+                                    fds, DBPF_URING_MAX_FILES);
+        uring_files_registered = (ret == 0);
+        free(fds);
+    }
+
+    uring_inflight = 0;
+    ret = pthread_create(&uring_reaper, NULL, uring_reap_thread, NULL);
+    if(ret != 0)
+    {
+        errno = ret;
+        goto error_exit;
+    }
+
+    gossip_debug(GOSSIP_BSTREAM_DEBUG, "[io-uring]: ring started with "
+                 "%u entries, registered files: %s\n", ring.sq_entries,
+                 (uring_files_registered ? "yes" : "no"));
+    return(0);
+
+error_exit:
+    ret = -errno;
+    uring_unmap();
+    return(ret);
+}
+
+/* uring_submit_locked()
+ *
+ * moves as many backlogged aiocbs into the submission queue as the ring
+ * has room for, then submits them all with one system call.  The number
+ * of requests in flight is kept below the size of the completion queue
+ * so that completions can never be dropped.  Called with uring_mutex
+ * held.
+ */
+static void uring_submit_locked(void)
+{
+    struct uring_list *list;
+    struct uring_req *req;
+    struct io_uring_sqe *sqe;
+    unsigned head, index;
+    int fd, to_submit, ret;
+
+    while(!qlist_empty(&uring_backlog))
+    {
+        list = qlist_entry(uring_backlog.next, struct uring_list, list_link);
+        while(list->submitted < list->nent)
+        {
+            head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+            if(ring.sq_local_tail - head >= ring.sq_entries ||
+               uring_inflight >= ring.cq_entries)
+            {
+                goto submit;
+            }
+
+            req = &list->reqs[list->submitted];
+            index = ring.sq_local_tail & ring.sq_mask;
+            sqe = &ring.sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+
+            sqe->opcode = (req->cb_p->aio_lio_opcode == LIO_READ) ?
+                IORING_OP_READV : IORING_OP_WRITEV;
+            fd = req->cb_p->aio_fildes;
+            if(fd >= 0 && fd < DBPF_URING_MAX_FILES && uring_fixed[fd])
+            {
+                sqe->flags |= IOSQE_FIXED_FILE;
+            }
+            sqe->fd = fd;
+            sqe->addr = (unsigned long)&req->iov;
+            sqe->len = 1;
+            sqe->off = req->cb_p->aio_offset;
+            sqe->user_data = (unsigned long)req;
+
+            ring.sq_array[index] = index;
+            ring.sq_local_tail++;
+            list->submitted++;
+            uring_inflight++;
+        }
+        qlist_del(&list->list_link);
+    }
+
+submit:
+    __atomic_store_n(ring.sq_tail, ring.sq_local_tail, __ATOMIC_RELEASE);
+    to_submit = ring.sq_local_tail -
+        __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    if(to_submit > 0)
+    {
+        ret = sys_io_uring_enter(ring.fd, to_submit, 0, 0);
+        if(ret < 0 && errno != EAGAIN && errno != EBUSY && errno != EINTR)
+        {
+            /* anything not consumed stays in the ring and is picked up
+             * by the next submission
+             */
+            gossip_err("[io-uring]: io_uring_enter failed: %s\n",
+                       strerror(errno));
+        }
+    }
+}
+
+/* uring_reap_thread()
+ *
+ * waits for completions, records the result of each aiocb and runs the
+ * notification callback of every list that has finished.  A completion
+ * without a request is the wakeup posted by dbpf_uring_finalize().
+ */
+static void *uring_reap_thread(void *arg)
+{
+    struct io_uring_cqe *cqe;
+    struct uring_req *req;
+    struct uring_list *list, *tmp;
+    unsigned head;
+    int reaped;
+    int stop = 0;
+    int ret;
+    QLIST_HEAD(done_list);
+
+    while(!stop)
+    {
+        ret = sys_io_uring_enter(ring.fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            gossip_err("[io-uring]: io_uring_enter failed: %s\n",
+                       strerror(errno));
+        }
+
+        reaped = 0;
+        head = *ring.cq_head;
+        while(head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE))
+        {
+            cqe = &ring.cqes[head & ring.cq_mask];
+            req = (struct uring_req *)(unsigned long)cqe->user_data;
+            ret = cqe->res;
+            head++;
+
+            if(!req)
+            {
+                stop = 1;
+                continue;
+            }
+            reaped++;
+
+            /* store error and return codes */
+            if(ret < 0)
+            {
+#ifdef HAVE_AIOCB_ERROR_CODE
+                req->cb_p->__error_code = -ret;
+#endif
+            }
+            else
+            {
+#ifdef HAVE_AIOCB_ERROR_CODE
+                req->cb_p->__error_code = 0;
+#endif
+#ifdef HAVE_AIOCB_RETURN_VALUE
+                req->cb_p->__return_value = ret;
+#endif
+            }
+
+            list = req->list;
+            if(--list->remaining == 0)
+            {
+                qlist_add_tail(&list->list_link, &done_list);
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        if(reaped)
+        {
+            gen_mutex_lock(&uring_mutex);
+            uring_inflight -= reaped;
+            uring_submit_locked();
+            gen_mutex_unlock(&uring_mutex);
+        }
+
+        /* run callbacks without any locks held; they may post more I/O */
+        qlist_for_each_entry_safe(list, tmp, &done_list, list_link)
+        {
+            qlist_del(&list->list_link);
+            list->sig->sigev_notify_function(list->sig->sigev_value);
+            free(list);
+        }
+    }
+
+    return(NULL);
+}
+
+static int uring_lio_listio(int mode, struct aiocb * const list[],
+                            int nent, struct sigevent *sig)
+{
+    struct uring_list *tmp_list;
+    int i;
+
+    /* dbpf only posts non blocking lists */
+    if(mode != LIO_NOWAIT || nent < 1)
+    {
+        errno = EINVAL;
+        return(-1);
+    }
+
+    tmp_list = (struct uring_list *)malloc(
+        sizeof(struct uring_list) + (nent - 1) * sizeof(struct uring_req));
+    if(!tmp_list)
+    {
+        errno = ENOMEM;
+        return(-1);
+    }
+    memset(tmp_list, 0, sizeof(struct uring_list));
+    tmp_list->sig = sig;
+    tmp_list->nent = nent;
+    tmp_list->remaining = nent;
+
+    for(i = 0; i < nent; i++)
+    {
+        /* this should have been caught already */
+        assert(list[i]->aio_lio_opcode == LIO_READ ||
+               list[i]->aio_lio_opcode == LIO_WRITE);
+
+        tmp_list->reqs[i].cb_p = list[i];
+        tmp_list->reqs[i].iov.iov_base = (void *)list[i]->aio_buf;
+        tmp_list->reqs[i].iov.iov_len = list[i]->aio_nbytes;
+        tmp_list->reqs[i].list = tmp_list;
+#ifdef HAVE_AIOCB_ERROR_CODE
+        list[i]->__error_code = EINPROGRESS;
+#endif
+    }
+
+    gossip_debug(GOSSIP_BSTREAM_DEBUG, "[io-uring]: queueing %d aiocbs "
+                 "on fd %d\n", nent, list[0]->aio_fildes);
+
+    gen_mutex_lock(&uring_mutex);
+    qlist_add_tail(&tmp_list->list_link, &uring_backlog);
+    uring_submit_locked();
+    gen_mutex_unlock(&uring_mutex);
+
+    return(0);
+}
+
+static int uring_aio_error(const struct aiocb *aiocbp)
+{
+#ifdef HAVE_AIOCB_ERROR_CODE
+    return aiocbp->__error_code;
+#else
+    return 0;
+#endif
+}
+
+static ssize_t uring_aio_return(struct aiocb *aiocbp)
+{
+#ifdef HAVE_AIOCB_RETURN_VALUE
+    return aiocbp->__return_value;
+#else
+    return 0;
+#endif
+}
+
+static int uring_aio_cancel(int filedesc, struct aiocb *aiocbp)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static int uring_aio_suspend(const struct aiocb * const list[], int nent,
+                             const struct timespec * timeout)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static int uring_aio_read(struct aiocb * aiocbp)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static int uring_aio_write(struct aiocb * aiocbp)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static int uring_aio_fsync(int operation, struct aiocb * aiocbp)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+static struct dbpf_aio_ops uring_aio_ops =
+{
+    uring_aio_read,
+    uring_aio_write,
+    uring_lio_listio,
+    uring_aio_error,
+    uring_aio_return,
+    uring_aio_cancel,
+    uring_aio_suspend,
+    uring_aio_fsync
+};
+
+#endif /* HAVE_IO_URING */
+
+/* uring_get_ops()
+ *
+ * starts the ring on first use
+ *
+ * returns the io_uring aio ops, or the alt-aio ones if io_uring can't
+ * be used
+ */
+static struct dbpf_aio_ops *uring_get_ops(void)
+{
+    enum uring_state state;
+#ifdef HAVE_IO_URING
+    int ret;
+#endif
+
+    gen_mutex_lock(&uring_mutex);
+    if(uring_state == URING_UNINITIALIZED)
+    {
+#ifdef HAVE_IO_URING
+        ret = uring_start();
+        if(ret < 0)
+        {
+            gossip_err("Warning: io_uring setup failed (%s); "
+                       "using alt-aio instead.\n", strerror(-ret));
+            uring_state = URING_FAILED;
+        }
+        else
+        {
+            uring_state = URING_RUNNING;
+        }
+#else
+        gossip_err("Warning: io_uring support not compiled in; "
+                   "using alt-aio instead.\n");
+        uring_state = URING_FAILED;
+#endif
+    }
+    state = uring_state;
+    gen_mutex_unlock(&uring_mutex);
+
+#ifdef HAVE_IO_URING
+    if(state == URING_RUNNING)
+    {
+        return(&uring_aio_ops);
+    }
+#endif
+    return(&alt_aio_ops);
+}
+
+/* dbpf_uring_finalize()
+ *
+ * stops the reaper thread and tears down the ring, if it was started.
+ * All I/O must have completed.
+ */
+void dbpf_uring_finalize(void)
+{
+#ifdef HAVE_IO_URING
+    struct io_uring_sqe *sqe;
+    unsigned index;
+
+    gen_mutex_lock(&uring_mutex);
+    if(uring_state != URING_RUNNING)
+    {
+        uring_state = URING_UNINITIALIZED;
+        gen_mutex_unlock(&uring_mutex);
+        return;
+    }
+
+    /* wake the reaper with a request that has no user data */
+    index = ring.sq_local_tail & ring.sq_mask;
+    sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    ring.sq_array[index] = index;
+    ring.sq_local_tail++;
+    uring_submit_locked();
+    gen_mutex_unlock(&uring_mutex);
+
+    pthread_join(uring_reaper, NULL);
+
+    gen_mutex_lock(&uring_mutex);
+    uring_unmap();
+    uring_files_registered = 0;
+    uring_state = URING_UNINITIALIZED;
+    gen_mutex_unlock(&uring_mutex);
+#else
+    gen_mutex_lock(&uring_mutex);
+    uring_state = URING_UNINITIALIZED;
+    gen_mutex_unlock(&uring_mutex);
+#endif
+}
+
+/* dbpf_uring_register_fd()
+ *
+ * called by the open cache after opening a bstream; installs the
+ * descriptor in the ring's file table at the slot matching its number
+ */
+void dbpf_uring_register_fd(int fd)
+{
+#ifdef HAVE_IO_URING
+    struct io_uring_files_update update;
+    int ret;
+
+    if(fd < 0 || fd >= DBPF_URING_MAX_FILES)
+    {
+        return;
+    }
+
+    gen_mutex_lock(&uring_mutex);
+    if(uring_state == URING_RUNNING && uring_files_registered)
+    {
+        memset(&update, 0, sizeof(update));
+        update.offset = fd;
+        update.fds = (unsigned long)&fd;
+        ret = sys_io_uring_register(ring.fd, IORING_REGISTER_FILES_UPDATE,
+                                    &update, 1);
+        uring_fixed[fd] = (ret == 1);
+    }
+    gen_mutex_unlock(&uring_mutex);
+#endif
+}
+
+/* dbpf_uring_unregister_fd()
+ *
+ * called by the open cache before closing a bstream, so that a later
+ * file that reuses the descriptor number is never reached via the old
+ * registration
+ */
+void dbpf_uring_unregister_fd(int fd)
+{
+#ifdef HAVE_IO_URING
+    struct io_uring_files_update update;
+    int empty = -1;
+    int ret;
+
+    if(fd < 0 || fd >= DBPF_URING_MAX_FILES)
+    {
+        return;
+    }
+
+    gen_mutex_lock(&uring_mutex);
+    if(uring_state == URING_RUNNING && uring_fixed[fd])
+    {
+        memset(&update, 0, sizeof(update));
+        update.offset = fd;
+        update.fds = (unsigned long)&empty;
+        ret = sys_io_uring_register(ring.fd, IORING_REGISTER_FILES_UPDATE,
+                                    &update, 1);
+        if(ret != 1)
+        {
+            gossip_err("[io-uring]: failed to unregister fd %d: %s\n",
+                       fd, strerror(errno));
+        }
+    }
+    uring_fixed[fd] = 0;
+    gen_mutex_unlock(&uring_mutex);
+#endif
+}
+
+static int uring_bstream_read_list(TROVE_coll_id coll_id,
+                                   TROVE_handle handle,
+                                   char **mem_offset_array,
+                                   TROVE_size *mem_size_array,
+                                   int mem_count,
+                                   TROVE_offset *stream_offset_array,
+                                   TROVE_size *stream_size_array,
+                                   int stream_count,
+                                   TROVE_size *out_size_p,
+                                   TROVE_ds_flags flags,
+                                   TROVE_vtag_s *vtag,
+                                   void *user_ptr,
+                                   TROVE_context_id context_id,
+                                   TROVE_op_id *out_op_id_p,
+                                   PVFS_hint  hints)
+{
+    return dbpf_bstream_rw_list(coll_id,
+                                handle,
+                                mem_offset_array,
+                                mem_size_array,
+                                mem_count,
+                                stream_offset_array,
+                                stream_size_array,
+                                stream_count,
+                                out_size_p,
+                                flags,
+                                vtag,
+                                user_ptr,
+                                context_id,
+                                out_op_id_p,
+                                LIO_READ,
+                                uring_get_ops(),
+                                hints);
+}
+
+static int uring_bstream_write_list(TROVE_coll_id coll_id,
+                                    TROVE_handle handle,
+                                    char **mem_offset_array,
+                                    TROVE_size *mem_size_array,
+                                    int mem_count,
+                                    TROVE_offset *stream_offset_array,
+                                    TROVE_size *stream_size_array,
+                                    int stream_count,
+                                    TROVE_size *out_size_p,
+                                    TROVE_ds_flags flags,
+                                    TROVE_vtag_s *vtag,
+                                    void *user_ptr,
+                                    TROVE_context_id context_id,
+                                    TROVE_op_id *out_op_id_p,
+                                    PVFS_hint  hints)
+{
+    return dbpf_bstream_rw_list(coll_id,
+                                handle,
+                                mem_offset_array,
+                                mem_size_array,
+                                mem_count,
+                                stream_offset_array,
+                                stream_size_array,
+                                stream_count,
+                                out_size_p,
+                                flags,
+                                vtag,
+                                user_ptr,
+                                context_id,
+                                out_op_id_p,
+                                LIO_WRITE,
+                                uring_get_ops(),
+                                hints);
+}
+
+struct TROVE_bstream_ops uring_aio_bstream_ops =
+{
+    dbpf_bstream_read_at,
+    dbpf_bstream_write_at,
+    dbpf_bstream_resize,
+    dbpf_bstream_validate,
+    uring_bstream_read_list,
+    uring_bstream_write_list,
+    dbpf_bstream_flush,
+    NULL,
+    dbpf_bstream_fd_get,
+    dbpf_bstream_fd_put
+};
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
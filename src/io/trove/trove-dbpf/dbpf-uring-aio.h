@@ -0,0 +1,39 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+#ifndef __DBPF_URING_AIO_H__
+#define __DBPF_URING_AIO_H__
+
+#include "trove-internal.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* number of submission queue entries in the shared ring */
+#define DBPF_URING_QUEUE_DEPTH 256
+
+/* descriptors below this value may be registered with the ring */
+#define DBPF_URING_MAX_FILES 1024
+
+void dbpf_uring_finalize(void);
+void dbpf_uring_register_fd(int fd);
+void dbpf_uring_unregister_fd(int fd);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
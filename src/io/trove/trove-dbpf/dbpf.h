@@ -570,6 +570,17 @@ enum dbpf_op_type
      __op == DSPACE_REMOVE      || \
      __op == DSPACE_SETATTR)
 
+/* ops that only read the databases; with TroveMetaReadThreads these
+ * are serviced by the read threads instead of the trove thread */
+#define DBPF_OP_IS_READ_ONLY(__op, __flags)                   \
+    (__op == KEYVAL_READ                                   || \
+     __op == KEYVAL_READ_LIST                              || \
+     __op == KEYVAL_GET_HANDLE_INFO                        || \
+     __op == DSPACE_GETATTR                                || \
+     __op == DSPACE_GETATTR_LIST                           || \
+     ((__op == KEYVAL_ITERATE || __op == KEYVAL_ITERATE_KEYS) && \
+      !((__flags) & TROVE_KEYVAL_ITERATE_REMOVE)))
+
 /*
   a function useful for debugging that returns a human readable
   op_type name given an op_type; returns NULL if no match is found
@@ -858,6 +869,14 @@ int dbpf_bstream_validate(TROVE_coll_id coll_id,
                           TROVE_op_id *out_op_id_p,
                           PVFS_hint  hints);
 
+int dbpf_bstream_fd_get(TROVE_coll_id coll_id,
+                        TROVE_handle handle,
+                        int *out_fd_p,
+                        void **out_ref_p);
+
+void dbpf_bstream_fd_put(TROVE_coll_id coll_id,
+                         void *ref);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -44,8 +44,13 @@ static void extent_count(
 static TROVE_handle avltree_extent_search_in_range(
     struct avlnode *n,
     TROVE_extent *req_extent);
+static void extent_copy(
+    struct avlnode *n,
+    int param, int depth);
 
 static uint64_t g_counter = 0;
+static TROVE_extent *g_copy_array = NULL;
+static uint64_t g_copy_max = 0;
 
 /* constructor for an extent 
  * first: start of extent range
@@ -480,6 +485,37 @@ void extentlist_count(
     *count = g_counter;
 }
 
+/*
+ * copies up to 'max' extents of the list into 'out' (which may be NULL
+ * to just count them) and returns the number of extents in the list.
+ * like extentlist_count, this relies on the trove-handle-mgmt layer to
+ * serialize calls.
+ */
+uint64_t extentlist_copy_extents(
+    struct TROVE_handle_extentlist *elist,
+    TROVE_extent *out,
+    uint64_t max)
+{
+    g_counter = 0;
+    g_copy_array = out;
+    g_copy_max = (out ? max : 0);
+    avldepthfirst(elist->index, extent_copy, 0, 0);
+    g_copy_array = NULL;
+    return g_counter;
+}
+
+static void extent_copy(struct avlnode *n, int param, int depth)
+{
+    struct TROVE_handle_extent *e = (struct TROVE_handle_extent *)(n->d);
+
+    if (g_counter < g_copy_max)
+    {
+        g_copy_array[g_counter].first = e->first;
+        g_copy_array[g_counter].last = e->last;
+    }
+    g_counter++;
+}
+
 static void extent_show(struct avlnode *n, int param, int depth)
 {
     struct TROVE_handle_extent *e __attribute__((unused)) =
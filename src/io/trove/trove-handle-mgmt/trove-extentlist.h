@@ -88,6 +88,10 @@ void extentlist_count(
     uint64_t* count);
 void extentlist_stats(
     struct TROVE_handle_extentlist *elist); 
+uint64_t extentlist_copy_extents(
+    struct TROVE_handle_extentlist *elist,
+    TROVE_extent *out,
+    uint64_t max);
 int extentlist_hit_cutoff(
     struct TROVE_handle_extentlist *elist,
     TROVE_handle cutoff);
@@ -7,8 +7,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <assert.h>
 #include <sys/time.h>
+#ifdef __PVFS2_TROVE_THREADED__
+#include <pthread.h>
+#endif
 
 #include "trove.h"
 #include "quickhash.h"
@@ -28,11 +32,59 @@ typedef struct
     struct qlist_head hash_link;
 
     TROVE_coll_id coll_id;
+    TROVE_context_id context_id;
     int have_valid_ranges;
 
     struct handle_ledger *ledger;
+
+    /*
+      snapshot state: the ranges the ledger was built from, whether the
+      ledger matches the collection (no scan is pending), and whether
+      it changed since the last snapshot was written
+    */
+    char *handle_range_str;
+    int verified;
+    int dirty;
+    int checkpoint_secs;
+
+#ifdef __PVFS2_TROVE_THREADED__
+    pthread_t thread;
+    gen_cond_t thread_cond;
+    int thread_running;
+    int thread_stop;
+    int scan_pending;
+
+    /*
+      while a scan is pending, the ledger it is rebuilding from the
+      valid ranges.  every handle the live ledger allocates or frees
+      from the time the snapshot is loaded is applied to it as well,
+      so that it can replace the live ledger once the scan is done.
+    */
+    struct handle_ledger *scan_ledger;
+#endif
 } handle_ledger_t;
 
+/*
+  the free extents of each ledger are saved in the collection attribute
+  space under this key, as a header, the handle range string the ledger
+  was built from, then the extents themselves.  A snapshot is only
+  trusted on its own if it was written by a clean shutdown; on startup
+  it is immediately overwritten by one that is not, so that a crash
+  falls back to scanning the collection.
+*/
+#define HANDLE_LEDGER_KEYSTR       "handle_ledger"
+#define HANDLE_LEDGER_MAGIC        0x4c444752
+#define HANDLE_LEDGER_VERSION      1
+
+struct handle_ledger_snapshot
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t clean;
+    uint32_t range_len;         /* padded length of the range string */
+    uint64_t extent_count;
+};
+
 static struct qhash_table *s_fsid_to_ledger_table = NULL;
 
 /* these are based on code from src/server/request-scheduler.c */
@@ -41,6 +93,16 @@ static int hash_fsid_compare(const void *key, struct qlist_head *link);
 
 static gen_mutex_t trove_handle_mutex = GEN_MUTEX_INITIALIZER;
 
+#ifdef __PVFS2_TROVE_THREADED__
+static void *handle_ledger_thread_function(void *ptr);
+static void handle_ledger_stop_thread(handle_ledger_t *ledger);
+static int handle_ledger_rebuild(handle_ledger_t *ledger,
+                                 TROVE_context_id context_id,
+                                 PINT_llist *extent_list);
+static void handle_ledger_track(handle_ledger_t *ledger,
+                                TROVE_handle handle, int freed);
+#endif
+
 /* trove_check_handle_ranges:
  *  internal function to verify that handles
  *  on disk match our assigned handles.
@@ -49,23 +111,34 @@ static gen_mutex_t trove_handle_mutex = GEN_MUTEX_INITIALIZER;
  * coll_id: id of collection which we will verify
  * extent_list: llist of legal handle ranges/extents
  * ledger: a book-keeping ledger object
+ * stop: NULL, or if the scan is rebuilding a ledger while the
+ *  collection is in use, a flag that cancels the scan when set.  The
+ *  handle mutex is then taken around each batch rather than held by
+ *  the caller, handles that were allocated since the scan began are
+ *  already out of the ledger, and out of range handles are reported
+ *  but not fatal.
  *
  * returns 0 on success; -1 otherwise
  */
 static int trove_check_handle_ranges(TROVE_coll_id coll_id,
                                      TROVE_context_id context_id,
                                      PINT_llist *extent_list,
-                                     struct handle_ledger *ledger)
+                                     struct handle_ledger *ledger,
+                                     int *stop)
 {
-    int ret = -1, i = 0, count = 0, op_count = 0;
+    int ret = -1, i = 0, count = 0, op_count = 0, invalid = 0;
     TROVE_op_id op_id = 0;
     TROVE_ds_state state = 0;
     TROVE_ds_position pos = TROVE_ITERATE_START;
-    static TROVE_handle handles[MAX_NUM_VERIFY_HANDLE_COUNT] =
-        {TROVE_HANDLE_NULL};
+    TROVE_handle *handles = NULL;
 
     if (extent_list && ledger)
     {
+        handles = malloc(MAX_NUM_VERIFY_HANDLE_COUNT * sizeof(TROVE_handle));
+        if (!handles)
+        {
+            return -TROVE_ENOMEM;
+        }
         count = MAX_NUM_VERIFY_HANDLE_COUNT;
 
         while(count > 0)
@@ -85,7 +158,7 @@ static int trove_check_handle_ranges(TROVE_coll_id coll_id,
             {
                 gossip_debug(GOSSIP_TROVE_DEBUG,
                              "dspace test of iterate_handles failed\n");
-                return ret;
+                break;
             }
 
             ret = 0;
@@ -97,7 +170,8 @@ static int trove_check_handle_ranges(TROVE_coll_id coll_id,
             {
                 gossip_debug(GOSSIP_TROVE_DEBUG,
                              "trove_dspace_iterate_handles failed\n");
-                return state;
+                ret = state;
+                break;
             }
 
             /* look for special case of a blank fs */
@@ -105,11 +179,21 @@ static int trove_check_handle_ranges(TROVE_coll_id coll_id,
             {
                 gossip_debug(GOSSIP_TROVE_DEBUG,
                              "* Trove: Assuming a blank filesystem\n");
-                return ret;
+                break;
             }
 
             if (count > 0)
             {
+                if (stop)
+                {
+                    gen_mutex_lock(&trove_handle_mutex);
+                    if (*stop)
+                    {
+                        gen_mutex_unlock(&trove_handle_mutex);
+                        ret = -TROVE_ECANCEL;
+                        break;
+                    }
+                }
                 for(i = 0; i != count; i++)
                 {
                     /* check every item in our range list */
@@ -119,25 +203,272 @@ static int trove_check_handle_ranges(TROVE_coll_id coll_id,
                         gossip_err(
                             "Error: handle %llu is invalid "
                             "(out of bounds)\n", llu(handles[i]));
-                        return -1;
+                        if (stop)
+                        {
+                            continue;
+                        }
+                        invalid = 1;
+                        break;
                     }
 
 		    /* remove handle from trove-handle-mgmt */
 		    ret = trove_handle_remove(ledger, handles[i]);
-		    if (ret != 0)
+		    if ((ret != 0) && !stop)
                     {
 			gossip_err(
                             "WARNING: could not remove "
                             "handle %llu from ledger; continuing.\n", llu(handles[i]));
 		    }
                 }
-                ret = ((i == count) ? 0 : -1);
+                if (stop)
+                {
+                    gen_mutex_unlock(&trove_handle_mutex);
+                    ret = 0;
+                }
+                else if (invalid)
+                {
+                    ret = -1;
+                    break;
+                }
+                else
+                {
+                    ret = ((i == count) ? 0 : -1);
+                }
             }
         }
+        free(handles);
     }
     return ret;
 }
 
+/* handle_ledger_snapshot_build:
+ *  packs the free extents of a ledger into a snapshot buffer.  called
+ *  with the handle mutex held.
+ *
+ * returns 0 on success, -TROVE_ENOMEM otherwise
+ */
+static int handle_ledger_snapshot_build(handle_ledger_t *ledger,
+                                        int clean,
+                                        void **buffer,
+                                        int *buffer_sz)
+{
+    int ret;
+    uint64_t count = 0;
+    uint32_t range_len;
+    size_t total;
+    TROVE_extent *extents = NULL;
+    struct handle_ledger_snapshot *snap;
+
+    ret = trove_handle_ledger_get_extents(ledger->ledger, &extents, &count);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    range_len = strlen(ledger->handle_range_str) + 1;
+    range_len = (range_len + 7) & ~7;
+    total = sizeof(*snap) + range_len + (count * sizeof(TROVE_extent));
+    snap = calloc(1, total);
+    if (!snap)
+    {
+        free(extents);
+        return -TROVE_ENOMEM;
+    }
+
+    snap->magic = HANDLE_LEDGER_MAGIC;
+    snap->version = HANDLE_LEDGER_VERSION;
+    snap->clean = clean;
+    snap->range_len = range_len;
+    snap->extent_count = count;
+    strcpy((char *)(snap + 1), ledger->handle_range_str);
+    memcpy((char *)(snap + 1) + range_len, extents,
+           count * sizeof(TROVE_extent));
+    free(extents);
+
+    *buffer = snap;
+    *buffer_sz = (int)total;
+    return 0;
+}
+
+/* handle_ledger_snapshot_store:
+ *  writes a snapshot built by handle_ledger_snapshot_build to the
+ *  collection.  must be called without the handle mutex held, since
+ *  the storage layer may itself be waiting on a handle allocation.
+ *
+ * returns 0 on success, negative error code otherwise
+ */
+static int handle_ledger_snapshot_store(TROVE_coll_id coll_id,
+                                        TROVE_context_id context_id,
+                                        void *buffer,
+                                        int buffer_sz)
+{
+    int ret, count = 0;
+    TROVE_op_id op_id = 0;
+    TROVE_ds_state state = 0;
+    TROVE_keyval_s key, val;
+
+    memset(&key, 0, sizeof(key));
+    memset(&val, 0, sizeof(val));
+    key.buffer = HANDLE_LEDGER_KEYSTR;
+    key.buffer_sz = sizeof(HANDLE_LEDGER_KEYSTR);
+    val.buffer = buffer;
+    val.buffer_sz = buffer_sz;
+
+    ret = trove_collection_seteattr(coll_id, &key, &val, 0, NULL,
+                                    context_id, &op_id);
+    while (ret == 0)
+    {
+        ret = trove_dspace_test(coll_id, op_id, context_id, &count,
+                                NULL, NULL, &state,
+                                TROVE_DEFAULT_TEST_TIMEOUT);
+    }
+    if (ret < 0)
+    {
+        gossip_err("Error: failed to save handle ledger of "
+                   "collection %d\n", (int)coll_id);
+        return ret;
+    }
+    return 0;
+}
+
+/* handle_ledger_snapshot_write:
+ *  saves the current state of a ledger.  called with the handle mutex
+ *  held, which is dropped while the snapshot is written.
+ */
+static int handle_ledger_snapshot_write(handle_ledger_t *ledger,
+                                        TROVE_context_id context_id,
+                                        int clean)
+{
+    int ret, buffer_sz = 0;
+    void *buffer = NULL;
+
+    ret = handle_ledger_snapshot_build(ledger, clean, &buffer, &buffer_sz);
+    if (ret != 0)
+    {
+        return ret;
+    }
+    ledger->dirty = 0;
+
+    gen_mutex_unlock(&trove_handle_mutex);
+    ret = handle_ledger_snapshot_store(
+        ledger->coll_id, context_id, buffer, buffer_sz);
+    gen_mutex_lock(&trove_handle_mutex);
+    free(buffer);
+
+    if (ret != 0)
+    {
+        ledger->dirty = 1;
+    }
+    else
+    {
+        gossip_debug(GOSSIP_TROVE_DEBUG, "saved %s handle ledger of "
+                     "collection %d (%d bytes)\n",
+                     (clean ? "clean" : "working"), (int)ledger->coll_id,
+                     buffer_sz);
+    }
+    return ret;
+}
+
+/* handle_ledger_snapshot_read:
+ *  reads the saved snapshot of a collection, if any, and checks it was
+ *  taken with the same handle ranges.  on success, the caller frees
+ *  *extents.
+ *
+ * returns 0 on success, -TROVE_ENOENT if there is no usable snapshot
+ */
+static int handle_ledger_snapshot_read(TROVE_coll_id coll_id,
+                                       TROVE_context_id context_id,
+                                       char *handle_range_str,
+                                       TROVE_extent **extents,
+                                       uint64_t *extent_count,
+                                       int *clean)
+{
+    int ret, count = 0;
+    TROVE_op_id op_id = 0;
+    TROVE_ds_state state = 0;
+    TROVE_keyval_s key, val;
+    struct handle_ledger_snapshot header, *snap = NULL;
+    size_t total;
+
+    memset(&key, 0, sizeof(key));
+    memset(&val, 0, sizeof(val));
+    key.buffer = HANDLE_LEDGER_KEYSTR;
+    key.buffer_sz = sizeof(HANDLE_LEDGER_KEYSTR);
+
+    /* read the header first to learn how large the snapshot is */
+    val.buffer = &header;
+    val.buffer_sz = sizeof(header);
+    ret = trove_collection_geteattr(coll_id, &key, &val, 0, NULL,
+                                    context_id, &op_id);
+    while (ret == 0)
+    {
+        ret = trove_dspace_test(coll_id, op_id, context_id, &count,
+                                NULL, NULL, &state,
+                                TROVE_DEFAULT_TEST_TIMEOUT);
+    }
+    if (ret < 0 || val.read_sz < (int)sizeof(header))
+    {
+        return -TROVE_ENOENT;
+    }
+
+    total = sizeof(header) + header.range_len +
+        (header.extent_count * sizeof(TROVE_extent));
+    if (header.magic != HANDLE_LEDGER_MAGIC ||
+        header.version != HANDLE_LEDGER_VERSION ||
+        (size_t)val.read_sz != total)
+    {
+        gossip_err("Warning: ignoring invalid handle ledger snapshot "
+                   "of collection %d\n", (int)coll_id);
+        return -TROVE_ENOENT;
+    }
+
+    snap = malloc(total);
+    if (!snap)
+    {
+        return -TROVE_ENOMEM;
+    }
+    val.buffer = snap;
+    val.buffer_sz = total;
+    ret = trove_collection_geteattr(coll_id, &key, &val, 0, NULL,
+                                    context_id, &op_id);
+    while (ret == 0)
+    {
+        ret = trove_dspace_test(coll_id, op_id, context_id, &count,
+                                NULL, NULL, &state,
+                                TROVE_DEFAULT_TEST_TIMEOUT);
+    }
+    if (ret < 0 || (size_t)val.read_sz != total ||
+        memcmp(snap, &header, sizeof(header)) != 0)
+    {
+        free(snap);
+        return -TROVE_ENOENT;
+    }
+
+    /* a snapshot taken with other handle ranges tells us nothing */
+    if (strncmp((char *)(snap + 1), handle_range_str, snap->range_len) != 0)
+    {
+        gossip_debug(GOSSIP_TROVE_DEBUG, "handle ranges of collection %d "
+                     "changed; ignoring handle ledger snapshot\n",
+                     (int)coll_id);
+        free(snap);
+        return -TROVE_ENOENT;
+    }
+
+    *extents = malloc((snap->extent_count ? snap->extent_count : 1) *
+                      sizeof(TROVE_extent));
+    if (!*extents)
+    {
+        free(snap);
+        return -TROVE_ENOMEM;
+    }
+    memcpy(*extents, (char *)(snap + 1) + snap->range_len,
+           snap->extent_count * sizeof(TROVE_extent));
+    *extent_count = snap->extent_count;
+    *clean = snap->clean;
+    free(snap);
+    return 0;
+}
+
 static int trove_map_handle_ranges( PINT_llist *extent_list,
                                    struct handle_ledger *ledger)
 {
@@ -192,8 +523,10 @@ static handle_ledger_t *get_or_add_handle_ledger(TROVE_coll_id coll_id)
         ledger = (handle_ledger_t *)malloc(sizeof(handle_ledger_t));
         if (ledger)
         {
+            memset(ledger, 0, sizeof(handle_ledger_t));
             ledger->coll_id = coll_id;
             ledger->have_valid_ranges = 0;
+            ledger->checkpoint_secs = TROVE_DEFAULT_HANDLE_CHECKPOINT_SEC;
             ledger->ledger = trove_handle_ledger_init(coll_id,NULL);
             if (ledger->ledger)
             {
@@ -272,6 +605,94 @@ int trove_handle_mgmt_initialize()
     return ret;
 }
 
+/* trove_load_handle_ranges:
+ *  takes the handles in use out of a ledger that has just been given
+ *  its valid ranges: by replacing its free extents with the saved
+ *  snapshot if there is a usable one (to be rebuilt in the background
+ *  if it is a working one), and by scanning the collection otherwise.
+ *  called with the handle mutex held.
+ *
+ * returns 0 on success, nonzero otherwise
+ */
+static int trove_load_handle_ranges(handle_ledger_t *ledger,
+                                    TROVE_context_id context_id,
+                                    PINT_llist *extent_list,
+                                    char *handle_range_str)
+{
+    int ret, clean = 0;
+    TROVE_extent *extents = NULL;
+    uint64_t extent_count = 0;
+
+    ret = handle_ledger_snapshot_read(ledger->coll_id, context_id,
+                                      handle_range_str, &extents,
+                                      &extent_count, &clean);
+#ifndef __PVFS2_TROVE_THREADED__
+    /* without a thread to verify it, only a clean snapshot will do */
+    if ((ret == 0) && !clean)
+    {
+        free(extents);
+        ret = -TROVE_ENOENT;
+    }
+#endif
+    if (ret == 0)
+    {
+        ret = trove_handle_ledger_set_extents(
+            ledger->ledger, extents, extent_count);
+        free(extents);
+        if (ret != 0)
+        {
+            return ret;
+        }
+
+        gossip_debug(GOSSIP_TROVE_DEBUG, "loaded %s handle ledger of "
+                     "collection %d (%llu extents)\n",
+                     (clean ? "clean" : "working"), (int)ledger->coll_id,
+                     llu(extent_count));
+        ledger->verified = clean;
+#ifdef __PVFS2_TROVE_THREADED__
+        /*
+          a working snapshot may still count handles created after it
+          was taken as free, and handles freed after it as in use.  the
+          ledger thread rebuilds the ledger by scanning the collection
+          while it is in use, so start tracking changes now.
+        */
+        if (!clean)
+        {
+            ledger->scan_ledger =
+                trove_handle_ledger_init(ledger->coll_id, NULL);
+            if (!ledger->scan_ledger)
+            {
+                return -TROVE_ENOMEM;
+            }
+            ret = trove_map_handle_ranges(extent_list, ledger->scan_ledger);
+            if (ret != 0)
+            {
+                trove_handle_ledger_free(ledger->scan_ledger);
+                ledger->scan_ledger = NULL;
+                return ret;
+            }
+            ledger->scan_pending = 1;
+        }
+#endif
+        return 0;
+    }
+    else if (ret != -TROVE_ENOENT)
+    {
+        return ret;
+    }
+
+    gossip_debug(GOSSIP_TROVE_DEBUG, "no usable handle ledger snapshot of "
+                 "collection %d; scanning all handles\n",
+                 (int)ledger->coll_id);
+    ret = trove_check_handle_ranges(
+        ledger->coll_id, context_id, extent_list, ledger->ledger, NULL);
+    if (ret == 0)
+    {
+        ledger->verified = 1;
+    }
+    return ret;
+}
+
 int trove_set_handle_ranges(TROVE_coll_id coll_id,
                             TROVE_context_id context_id,
                             char *handle_range_str)
@@ -295,27 +716,89 @@ int trove_set_handle_ranges(TROVE_coll_id coll_id,
             {
                 /* assert the internal ledger struct is valid */
                 assert(ledger->ledger);
-		
+
+                ledger->context_id = context_id;
+                free(ledger->handle_range_str);
+                ledger->handle_range_str = strdup(handle_range_str);
+                if (!ledger->handle_range_str)
+                {
+                    PINT_release_extent_list(extent_list);
+                    gen_mutex_unlock(&trove_handle_mutex);
+                    return -TROVE_ENOMEM;
+                }
+
 		/* tell trove what are our valid ranges are */
 		ret = trove_map_handle_ranges(
                     extent_list, ledger->ledger);
 		if (ret != 0)
                 {
+                    PINT_release_extent_list(extent_list);
                     gen_mutex_unlock(&trove_handle_mutex);
                     return ret;
                 }
 
-                ret = trove_check_handle_ranges(
-                    coll_id,context_id,extent_list,ledger->ledger);
+                ret = trove_load_handle_ranges(
+                    ledger, context_id, extent_list, handle_range_str);
 		if (ret != 0)
                 {
+                    PINT_release_extent_list(extent_list);
                     gen_mutex_unlock(&trove_handle_mutex);
                     return ret;
                 }
-                else
+
+                /*
+                  replace the snapshot straight away with one that is
+                  not marked clean, so that if we crash from here on
+                  the next startup does not trust it blindly.  if that
+                  fails the clean one would be trusted, so give up.
+                */
+                ret = handle_ledger_snapshot_write(ledger, context_id, 0);
+                if (ret != 0)
+                {
+#ifdef __PVFS2_TROVE_THREADED__
+                    if (ledger->scan_ledger)
+                    {
+                        trove_handle_ledger_free(ledger->scan_ledger);
+                        ledger->scan_ledger = NULL;
+                    }
+                    ledger->scan_pending = 0;
+#endif
+                    PINT_release_extent_list(extent_list);
+                    gen_mutex_unlock(&trove_handle_mutex);
+                    return ret;
+                }
+                ledger->have_valid_ranges = 1;
+
+#ifdef __PVFS2_TROVE_THREADED__
+                if (!ledger->thread_running)
                 {
-                    ledger->have_valid_ranges = 1;
+                    ledger->thread_stop = 0;
+                    gen_cond_init(&ledger->thread_cond);
+                    if (pthread_create(&ledger->thread, NULL,
+                                       handle_ledger_thread_function,
+                                       ledger) == 0)
+                    {
+                        ledger->thread_running = 1;
+                    }
+                    else
+                    {
+                        gossip_err("Warning: failed to start handle "
+                                   "ledger thread of collection %d\n",
+                                   (int)coll_id);
+                        gen_cond_destroy(&ledger->thread_cond);
+                        if (ledger->scan_pending)
+                        {
+                            /* rebuild the ledger the slow way */
+                            ledger->scan_pending = 0;
+                            gen_mutex_unlock(&trove_handle_mutex);
+                            handle_ledger_rebuild(
+                                ledger, context_id, extent_list);
+                            gen_mutex_lock(&trove_handle_mutex);
+                            ret = 0;
+                        }
+                    }
                 }
+#endif
             }
             PINT_release_extent_list(extent_list);
         }
@@ -324,6 +807,236 @@ int trove_set_handle_ranges(TROVE_coll_id coll_id,
     return ret;
 }
 
+/*
+ * trove_set_handle_checkpoint: controls how often the handle ledger
+ * is saved to the collection while the server runs, in seconds.  0
+ * means it is only saved at startup and shutdown.
+ */
+int trove_set_handle_checkpoint(TROVE_coll_id coll_id,
+                                TROVE_context_id context_id,
+                                int seconds)
+{
+    int ret = -1;
+    handle_ledger_t *ledger = NULL;
+
+    gen_mutex_lock(&trove_handle_mutex);
+    ledger = get_or_add_handle_ledger(coll_id);
+    if (ledger)
+    {
+        ledger->checkpoint_secs = ((seconds < 0) ? 0 : seconds);
+#ifdef __PVFS2_TROVE_THREADED__
+        if (ledger->thread_running)
+        {
+            gen_cond_signal(&ledger->thread_cond);
+        }
+#endif
+        gossip_debug(GOSSIP_TROVE_DEBUG, "- set handle ledger checkpoint "
+                     "interval to %d seconds\n", ledger->checkpoint_secs);
+        ret = 0;
+    }
+    gen_mutex_unlock(&trove_handle_mutex);
+    return ret;
+}
+
+/*
+ * trove_handle_mgmt_flush: saves the handle ledger of a collection
+ * that is being closed.  The snapshot is marked clean, so the next
+ * startup can load it without scanning the collection, unless a scan
+ * of the ledger was still outstanding.
+ */
+int trove_handle_mgmt_flush(TROVE_coll_id coll_id)
+{
+    int ret = 0;
+    handle_ledger_t *ledger = NULL;
+    struct qlist_head *hash_link = NULL;
+
+    gen_mutex_lock(&trove_handle_mutex);
+    if (s_fsid_to_ledger_table)
+    {
+        hash_link = qhash_search(s_fsid_to_ledger_table,&(coll_id));
+    }
+    if (hash_link)
+    {
+        ledger = qlist_entry(hash_link, handle_ledger_t, hash_link);
+#ifdef __PVFS2_TROVE_THREADED__
+        handle_ledger_stop_thread(ledger);
+#endif
+        if (ledger->have_valid_ranges == 1)
+        {
+            ret = handle_ledger_snapshot_write(
+                ledger, ledger->context_id, ledger->verified);
+        }
+    }
+    gen_mutex_unlock(&trove_handle_mutex);
+    return ret;
+}
+
+#ifdef __PVFS2_TROVE_THREADED__
+/*
+ * handle_ledger_track: applies an allocation or free of a handle in
+ * the live ledger to the scan ledger, if a scan is rebuilding one.  a
+ * freed handle goes straight to the scan ledger's purgatory, where
+ * the scan finding it before it was removed from disk cannot take it
+ * back out.  called with the handle mutex held.
+ */
+static void handle_ledger_track(handle_ledger_t *ledger,
+                                TROVE_handle handle, int freed)
+{
+    if (!ledger->scan_ledger || (handle == TROVE_HANDLE_NULL))
+    {
+        return;
+    }
+    trove_handle_remove(ledger->scan_ledger, handle);
+    if (freed)
+    {
+        trove_ledger_handle_free(ledger->scan_ledger, handle);
+    }
+}
+
+/*
+ * handle_ledger_rebuild: scans the collection into the scan ledger of
+ * a ledger loaded from a working snapshot and, if the scan completes,
+ * makes it the live ledger.  Otherwise the scan ledger is dropped and
+ * the ledger stays unverified, so it is never saved as clean.  called
+ * without the handle mutex held.
+ *
+ * returns 0 on success, nonzero otherwise
+ */
+static int handle_ledger_rebuild(handle_ledger_t *ledger,
+                                 TROVE_context_id context_id,
+                                 PINT_llist *extent_list)
+{
+    int ret;
+
+    ret = trove_check_handle_ranges(
+        ledger->coll_id, context_id, extent_list, ledger->scan_ledger,
+        &ledger->thread_stop);
+
+    gen_mutex_lock(&trove_handle_mutex);
+    if (ret == 0)
+    {
+        trove_handle_ledger_free(ledger->ledger);
+        ledger->ledger = ledger->scan_ledger;
+        ledger->verified = 1;
+        ledger->dirty = 1;
+    }
+    else
+    {
+        trove_handle_ledger_free(ledger->scan_ledger);
+    }
+    ledger->scan_ledger = NULL;
+    gen_mutex_unlock(&trove_handle_mutex);
+    return ret;
+}
+
+/*
+ * handle_ledger_thread_function: rebuilds a ledger loaded from a
+ * working snapshot, then saves the ledger every checkpoint_secs
+ * seconds while it is changing.
+ */
+static void *handle_ledger_thread_function(void *ptr)
+{
+    int ret;
+    handle_ledger_t *ledger = (handle_ledger_t *)ptr;
+    TROVE_context_id context_id;
+    PINT_llist *extent_list = NULL;
+    struct timeval now;
+    struct timespec timeout;
+
+    ret = trove_open_context(ledger->coll_id, &context_id);
+    if (ret < 0)
+    {
+        gossip_err("Warning: handle ledger thread of collection %d "
+                   "could not open a trove context\n", (int)ledger->coll_id);
+        return NULL;
+    }
+
+    gen_mutex_lock(&trove_handle_mutex);
+    if (ledger->scan_pending)
+    {
+        extent_list = PINT_create_extent_list(ledger->handle_range_str);
+        gen_mutex_unlock(&trove_handle_mutex);
+
+        gossip_debug(GOSSIP_TROVE_DEBUG, "scanning handles of collection "
+                     "%d in the background\n", (int)ledger->coll_id);
+        if (extent_list)
+        {
+            ret = handle_ledger_rebuild(ledger, context_id, extent_list);
+            PINT_release_extent_list(extent_list);
+        }
+        else
+        {
+            gen_mutex_lock(&trove_handle_mutex);
+            trove_handle_ledger_free(ledger->scan_ledger);
+            ledger->scan_ledger = NULL;
+            gen_mutex_unlock(&trove_handle_mutex);
+            ret = -TROVE_ENOMEM;
+        }
+
+        gen_mutex_lock(&trove_handle_mutex);
+        ledger->scan_pending = 0;
+        if (ret == 0)
+        {
+            gossip_debug(GOSSIP_TROVE_DEBUG, "background handle scan of "
+                         "collection %d complete\n", (int)ledger->coll_id);
+        }
+        else if (ret != -TROVE_ECANCEL)
+        {
+            gossip_err("Warning: background handle scan of collection %d "
+                       "failed; it will be repeated at next startup\n",
+                       (int)ledger->coll_id);
+        }
+    }
+
+    while (!ledger->thread_stop)
+    {
+        if (ledger->checkpoint_secs > 0)
+        {
+            gettimeofday(&now, NULL);
+            timeout.tv_sec = now.tv_sec + ledger->checkpoint_secs;
+            timeout.tv_nsec = now.tv_usec * 1000;
+            ret = gen_cond_timedwait(&ledger->thread_cond,
+                                     &trove_handle_mutex, &timeout);
+        }
+        else
+        {
+            ret = gen_cond_wait(&ledger->thread_cond, &trove_handle_mutex);
+        }
+
+        if (!ledger->thread_stop && (ret == ETIMEDOUT) && ledger->dirty)
+        {
+            handle_ledger_snapshot_write(ledger, context_id, 0);
+        }
+    }
+    gen_mutex_unlock(&trove_handle_mutex);
+
+    trove_close_context(ledger->coll_id, context_id);
+    return NULL;
+}
+
+/*
+ * handle_ledger_stop_thread: stops the ledger thread of a collection,
+ * if it is running.  called with the handle mutex held, which is
+ * dropped while waiting for the thread to exit.
+ */
+static void handle_ledger_stop_thread(handle_ledger_t *ledger)
+{
+    if (!ledger->thread_running)
+    {
+        return;
+    }
+
+    ledger->thread_stop = 1;
+    gen_cond_signal(&ledger->thread_cond);
+    gen_mutex_unlock(&trove_handle_mutex);
+    pthread_join(ledger->thread, NULL);
+    gen_mutex_lock(&trove_handle_mutex);
+
+    gen_cond_destroy(&ledger->thread_cond);
+    ledger->thread_running = 0;
+}
+#endif
+
 /*
  * trove_set_handle_timeout: controls how long a handle, once freed,
  * will sit on the sidelines before returning to the pool of
@@ -374,6 +1087,10 @@ TROVE_handle trove_handle_alloc(TROVE_coll_id coll_id)
         if (ledger && (ledger->have_valid_ranges == 1))
         {
             handle = trove_ledger_handle_alloc(ledger->ledger);
+#ifdef __PVFS2_TROVE_THREADED__
+            handle_ledger_track(ledger, handle, 0);
+#endif
+            ledger->dirty = 1;
         }
     }
     gen_mutex_unlock(&trove_handle_mutex);
@@ -402,6 +1119,10 @@ TROVE_handle trove_handle_alloc_from_range(
                     ledger->ledger, &(extent_array->extent_array[i]));
                 if (handle != TROVE_HANDLE_NULL)
                 {
+#ifdef __PVFS2_TROVE_THREADED__
+                    handle_ledger_track(ledger, handle, 0);
+#endif
+                    ledger->dirty = 1;
                     break;
                 }
             }
@@ -501,6 +1222,10 @@ int trove_handle_set_used(TROVE_coll_id coll_id, TROVE_handle handle)
         if (ledger)
         {
             ret = trove_handle_remove(ledger->ledger,handle);
+#ifdef __PVFS2_TROVE_THREADED__
+            handle_ledger_track(ledger, handle, 0);
+#endif
+            ledger->dirty = 1;
         }
     }
     gen_mutex_unlock(&trove_handle_mutex);
@@ -521,6 +1246,10 @@ int trove_handle_free(TROVE_coll_id coll_id, TROVE_handle handle)
         if (ledger)
         {
             ret = trove_ledger_handle_free(ledger->ledger, handle);
+#ifdef __PVFS2_TROVE_THREADED__
+            handle_ledger_track(ledger, handle, 1);
+#endif
+            ledger->dirty = 1;
         }
     }
     gen_mutex_unlock(&trove_handle_mutex);
@@ -587,7 +1316,15 @@ int trove_handle_mgmt_finalize()
                 assert(ledger);
                 assert(ledger->ledger);
 
+#ifdef __PVFS2_TROVE_THREADED__
+                handle_ledger_stop_thread(ledger);
+                if (ledger->scan_ledger)
+                {
+                    trove_handle_ledger_free(ledger->scan_ledger);
+                }
+#endif
                 trove_handle_ledger_free(ledger->ledger);
+                free(ledger->handle_range_str);
                 free(ledger);
             }
         } while(hash_link);
@@ -11,6 +11,8 @@
 
 #define TROVE_DEFAULT_HANDLE_PURGATORY_SEC 360
 
+#define TROVE_DEFAULT_HANDLE_CHECKPOINT_SEC 300
+
 /*
   public methods.  all methods return -1 on error; 0 on success unless
   otherwise noted
@@ -27,6 +29,18 @@ int trove_set_handle_timeout(
     TROVE_context_id context_id,
     struct timeval * timeout);
 
+int trove_set_handle_checkpoint(
+    TROVE_coll_id coll_id,
+    TROVE_context_id context_id,
+    int seconds);
+
+/*
+  saves the handle ledger of a collection that is about to be closed,
+  so that the next startup need not scan the collection for handles in
+  use
+*/
+int trove_handle_mgmt_flush(TROVE_coll_id coll_id);
+
 /*
   returns a valid TROVE_handle on success and TROVE_HANDLE_NULL
   otherwise (e.g.. no more free handles)
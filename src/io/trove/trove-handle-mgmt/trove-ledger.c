@@ -235,6 +235,84 @@ void trove_handle_ledger_get_statistics(
 }
 
 
+/* trove_handle_ledger_get_extents()
+ *
+ * returns, in a newly allocated array the caller must free, every
+ * extent of handles the ledger does not consider in use: the free list
+ * plus the handles still sitting out their re-use timeout.  This is
+ * the set a full scan of the collection would rebuild after a restart.
+ *
+ * returns 0 on success, -TROVE_ENOMEM on failure
+ */
+int trove_handle_ledger_get_extents(
+    struct handle_ledger *hl,
+    TROVE_extent **extents,
+    uint64_t *count)
+{
+    uint64_t total = 0;
+    uint64_t n = 0;
+
+    total += extentlist_copy_extents(&(hl->free_list), NULL, 0);
+    total += extentlist_copy_extents(&(hl->recently_freed_list), NULL, 0);
+    total += extentlist_copy_extents(&(hl->overflow_list), NULL, 0);
+
+    /* always hand back a valid pointer, even for an exhausted ledger */
+    *extents = malloc((total ? total : 1) * sizeof(TROVE_extent));
+    if (!*extents)
+    {
+        return -TROVE_ENOMEM;
+    }
+
+    n += extentlist_copy_extents(&(hl->free_list), *extents, total);
+    n += extentlist_copy_extents(
+        &(hl->recently_freed_list), *extents + n, total - n);
+    n += extentlist_copy_extents(
+        &(hl->overflow_list), *extents + n, total - n);
+    assert(n == total);
+
+    *count = total;
+    return 0;
+}
+
+/* trove_handle_ledger_set_extents()
+ *
+ * replaces the contents of the ledger with the given free extents, as
+ * saved by trove_handle_ledger_get_extents.  The extents must not
+ * overlap.
+ *
+ * returns 0 on success, nonzero on error
+ */
+int trove_handle_ledger_set_extents(
+    struct handle_ledger *hl,
+    TROVE_extent *extents,
+    uint64_t count)
+{
+    uint64_t i;
+    int ret;
+
+    extentlist_free(&(hl->free_list));
+    extentlist_free(&(hl->recently_freed_list));
+    extentlist_free(&(hl->overflow_list));
+    if (extentlist_init(&(hl->free_list)) ||
+        extentlist_init(&(hl->recently_freed_list)) ||
+        extentlist_init(&(hl->overflow_list)))
+    {
+        return -TROVE_ENOMEM;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        ret = extentlist_addextent(&(hl->free_list),
+                                   extents[i].first, extents[i].last);
+        if (ret != 0)
+        {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+
 void trove_handle_ledger_show(struct handle_ledger *hl) 
 {
     gossip_debug(GOSSIP_TROVE_DEBUG, "====== free list\n");
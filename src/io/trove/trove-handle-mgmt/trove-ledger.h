@@ -74,6 +74,14 @@ int trove_ledger_set_timeout(
 void trove_handle_ledger_get_statistics(
     struct handle_ledger *hl,
     uint64_t *free_count);
+int trove_handle_ledger_get_extents(
+    struct handle_ledger *hl,
+    TROVE_extent **extents,
+    uint64_t *count);
+int trove_handle_ledger_set_extents(
+    struct handle_ledger *hl,
+    TROVE_extent *extents,
+    uint64_t count);
 #endif
 
 /*
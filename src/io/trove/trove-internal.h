@@ -115,6 +115,19 @@ struct TROVE_bstream_ops
          TROVE_coll_id coll_id,
          TROVE_op_id cancel_id,
          TROVE_context_id context_id);
+
+     /* optional; methods that cannot expose a buffered file
+      * descriptor for a bstream leave these NULL
+      */
+     int (*bstream_fd_get)(
+         TROVE_coll_id coll_id,
+         TROVE_handle handle,
+         int *out_fd_p,
+         void **out_ref_p);
+
+     void (*bstream_fd_put)(
+         TROVE_coll_id coll_id,
+         void *ref);
 };
 
 struct TROVE_keyval_ops
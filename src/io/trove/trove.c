@@ -34,6 +34,9 @@ struct PINT_perf_counter* PINT_server_tpc = NULL;
 
 int TROVE_shm_key_hint = 0;
 int TROVE_max_concurrent_io = 16;
+int TROVE_meta_batch_max_ops = 1;
+int TROVE_meta_batch_max_latency = 2000;
+int TROVE_meta_read_threads = 0;
 
 extern TROVE_method_callback global_trove_method_callback;
 
@@ -259,6 +262,43 @@ int trove_bstream_flush(
            hints);
 }
 
+/** Obtain a file descriptor that can be used to read the contents of a
+ *  bstream directly.  Returns -TROVE_ENOSYS if the storage method cannot
+ *  provide one.  The reference must be released with trove_bstream_fd_put().
+ */
+int trove_bstream_fd_get(
+    TROVE_coll_id coll_id,
+    TROVE_handle handle,
+    int *out_fd_p,
+    void **out_ref_p)
+{
+    TROVE_method_id method_id;
+    method_id = global_trove_method_callback(coll_id);
+    if (!bstream_method_table[method_id]->bstream_fd_get)
+    {
+        return -TROVE_ENOSYS;
+    }
+    return bstream_method_table[method_id]->bstream_fd_get(
+           coll_id,
+           handle,
+           out_fd_p,
+           out_ref_p);
+}
+
+/** Release a descriptor obtained with trove_bstream_fd_get().
+ */
+void trove_bstream_fd_put(
+    TROVE_coll_id coll_id,
+    void *ref)
+{
+    TROVE_method_id method_id;
+    method_id = global_trove_method_callback(coll_id);
+    if (bstream_method_table[method_id]->bstream_fd_put)
+    {
+        bstream_method_table[method_id]->bstream_fd_put(coll_id, ref);
+    }
+}
+
 /** Initiate read of a single keyword/value pair.
  */
 int trove_keyval_read(
@@ -1050,6 +1090,21 @@ int trove_collection_setinfo(
         TROVE_max_concurrent_io = *((int*)parameter);
         return(0);
     }
+    if(option == TROVE_META_BATCH_MAX_OPS)
+    {
+        TROVE_meta_batch_max_ops = *((int*)parameter);
+        return(0);
+    }
+    if(option == TROVE_META_BATCH_MAX_LATENCY)
+    {
+        TROVE_meta_batch_max_latency = *((int*)parameter);
+        return(0);
+    }
+    if(option == TROVE_META_READ_THREADS)
+    {
+        TROVE_meta_read_threads = *((int*)parameter);
+        return(0);
+    }
     method_id = global_trove_method_callback(coll_id);
     return mgmt_method_table[method_id]->collection_setinfo(
            method_id,
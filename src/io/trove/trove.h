@@ -76,6 +76,7 @@ enum
 {
     TROVE_COLLECTION_HANDLE_RANGES,
     TROVE_COLLECTION_HANDLE_TIMEOUT,
+    TROVE_COLLECTION_HANDLE_CHECKPOINT,
     TROVE_COLLECTION_ATTR_CACHE_KEYWORDS,
     TROVE_COLLECTION_ATTR_CACHE_SIZE,
     TROVE_COLLECTION_ATTR_CACHE_MAX_NUM_ELEMS,
@@ -88,7 +89,10 @@ enum
     TROVE_COLLECTION_IMMEDIATE_COMPLETION,
     TROVE_DIRECTIO_THREADS_NUM,
     TROVE_DIRECTIO_OPS_PER_QUEUE,
-    TROVE_DIRECTIO_TIMEOUT
+    TROVE_DIRECTIO_TIMEOUT,
+    TROVE_META_BATCH_MAX_OPS,
+    TROVE_META_BATCH_MAX_LATENCY,
+    TROVE_META_READ_THREADS
 };
 
 /** Initializes the Trove layer.  Must be called before any other Trove
@@ -250,6 +254,14 @@ int trove_bstream_flush(TROVE_coll_id coll_id,
 			TROVE_op_id *out_op_id_p,
             PVFS_hint hints);
 
+int trove_bstream_fd_get(TROVE_coll_id coll_id,
+                         TROVE_handle handle,
+                         int *out_fd_p,
+                         void **out_ref_p);
+
+void trove_bstream_fd_put(TROVE_coll_id coll_id,
+                          void *ref);
+
 int trove_keyval_read(
 		      TROVE_coll_id coll_id,
 		      TROVE_handle handle,
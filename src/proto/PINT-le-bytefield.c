@@ -107,6 +107,7 @@ static void lebf_initialize(void)
             case PVFS_SERV_INVALID:
             case PVFS_SERV_PERF_UPDATE:
             case PVFS_SERV_PRECREATE_POOL_REFILLER:
+            case PVFS_SERV_DIRENT_SPLIT:
             case PVFS_SERV_JOB_TIMER:
                 /* never used, skip initialization */
                 continue;
@@ -136,12 +137,24 @@ static void lebf_initialize(void)
                 reqsize = extra_size_PVFS_servreq_create;
                 respsize = extra_size_PVFS_servresp_create;
                 break;
+            case PVFS_SERV_CREATE_LIST:
+                zero_credential(&req.u.create_list.credential);
+                resp.u.create_list.count = 0;
+                resp.u.create_list.dfile_total = 0;
+                reqsize = extra_size_PVFS_servreq_create_list;
+                respsize = extra_size_PVFS_servresp_create_list;
+                break;
             case PVFS_SERV_MIRROR:
                  req.u.mirror.dist = &tmp_dist;
                  req.u.mirror.dst_count = 0;
                  reqsize = extra_size_PVFS_servreq_mirror;
                  respsize = extra_size_PVFS_servresp_mirror;
                  break;
+            case PVFS_SERV_COPY_RANGE:
+                 req.u.copy_range.dist = &tmp_dist;
+                 zero_capability(&req.u.copy_range.dst_capability);
+                 reqsize = extra_size_PVFS_servreq_copy_range;
+                 break;
             case PVFS_SERV_IMM_COPIES:
                  break;
             case PVFS_SERV_REMOVE:
@@ -201,6 +214,13 @@ static void lebf_initialize(void)
                 req.u.crdirent.name = tmp_name;
                 reqsize = extra_size_PVFS_servreq_crdirent;
                 break;
+            case PVFS_SERV_CRDIRENT_LIST:
+                zero_credential(&req.u.crdirent_list.credential);
+                req.u.crdirent_list.count = 0;
+                resp.u.crdirent_list.count = 0;
+                reqsize = extra_size_PVFS_servreq_crdirent_list;
+                respsize = extra_size_PVFS_servresp_crdirent_list;
+                break;
             case PVFS_SERV_RMDIRENT:
                 req.u.rmdirent.entry = tmp_name;
                 reqsize = extra_size_PVFS_servreq_rmdirent;
@@ -225,6 +245,12 @@ static void lebf_initialize(void)
                 resp.u.readdir.dirent_count = 0;
                 respsize = extra_size_PVFS_servresp_readdir;
                 break;
+            case PVFS_SERV_READDIRPLUS:
+                resp.u.readdirplus.directory_version = 0;
+                resp.u.readdirplus.dirent_count = 0;
+                resp.u.readdirplus.size_count = 0;
+                respsize = extra_size_PVFS_servresp_readdirplus;
+                break;
             case PVFS_SERV_FLUSH:
                 /* nothing special */
                 break;
@@ -442,9 +468,11 @@ encode_common(struct PINT_encoded_msg *target_msg, int maxsize)
     gossip_debug(GOSSIP_ENDECODE_DEBUG,"\tmaxsize:%d\tinitializing_sizes:%d\n"
                                       ,maxsize,initializing_sizes);
 
-    /* allocate the max size buffer to avoid the work of calculating it */
+    /* use a max size buffer to avoid the work of calculating it; these
+     * are recycled, so only the bytes actually encoded get cleared
+     */
     buf = (initializing_sizes ? malloc(maxsize) :
-           BMI_memalloc(target_msg->dest, maxsize, BMI_SEND));
+           PINT_encode_buffer_get(target_msg->dest, maxsize, BMI_SEND));
     if (!buf)
     {
         gossip_err("Error: failed to BMI_malloc memory for response.\n");
@@ -500,7 +528,9 @@ static int lebf_encode_req(
         /* call standard function defined in headers */
         CASE(PVFS_SERV_LOOKUP_PATH, lookup_path);
         CASE(PVFS_SERV_CREATE, create);
+        CASE(PVFS_SERV_CREATE_LIST, create_list);
         CASE(PVFS_SERV_MIRROR, mirror);
+        CASE(PVFS_SERV_COPY_RANGE, copy_range);
         CASE(PVFS_SERV_UNSTUFF, unstuff);
         CASE(PVFS_SERV_BATCH_CREATE, batch_create);
         CASE(PVFS_SERV_BATCH_REMOVE, batch_remove);
@@ -517,11 +547,13 @@ static int lebf_encode_req(
         CASE(PVFS_SERV_GETATTR, getattr);
         CASE(PVFS_SERV_SETATTR, setattr);
         CASE(PVFS_SERV_CRDIRENT, crdirent);
+        CASE(PVFS_SERV_CRDIRENT_LIST, crdirent_list);
         CASE(PVFS_SERV_RMDIRENT, rmdirent);
         CASE(PVFS_SERV_CHDIRENT, chdirent);
         CASE(PVFS_SERV_TRUNCATE, truncate);
         CASE(PVFS_SERV_MKDIR, mkdir);
         CASE(PVFS_SERV_READDIR, readdir);
+        CASE(PVFS_SERV_READDIRPLUS, readdirplus);
         CASE(PVFS_SERV_FLUSH, flush);
         CASE(PVFS_SERV_STATFS, statfs);
         CASE(PVFS_SERV_MGMT_SETPARAM, mgmt_setparam);
@@ -552,6 +584,7 @@ static int lebf_encode_req(
         case PVFS_SERV_WRITE_COMPLETION:
         case PVFS_SERV_PERF_UPDATE:
         case PVFS_SERV_PRECREATE_POOL_REFILLER:
+        case PVFS_SERV_DIRENT_SPLIT:
         case PVFS_SERV_JOB_TIMER:
         case PVFS_SERV_NUM_OPS:  /* sentinel */
             gossip_err("%s: invalid operation %d\n", __func__, req->op);
@@ -617,16 +650,20 @@ static int lebf_encode_resp(
         CASE(PVFS_SERV_GETCONFIG, getconfig);
         CASE(PVFS_SERV_LOOKUP_PATH, lookup_path);
         CASE(PVFS_SERV_CREATE, create);
+        CASE(PVFS_SERV_CREATE_LIST, create_list);
         CASE(PVFS_SERV_MIRROR, mirror);
+        CASE(PVFS_SERV_COPY_RANGE, copy_range);
         CASE(PVFS_SERV_UNSTUFF, unstuff);
         CASE(PVFS_SERV_BATCH_CREATE, batch_create);
         CASE(PVFS_SERV_IO, io);
         CASE(PVFS_SERV_SMALL_IO, small_io);
         CASE(PVFS_SERV_GETATTR, getattr);
+        CASE(PVFS_SERV_CRDIRENT_LIST, crdirent_list);
         CASE(PVFS_SERV_RMDIRENT, rmdirent);
         CASE(PVFS_SERV_CHDIRENT, chdirent);
         CASE(PVFS_SERV_MKDIR, mkdir);
         CASE(PVFS_SERV_READDIR, readdir);
+        CASE(PVFS_SERV_READDIRPLUS, readdirplus);
         CASE(PVFS_SERV_STATFS, statfs);
         CASE(PVFS_SERV_MGMT_PERF_MON, mgmt_perf_mon);
         CASE(PVFS_SERV_MGMT_ITERATE_HANDLES, mgmt_iterate_handles);
@@ -668,6 +705,7 @@ static int lebf_encode_resp(
         case PVFS_SERV_INVALID:
         case PVFS_SERV_PERF_UPDATE:
         case PVFS_SERV_PRECREATE_POOL_REFILLER:
+        case PVFS_SERV_DIRENT_SPLIT:
         case PVFS_SERV_JOB_TIMER:
         case PVFS_SERV_NUM_OPS:  /* sentinel */
             gossip_err("%s: invalid operation %d\n", __func__, resp->op);
@@ -728,7 +766,9 @@ static int lebf_decode_req(
         /* call standard function defined in headers */
         CASE(PVFS_SERV_LOOKUP_PATH, lookup_path);
         CASE(PVFS_SERV_CREATE, create);
+        CASE(PVFS_SERV_CREATE_LIST, create_list);
         CASE(PVFS_SERV_MIRROR, mirror);
+        CASE(PVFS_SERV_COPY_RANGE, copy_range);
         CASE(PVFS_SERV_UNSTUFF, unstuff);
         CASE(PVFS_SERV_BATCH_CREATE, batch_create);
         CASE(PVFS_SERV_BATCH_REMOVE, batch_remove);
@@ -745,11 +785,13 @@ static int lebf_decode_req(
         CASE(PVFS_SERV_GETATTR, getattr);
         CASE(PVFS_SERV_SETATTR, setattr);
         CASE(PVFS_SERV_CRDIRENT, crdirent);
+        CASE(PVFS_SERV_CRDIRENT_LIST, crdirent_list);
         CASE(PVFS_SERV_RMDIRENT, rmdirent);
         CASE(PVFS_SERV_CHDIRENT, chdirent);
         CASE(PVFS_SERV_TRUNCATE, truncate);
         CASE(PVFS_SERV_MKDIR, mkdir);
         CASE(PVFS_SERV_READDIR, readdir);
+        CASE(PVFS_SERV_READDIRPLUS, readdirplus);
         CASE(PVFS_SERV_FLUSH, flush);
         CASE(PVFS_SERV_STATFS, statfs);
         CASE(PVFS_SERV_MGMT_SETPARAM, mgmt_setparam);
@@ -779,6 +821,7 @@ static int lebf_decode_req(
         case PVFS_SERV_WRITE_COMPLETION:
         case PVFS_SERV_PERF_UPDATE:
         case PVFS_SERV_PRECREATE_POOL_REFILLER:
+        case PVFS_SERV_DIRENT_SPLIT:
         case PVFS_SERV_JOB_TIMER:
         case PVFS_SERV_PROTO_ERROR:
         case PVFS_SERV_NUM_OPS:  /* sentinel */
@@ -835,16 +878,20 @@ static int lebf_decode_resp(
         CASE(PVFS_SERV_GETCONFIG, getconfig);
         CASE(PVFS_SERV_LOOKUP_PATH, lookup_path);
         CASE(PVFS_SERV_CREATE, create);
+        CASE(PVFS_SERV_CREATE_LIST, create_list);
         CASE(PVFS_SERV_MIRROR, mirror);
+        CASE(PVFS_SERV_COPY_RANGE, copy_range);
         CASE(PVFS_SERV_UNSTUFF, unstuff);
         CASE(PVFS_SERV_BATCH_CREATE, batch_create);
         CASE(PVFS_SERV_IO, io);
         CASE(PVFS_SERV_SMALL_IO, small_io);
         CASE(PVFS_SERV_GETATTR, getattr);
+        CASE(PVFS_SERV_CRDIRENT_LIST, crdirent_list);
         CASE(PVFS_SERV_RMDIRENT, rmdirent);
         CASE(PVFS_SERV_CHDIRENT, chdirent);
         CASE(PVFS_SERV_MKDIR, mkdir);
         CASE(PVFS_SERV_READDIR, readdir);
+        CASE(PVFS_SERV_READDIRPLUS, readdirplus);
         CASE(PVFS_SERV_STATFS, statfs);
         CASE(PVFS_SERV_MGMT_PERF_MON, mgmt_perf_mon);
         CASE(PVFS_SERV_MGMT_ITERATE_HANDLES, mgmt_iterate_handles);
@@ -886,6 +933,7 @@ static int lebf_decode_resp(
         case PVFS_SERV_INVALID:
         case PVFS_SERV_PERF_UPDATE:
         case PVFS_SERV_PRECREATE_POOL_REFILLER:
+        case PVFS_SERV_DIRENT_SPLIT:
         case PVFS_SERV_JOB_TIMER:
         case PVFS_SERV_NUM_OPS:  /* sentinel */
             gossip_lerr("%s: invalid operation %d.\n", __func__, resp->op);
@@ -924,8 +972,7 @@ static void lebf_encode_rel(
     }
     else
     {
-        BMI_memfree(msg->dest, msg->buffer_list[0],
-                    msg->alloc_size_list[0], BMI_SEND);
+        PINT_encode_buffer_put(msg->buffer_list[0], msg->total_size);
     }
 }
 
@@ -956,6 +1003,18 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                 if (req->u.create.layout.server_list.servers)
                     decode_free(req->u.create.layout.server_list.servers);
                 break;
+            case PVFS_SERV_CREATE_LIST:
+                decode_free(req->u.create_list.credential.group_array);
+                decode_free(req->u.create_list.credential.signature);
+#ifdef ENABLE_SECURITY_CERT
+                decode_free(req->u.create_list.credential.certificate.buf);
+#endif
+                if (req->u.create_list.attr.mask & PVFS_ATTR_META_DIST)
+                    decode_free(req->u.create_list.attr.u.meta.dist);
+                if (req->u.create_list.layout.server_list.servers)
+                    decode_free(
+                        req->u.create_list.layout.server_list.servers);
+                break;
             case PVFS_SERV_BATCH_CREATE:
                 decode_free(
                     req->u.batch_create.handle_extent_array.extent_array);
@@ -977,6 +1036,12 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                 decode_free(req->u.mirror.wcIndex);
                 break;
 
+            case PVFS_SERV_COPY_RANGE:
+                decode_free(req->u.copy_range.dist);
+                decode_free(req->u.copy_range.dst_capability.handle_array);
+                decode_free(req->u.copy_range.dst_capability.signature);
+                break;
+
             case PVFS_SERV_MKDIR:
                 decode_free(req->u.mkdir.handle_extent_array.extent_array);
                 decode_free(req->u.mkdir.credential.group_array);
@@ -1116,6 +1181,16 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
 #endif
                 break;
 
+            case PVFS_SERV_CRDIRENT_LIST:
+                decode_free(req->u.crdirent_list.credential.group_array);
+                decode_free(req->u.crdirent_list.credential.signature);
+#ifdef ENABLE_SECURITY_CERT
+                decode_free(req->u.crdirent_list.credential.certificate.buf);
+#endif
+                decode_free(req->u.crdirent_list.new_handles);
+                decode_free(req->u.crdirent_list.names);
+                break;
+
             case PVFS_SERV_REMOVE:
                 decode_free(req->u.remove.credential.group_array);
                 decode_free(req->u.remove.credential.signature);
@@ -1138,6 +1213,7 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
             case PVFS_SERV_CHDIRENT:
             case PVFS_SERV_TRUNCATE:
             case PVFS_SERV_READDIR:
+            case PVFS_SERV_READDIRPLUS:
             case PVFS_SERV_FLUSH:
             case PVFS_SERV_MGMT_SETPARAM:
             case PVFS_SERV_MGMT_NOOP:
@@ -1160,6 +1236,7 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
             case PVFS_SERV_WRITE_COMPLETION:
             case PVFS_SERV_PERF_UPDATE:
             case PVFS_SERV_PRECREATE_POOL_REFILLER:
+            case PVFS_SERV_DIRENT_SPLIT:
             case PVFS_SERV_JOB_TIMER:
             case PVFS_SERV_PROTO_ERROR:            
             case PVFS_SERV_NUM_OPS:  /* sentinel */
@@ -1211,6 +1288,15 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                        }
                     break;
 
+                case PVFS_SERV_CREATE_LIST:
+                    decode_free(resp->u.create_list.entries);
+                    decode_free(resp->u.create_list.dfile_handles);
+                    break;
+
+                case PVFS_SERV_CRDIRENT_LIST:
+                    decode_free(resp->u.crdirent_list.errors);
+                    break;
+
                 case PVFS_SERV_MGMT_DSPACE_INFO_LIST:
                     decode_free(resp->u.mgmt_dspace_info_list.dspace_info_array);
                     break;
@@ -1316,6 +1402,37 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                         break;
                     }/*end case*/
 
+                case PVFS_SERV_READDIRPLUS:
+                    {
+                     int i;
+                     PVFS_object_attr *attr;
+                     decode_free(resp->u.readdirplus.dirent_array);
+                     decode_free(resp->u.readdirplus.stat_err_array);
+                     decode_free(resp->u.readdirplus.size_array);
+                     if (resp->u.readdirplus.attr_array) {
+                         for (i = 0; i < resp->u.readdirplus.dirent_count;
+                              i++) {
+                          attr = &resp->u.readdirplus.attr_array[i];
+                          if (attr->mask & PVFS_ATTR_META_DIST)
+                           decode_free(attr->u.meta.dist);
+                          if (attr->mask & PVFS_ATTR_META_DFILES)
+                           decode_free(attr->u.meta.dfile_array);
+                          if (attr->mask & PVFS_ATTR_META_MIRROR_DFILES)
+                           decode_free(attr->u.meta.mirror_dfile_array);
+                          if (attr->mask & PVFS_ATTR_CAPABILITY) {
+                           decode_free(attr->capability.handle_array);
+                           decode_free(attr->capability.signature);
+                          }
+                          if (attr->mask & PVFS_ATTR_DISTDIR_ATTR) {
+                           decode_free(attr->dist_dir_bitmap);
+                           decode_free(attr->dirdata_handles);
+                          }
+                         }/*end for*/
+                         decode_free(resp->u.readdirplus.attr_array);
+                     }/*end if attr*/
+                        break;
+                    }/*end case*/
+
                 case PVFS_SERV_MIRROR:
                    {
                       decode_free(resp->u.mirror.bytes_written);
@@ -1385,6 +1502,7 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                 case PVFS_SERV_MGMT_NOOP:
                 case PVFS_SERV_STATFS:
                 case PVFS_SERV_WRITE_COMPLETION:
+                case PVFS_SERV_COPY_RANGE:
                 case PVFS_SERV_PROTO_ERROR:
                 case PVFS_SERV_BATCH_REMOVE:
                 case PVFS_SERV_IMM_COPIES:
@@ -1396,6 +1514,7 @@ static void lebf_decode_rel(struct PINT_decoded_msg *msg,
                 case PVFS_SERV_INVALID:
                 case PVFS_SERV_PERF_UPDATE:
                 case PVFS_SERV_PRECREATE_POOL_REFILLER:
+                case PVFS_SERV_DIRENT_SPLIT:
                 case PVFS_SERV_JOB_TIMER:
                 case PVFS_SERV_NUM_OPS:  /* sentinel */
                     gossip_lerr("%s: invalid response operation %d.\n",
@@ -0,0 +1,387 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/* Recycled buffers for encoded protocol messages.
+ *
+ * Every request and response is encoded into a buffer sized for the
+ * worst case of its operation (tens of kilobytes for most requests, up
+ * to megabytes for some responses), and every msgpair receives its
+ * response into a similar worst case buffer.  Rather than going to BMI
+ * for each of these, buffers are kept in power of two size classes per
+ * BMI method and direction, first in a small cache private to each
+ * thread and then in a shared depot.
+ *
+ * Send buffers are handed out zeroed, as BMI_memalloc() does: the
+ * releasing caller reports how many bytes it used and only those are
+ * cleared before the buffer is cached again.  Receive buffers are handed
+ * out with whatever the last message left in them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bmi.h"
+#include "gossip.h"
+#include "quicklist.h"
+#include "gen-locks.h"
+#include "pvfs2-debug.h"
+#include "PINT-reqproto-encode.h"
+#include "pvfs2-internal.h"
+
+/* size classes are powers of two from 1K to 4M; larger buffers, and
+ * buffers for methods beyond BUF_MAX_METHODS, are never cached
+ */
+#define BUF_MIN_SHIFT 10
+#define BUF_CLASS_COUNT 13
+#define BUF_MAX_METHODS 8
+
+/* each thread caches at most this many bytes per class (but always at
+ * least one buffer, and never more than BUF_THREAD_MAX_COUNT of them)
+ */
+#define BUF_THREAD_CLASS_BYTES (256*1024)
+#define BUF_THREAD_MAX_COUNT 8
+
+/* limit on the bytes held by the shared depot */
+#define BUF_DEPOT_MAX_BYTES (32*1024*1024)
+
+/* precedes every buffer; 16 bytes so the caller's part stays aligned */
+struct buf_header
+{
+    struct buf_header *next;    /* free list link while cached */
+    int32_t alloc_size;         /* bytes following the header */
+    int16_t method;
+    int8_t dir;                 /* 0 for BMI_SEND, 1 for BMI_RECV */
+    int8_t size_class;          /* -1 if never cached */
+};
+
+struct buf_lists
+{
+    struct buf_header *head[BUF_MAX_METHODS][2][BUF_CLASS_COUNT];
+    int count[BUF_MAX_METHODS][2][BUF_CLASS_COUNT];
+};
+
+/* per thread cache; all of them are linked together so that finalize
+ * can release buffers cached by threads that are still running
+ */
+struct buf_thread_cache
+{
+    struct buf_lists lists;
+    struct qlist_head link;
+};
+
+static gen_mutex_t depot_mutex = GEN_MUTEX_INITIALIZER;
+static int pool_initialized = 0;
+static pthread_key_t cache_key;
+static struct buf_lists depot;
+static PVFS_size depot_bytes = 0;
+static QLIST_HEAD(cache_list);
+
+#define BUF_DIR(__send_recv) ((__send_recv) == BMI_SEND ? 0 : 1)
+#define BUF_CLASS_SIZE(__class) (1 << (BUF_MIN_SHIFT + (__class)))
+
+static int buf_size_class(PVFS_size size)
+{
+    int size_class = 0;
+
+    while(size_class < BUF_CLASS_COUNT &&
+          BUF_CLASS_SIZE(size_class) < size)
+    {
+        size_class++;
+    }
+    return(size_class < BUF_CLASS_COUNT ? size_class : -1);
+}
+
+static int buf_thread_limit(int size_class)
+{
+    int limit = BUF_THREAD_CLASS_BYTES / BUF_CLASS_SIZE(size_class);
+
+    if(limit < 1)
+    {
+        limit = 1;
+    }
+    return(limit < BUF_THREAD_MAX_COUNT ? limit : BUF_THREAD_MAX_COUNT);
+}
+
+static void buf_release(struct buf_header *hdr)
+{
+    BMI_method_memfree(hdr->method, hdr,
+                       hdr->alloc_size + sizeof(struct buf_header),
+                       (hdr->dir == 0 ? BMI_SEND : BMI_RECV));
+}
+
+static struct buf_header *buf_pop(struct buf_lists *lists, int method,
+                                  int dir, int size_class)
+{
+    struct buf_header *hdr = lists->head[method][dir][size_class];
+
+    if(hdr)
+    {
+        lists->head[method][dir][size_class] = hdr->next;
+        lists->count[method][dir][size_class]--;
+    }
+    return(hdr);
+}
+
+static void buf_push(struct buf_lists *lists, struct buf_header *hdr)
+{
+    hdr->next = lists->head[hdr->method][hdr->dir][hdr->size_class];
+    lists->head[hdr->method][hdr->dir][hdr->size_class] = hdr;
+    lists->count[hdr->method][hdr->dir][hdr->size_class]++;
+}
+
+/* buf_depot_put_locked()
+ *
+ * caches a buffer in the depot, or frees it if the depot is full
+ */
+static void buf_depot_put_locked(struct buf_header *hdr)
+{
+    if(depot_bytes + hdr->alloc_size <= BUF_DEPOT_MAX_BYTES)
+    {
+        buf_push(&depot, hdr);
+        depot_bytes += hdr->alloc_size;
+    }
+    else
+    {
+        buf_release(hdr);
+    }
+}
+
+/* buf_drain_lists()
+ *
+ * empties a set of lists, either into the depot or straight back to BMI
+ */
+static void buf_drain_lists(struct buf_lists *lists, int to_depot)
+{
+    struct buf_header *hdr;
+    int method, dir, size_class;
+
+    for(method = 0; method < BUF_MAX_METHODS; method++)
+    {
+        for(dir = 0; dir < 2; dir++)
+        {
+            for(size_class = 0; size_class < BUF_CLASS_COUNT; size_class++)
+            {
+                while((hdr = buf_pop(lists, method, dir, size_class)))
+                {
+                    if(to_depot)
+                    {
+                        buf_depot_put_locked(hdr);
+                    }
+                    else
+                    {
+                        buf_release(hdr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* called when a thread with a cache exits */
+static void buf_cache_destroy(void *arg)
+{
+    struct buf_thread_cache *cache = arg;
+
+    gen_mutex_lock(&depot_mutex);
+    buf_drain_lists(&cache->lists, 1);
+    qlist_del(&cache->link);
+    gen_mutex_unlock(&depot_mutex);
+    free(cache);
+}
+
+static struct buf_thread_cache *buf_get_cache(void)
+{
+    struct buf_thread_cache *cache = pthread_getspecific(cache_key);
+
+    if(!cache)
+    {
+        cache = calloc(1, sizeof(*cache));
+        if(!cache)
+        {
+            return(NULL);
+        }
+        if(pthread_setspecific(cache_key, cache) != 0)
+        {
+            free(cache);
+            return(NULL);
+        }
+        gen_mutex_lock(&depot_mutex);
+        qlist_add_tail(&cache->link, &cache_list);
+        gen_mutex_unlock(&depot_mutex);
+    }
+    return(cache);
+}
+
+/* PINT_encode_buffer_initialize()
+ *
+ * sets up the buffer caches; called by PINT_encode_initialize()
+ *
+ * returns 0 on success, -PVFS_error on failure
+ */
+int PINT_encode_buffer_initialize(void)
+{
+    if(pool_initialized)
+    {
+        return(0);
+    }
+    if(pthread_key_create(&cache_key, buf_cache_destroy) != 0)
+    {
+        return(-PVFS_ENOMEM);
+    }
+    memset(&depot, 0, sizeof(depot));
+    depot_bytes = 0;
+    pool_initialized = 1;
+    return(0);
+}
+
+/* PINT_encode_buffer_finalize()
+ *
+ * returns every cached buffer to BMI; called by PINT_encode_finalize(),
+ * which must therefore run before BMI_finalize().  Buffers still held by
+ * callers at this point are simply released directly when they come
+ * back.
+ */
+void PINT_encode_buffer_finalize(void)
+{
+    struct buf_thread_cache *cache, *tmp;
+
+    if(!pool_initialized)
+    {
+        return;
+    }
+
+    gen_mutex_lock(&depot_mutex);
+    pool_initialized = 0;
+    qlist_for_each_entry_safe(cache, tmp, &cache_list, link)
+    {
+        buf_drain_lists(&cache->lists, 0);
+        qlist_del(&cache->link);
+        free(cache);
+    }
+    buf_drain_lists(&depot, 0);
+    depot_bytes = 0;
+    gen_mutex_unlock(&depot_mutex);
+
+    pthread_key_delete(cache_key);
+}
+
+/* PINT_encode_buffer_get()
+ *
+ * returns a buffer of at least size bytes suitable for sending to or
+ * receiving from addr.  Send buffers are zeroed; receive buffers are
+ * not.
+ *
+ * returns pointer to buffer on success, NULL on failure
+ */
+void *PINT_encode_buffer_get(PVFS_BMI_addr_t addr,
+                             PVFS_size size,
+                             enum bmi_op_type send_recv)
+{
+    struct buf_thread_cache *cache = NULL;
+    struct buf_header *hdr = NULL;
+    int method = -1;
+    int dir = BUF_DIR(send_recv);
+    int size_class = -1;
+    int32_t alloc_size = size;
+
+    if(BMI_get_info(addr, BMI_GET_METH_INDEX, &method) < 0)
+    {
+        return(NULL);
+    }
+
+    if(pool_initialized && method < BUF_MAX_METHODS)
+    {
+        size_class = buf_size_class(size);
+    }
+
+    if(size_class >= 0)
+    {
+        alloc_size = BUF_CLASS_SIZE(size_class);
+
+        cache = buf_get_cache();
+        if(cache)
+        {
+            hdr = buf_pop(&cache->lists, method, dir, size_class);
+        }
+        if(!hdr)
+        {
+            gen_mutex_lock(&depot_mutex);
+            hdr = buf_pop(&depot, method, dir, size_class);
+            if(hdr)
+            {
+                depot_bytes -= hdr->alloc_size;
+            }
+            gen_mutex_unlock(&depot_mutex);
+        }
+        if(hdr)
+        {
+            return(hdr + 1);
+        }
+    }
+
+    hdr = BMI_method_memalloc(method, alloc_size + sizeof(*hdr), send_recv);
+    if(!hdr)
+    {
+        return(NULL);
+    }
+    hdr->next = NULL;
+    hdr->alloc_size = alloc_size;
+    hdr->method = method;
+    hdr->dir = dir;
+    hdr->size_class = size_class;
+    return(hdr + 1);
+}
+
+/* PINT_encode_buffer_put()
+ *
+ * returns a buffer obtained from PINT_encode_buffer_get().  used is the
+ * number of bytes at the start of a send buffer that may have been
+ * written; it is ignored for receive buffers.
+ */
+void PINT_encode_buffer_put(void *buffer, PVFS_size used)
+{
+    struct buf_thread_cache *cache = NULL;
+    struct buf_header *hdr;
+
+    if(!buffer)
+    {
+        return;
+    }
+    hdr = (struct buf_header *)buffer - 1;
+
+    if(hdr->size_class < 0 || !pool_initialized)
+    {
+        buf_release(hdr);
+        return;
+    }
+
+    if(hdr->dir == 0 && used > 0)
+    {
+        memset(buffer, 0, (used < hdr->alloc_size ? used : hdr->alloc_size));
+    }
+
+    cache = buf_get_cache();
+    if(cache && cache->lists.count[hdr->method][hdr->dir][hdr->size_class]
+       < buf_thread_limit(hdr->size_class))
+    {
+        buf_push(&cache->lists, hdr);
+        return;
+    }
+
+    gen_mutex_lock(&depot_mutex);
+    buf_depot_put_locked(hdr);
+    gen_mutex_unlock(&depot_mutex);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
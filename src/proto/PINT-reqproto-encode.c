@@ -56,6 +56,12 @@ int PINT_encode_initialize(void)
     gossip_debug(GOSSIP_ENDECODE_DEBUG,"PINT_encode_initialize\n");
     if (ENCODING_IS_SUPPORTED(ENCODING_LE_BFIELD))
     {
+        ret = PINT_encode_buffer_initialize();
+        if (ret < 0)
+        {
+            return ret;
+        }
+
         /* setup little endian bytefield encoding */
         PINT_encoding_table[ENCODING_LE_BFIELD] = &le_bytefield_table;
         le_bytefield_table.init_fun();
@@ -80,13 +86,15 @@ int PINT_encode_initialize(void)
 
 /* PINT_encode_finalize()
  *
- * shuts down the protocol encoding interface
+ * shuts down the protocol encoding interface; the recycled message
+ * buffers belong to BMI, so this must be called before BMI_finalize()
  *
  * no return value
  */
 void PINT_encode_finalize(void)
 {
     le_bytefield_table.finalize_fun();
+    PINT_encode_buffer_finalize();
     gossip_debug(GOSSIP_ENDECODE_DEBUG,"PINT_encode_finalize\n");
     return;
 }
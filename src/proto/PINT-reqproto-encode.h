@@ -96,6 +96,20 @@ int PINT_encode_calc_max_size(
     enum PVFS_server_op op_type,
     enum PVFS_encoding_type enc_type);
 
+/* recycled buffers for encoded messages; see PINT-reqproto-buffers.c */
+int PINT_encode_buffer_initialize(void);
+
+void PINT_encode_buffer_finalize(void);
+
+void *PINT_encode_buffer_get(
+    PVFS_BMI_addr_t addr,
+    PVFS_size size,
+    enum bmi_op_type send_recv);
+
+void PINT_encode_buffer_put(
+    void *buffer,
+    PVFS_size used);
+
 
 #endif /* __PINT_REQUEST_ENCODE_H */
 
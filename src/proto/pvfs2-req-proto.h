@@ -98,6 +98,11 @@ enum PVFS_server_op
     PVFS_SERV_TREE_GETATTR = 49,
     PVFS_SERV_MGMT_GET_USER_CERT = 50,
     PVFS_SERV_MGMT_GET_USER_CERT_KEYREQ = 51,
+    PVFS_SERV_READDIRPLUS = 52,
+    PVFS_SERV_DIRENT_SPLIT = 53, /* not a real protocol request */
+    PVFS_SERV_CREATE_LIST = 54,
+    PVFS_SERV_CRDIRENT_LIST = 55,
+    PVFS_SERV_COPY_RANGE = 56,
 
     /* leave this entry last */
     PVFS_SERV_NUM_OPS
@@ -159,6 +164,9 @@ enum PVFS_server_op
 #define PVFS_REQ_LIMIT_DIRENT_COUNT 512
 /* max count of directory entries per readdirplus request */
 #define PVFS_REQ_LIMIT_DIRENT_COUNT_READDIRPLUS PVFS_SYS_LIMIT_LISTATTR
+/* max count of datafile sizes returned with one readdirplus response */
+#define PVFS_REQ_LIMIT_READDIRPLUS_SIZES \
+    (PVFS_REQ_LIMIT_DIRENT_COUNT_READDIRPLUS * 16)
 /* max number of perf metrics returned by mgmt perf mon op */
 #define PVFS_REQ_LIMIT_MGMT_PERF_MON_COUNT 16
 /* max number of events returned by mgmt event mon op */
@@ -167,6 +175,13 @@ enum PVFS_server_op
 #define PVFS_REQ_LIMIT_HANDLES_COUNT PVFS_SYS_LIMIT_HANDLES_COUNT
 /* max number of handles that can be created at once using batch create */
 #define PVFS_REQ_LIMIT_BATCH_CREATE 8192
+/* max number of files created by one create_list request */
+#define PVFS_REQ_LIMIT_CREATE_LIST 256
+/* max number of datafile handles returned by one create_list response */
+#define PVFS_REQ_LIMIT_CREATE_LIST_DFILES 2048
+/* max number of entries added by one crdirent_list request; the names
+ * have to fit in an unexpected message */
+#define PVFS_REQ_LIMIT_CRDIRENT_LIST 32
 /* max number of handles returned by mgmt iterate handles op */
 #define PVFS_REQ_LIMIT_MGMT_ITERATE_HANDLES_COUNT \
   PVFS_REQ_LIMIT_HANDLES_COUNT
@@ -271,6 +286,99 @@ endecode_fields_3_struct(PVFS_servresp_create,        \
 #define extra_size_PVFS_servresp_create \
    (extra_size_PVFS_object_attr)
 
+/* create_list ****************************************************/
+/* - used to create several files with the same attributes and
+ * distribution at once.  Each one is created exactly as a create
+ * request would; the directory entries are added separately. */
+
+struct PVFS_servreq_create_list
+{
+    PVFS_fs_id fs_id;
+    PVFS_credential credential;
+    PVFS_object_attr attr;
+
+    int32_t num_dfiles_req;
+    uint32_t count;            /* number of files to create */
+    /* NOTE: leave layout as final field so that we can deal with encoding
+     * errors */
+    PVFS_sys_layout layout;
+};
+endecode_fields_7_struct(
+    PVFS_servreq_create_list,
+    PVFS_fs_id, fs_id,
+    skip4,,
+    PVFS_credential, credential,
+    PVFS_object_attr, attr,
+    int32_t, num_dfiles_req,
+    uint32_t, count,
+    PVFS_sys_layout, layout);
+
+#define extra_size_PVFS_servreq_create_list                     \
+    (extra_size_PVFS_object_attr + extra_size_PVFS_sys_layout + \
+     extra_size_PVFS_credential)
+
+#define PINT_SERVREQ_CREATE_LIST_FILL(__req,                       \
+                                      __cap,                       \
+                                      __cred,                      \
+                                      __fsid,                      \
+                                      __attr,                      \
+                                      __num_dfiles_req,            \
+                                      __count,                     \
+                                      __layout,                    \
+                                      __hints)                     \
+do {                                                               \
+    int mask;                                                      \
+    memset(&(__req), 0, sizeof(__req));                            \
+    (__req).op = PVFS_SERV_CREATE_LIST;                            \
+    PVFS_REQ_COPY_CAPABILITY((__cap), (__req));                    \
+    (__req).hints = (__hints);                                     \
+    (__req).u.create_list.fs_id = (__fsid);                        \
+    (__req).u.create_list.credential = (__cred);                   \
+    (__req).u.create_list.num_dfiles_req = (__num_dfiles_req);     \
+    (__req).u.create_list.count = (__count);                       \
+    (__attr).objtype = PVFS_TYPE_METAFILE;                         \
+    mask = (__attr).mask;                                          \
+    (__attr).mask = PVFS_ATTR_COMMON_ALL;                          \
+    (__attr).mask |= PVFS_ATTR_SYS_TYPE;                           \
+    PINT_copy_object_attr(&(__req).u.create_list.attr, &(__attr)); \
+    (__req).u.create_list.attr.mask |= mask;                       \
+    (__req).u.create_list.layout = __layout;                       \
+} while (0)
+
+/* one per requested file; the datafile handles of all files follow
+ * the entries in order, dfile_count of them for each file */
+typedef struct
+{
+    PVFS_handle metafile_handle;
+    PVFS_error error;
+    uint32_t dfile_count;
+} PVFS_servresp_create_list_entry;
+endecode_fields_3(
+    PVFS_servresp_create_list_entry,
+    PVFS_handle, metafile_handle,
+    PVFS_error, error,
+    uint32_t, dfile_count);
+
+struct PVFS_servresp_create_list
+{
+    uint32_t count;
+    PVFS_servresp_create_list_entry *entries;
+    uint32_t dfile_total;
+    PVFS_handle *dfile_handles;
+};
+endecode_fields_1a_1a_struct(
+    PVFS_servresp_create_list,
+    skip4,,
+    uint32_t, count,
+    PVFS_servresp_create_list_entry, entries,
+    skip4,,
+    uint32_t, dfile_total,
+    PVFS_handle, dfile_handles);
+#define extra_size_PVFS_servresp_create_list                          \
+    ((PVFS_REQ_LIMIT_CREATE_LIST *                                    \
+      sizeof(PVFS_servresp_create_list_entry)) +                      \
+     (PVFS_REQ_LIMIT_CREATE_LIST_DFILES * sizeof(PVFS_handle)))
+
 /* batch_create *********************************************************/
 /* - used to create new multiple metafile and datafile objects */
 
@@ -1110,6 +1218,71 @@ do {                                                      \
     (__req).u.crdirent.fs_id = (__fs_id);                 \
 } while (0)
 
+/* crdirent_list ***********************************************/
+/* - creates several new entries within an existing directory, all
+ * in the same bucket of directory entries */
+
+struct PVFS_servreq_crdirent_list
+{
+    PVFS_credential credential;
+    PVFS_handle handle;        /* handle of directory */
+    PVFS_handle dirent_handle; /* handle of directory entries */
+    PVFS_fs_id fs_id;          /* file system */
+    uint32_t count;            /* number of new entries */
+    PVFS_handle *new_handles;  /* handles of new entries */
+    char **names;              /* names of new entries */
+};
+endecode_fields_4aa_struct(
+    PVFS_servreq_crdirent_list,
+    PVFS_credential, credential,
+    PVFS_handle, handle,
+    PVFS_handle, dirent_handle,
+    PVFS_fs_id, fs_id,
+    uint32_t, count,
+    PVFS_handle, new_handles,
+    string, names);
+#define extra_size_PVFS_servreq_crdirent_list                  \
+    (PVFS_REQ_LIMIT_CRDIRENT_LIST *                            \
+     (sizeof(PVFS_handle) + roundup8(PVFS_REQ_LIMIT_SEGMENT_BYTES + 1)))
+
+#define PINT_SERVREQ_CRDIRENT_LIST_FILL(__req,                 \
+                                        __cap,                 \
+                                        __cred,                \
+                                        __handle,              \
+                                        __dirent_handle,       \
+                                        __fs_id,               \
+                                        __count,               \
+                                        __new_handles,         \
+                                        __names,               \
+                                        __hints)               \
+do {                                                           \
+    memset(&(__req), 0, sizeof(__req));                        \
+    (__req).op = PVFS_SERV_CRDIRENT_LIST;                      \
+    PVFS_REQ_COPY_CAPABILITY((__cap), (__req));                \
+    (__req).u.crdirent_list.credential = (__cred);             \
+    (__req).hints = (__hints);                                 \
+    (__req).u.crdirent_list.handle = (__handle);               \
+    (__req).u.crdirent_list.dirent_handle = (__dirent_handle); \
+    (__req).u.crdirent_list.fs_id = (__fs_id);                 \
+    (__req).u.crdirent_list.count = (__count);                 \
+    (__req).u.crdirent_list.new_handles = (__new_handles);     \
+    (__req).u.crdirent_list.names = (__names);                 \
+} while (0)
+
+/* one status per entry, in request order */
+struct PVFS_servresp_crdirent_list
+{
+    uint32_t count;
+    PVFS_error *errors;
+};
+endecode_fields_1a_struct(
+    PVFS_servresp_crdirent_list,
+    skip4,,
+    uint32_t, count,
+    PVFS_error, errors);
+#define extra_size_PVFS_servresp_crdirent_list \
+    (PVFS_REQ_LIMIT_CRDIRENT_LIST * sizeof(PVFS_error))
+
 /* rmdirent ****************************************************/
 /* - removes an existing directory entry */
 
@@ -1255,6 +1428,116 @@ endecode_fields_3a_struct(
 #define extra_size_PVFS_servresp_readdir \
   (PVFS_REQ_LIMIT_DIRENT_COUNT * sizeof(PVFS_dirent))
 
+/* readdirplus *************************************************/
+/* - reads entries from a directory along with the attributes of
+ *   each entry whose metadata lives on the same server, and the
+ *   sizes of any of their datafiles that live there as well
+ */
+
+struct PVFS_servreq_readdirplus
+{
+    PVFS_handle handle;     /* handle of directory entries */
+    PVFS_fs_id fs_id;       /* file system */
+    PVFS_ds_position token; /* dir offset */
+    uint32_t dirent_count;  /* desired # of entries */
+    uint32_t attrmask;      /* mask of desired attributes */
+};
+endecode_fields_5_struct(
+    PVFS_servreq_readdirplus,
+    PVFS_handle, handle,
+    PVFS_fs_id, fs_id,
+    uint32_t, dirent_count,
+    uint32_t, attrmask,
+    PVFS_ds_position, token);
+
+#define PINT_SERVREQ_READDIRPLUS_FILL(__req,               \
+                                      __cap,               \
+                                      __fsid,              \
+                                      __handle,            \
+                                      __token,             \
+                                      __dirent_count,      \
+                                      __amask,             \
+                                      __hints)             \
+do {                                                       \
+    memset(&(__req), 0, sizeof(__req));                    \
+    (__req).op = PVFS_SERV_READDIRPLUS;                    \
+    PVFS_REQ_COPY_CAPABILITY((__cap), (__req));            \
+    (__req).hints = (__hints);                             \
+    (__req).u.readdirplus.fs_id = (__fsid);                \
+    (__req).u.readdirplus.handle = (__handle);             \
+    (__req).u.readdirplus.token = (__token);               \
+    (__req).u.readdirplus.dirent_count = (__dirent_count); \
+    (__req).u.readdirplus.attrmask = (__amask);            \
+} while (0);
+
+/* Entries whose metadata lives on another server come back with
+ * stat_err_array[i] set to -PVFS_EREMOTE and must be fetched with
+ * listattr.  size_array holds the datafile sizes of the unstuffed
+ * regular files among the returned entries, dfile_count sizes per
+ * file in entry order; it stops at the first file whose sizes do not
+ * fit, and sizes of datafiles stored elsewhere are -1.
+ */
+struct PVFS_servresp_readdirplus
+{
+    PVFS_ds_position token;  /* new dir offset */
+    uint64_t directory_version;
+    uint32_t dirent_count;   /* # of entries retrieved */
+    PVFS_dirent *dirent_array;
+    PVFS_error *stat_err_array;
+    PVFS_object_attr *attr_array;
+    uint32_t size_count;     /* # of datafile sizes */
+    PVFS_size *size_array;
+};
+#ifdef __PINT_REQPROTO_ENCODE_FUNCS_C
+static inline void encode_PVFS_servresp_readdirplus(
+    char **pptr, const struct PVFS_servresp_readdirplus *x)
+{
+    uint32_t i;
+    encode_PVFS_ds_position(pptr, &x->token);
+    encode_uint64_t(pptr, &x->directory_version);
+    encode_uint32_t(pptr, &x->dirent_count);
+    encode_uint32_t(pptr, &x->size_count);
+    for (i = 0; i < x->dirent_count; i++)
+        encode_PVFS_dirent(pptr, &x->dirent_array[i]);
+    for (i = 0; i < x->dirent_count; i++)
+        encode_PVFS_error(pptr, &x->stat_err_array[i]);
+    for (i = 0; i < x->dirent_count; i++)
+        encode_PVFS_object_attr(pptr, &x->attr_array[i]);
+    for (i = 0; i < x->size_count; i++)
+        encode_PVFS_size(pptr, &x->size_array[i]);
+}
+static inline void decode_PVFS_servresp_readdirplus(
+    char **pptr, struct PVFS_servresp_readdirplus *x)
+{
+    uint32_t i;
+    decode_PVFS_ds_position(pptr, &x->token);
+    decode_uint64_t(pptr, &x->directory_version);
+    decode_uint32_t(pptr, &x->dirent_count);
+    decode_uint32_t(pptr, &x->size_count);
+    x->dirent_array = decode_malloc(x->dirent_count *
+                                    sizeof(*x->dirent_array));
+    for (i = 0; i < x->dirent_count; i++)
+        decode_PVFS_dirent(pptr, &x->dirent_array[i]);
+    x->stat_err_array = decode_malloc(x->dirent_count *
+                                      sizeof(*x->stat_err_array));
+    for (i = 0; i < x->dirent_count; i++)
+        decode_PVFS_error(pptr, &x->stat_err_array[i]);
+    x->attr_array = decode_malloc(x->dirent_count *
+                                  sizeof(*x->attr_array));
+    for (i = 0; i < x->dirent_count; i++)
+        decode_PVFS_object_attr(pptr, &x->attr_array[i]);
+    x->size_array = decode_malloc(x->size_count *
+                                  sizeof(*x->size_array));
+    for (i = 0; i < x->size_count; i++)
+        decode_PVFS_size(pptr, &x->size_array[i]);
+}
+#endif
+#define extra_size_PVFS_servresp_readdirplus                           \
+  (PVFS_REQ_LIMIT_DIRENT_COUNT_READDIRPLUS *                           \
+   (sizeof(PVFS_dirent) + sizeof(PVFS_error) +                         \
+    extra_size_PVFS_object_attr) +                                     \
+   (PVFS_REQ_LIMIT_READDIRPLUS_SIZES * sizeof(PVFS_size)))
+
 /* getconfig ***************************************************/
 /* - retrieves initial configuration information from server */
 
@@ -1558,6 +1841,116 @@ endecode_fields_1_struct(
     PVFS_servresp_write_completion,
     PVFS_size, total_completed);
 
+/* copy_range **************************************************/
+/* - copies a logical byte range held by one datafile to the   */
+/*   matching datafile of another file.  The receiving server  */
+/*   reads its local data and writes it to the destination     */
+/*   datafile with a PVFS_SERV_IO write and a flow, so the     */
+/*   data never passes through the client.  Both files must    */
+/*   share the distribution so that datafile server_nr of one  */
+/*   holds exactly the bytes that server_nr of the other needs. */
+
+struct PVFS_servreq_copy_range
+{
+    PVFS_handle handle;        /* source datafile */
+    PVFS_fs_id fs_id;          /* file system */
+    PVFS_handle dst_handle;    /* destination datafile */
+    /* capability used for the write to the destination datafile */
+    PVFS_capability dst_capability;
+    enum PVFS_flowproto_type flow_type;
+    /* relative number of this datafile in the distribution */
+    uint32_t server_nr;
+    /* total number of datafiles in the distribution */
+    uint32_t server_ct;
+    /* distribution shared by both files */
+    PINT_dist *dist;
+    PVFS_offset src_offset;    /* logical offset in the source file */
+    PVFS_offset dst_offset;    /* logical offset in the destination file */
+    PVFS_size length;          /* logical length of the range */
+};
+#ifdef __PINT_REQPROTO_ENCODE_FUNCS_C
+#define encode_PVFS_servreq_copy_range(pptr,x) do {         \
+    encode_PVFS_handle(pptr, &(x)->handle);                 \
+    encode_PVFS_fs_id(pptr, &(x)->fs_id);                   \
+    encode_skip4(pptr,);                                    \
+    encode_PVFS_handle(pptr, &(x)->dst_handle);             \
+    encode_PVFS_capability(pptr, &(x)->dst_capability);     \
+    encode_enum(pptr, &(x)->flow_type);                     \
+    encode_uint32_t(pptr, &(x)->server_nr);                 \
+    encode_uint32_t(pptr, &(x)->server_ct);                 \
+    encode_skip4(pptr,);                                    \
+    encode_PINT_dist(pptr, &(x)->dist);                     \
+    encode_PVFS_offset(pptr, &(x)->src_offset);             \
+    encode_PVFS_offset(pptr, &(x)->dst_offset);             \
+    encode_PVFS_size(pptr, &(x)->length);                   \
+} while (0)
+#define decode_PVFS_servreq_copy_range(pptr,x) do {         \
+    decode_PVFS_handle(pptr, &(x)->handle);                 \
+    decode_PVFS_fs_id(pptr, &(x)->fs_id);                   \
+    decode_skip4(pptr,);                                    \
+    decode_PVFS_handle(pptr, &(x)->dst_handle);             \
+    decode_PVFS_capability(pptr, &(x)->dst_capability);     \
+    decode_enum(pptr, &(x)->flow_type);                     \
+    decode_uint32_t(pptr, &(x)->server_nr);                 \
+    decode_uint32_t(pptr, &(x)->server_ct);                 \
+    decode_skip4(pptr,);                                    \
+    decode_PINT_dist(pptr, &(x)->dist);                     \
+    decode_PVFS_offset(pptr, &(x)->src_offset);             \
+    decode_PVFS_offset(pptr, &(x)->dst_offset);             \
+    decode_PVFS_size(pptr, &(x)->length);                   \
+} while (0)
+#endif
+#define extra_size_PVFS_servreq_copy_range \
+    (extra_size_PVFS_capability + PVFS_REQ_LIMIT_DIST_BYTES)
+
+#define PINT_SERVREQ_COPY_RANGE_FILL(__req,                      \
+                                     __cap,                      \
+                                     __dst_cap,                  \
+                                     __fsid,                     \
+                                     __handle,                   \
+                                     __dst_handle,               \
+                                     __flow_type,                \
+                                     __server_nr,                \
+                                     __server_ct,                \
+                                     __dist,                     \
+                                     __src_offset,               \
+                                     __dst_offset,               \
+                                     __length,                   \
+                                     __hints)                    \
+do {                                                             \
+    int __rc;                                                    \
+    memset(&(__req), 0, sizeof(__req));                          \
+    (__req).op = PVFS_SERV_COPY_RANGE;                           \
+    PVFS_REQ_COPY_CAPABILITY((__cap), (__req));                  \
+    __rc = PINT_copy_capability(&(__dst_cap),                    \
+                                &(__req).u.copy_range.dst_capability); \
+    assert(__rc == 0);                                           \
+    (__req).hints = (__hints);                                   \
+    (__req).u.copy_range.fs_id = (__fsid);                       \
+    (__req).u.copy_range.handle = (__handle);                    \
+    (__req).u.copy_range.dst_handle = (__dst_handle);            \
+    (__req).u.copy_range.flow_type = (__flow_type);              \
+    (__req).u.copy_range.server_nr = (__server_nr);              \
+    (__req).u.copy_range.server_ct = (__server_ct);              \
+    (__req).u.copy_range.dist = (__dist);                        \
+    (__req).u.copy_range.src_offset = (__src_offset);            \
+    (__req).u.copy_range.dst_offset = (__dst_offset);            \
+    (__req).u.copy_range.length = (__length);                    \
+} while (0)
+
+struct PVFS_servresp_copy_range
+{
+    /* logical length of the range covered by the source datafile's
+     * data; less than the requested length when the datafile ends
+     * inside the range */
+    PVFS_size length;
+    PVFS_size total_completed; /* bytes written to the destination */
+};
+endecode_fields_2_struct(
+    PVFS_servresp_copy_range,
+    PVFS_size, length,
+    PVFS_size, total_completed);
+
 #define SMALL_IO_MAX_SEGMENTS 64
 
 struct PVFS_servreq_small_io
@@ -2561,7 +2954,9 @@ struct PVFS_server_req
     union
     {
         struct PVFS_servreq_mirror mirror;
+        struct PVFS_servreq_copy_range copy_range;
         struct PVFS_servreq_create create;
+        struct PVFS_servreq_create_list create_list;
         struct PVFS_servreq_unstuff unstuff;
         struct PVFS_servreq_batch_create batch_create;
         struct PVFS_servreq_remove remove;
@@ -2571,8 +2966,10 @@ struct PVFS_server_req
         struct PVFS_servreq_setattr setattr;
         struct PVFS_servreq_mkdir mkdir;
         struct PVFS_servreq_readdir readdir;
+        struct PVFS_servreq_readdirplus readdirplus;
         struct PVFS_servreq_lookup_path lookup_path;
         struct PVFS_servreq_crdirent crdirent;
+        struct PVFS_servreq_crdirent_list crdirent_list;
         struct PVFS_servreq_rmdirent rmdirent;
         struct PVFS_servreq_chdirent chdirent;
         struct PVFS_servreq_truncate truncate;
@@ -2636,13 +3033,17 @@ struct PVFS_server_resp
     union
     {
         struct PVFS_servresp_mirror mirror;
+        struct PVFS_servresp_copy_range copy_range;
         struct PVFS_servresp_create create;
+        struct PVFS_servresp_create_list create_list;
         struct PVFS_servresp_unstuff unstuff;
         struct PVFS_servresp_batch_create batch_create;
         struct PVFS_servresp_getattr getattr;
         struct PVFS_servresp_mkdir mkdir;
         struct PVFS_servresp_readdir readdir;
+        struct PVFS_servresp_readdirplus readdirplus;
         struct PVFS_servresp_lookup_path lookup_path;
+        struct PVFS_servresp_crdirent_list crdirent_list;
         struct PVFS_servresp_rmdirent rmdirent;
         struct PVFS_servresp_chdirent chdirent;
         struct PVFS_servresp_getconfig getconfig;
@@ -15,9 +15,13 @@ extern struct PINT_server_req_params pvfs2_get_attr_params;
 extern struct PINT_server_req_params pvfs2_list_attr_params;
 extern struct PINT_server_req_params pvfs2_set_attr_params;
 extern struct PINT_server_req_params pvfs2_create_params;
+extern struct PINT_server_req_params pvfs2_create_list_params;
 extern struct PINT_server_req_params pvfs2_crdirent_params;
+extern struct PINT_server_req_params pvfs2_crdirent_list_params;
 extern struct PINT_server_req_params pvfs2_mkdir_params;
 extern struct PINT_server_req_params pvfs2_readdir_params;
+extern struct PINT_server_req_params pvfs2_readdirplus_params;
+extern struct PINT_server_req_params pvfs2_dirent_split_params;
 extern struct PINT_server_req_params pvfs2_lookup_params;
 extern struct PINT_server_req_params pvfs2_io_params;
 extern struct PINT_server_req_params pvfs2_small_io_params;
@@ -52,6 +56,7 @@ extern struct PINT_server_req_params pvfs2_unstuff_params;
 extern struct PINT_server_req_params pvfs2_stuffed_create_params;
 extern struct PINT_server_req_params pvfs2_precreate_pool_refiller_params;
 extern struct PINT_server_req_params pvfs2_mirror_params;
+extern struct PINT_server_req_params pvfs2_copy_range_params;
 extern struct PINT_server_req_params pvfs2_create_immutable_copies_params;
 extern struct PINT_server_req_params pvfs2_tree_remove_params;
 extern struct PINT_server_req_params pvfs2_tree_get_file_size_params;
@@ -121,11 +126,16 @@ struct PINT_server_req_entry PINT_server_req_table[] =
     /* 49 */ {PVFS_SERV_TREE_GETATTR, &pvfs2_tree_getattr_params},
 #ifdef ENABLE_SECURITY_CERT    
     /* 50 */ {PVFS_SERV_MGMT_GET_USER_CERT, &pvfs2_get_user_cert_params},
-    /* 51 */ {PVFS_SERV_MGMT_GET_USER_CERT_KEYREQ, &pvfs2_get_user_cert_keyreq_params}
+    /* 51 */ {PVFS_SERV_MGMT_GET_USER_CERT_KEYREQ, &pvfs2_get_user_cert_keyreq_params},
 #else
     /* 50 */ {PVFS_SERV_MGMT_GET_USER_CERT, NULL},
     /* 51 */ {PVFS_SERV_MGMT_GET_USER_CERT_KEYREQ, NULL},
 #endif
+    /* 52 */ {PVFS_SERV_READDIRPLUS, &pvfs2_readdirplus_params},
+    /* 53 */ {PVFS_SERV_DIRENT_SPLIT, &pvfs2_dirent_split_params},
+    /* 54 */ {PVFS_SERV_CREATE_LIST, &pvfs2_create_list_params},
+    /* 55 */ {PVFS_SERV_CRDIRENT_LIST, &pvfs2_crdirent_list_params},
+    /* 56 */ {PVFS_SERV_COPY_RANGE, &pvfs2_copy_range_params},
 };
 
 #define CHECK_OP(_op_) assert(_op_ == PINT_server_req_table[_op_].op_type)
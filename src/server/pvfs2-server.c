@@ -101,6 +101,8 @@ static pid_t server_controlling_pid = 0;
 
 static PINT_event_id PINT_sm_event_id;
 
+/* protects the three lists below */
+gen_mutex_t server_sop_list_mutex = GEN_MUTEX_INITIALIZER;
 /* A list of all serv_op's posted for unexpected message alone */
 QLIST_HEAD(posted_sop_list);
 /* A list of all serv_op's posted for expected messages alone */
@@ -166,6 +168,36 @@ static job_id_t *server_job_id_array = NULL;
 static void **server_completed_job_p_array = NULL;
 static job_status_s *server_job_status_array = NULL;
 
+/* State machine worker threads, used when ServerStateMachineThreads is
+ * greater than 1.  The main loop still collects completed jobs, but hands
+ * each state machine to a worker picked from the root of its family (the
+ * machine itself, or the parent that started it as a child), so the steps
+ * of one request never run on two threads at once and a parent always
+ * sees the updates made by its children.
+ */
+struct server_sm_work
+{
+    struct qlist_head link;
+    struct PINT_smcb *smcb;
+    job_status_s js;
+    int start;  /* run PINT_state_machine_start() rather than continue */
+};
+
+struct server_sm_worker
+{
+    gen_thread_t thread;
+    gen_mutex_t mutex;
+    gen_cond_t work_cond;   /* signaled when work is queued */
+    gen_cond_t idle_cond;   /* signaled when the queue has drained */
+    struct qlist_head queue;
+    int waiting;            /* sleeping on work_cond */
+    int busy;               /* threads running its state machines */
+    int stop;
+};
+
+static struct server_sm_worker *sm_workers = NULL;
+static int sm_worker_count = 0;
+
 /* Prototypes for internal functions */
 static int server_initialize(
     PINT_server_status_flag *server_status_flag,
@@ -203,11 +235,20 @@ static int precreate_pool_count(
 
 static TROVE_method_id trove_coll_to_method_callback(TROVE_coll_id);
 
+static int server_sm_workers_start(int count);
+static void server_sm_workers_stop(void);
+static void server_sm_workers_quiesce(void);
+static void server_sm_dispatch(
+    struct PINT_smcb *smcb, job_status_s *js_p, int start);
+static void server_sm_start(
+    struct PINT_smcb *smcb, job_status_s *js_p);
+
 
 
 int main(int argc, char **argv)
 {
     int ret = -1, siglevel = 0;
+    int unexp_purged = 0;
     struct PINT_smcb *tmp_op = NULL;
     uint64_t debug_mask = 0;
 
@@ -398,6 +439,17 @@ int main(int argc, char **argv)
         goto server_shutdown;
     }
 
+    if (server_config.server_sm_threads > 1)
+    {
+        ret = server_sm_workers_start(server_config.server_sm_threads);
+        if (ret < 0)
+        {
+            PVFS_perror_gossip("Error: failed to start state machine "
+                               "threads.\n", ret);
+            goto server_shutdown;
+        }
+    }
+
     gossip_debug_fp(stderr, 'S', GOSSIP_LOGSTAMP_DATETIME,
                     "PVFS2 Server ready.\n");
 
@@ -411,6 +463,8 @@ int main(int argc, char **argv)
             /* If the signal is a SIGHUP, catch and reload configuration */
             if (signal_recvd_flag == SIGHUP)
             {
+                /* no state machine may run while the config changes */
+                server_sm_workers_quiesce();
                 reload_config();
 
                 /* re-open log file to allow normal rotation */
@@ -424,6 +478,23 @@ int main(int argc, char **argv)
             }
             else
             {
+                int drained;
+
+                /*
+                 * Cancel all the machines that we had posted for
+                 * unexpected BMI messages.  From now the server will only
+                 * try and finish operations that are already in progress,
+                 * wait for them to timeout or complete before initiating
+                 * shutdown.  This is done here rather than in the signal
+                 * handler since state machine threads may be changing the
+                 * posted list.
+                 */
+                if (!unexp_purged)
+                {
+                    server_purge_unexpected_recv_machines();
+                    unexp_purged = 1;
+                }
+
                 /*
                  * If we received a signal and we have drained all the state
                  * machines that were in progress, we initiate a shutdown of
@@ -431,7 +502,10 @@ int main(int argc, char **argv)
                  * all s_ops (for expected messages) have either finished or
                  * timed out,
                  */
-                if (qlist_empty(&inprogress_sop_list))
+                gen_mutex_lock(&server_sop_list_mutex);
+                drained = qlist_empty(&inprogress_sop_list);
+                gen_mutex_unlock(&server_sop_list_mutex);
+                if (drained)
                 {
                     ret = 0;
                     siglevel = signal_recvd_flag;
@@ -461,6 +535,12 @@ int main(int argc, char **argv)
             /* int unexpected_msg = 0; */
             struct PINT_smcb *smcb = server_completed_job_p_array[i];
 
+            if (sm_workers)
+            {
+                server_sm_dispatch(smcb, &server_job_status_array[i], 0);
+                continue;
+            }
+
                /* NOTE: PINT_state_machine_next() is a function that
                 * is shared with the client-side state machine
                 * processing, so it is defined in the src/common
@@ -793,6 +873,7 @@ static int server_initialize_subsystems(
     PVFS_ds_flags init_flags = 0;
     int bmi_flags = BMI_INIT_SERVER;
     int server_index;
+    PVFS_size pool_size;
 
     if(server_config.enable_events)
     {
@@ -869,6 +950,16 @@ static int server_initialize_subsystems(
                  (void *)&server_config.tcp_buffer_size_send);
     BMI_set_info(0, BMI_TCP_BUFFER_RECEIVE_SIZE, 
                  (void *)&server_config.tcp_buffer_size_receive);
+    if (server_config.tcp_progress_threads > 0)
+    {
+        ret = BMI_set_info(0, BMI_TCP_PROGRESS_THREADS,
+                           (void *)&server_config.tcp_progress_threads);
+        if (ret < 0)
+        {
+            PVFS_perror_gossip("Error: BMI_set_info", ret);
+            return ret;
+        }
+    }
 
     *server_status_flag |= SERVER_BMI_INIT;
 
@@ -890,6 +981,15 @@ static int server_initialize_subsystems(
                                    &server_config.trove_max_concurrent_io);
     /* this should never fail */
     assert(ret == 0);
+    ret = trove_collection_setinfo(0, 0, TROVE_META_BATCH_MAX_OPS,
+                                   &server_config.trove_meta_batch_max_ops);
+    assert(ret == 0);
+    ret = trove_collection_setinfo(0, 0, TROVE_META_BATCH_MAX_LATENCY,
+                                   &server_config.trove_meta_batch_max_latency);
+    assert(ret == 0);
+    ret = trove_collection_setinfo(0, 0, TROVE_META_READ_THREADS,
+                                   &server_config.trove_meta_read_threads);
+    assert(ret == 0);
 
     generate_shm_key_hint(&server_index);
 
@@ -932,6 +1032,10 @@ static int server_initialize_subsystems(
 
     *server_status_flag |= SERVER_FLOW_INIT;
 
+    pool_size = (PVFS_size)server_config.flow_buffer_pool_mb * 1024 * 1024;
+    PINT_flow_setinfo(NULL, FLOWPROTO_BUFFER_POOL_SIZE, &pool_size);
+    PINT_flow_setinfo(NULL, FLOWPROTO_SENDFILE, &server_config.flow_sendfile);
+
     cur = server_config.file_systems;
     while(cur)
     {
@@ -1061,6 +1165,17 @@ static int server_initialize_subsystems(
                 gossip_err("Error setting handle timeout\n");
             }
 
+            ret = trove_collection_setinfo(
+                                   cur_fs->coll_id,
+                                   trove_context,
+                                   TROVE_COLLECTION_HANDLE_CHECKPOINT,
+                                   (void *)&cur_fs->handle_checkpoint_secs);
+            if (ret < 0)
+            {
+                gossip_err("Error setting handle ledger checkpoint "
+                           "interval\n");
+            }
+
             if (cur_fs->attr_cache_keywords &&
                 cur_fs->attr_cache_size &&
                 cur_fs->attr_cache_max_num_elems)
@@ -1251,6 +1366,30 @@ static int server_initialize_subsystems(
         PVFS_perror_gossip("Error: PINT_req_sched_intialize", ret);
         return ret;
     }
+
+    ret = PINT_req_sched_set_info(PINT_REQ_SCHED_METADATA_WEIGHT,
+                                  server_config.req_sched_metadata_weight);
+    if (ret == 0)
+    {
+        ret = PINT_req_sched_set_info(PINT_REQ_SCHED_IO_WEIGHT,
+                                      server_config.req_sched_io_weight);
+    }
+    if (ret == 0)
+    {
+        ret = PINT_req_sched_set_info(PINT_REQ_SCHED_MGMT_WEIGHT,
+                                      server_config.req_sched_mgmt_weight);
+    }
+    if (ret == 0)
+    {
+        ret = PINT_req_sched_set_info(PINT_REQ_SCHED_MAX_BYPASS,
+                                      server_config.req_sched_max_bypass);
+    }
+    if (ret < 0)
+    {
+        PVFS_perror_gossip("Error: PINT_req_sched_set_info", ret);
+        PINT_req_sched_finalize();
+        return ret;
+    }
     *server_status_flag |= SERVER_REQ_SCHED_INIT;
 
 #ifndef __PVFS2_DISABLE_PERF_COUNTERS__
@@ -1800,6 +1939,11 @@ static int server_shutdown(PINT_server_status_flag status,
     gossip_debug(GOSSIP_SERVER_DEBUG,
                  "*** server shutdown in progress ***\n");
 
+    if (sm_workers)
+    {
+        server_sm_workers_stop();
+    }
+
     free(s_server_options.server_alias);
 
     if (status & SERVER_PRECREATE_INIT)
@@ -1879,6 +2023,16 @@ static int server_shutdown(PINT_server_status_flag status,
                      "interface            [ stopped ]\n");
     }
 
+    /* the encoder caches BMI buffers, so it has to go first */
+    if (status & SERVER_ENCODER_INIT)
+    {
+        gossip_debug(GOSSIP_SERVER_DEBUG, "[+] halting encoder "
+                     "interface         [   ...   ]\n");
+        PINT_encode_finalize();
+        gossip_debug(GOSSIP_SERVER_DEBUG, "[-]         encoder "
+                     "interface         [ stopped ]\n");
+    }
+
     if (status & SERVER_BMI_INIT)
     {
         gossip_debug(GOSSIP_SERVER_DEBUG, "[+] halting bmi "
@@ -1955,15 +2109,6 @@ static int server_shutdown(PINT_server_status_flag status,
     }
 #endif /* ENABLE_CAPCACHE */
 
-    if (status & SERVER_ENCODER_INIT)
-    {
-        gossip_debug(GOSSIP_SERVER_DEBUG, "[+] halting encoder "
-                     "interface         [   ...   ]\n");
-        PINT_encode_finalize();
-        gossip_debug(GOSSIP_SERVER_DEBUG, "[-]         encoder "
-                     "interface         [ stopped ]\n");
-    }
-
     if (status & SERVER_DIST_INIT)
     {
         gossip_debug(GOSSIP_SERVER_DEBUG, "[+] halting dist "
@@ -2042,14 +2187,6 @@ static void server_sig_handler(int sig)
          * server to exit gracefully on the next work cycle
          */
         signal_recvd_flag = sig;
-        /*
-         * iterate through all the machines that we had posted for
-         * unexpected BMI messages and deallocate them.
-         * From now the server will only try and finish operations
-         * that are already in progress, wait for them to timeout
-         * or complete before initiating shutdown
-         */
-        server_purge_unexpected_recv_machines();
     }
 }
 
@@ -2302,7 +2439,19 @@ int server_post_unexpected_recv(void)
     s_op->target_fs_id = PVFS_FS_ID_NULL;
 
     /* Add an unexpected s_ops to the list */
+    gen_mutex_lock(&server_sop_list_mutex);
     qlist_add_tail(&s_op->next, &posted_sop_list);
+    gen_mutex_unlock(&server_sop_list_mutex);
+
+    if (sm_workers)
+    {
+        /* we are on a state machine thread, but the new machine belongs
+         * to whichever worker its own completions will go to; it has to
+         * start there too or the two threads would race on it.
+         */
+        server_sm_dispatch(smcb, &js, 1);
+        return 0;
+    }
 
     ret = PINT_state_machine_start(smcb, &js);
     if(ret == SM_ACTION_TERMINATE)
@@ -2314,6 +2463,282 @@ int server_post_unexpected_recv(void)
     return ret;
 }
 
+/* server_sm_start()
+ *
+ * starts a machine set up by server_post_unexpected_recv() or
+ * server_state_machine_start_noreq() on the state machine thread it was
+ * dispatched to
+ */
+static void server_sm_start(
+    struct PINT_smcb *smcb, job_status_s *js_p)
+{
+    PINT_server_op *s_op = PINT_sm_frame(smcb, PINT_FRAME_CURRENT);
+    /* once started, the machine may finish and be freed on another
+     * thread, so look at it now
+     */
+    int unexpected = (s_op->op == BMI_UNEXPECTED_OP);
+    int ret;
+
+    ret = PINT_state_machine_start(smcb, js_p);
+    if (unexpected)
+    {
+        if (ret == SM_ACTION_TERMINATE)
+        {
+            PVFS_perror_gossip("Error: failed to post unexpected receive",
+                               js_p->error_code);
+            PINT_smcb_free(smcb);
+        }
+    }
+    else if (ret < 0)
+    {
+        gossip_lerr("Error: failed to start state machine.\n");
+        gen_mutex_lock(&server_sop_list_mutex);
+        qlist_del(&s_op->next);
+        gen_mutex_unlock(&server_sop_list_mutex);
+        PINT_smcb_free(smcb);
+    }
+}
+
+/* server_sm_worker_index()
+ *
+ * picks the worker for a family of state machines from its root smcb
+ */
+static int server_sm_worker_index(struct PINT_smcb *smcb)
+{
+    uint64_t hash;
+
+    while (smcb->parent_smcb)
+    {
+        smcb = smcb->parent_smcb;
+    }
+    /* the low bits of a heap address carry no information */
+    hash = ((uint64_t) (uintptr_t) smcb >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (int) ((hash >> 32) % sm_worker_count);
+}
+
+/* server_sm_dispatch()
+ *
+ * queues a state machine step on the worker that owns its family
+ */
+static void server_sm_dispatch(
+    struct PINT_smcb *smcb, job_status_s *js_p, int start)
+{
+    struct server_sm_worker *w = &sm_workers[server_sm_worker_index(smcb)];
+    struct server_sm_work *work;
+
+    work = (struct server_sm_work *) malloc(sizeof(*work));
+    if (!work)
+    {
+        /* run it here instead, once nothing of its family is running */
+        gossip_err("Warning: out of memory queueing state machine %p; "
+                   "running it in place.\n", smcb);
+        gen_mutex_lock(&w->mutex);
+        while (!qlist_empty(&w->queue) || w->busy)
+        {
+            gen_cond_wait(&w->idle_cond, &w->mutex);
+        }
+        w->busy++;
+        gen_mutex_unlock(&w->mutex);
+
+        if (start)
+        {
+            server_sm_start(smcb, js_p);
+        }
+        else if (SM_ACTION_ISERR(PINT_state_machine_continue(smcb, js_p)))
+        {
+            gossip_err("Error: state machine processing error\n");
+        }
+
+        gen_mutex_lock(&w->mutex);
+        if (--w->busy == 0 && qlist_empty(&w->queue))
+        {
+            gen_cond_broadcast(&w->idle_cond);
+        }
+        gen_mutex_unlock(&w->mutex);
+        return;
+    }
+    work->smcb = smcb;
+    work->js = *js_p;
+    work->start = start;
+
+    gen_mutex_lock(&w->mutex);
+    qlist_add_tail(&work->link, &w->queue);
+    if (w->waiting)
+    {
+        gen_cond_signal(&w->work_cond);
+    }
+    gen_mutex_unlock(&w->mutex);
+}
+
+static void *server_sm_worker_fn(void *arg)
+{
+    struct server_sm_worker *w = (struct server_sm_worker *) arg;
+    struct server_sm_work *work, *tmp;
+    struct qlist_head batch;
+    sigset_t mask;
+    int ret;
+
+    /* leave signals to the main thread, apart from those raised by
+     * faults in this one
+     */
+    sigfillset(&mask);
+    sigdelset(&mask, SIGSEGV);
+    sigdelset(&mask, SIGBUS);
+    sigdelset(&mask, SIGILL);
+    sigdelset(&mask, SIGFPE);
+    sigdelset(&mask, SIGABRT);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    gen_mutex_lock(&w->mutex);
+    for (;;)
+    {
+        while (qlist_empty(&w->queue) && !w->stop)
+        {
+            w->waiting = 1;
+            gen_cond_wait(&w->work_cond, &w->mutex);
+            w->waiting = 0;
+        }
+        if (qlist_empty(&w->queue))
+        {
+            break;
+        }
+
+        /* take everything queued so far */
+        INIT_QLIST_HEAD(&batch);
+        qlist_splice(&w->queue, &batch);
+        INIT_QLIST_HEAD(&w->queue);
+        w->busy++;
+        gen_mutex_unlock(&w->mutex);
+
+        qlist_for_each_entry_safe(work, tmp, &batch, link)
+        {
+            if (work->start)
+            {
+                server_sm_start(work->smcb, &work->js);
+            }
+            else
+            {
+                ret = PINT_state_machine_continue(work->smcb, &work->js);
+                if (SM_ACTION_ISERR(ret))
+                {
+                    PVFS_perror_gossip("Error: state machine processing "
+                                       "error", ret);
+                }
+            }
+            free(work);
+        }
+
+        gen_mutex_lock(&w->mutex);
+        if (--w->busy == 0 && qlist_empty(&w->queue))
+        {
+            gen_cond_broadcast(&w->idle_cond);
+        }
+    }
+    gen_mutex_unlock(&w->mutex);
+    return NULL;
+}
+
+/* server_sm_workers_start()
+ *
+ * starts the state machine threads; completed jobs are handed to them
+ * from then on
+ *
+ * returns 0 on success, -PVFS_error on failure
+ */
+static int server_sm_workers_start(int count)
+{
+    struct server_sm_worker *workers;
+    int i;
+    int ret;
+
+    workers = (struct server_sm_worker *) calloc(count, sizeof(*workers));
+    if (!workers)
+    {
+        return -PVFS_ENOMEM;
+    }
+    for (i = 0; i < count; i++)
+    {
+        gen_mutex_init(&workers[i].mutex);
+        gen_cond_init(&workers[i].work_cond);
+        gen_cond_init(&workers[i].idle_cond);
+        INIT_QLIST_HEAD(&workers[i].queue);
+    }
+
+    /* the dispatch path only looks at these once the threads exist */
+    sm_worker_count = count;
+    for (i = 0; i < count; i++)
+    {
+        ret = pthread_create(&workers[i].thread, NULL,
+                             server_sm_worker_fn, &workers[i]);
+        if (ret != 0)
+        {
+            sm_worker_count = i;
+            sm_workers = workers;
+            server_sm_workers_stop();
+            return -PVFS_ENOMEM;
+        }
+    }
+    sm_workers = workers;
+
+    gossip_debug(GOSSIP_SERVER_DEBUG, "Running state machines on %d "
+                 "threads.\n", count);
+    return 0;
+}
+
+/* server_sm_workers_quiesce()
+ *
+ * waits until every state machine handed to a worker has run; as only the
+ * main loop hands out work, none run again until it dispatches more
+ */
+static void server_sm_workers_quiesce(void)
+{
+    int i;
+
+    for (i = 0; i < sm_worker_count && sm_workers; i++)
+    {
+        gen_mutex_lock(&sm_workers[i].mutex);
+        while (!qlist_empty(&sm_workers[i].queue) || sm_workers[i].busy)
+        {
+            gen_cond_wait(&sm_workers[i].idle_cond, &sm_workers[i].mutex);
+        }
+        gen_mutex_unlock(&sm_workers[i].mutex);
+    }
+}
+
+/* server_sm_workers_stop()
+ *
+ * runs whatever is still queued, then stops the state machine threads;
+ * later completions are left in the job layer
+ */
+static void server_sm_workers_stop(void)
+{
+    struct server_sm_worker *workers = sm_workers;
+    int count = sm_worker_count;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        gen_mutex_lock(&workers[i].mutex);
+        workers[i].stop = 1;
+        gen_cond_signal(&workers[i].work_cond);
+        gen_mutex_unlock(&workers[i].mutex);
+    }
+    for (i = 0; i < count; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    sm_workers = NULL;
+    sm_worker_count = 0;
+    for (i = 0; i < count; i++)
+    {
+        gen_cond_destroy(&workers[i].work_cond);
+        gen_cond_destroy(&workers[i].idle_cond);
+        gen_mutex_destroy(&workers[i].mutex);
+    }
+    free(workers);
+}
+
 /* server_purge_unexpected_recv_machines()
  *
  * removes any s_ops that were posted to field unexpected BMI messages
@@ -2324,8 +2749,10 @@ static int server_purge_unexpected_recv_machines(void)
 {
     struct qlist_head *tmp = NULL, *tmp2 = NULL;
 
+    gen_mutex_lock(&server_sop_list_mutex);
     if (qlist_empty(&posted_sop_list))
     {
+        gen_mutex_unlock(&server_sop_list_mutex);
         gossip_err("WARNING: Found empty posted operation list!\n");
         return -PVFS_EINVAL;
     }
@@ -2345,6 +2772,7 @@ static int server_purge_unexpected_recv_machines(void)
         /* cancel the pending job_bmi_unexp operation */
         job_bmi_unexp_cancel(s_op->unexp_id);
     }
+    gen_mutex_unlock(&server_sop_list_mutex);
     return 0;
 }
 
@@ -2409,8 +2837,10 @@ int server_state_machine_start(
         return ret;
     }
     /* Remove s_op from posted_sop_list and move it to the inprogress_sop_list */
+    gen_mutex_lock(&server_sop_list_mutex);
     qlist_del(&s_op->next);
     qlist_add_tail(&s_op->next, &inprogress_sop_list);
+    gen_mutex_unlock(&server_sop_list_mutex);
 
     /* set timestamp on the beginning of this state machine */
     id_gen_fast_register(&tmp_id, s_op);
@@ -2510,7 +2940,9 @@ int server_state_machine_alloc_noreq(
  * side request
  *
  * PINT_server_op structure must have been previously allocated using
- * server_state_machine_alloc_noreq().
+ * server_state_machine_alloc_noreq().  On failure the caller still owns
+ * it; with state machine threads, the first state runs on one of them
+ * and a failure there frees it instead.
  *
  * returns 0 on success, -PVFS_error on failure
  */
@@ -2529,13 +2961,27 @@ int server_state_machine_start_noreq(struct PINT_smcb *smcb)
     {
 
         /* add to list of state machines started without a request */
+        gen_mutex_lock(&server_sop_list_mutex);
         qlist_add_tail(&new_op->next, &noreq_sop_list);
+        gen_mutex_unlock(&server_sop_list_mutex);
+
+        if (sm_workers)
+        {
+            /* the caller may itself be a state machine; the new one
+             * has to start on the worker its completions will go to
+             */
+            server_sm_dispatch(smcb, &tmp_status, 1);
+            return 0;
+        }
 
         /* execute first state */
         ret = PINT_state_machine_start(smcb, &tmp_status);
         if (ret < 0)
         {
             gossip_lerr("Error: failed to start state machine.\n");
+            gen_mutex_lock(&server_sop_list_mutex);
+            qlist_del(&new_op->next);
+            gen_mutex_unlock(&server_sop_list_mutex);
             return ret;
         }
     }
@@ -2558,7 +3004,9 @@ int server_state_machine_complete_noreq(PINT_smcb *smcb)
     gossip_debug(GOSSIP_SERVER_DEBUG, "%s: %p\n", __func__, smcb);
     id_gen_fast_register(&tmp_id, s_op);
                 
+    gen_mutex_lock(&server_sop_list_mutex);
     qlist_del(&s_op->next);
+    gen_mutex_unlock(&server_sop_list_mutex);
                 
     return SM_ACTION_TERMINATE;
 }
@@ -2621,7 +3069,9 @@ int server_state_machine_complete(PINT_smcb *smcb)
 
 
    /* Remove s_op from the inprogress_sop_list */
+    gen_mutex_lock(&server_sop_list_mutex);
     qlist_del(&s_op->next);
+    gen_mutex_unlock(&server_sop_list_mutex);
 
     return SM_ACTION_TERMINATE;
 }
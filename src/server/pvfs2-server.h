@@ -220,6 +220,26 @@ struct PINT_server_mirror_op
 };
 typedef struct PINT_server_mirror_op PINT_server_mirror_op;
 
+/* used during the processing of a "copy_range" request; the copy is a
+ * mirror of part of one datafile to a single destination datafile */
+struct PINT_server_copy_range_op
+{
+   /* logical length of the range covered by local data */
+   PVFS_size length;
+
+   /* bytes of local data that fall within that range */
+   PVFS_size bytes;
+
+   /* number of outstanding jobs (write ack and flow) */
+   int job_count;
+
+   /* maximum response size for the write request */
+   int max_resp_sz;
+
+   /* the write to the destination datafile */
+   write_job_t job;
+};
+
 /* Source refers to the handle being copied, and destination refers to        */
 /* its copy.                                                                  */
 struct PINT_server_create_copies_op
@@ -367,16 +387,27 @@ struct PINT_server_readdir_op
     PVFS_size dirdata_size;
 };
 
-typedef struct
+struct PINT_server_readdirplus_op
 {
-    int start_entry;
-    int nentries;
-} split_msg_boundary;
+    uint64_t directory_version;
+    uint32_t attrmask;          /* requested mask, less capability */
+    int dirent_count;           /* entries read from the dirdata object */
+    PVFS_ds_position position;  /* dirdata position after them */
+    PVFS_object_attr *attr_a;   /* per entry attributes */
+    PVFS_error *errors;         /* per entry status */
+    int parallel_sms;
+    /* local datafiles whose sizes are returned, and their slots in
+     * the response size array */
+    int dfile_count;
+    PVFS_handle *dfile_handles;
+    int *dfile_slots;
+    PVFS_error *dfile_errors;
+    PVFS_ds_attributes *dfile_ds_attr;
+};
 
 struct PINT_server_crdirent_op
 {
     PVFS_credential credential;
-    PVFS_capability capability;
     char *name;
     PVFS_handle new_handle;
     PVFS_handle parent_handle;
@@ -388,26 +419,10 @@ struct PINT_server_crdirent_op
     int dir_attr_update_required;
     PVFS_object_attr dirdata_attr;
     PVFS_ds_attributes dirdata_ds_attr;
-
-    /* index of node to receive directory entries when a split is necessary. */
-    int split_node;
-
-    /* Save the old directory attrs in case we have to back out due to an error. */
-    PVFS_object_attr saved_attr;
-
-    /* variables used for sending mgmt_split_dirent request */
-    PVFS_BMI_addr_t svr_addr; /*destination server address*/
-    PVFS_error *split_status; /*status from PVFS_SERV_MGMT_SPLIT_DIRENT*/
-    PINT_dist *dist; /*distribution structure for basic_dist*/
-    int read_all_directory_entries;
-    int nentries;
-    PVFS_handle *entry_handles;
-    char **entry_names;
-    int num_msgs_required;
-    split_msg_boundary *msg_boundaries;
-    PVFS_ds_keyval *entries_key_a;
-    PVFS_ds_keyval *entries_val_a;
-    PVFS_handle *remote_dirdata_handles;
+    /* crdirent_list only: one status per entry and the entry being
+     * written */
+    PVFS_error *list_errors;
+    uint32_t list_index;
 };
 
 struct PINT_server_setattr_op
@@ -512,11 +527,19 @@ struct PINT_server_io_op
     flow_descriptor* flow_d;
 };
 
+struct small_io_queue;
+
 struct PINT_server_small_io_op
 {
     PVFS_offset offsets[IO_MAX_REGIONS];
     PVFS_size sizes[IO_MAX_REGIONS];
     PVFS_size result_bytes;
+    int segs;                        /* regions used in offsets/sizes */
+    /* coalescing state; see small-io.sm */
+    struct small_io_queue *queue;    /* datafile queue, NULL if not batched */
+    struct qlist_head queue_link;    /* link in the queue's op list */
+    struct PINT_smcb *smcb;          /* for waking this op */
+    int batch_error;                 /* result of the op's batch */
 };
 
 struct PINT_server_flush_op
@@ -577,6 +600,14 @@ struct PINT_server_listattr_op
     int parallel_sms;
 };
 
+struct PINT_server_create_list_op
+{
+    PVFS_servresp_create_list_entry *entries;
+    PVFS_handle *dfile_handles;
+    struct PINT_server_op **frames;  /* nested create of each entry */
+    int parallel_sms;
+};
+
 /* this is used in both set_eattr, get_eattr and list_eattr */
 struct PINT_server_eattr_op
 {
@@ -628,6 +659,45 @@ struct PINT_server_perf_update_op
     struct PINT_perf_counter *tpc;
 };
 
+struct PINT_dirent_split;
+
+struct PINT_server_dirent_split_op
+{
+    struct PINT_dirent_split *split; /* registry entry for this split */
+    PVFS_fs_id fs_id;
+    PVFS_handle handle;         /* dirdata handle being split */
+    PVFS_handle parent_handle;
+    PVFS_handle dest_handle;    /* dirdata handle receiving entries */
+    int split_node;
+    PVFS_capability capability;
+    PVFS_credential credential;
+    PINT_dist *dist;
+    int undo;                   /* removing copies from dest_handle */
+    int flipped;                /* new attrs written to the source */
+    PVFS_ds_keyval_handle_info keyval_handle_info;
+    PVFS_object_attr saved_attr;
+    PVFS_handle *remote_dirdata_handles;
+
+    /* one batch of entries read from the source */
+    PVFS_ds_position position;
+    PVFS_ds_keyval *key_a;
+    PVFS_ds_keyval *val_a;
+    PVFS_error *error_a;
+    PVFS_dirent *dirents;
+    int count;
+    /* the part of the batch sent to dest_handle */
+    char **names;
+    PVFS_handle *handles;
+    int nentries;
+
+    /* names touched while copying, replayed before the bitmap flips */
+    char **replay_names;
+    int replay_count;
+    int replay_index;
+    int replay_batch;
+    struct timespec flip_time;
+};
+
 /* This structure is passed into the void *ptr 
  * within the job interface.  Used to tell us where
  * to go next in our state machine.
@@ -703,11 +773,13 @@ typedef struct PINT_server_op
         struct PINT_server_eattr_op eattr;
         struct PINT_server_getattr_op getattr;
         struct PINT_server_listattr_op listattr;
+        struct PINT_server_create_list_op create_list;
         struct PINT_server_getconfig_op getconfig;
         struct PINT_server_lookup_op lookup;
         struct PINT_server_crdirent_op crdirent;
         struct PINT_server_setattr_op setattr;
         struct PINT_server_readdir_op readdir;
+        struct PINT_server_readdirplus_op readdirplus;
         struct PINT_server_remove_op remove;
         struct PINT_server_chdirent_op chdirent;
         struct PINT_server_rmdirent_op rmdirent;
@@ -725,10 +797,12 @@ typedef struct PINT_server_op
         struct PINT_server_unstuff_op unstuff;
         struct PINT_server_create_copies_op create_copies;
         struct PINT_server_mirror_op mirror;
+        struct PINT_server_copy_range_op copy_range;
         struct PINT_server_tree_communicate_op tree_communicate;
         struct PINT_server_mgmt_get_dirent_op mgmt_get_dirent;
         struct PINT_server_mgmt_create_root_dir_op mgmt_create_root_dir;
         struct PINT_server_perf_update_op perf_update;
+        struct PINT_server_dirent_split_op dirent_split;
     } u;
 
 } PINT_server_op;
@@ -897,6 +971,7 @@ extern struct PINT_state_machine_s pvfs2_pjmp_mirror_work_sm;
 extern struct PINT_state_machine_s pvfs2_pjmp_create_immutable_copies_sm;
 extern struct PINT_state_machine_s pvfs2_pjmp_get_attr_work_sm;
 extern struct PINT_state_machine_s pvfs2_pjmp_set_attr_work_sm;
+extern struct PINT_state_machine_s pvfs2_pjmp_create_work_sm;
 
 /* nested state machines */
 extern struct PINT_state_machine_s pvfs2_set_attr_work_sm;
@@ -912,6 +987,7 @@ extern struct PINT_state_machine_s pvfs2_remove_work_sm;
 extern struct PINT_state_machine_s pvfs2_remove_with_prelude_sm;
 extern struct PINT_state_machine_s pvfs2_mkdir_work_sm;
 extern struct PINT_state_machine_s pvfs2_crdirent_work_sm;
+extern struct PINT_state_machine_s pvfs2_create_work_sm;
 extern struct PINT_state_machine_s pvfs2_unexpected_sm;
 extern struct PINT_state_machine_s pvfs2_create_immutable_copies_sm;
 extern struct PINT_state_machine_s pvfs2_mirror_work_sm;
@@ -926,6 +1002,7 @@ extern void tree_setattr_free(PINT_server_op *s_op);
 extern void tree_remove_free(PINT_server_op *s_op);
 extern void mkdir_free(struct PINT_server_op *s_op);
 extern void getattr_free(struct PINT_server_op *s_op);
+extern void create_free(struct PINT_server_op *s_op);
 
 /* Exported Prototypes */
 int server_perf_start_rollover(struct PINT_perf_counter *pc,
@@ -946,6 +1023,7 @@ int server_state_machine_complete(PINT_smcb *smcb);
 int server_state_machine_terminate(PINT_smcb *smcb, job_status_s *js_p);
 
 /* lists of server ops */
+extern gen_mutex_t server_sop_list_mutex;
 extern struct qlist_head posted_sop_list;
 extern struct qlist_head inprogress_sop_list;
 
@@ -956,6 +1034,21 @@ int server_state_machine_start_noreq(
     struct PINT_smcb *new_op);
 int server_state_machine_complete_noreq(PINT_smcb *smcb);
 
+/* background directory splits (dirent-split.sm) */
+int PINT_dirent_split_start(PVFS_fs_id fs_id,
+                            PVFS_handle handle,
+                            PVFS_handle parent_handle,
+                            PVFS_object_attr *attr,
+                            int split_node,
+                            const PVFS_credential *credential);
+void PINT_dirent_split_note(PVFS_fs_id fs_id,
+                            PVFS_handle handle,
+                            const char *name);
+int PINT_dirent_split_filter(PVFS_fs_id fs_id,
+                             PVFS_handle handle,
+                             PVFS_dirent *dirent_array,
+                             int count);
+
 /* INCLUDE STATE-MACHINE.H DOWN HERE */
 #if 0
 #define PINT_OP_STATE       PINT_server_op
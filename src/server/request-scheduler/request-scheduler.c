@@ -13,14 +13,18 @@
  *
  *  An implementation of the server side request scheduler API.  
  *
- *  \note this is a prototype.  It simply hashes on the handle
- *  value in the request and builds a linked list for each handle.
- *  Only the request at the head of each list is allowed to proceed.
- */
-
-/* LONG TERM
- * TODO: come up with a more sophisticated scheduling and
- *  consistency model
+ *  Requests are hashed on the handle value and kept in a linked list
+ *  for each handle, in arrival order.  Each request is assigned an
+ *  access group (shared, I/O read, I/O write or exclusive) and is
+ *  admitted as soon as it is compatible with every request that is
+ *  already active on that handle.  Shared requests may bypass a queued
+ *  exclusive request a bounded number of times (see
+ *  PINT_REQ_SCHED_MAX_BYPASS) so that writers cannot be starved.
+ *
+ *  Requests that had to queue are released through per-class ready
+ *  queues (metadata, bulk I/O, management).  Within a class, ready
+ *  requests are served round robin across clients, and the classes
+ *  themselves are served in weighted round robin order.
  */
 
 #include <errno.h>
@@ -38,6 +42,7 @@
 #include "gossip.h"
 #include "id-generator.h"
 #include "pvfs2-internal.h"
+#include "pint-perf-counter.h"
 
 /* we need the server header because it defines the operations that
  * we use to determine whether to schedule or queue.  
@@ -64,12 +69,51 @@ enum req_sched_states
     REQ_TIMING,
 };
 
+/** access groups; determine which requests may run concurrently on
+ *  the same handle
+ */
+enum req_sched_group
+{
+    /** read only access; also used for crdirent/rmdirent */
+    REQ_GROUP_SHARED = 0,
+    /** I/O that only reads the datafile */
+    REQ_GROUP_IO_READ = 1,
+    /** I/O that modifies the datafile */
+    REQ_GROUP_IO_WRITE = 2,
+    /** anything else that modifies the object */
+    REQ_GROUP_EXCLUSIVE = 3,
+    REQ_GROUP_COUNT = 4
+};
+
 /** linked lists to be stored at each hash table element */
 struct req_sched_list
 {
     struct qlist_head hash_link;
     struct qlist_head req_list;
     PVFS_handle handle;
+    /* number of scheduled or ready requests in each access group */
+    int active_count[REQ_GROUP_COUNT];
+    /* number of requests in the list that are still queued */
+    int queued_count;
+    /* shared requests admitted ahead of a queued request */
+    int bypass_count;
+};
+
+/** per client ready queue for one request class */
+struct req_sched_client
+{
+    struct qlist_head hash_link;    /* ties it to client table */
+    struct qlist_head rr_link;      /* ties it to its class rotation */
+    struct qlist_head ready_list;   /* ready elements from this client */
+    PVFS_BMI_addr_t addr;
+    enum PINT_req_sched_class op_class;
+};
+
+/** key used to look up a client ready queue */
+struct req_sched_client_key
+{
+    PVFS_BMI_addr_t addr;
+    enum PINT_req_sched_class op_class;
 };
 
 /** linked list elements; one for each request in the scheduler */
@@ -88,17 +132,37 @@ struct req_sched_element
     enum PINT_server_req_access_type access_type;
     int mode_change; /* specifies that the element is a mode change */
     enum PVFS_server_mode mode; /* the mode to change to */
+    PVFS_BMI_addr_t client_addr;       /* client that sent the request */
+    enum PINT_req_sched_class op_class; /* class used for ready queues */
+    enum req_sched_group group;         /* access group on the handle */
+    struct req_sched_client *client;    /* ready queue, if ready */
+    struct timespec wait_start;         /* time the request was queued */
 };
 
+/** scheduling state for one request class */
+struct req_sched_class_queue
+{
+    struct qlist_head rr_list;  /* clients with ready requests */
+    int weight;                 /* requests per round */
+    int credit;                 /* requests left in this round */
+    int ready_count;            /* requests waiting to be handed out */
+    int queued_count;           /* requests not yet scheduled */
+};
 
 /* hash table */
 static struct qhash_table *req_sched_table;
 
-/* queue of requests that are ready for service (in case
- * test_world is called 
- */
-static QLIST_HEAD(
-    ready_queue);
+/* per client ready queues, hashed on (client address, class) */
+static struct qhash_table *req_sched_client_table;
+
+/* ready queues for each class of request */
+static struct req_sched_class_queue class_queues[PINT_REQ_SCHED_CLASS_COUNT];
+
+/* class that weighted round robin will look at first */
+static int rr_next_class = 0;
+
+/* how many times shared requests may pass a queued request */
+static int max_bypass = PINT_REQ_SCHED_MAX_BYPASS_DEFAULT;
 
 /* queue of timed operations */
 static QLIST_HEAD(
@@ -114,6 +178,28 @@ static int hash_handle(
 static int hash_handle_compare(
     const void *key,
     struct qlist_head *link);
+static int hash_client(
+    const void *key,
+    int table_size);
+static int hash_client_compare(
+    const void *key,
+    struct qlist_head *link);
+
+#ifdef __PVFS2_SERVER__
+/* perf counter keys indexed by request class */
+static int class_depth_keys[PINT_REQ_SCHED_CLASS_COUNT] =
+{
+    PINT_PERF_REQSCHED_META_QUEUED,
+    PINT_PERF_REQSCHED_IO_QUEUED,
+    PINT_PERF_REQSCHED_MGMT_QUEUED
+};
+static int class_wait_tkeys[PINT_REQ_SCHED_CLASS_COUNT] =
+{
+    PINT_PERF_TREQSCHED_META_WAIT,
+    PINT_PERF_TREQSCHED_IO_WAIT,
+    PINT_PERF_TREQSCHED_MGMT_WAIT
+};
+#endif
 
 /* count of how many items are known to the scheduler */
 static int sched_count = 0;
@@ -127,6 +213,318 @@ enum PVFS_server_mode PINT_req_sched_get_mode(void)
     return(current_mode);
 }
 
+/* req_sched_op_class()
+ *
+ * maps a server operation to the class it is scheduled under
+ */
+static enum PINT_req_sched_class req_sched_op_class(enum PVFS_server_op op)
+{
+    switch(op)
+    {
+        case PVFS_SERV_IO:
+        case PVFS_SERV_SMALL_IO:
+        case PVFS_SERV_TRUNCATE:
+        case PVFS_SERV_MIRROR:
+        case PVFS_SERV_COPY_RANGE:
+        case PVFS_SERV_IMM_COPIES:
+        case PVFS_SERV_UNSTUFF:
+            return PINT_REQ_SCHED_CLASS_IO;
+        case PVFS_SERV_GETCONFIG:
+        case PVFS_SERV_MGMT_SETPARAM:
+        case PVFS_SERV_MGMT_NOOP:
+        case PVFS_SERV_STATFS:
+        case PVFS_SERV_MGMT_PERF_MON:
+        case PVFS_SERV_MGMT_ITERATE_HANDLES:
+        case PVFS_SERV_MGMT_DSPACE_INFO_LIST:
+        case PVFS_SERV_MGMT_EVENT_MON:
+        case PVFS_SERV_MGMT_REMOVE_OBJECT:
+        case PVFS_SERV_MGMT_REMOVE_DIRENT:
+        case PVFS_SERV_MGMT_GET_DIRDATA_HANDLE:
+        case PVFS_SERV_MGMT_GET_UID:
+        case PVFS_SERV_MGMT_GET_DIRENT:
+        case PVFS_SERV_MGMT_CREATE_ROOT_DIR:
+        case PVFS_SERV_MGMT_SPLIT_DIRENT:
+        case PVFS_SERV_MGMT_GET_USER_CERT:
+        case PVFS_SERV_MGMT_GET_USER_CERT_KEYREQ:
+            return PINT_REQ_SCHED_CLASS_MGMT;
+        default:
+            return PINT_REQ_SCHED_CLASS_METADATA;
+    }
+}
+
+/* req_sched_op_group()
+ *
+ * determines which access group a request belongs to
+ */
+static enum req_sched_group req_sched_op_group(
+    enum PVFS_server_op op,
+    enum PINT_server_req_access_type access_type)
+{
+    /* small I/O shares the datafile like I/O so that concurrent
+     * requests can be coalesced (see small-io.sm); copy_range reads its
+     * datafile like an I/O read, and must not block the I/O write it
+     * issues when the copy stays within one datafile
+     */
+    if(op == PVFS_SERV_IO || op == PVFS_SERV_SMALL_IO ||
+       op == PVFS_SERV_COPY_RANGE)
+    {
+        return (access_type == PINT_SERVER_REQ_READONLY) ?
+            REQ_GROUP_IO_READ : REQ_GROUP_IO_WRITE;
+    }
+    /* directory entry operations on the same dirdata handle are
+     * serialized at the trove level, so they may share the handle
+     */
+    if(op == PVFS_SERV_CRDIRENT || op == PVFS_SERV_CRDIRENT_LIST ||
+       op == PVFS_SERV_RMDIRENT || access_type == PINT_SERVER_REQ_READONLY)
+    {
+        return REQ_GROUP_SHARED;
+    }
+    return REQ_GROUP_EXCLUSIVE;
+}
+
+/* req_sched_compatible()
+ *
+ * returns 1 if a request in the given access group may run alongside
+ * the requests that are currently active on the list, 0 otherwise
+ */
+static int req_sched_compatible(struct req_sched_list *list,
+                                enum req_sched_group group)
+{
+    int *active = list->active_count;
+
+    switch(group)
+    {
+        case REQ_GROUP_SHARED:
+            return (active[REQ_GROUP_EXCLUSIVE] == 0 &&
+                    active[REQ_GROUP_IO_WRITE] == 0);
+        case REQ_GROUP_IO_READ:
+            return (active[REQ_GROUP_EXCLUSIVE] == 0);
+        case REQ_GROUP_IO_WRITE:
+            return (active[REQ_GROUP_EXCLUSIVE] == 0 &&
+                    active[REQ_GROUP_SHARED] == 0);
+        default:
+            return (active[REQ_GROUP_SHARED] == 0 &&
+                    active[REQ_GROUP_IO_READ] == 0 &&
+                    active[REQ_GROUP_IO_WRITE] == 0 &&
+                    active[REQ_GROUP_EXCLUSIVE] == 0);
+    }
+}
+
+/* req_sched_class_depth()
+ *
+ * adjusts the number of unscheduled requests in a class and updates
+ * the matching perf counter
+ */
+static void req_sched_class_depth(enum PINT_req_sched_class op_class,
+                                  int delta)
+{
+    class_queues[op_class].queued_count += delta;
+    assert(class_queues[op_class].queued_count >= 0);
+#ifdef __PVFS2_SERVER__
+    PINT_perf_count(PINT_server_pc, class_depth_keys[op_class],
+                    class_queues[op_class].queued_count, PINT_PERF_SET);
+#endif
+}
+
+/* req_sched_wait_done()
+ *
+ * records how long a queued request waited before it was scheduled
+ */
+static void req_sched_wait_done(struct req_sched_element *element)
+{
+    if(!element->list_head)
+    {
+        /* mode changes are not counted */
+        return;
+    }
+    req_sched_class_depth(element->op_class, -1);
+#ifdef __PVFS2_SERVER__
+    PINT_perf_timer_end(PINT_server_tpc, class_wait_tkeys[element->op_class],
+                        &element->wait_start);
+#endif
+}
+
+/* ready_enqueue()
+ *
+ * adds an element to the ready queue of its client and class
+ *
+ * returns 0 on success, -errno on failure
+ */
+static int ready_enqueue(struct req_sched_element *element)
+{
+    struct qlist_head *hash_link;
+    struct req_sched_client *client;
+    struct req_sched_class_queue *cq = &class_queues[element->op_class];
+    struct req_sched_client_key key;
+
+    key.addr = element->client_addr;
+    key.op_class = element->op_class;
+
+    hash_link = qhash_search(req_sched_client_table, &key);
+    if(hash_link)
+    {
+        client = qlist_entry(hash_link, struct req_sched_client, hash_link);
+    }
+    else
+    {
+        client = (struct req_sched_client *)malloc(sizeof(*client));
+        if(!client)
+        {
+            return(-ENOMEM);
+        }
+        client->addr = key.addr;
+        client->op_class = key.op_class;
+        INIT_QLIST_HEAD(&client->ready_list);
+        qhash_add(req_sched_client_table, &key, &client->hash_link);
+    }
+
+    if(qlist_empty(&client->ready_list))
+    {
+        /* client joins the back of the rotation for this class */
+        qlist_add_tail(&client->rr_link, &cq->rr_list);
+    }
+    qlist_add_tail(&element->ready_link, &client->ready_list);
+    element->client = client;
+    cq->ready_count++;
+
+    return(0);
+}
+
+/* ready_remove()
+ *
+ * removes an element from its ready queue, releasing the client queue
+ * if it becomes empty
+ */
+static void ready_remove(struct req_sched_element *element)
+{
+    struct req_sched_client *client = element->client;
+
+    qlist_del(&element->ready_link);
+    class_queues[element->op_class].ready_count--;
+    element->client = NULL;
+
+    if(client && qlist_empty(&client->ready_list))
+    {
+        qlist_del(&client->rr_link);
+        qlist_del(&client->hash_link);
+        free(client);
+    }
+}
+
+/* ready_next()
+ *
+ * picks the next ready element using weighted round robin across
+ * classes and round robin across the clients within a class
+ *
+ * returns element on success, NULL if nothing is ready
+ */
+static struct req_sched_element *ready_next(void)
+{
+    int pass, i, idx;
+    struct req_sched_class_queue *cq;
+    struct req_sched_client *client;
+    struct req_sched_element *element;
+
+    for(pass = 0; pass < 2; pass++)
+    {
+        for(i = 0; i < PINT_REQ_SCHED_CLASS_COUNT; i++)
+        {
+            idx = (rr_next_class + i) % PINT_REQ_SCHED_CLASS_COUNT;
+            cq = &class_queues[idx];
+            if(cq->ready_count == 0 || cq->credit <= 0)
+            {
+                continue;
+            }
+
+            client = qlist_entry(cq->rr_list.next, struct req_sched_client,
+                                 rr_link);
+            element = qlist_entry(client->ready_list.next,
+                                  struct req_sched_element, ready_link);
+
+            cq->credit--;
+            if(cq->credit == 0)
+            {
+                rr_next_class = (idx + 1) % PINT_REQ_SCHED_CLASS_COUNT;
+            }
+
+            if(element->ready_link.next != &client->ready_list)
+            {
+                /* client has more ready; move it to the back of the
+                 * rotation
+                 */
+                qlist_del(&client->rr_link);
+                qlist_add_tail(&client->rr_link, &cq->rr_list);
+            }
+            /* note: this frees the client queue if it is now empty */
+            ready_remove(element);
+            return(element);
+        }
+
+        /* every class with ready work has used its share; start a new
+         * round
+         */
+        for(i = 0; i < PINT_REQ_SCHED_CLASS_COUNT; i++)
+        {
+            class_queues[i].credit = class_queues[i].weight;
+        }
+    }
+
+    return(NULL);
+}
+
+/* req_sched_activate()
+ *
+ * marks an element as active on its handle list
+ */
+static void req_sched_activate(struct req_sched_element *element)
+{
+    element->list_head->active_count[element->group]++;
+}
+
+/* req_sched_wake()
+ *
+ * walks a handle list in arrival order, moving queued requests to the
+ * ready state for as long as they are compatible with the active ones
+ */
+static void req_sched_wake(struct req_sched_list *list)
+{
+    struct qlist_head *iterator;
+    struct req_sched_element *element;
+
+    qlist_for_each(iterator, &list->req_list)
+    {
+        element = qlist_entry(iterator, struct req_sched_element,
+                              list_link);
+        if(element->state != REQ_QUEUED)
+        {
+            continue;
+        }
+        if(!req_sched_compatible(list, element->group))
+        {
+            /* never let a later request pass a blocked one here;
+             * bounded bypass only happens at post time
+             */
+            break;
+        }
+
+        gossip_debug(GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED waking "
+                     "request, handle: %llu, queue_element: %p\n",
+                     llu(element->handle), element);
+        if(ready_enqueue(element) < 0)
+        {
+            /* leave it queued; it will be looked at again on the next
+             * release for this handle
+             */
+            gossip_err("Error: request scheduler out of memory.\n");
+            break;
+        }
+        element->state = REQ_READY_TO_SCHEDULE;
+        list->queued_count--;
+        list->bypass_count = 0;
+        req_sched_activate(element);
+    }
+}
+
 /* setup and teardown */
 
 /** Initializes the request scheduler.  Must be called before any other
@@ -137,6 +535,8 @@ enum PVFS_server_mode PINT_req_sched_get_mode(void)
 int PINT_req_sched_initialize(
     void)
 {
+    int i;
+
     /* build hash table */
     req_sched_table = qhash_init(hash_handle_compare, hash_handle, 1021);
     if (!req_sched_table)
@@ -144,9 +544,69 @@ int PINT_req_sched_initialize(
 	return (-ENOMEM);
     }
 
+    req_sched_client_table = qhash_init(hash_client_compare, hash_client,
+                                        1021);
+    if (!req_sched_client_table)
+    {
+        qhash_finalize(req_sched_table);
+        return (-ENOMEM);
+    }
+
+    for (i = 0; i < PINT_REQ_SCHED_CLASS_COUNT; i++)
+    {
+        INIT_QLIST_HEAD(&class_queues[i].rr_list);
+        class_queues[i].ready_count = 0;
+        class_queues[i].queued_count = 0;
+    }
+    class_queues[PINT_REQ_SCHED_CLASS_METADATA].weight =
+        PINT_REQ_SCHED_METADATA_WEIGHT_DEFAULT;
+    class_queues[PINT_REQ_SCHED_CLASS_IO].weight =
+        PINT_REQ_SCHED_IO_WEIGHT_DEFAULT;
+    class_queues[PINT_REQ_SCHED_CLASS_MGMT].weight =
+        PINT_REQ_SCHED_MGMT_WEIGHT_DEFAULT;
+    for (i = 0; i < PINT_REQ_SCHED_CLASS_COUNT; i++)
+    {
+        class_queues[i].credit = class_queues[i].weight;
+    }
+    rr_next_class = 0;
+
     return (0);
 }
 
+/** Sets a tunable parameter of the request scheduler
+ *
+ *  \return 0 on success, -errno on failure
+ */
+int PINT_req_sched_set_info(
+    enum PINT_req_sched_option option,
+    int arg)
+{
+    if (arg < 0)
+    {
+        return (-EINVAL);
+    }
+
+    switch (option)
+    {
+    case PINT_REQ_SCHED_METADATA_WEIGHT:
+    case PINT_REQ_SCHED_IO_WEIGHT:
+    case PINT_REQ_SCHED_MGMT_WEIGHT:
+        /* a class always gets at least one request per round */
+        if (arg < 1)
+        {
+            return (-EINVAL);
+        }
+        class_queues[option].weight = arg;
+        class_queues[option].credit = arg;
+        return (0);
+    case PINT_REQ_SCHED_MAX_BYPASS:
+        max_bypass = arg;
+        return (0);
+    default:
+        return (-EINVAL);
+    }
+}
+
 /** Free resources held by the timer queue
  */
 int PINT_timer_queue_finalize(void)
@@ -180,6 +640,7 @@ int PINT_req_sched_finalize(
 {
     int i;
     struct req_sched_list *tmp_list;
+    struct req_sched_client *tmp_client;
     struct qlist_head *scratch;
     struct qlist_head *iterator;
     struct qlist_head *scratch2;
@@ -211,9 +672,28 @@ int PINT_req_sched_finalize(
 	}
     }
 
+    /* ready queues only reference elements freed above */
+    for (i = 0; i < req_sched_client_table->table_size; i++)
+    {
+        qlist_for_each_safe(iterator, scratch,
+                            &(req_sched_client_table->array[i]))
+        {
+            tmp_client = qlist_entry(iterator, struct req_sched_client,
+                                     hash_link);
+            free(tmp_client);
+        }
+    }
+    for (i = 0; i < PINT_REQ_SCHED_CLASS_COUNT; i++)
+    {
+        INIT_QLIST_HEAD(&class_queues[i].rr_list);
+        class_queues[i].ready_count = 0;
+        class_queues[i].queued_count = 0;
+    }
+
     sched_count = 0;
 
-    /* tear down hash table */
+    /* tear down hash tables */
+    qhash_finalize(req_sched_client_table);
     qhash_finalize(req_sched_table);
     return (0);
 }
@@ -241,6 +721,7 @@ int PINT_req_sched_change_mode(enum PVFS_server_mode mode,
     mode_element->state = REQ_QUEUED;
     mode_element->mode_change = 1;
     mode_element->mode = mode;
+    mode_element->op_class = PINT_REQ_SCHED_CLASS_MGMT;
 
     /* will this be the front of the queue */
     if(qlist_empty(&mode_queue))
@@ -310,8 +791,11 @@ static int PINT_req_sched_schedule_mode_change(void)
     {
 	next_element = qlist_entry(mode_queue.next, struct req_sched_element,
 	    list_link);
-	next_element->state = REQ_READY_TO_SCHEDULE;
-	qlist_add_tail(&next_element->ready_link, &ready_queue);
+        if(next_element->state == REQ_QUEUED &&
+           ready_enqueue(next_element) == 0)
+        {
+            next_element->state = REQ_READY_TO_SCHEDULE;
+        }
     }
     return 0;
 }
@@ -335,6 +819,7 @@ static void PINT_req_sched_do_change_mode(
 int PINT_req_sched_post(enum PVFS_server_op op,
                         PVFS_fs_id fs_id,
                         PVFS_handle handle,
+                        PVFS_BMI_addr_t client_addr,
                         enum PINT_server_req_access_type access_type,
                         enum PINT_server_sched_policy sched_policy,
 			void *in_user_ptr,
@@ -343,12 +828,7 @@ int PINT_req_sched_post(enum PVFS_server_op op,
     struct qlist_head *hash_link;
     int ret = -1;
     struct req_sched_element *tmp_element;
-    struct req_sched_element *tmp_element2;
     struct req_sched_list *tmp_list;
-    struct req_sched_element *next_element;
-    struct req_sched_element *last_element;
-    struct qlist_head *iterator;
-    int tmp_flag;
 
     if(sched_policy == PINT_SERVER_REQ_BYPASS)
     {
@@ -373,6 +853,14 @@ int PINT_req_sched_post(enum PVFS_server_op op,
      * on handle == 0 for the moment...
      */
 
+    if(access_type == PINT_SERVER_REQ_MODIFY && !PVFS_SERV_IS_MGMT_OP(op))
+    {
+        if(PINT_req_sched_in_admin_mode())
+        {
+            return(-PVFS_EAGAIN);
+        }
+    }
+
     /* create a structure to store in the request queues */
     tmp_element = (struct req_sched_element *) malloc(sizeof(struct
 							     req_sched_element));
@@ -384,22 +872,14 @@ int PINT_req_sched_post(enum PVFS_server_op op,
 
     tmp_element->op = op;
     tmp_element->user_ptr = in_user_ptr;
-    id_gen_fast_register(out_id, tmp_element);
-    tmp_element->id = *out_id;
     tmp_element->state = REQ_QUEUED;
     tmp_element->handle = handle;
     tmp_element->list_head = NULL;
     tmp_element->access_type = access_type;
     tmp_element->mode_change = 0;
-
-    if(access_type == PINT_SERVER_REQ_MODIFY && !PVFS_SERV_IS_MGMT_OP(op))
-    {
-        if(PINT_req_sched_in_admin_mode())
-        {
-            free(tmp_element);
-            return(-PVFS_EAGAIN);
-        }
-    }
+    tmp_element->client_addr = client_addr;
+    tmp_element->op_class = req_sched_op_class(op);
+    tmp_element->group = req_sched_op_group(op, access_type);
 
     /* see if we have a request queue up for this handle */
     hash_link = qhash_search(req_sched_table, &(handle));
@@ -420,6 +900,7 @@ int PINT_req_sched_post(enum PVFS_server_op op,
 	    free(tmp_element);
 	    return (-ENOMEM);
 	}
+        memset(tmp_list, 0, sizeof(*tmp_list));
 
 	tmp_list->handle = handle;
 	INIT_QLIST_HEAD(&(tmp_list->req_list));
@@ -429,117 +910,56 @@ int PINT_req_sched_post(enum PVFS_server_op op,
     }
 
     /* at either rate, we now have a pointer to the list head */
+    tmp_element->list_head = tmp_list;
 
-    /* return 1 if the list is empty before we add this entry */
-    ret = qlist_empty(&(tmp_list->req_list));
-    if (ret == 1)
+    if (!req_sched_compatible(tmp_list, tmp_element->group))
     {
-	tmp_element->state = REQ_SCHEDULED;
+        /* conflicts with something that is already running */
+        ret = 0;
     }
-    else
+    else if (tmp_list->queued_count == 0)
     {
-        /* check queue to see if we can apply any optimizations */
-        /* first check: are all current queued operations already scheduled
-         * (ie, is the first and last scheduled?).  We can never bypass a
-         * queued operation 
+        /* nothing is waiting on this handle; go ahead */
+        ret = 1;
+    }
+    else if (tmp_element->group != REQ_GROUP_EXCLUSIVE &&
+             tmp_list->bypass_count < max_bypass)
+    {
+        /* something is waiting, but it is blocked by the same active
+         * requests that this one can share the handle with.  Let a
+         * bounded number of these through before the waiting request
+         * gets its turn.
          */
-	next_element = qlist_entry((tmp_list->req_list.next),
-				   struct req_sched_element,
-				   list_link);
-	last_element = qlist_entry((tmp_list->req_list.prev),
-				   struct req_sched_element,
-				   list_link);
-	if (op == PVFS_SERV_IO &&
-	    next_element->state == REQ_SCHEDULED &&
-	    last_element->state == REQ_SCHEDULED)
-	{
-            /* possible I/O optimization: see if all scheduled ops for this
-             * handle are for I/O.  If so, we can allow another concurrent
-             * I/O request to proceed 
-             */
-            tmp_flag = 0;
-            qlist_for_each(iterator, &tmp_list->req_list)
-            {
-                tmp_element2 = qlist_entry(iterator, struct req_sched_element,
-                    list_link);
-                if(tmp_element2->op != PVFS_SERV_IO)
-                {
-                    tmp_flag = 1;
-                    break;
-                }
-            }
+        tmp_list->bypass_count++;
+        gossip_debug(GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED allowing "
+                     "concurrent %s (bypass %d), handle: %llu\n",
+                     (tmp_element->group == REQ_GROUP_SHARED) ?
+                         "shared access" : "I/O",
+                     tmp_list->bypass_count, llu(handle));
+        ret = 1;
+    }
+    else
+    {
+        ret = 0;
+    }
 
-            if(!tmp_flag)
-            {
-                tmp_element->state = REQ_SCHEDULED;
-                ret = 1;
-                gossip_debug(GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED allowing "
-                             "concurrent I/O, handle: %llu\n", llu(handle));
-            }
-            else
-            {
-                tmp_element->state = REQ_QUEUED;
-                ret = 0;
-            }
-	}
-	else if (access_type == PINT_SERVER_REQ_READONLY &&
-	    next_element->state == REQ_SCHEDULED &&
-	    last_element->state == REQ_SCHEDULED)
-        {
-            /* possible read only optimization: see if all scheduled ops 
-             * for this handle are read only.  If so, we can allow another 
-             * concurrent read only request to proceed 
-             */
-            tmp_flag = 0;
-            qlist_for_each(iterator, &tmp_list->req_list)
-            {
-                tmp_element2 = qlist_entry(iterator, struct req_sched_element,
-                    list_link);
-                if(tmp_element2->access_type == PINT_SERVER_REQ_MODIFY)
-                {
-                    tmp_flag = 1;
-                    break;
-                }
-            }
+    id_gen_fast_register(out_id, tmp_element);
+    tmp_element->id = *out_id;
 
-            if(!tmp_flag)
-            {
-                tmp_element->state = REQ_SCHEDULED;
-                ret = 1;
-                gossip_debug(GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED allowing "
-                             "concurrent read only, handle: %llu\n", llu(handle));
-            }
-            else
-            {
-                tmp_element->state = REQ_QUEUED;
-                ret = 0;
-            }
-        }
-        else if((op == PVFS_SERV_CRDIRENT || op == PVFS_SERV_RMDIRENT) &&
-                next_element->state == REQ_SCHEDULED &&
-                last_element->state == REQ_SCHEDULED)
-        {
-            /* possible dirent optimization: see if all scheduled ops for this
-             * handle are for crdirent or rmdirent.  
-             * If so, we can allow another concurrent
-             * dirent request to proceed.
-             */
-            tmp_element->state = REQ_SCHEDULED;
-            tmp_element->access_type = PINT_SERVER_REQ_READONLY;
-            gossip_debug(GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED allowing "
-                         "concurrent dirent op, handle: %llu\n", 
-                         llu(handle));
-            ret = 1;
-        }
-	else
-	{
-	    tmp_element->state = REQ_QUEUED;
-	    ret = 0;
-	}
+    if (ret == 1)
+    {
+        tmp_element->state = REQ_SCHEDULED;
+        req_sched_activate(tmp_element);
+    }
+    else
+    {
+        tmp_element->state = REQ_QUEUED;
+        tmp_list->queued_count++;
+        req_sched_class_depth(tmp_element->op_class, 1);
+        PINT_perf_timer_start(&tmp_element->wait_start);
     }
 
     /* add this element to the list */
-    tmp_element->list_head = tmp_list;
     qlist_add_tail(&(tmp_element->list_link), &(tmp_list->req_list));
 
     gossip_debug(GOSSIP_REQ_SCHED_DEBUG,
@@ -648,12 +1068,7 @@ int PINT_req_sched_unpost(
     void **returned_user_ptr)
 {
     struct req_sched_element *tmp_element = NULL;
-    struct req_sched_element *next_element = NULL;
-    int next_ready_flag = 0;
-
-    /* NOTE: we set the next_ready_flag to 1 if the next element in
-     * the queue should be put in the ready list 
-     */
+    struct req_sched_list *tmp_list = NULL;
 
     /* retrieve the element directly from the id */
     tmp_element = id_gen_fast_lookup(in_id);
@@ -664,11 +1079,21 @@ int PINT_req_sched_unpost(
 	return (-EALREADY);
     }
 
+    tmp_list = tmp_element->list_head;
+
     if (tmp_element->state == REQ_READY_TO_SCHEDULE)
     {
-	qlist_del(&(tmp_element->ready_link));
-	next_ready_flag = 1;
-	/* fall through on purpose */
+	ready_remove(tmp_element);
+        if (tmp_list)
+        {
+            tmp_list->active_count[tmp_element->group]--;
+            req_sched_class_depth(tmp_element->op_class, -1);
+        }
+    }
+    else if (tmp_element->state == REQ_QUEUED && tmp_list)
+    {
+        tmp_list->queued_count--;
+        req_sched_class_depth(tmp_element->op_class, -1);
     }
 
     if (returned_user_ptr)
@@ -679,59 +1104,21 @@ int PINT_req_sched_unpost(
     qlist_del(&(tmp_element->list_link));
 
     /* special operations, like mode changes, may not be associated with a list */
-    if(tmp_element->list_head)
+    if(tmp_list)
     {
 	/* see if there is another request queued behind this one */
-	if (qlist_empty(&(tmp_element->list_head->req_list)))
+	if (qlist_empty(&(tmp_list->req_list)))
 	{
 	    /* queue now empty, remove from hash table and destroy */
-	    qlist_del(&(tmp_element->list_head->hash_link));
-	    free(tmp_element->list_head);
+	    qlist_del(&(tmp_list->hash_link));
+	    free(tmp_list);
 	}
 	else
 	{
-	    /* queue not empty, prepare next request in line for
-	     * processing if necessary
+	    /* queue not empty, prepare next requests in line for
+	     * processing if they are no longer blocked
 	     */
-	    if (next_ready_flag)
-	    {
-		next_element =
-		    qlist_entry((tmp_element->list_head->req_list.next),
-				struct req_sched_element,
-				list_link);
-		/* skip looking at the next request if it is already
-		 * ready to go 
-		 */
-		if (next_element->state != REQ_READY_TO_SCHEDULE &&
-		    next_element->state != REQ_SCHEDULED)
-		{
-		    next_element->state = REQ_READY_TO_SCHEDULE;
-		    qlist_add_tail(&(next_element->ready_link), &ready_queue);
-		    /* keep going as long as the operations are I/O requests;
-		     * we let these all go concurrently
-		     */
-		    while (next_element && next_element->op == PVFS_SERV_IO
-			   && next_element->list_link.next !=
-			   &(tmp_element->list_head->req_list))
-		    {
-			next_element =
-			    qlist_entry(next_element->list_link.next,
-					struct req_sched_element,
-					list_link);
-			if (next_element
-			    && next_element->op == PVFS_SERV_IO)
-			{
-			    gossip_debug(
-                                GOSSIP_REQ_SCHED_DEBUG, "REQ SCHED "
-                                "allowing concurrent I/O, handle: %llu\n",
-                                llu(next_element->handle));
-			    next_element->state = REQ_READY_TO_SCHEDULE;
-			    qlist_add_tail(&(next_element->ready_link),
-					   &ready_queue);
-			}
-		    }
-		}
-	    }
+            req_sched_wake(tmp_list);
 	}
 	sched_count--;
     }
@@ -756,7 +1143,6 @@ int PINT_req_sched_release(
 {
     struct req_sched_element *tmp_element = NULL;
     struct req_sched_list *tmp_list = NULL;
-    struct req_sched_element *next_element = NULL;
 
     /* NOTE: for now, this function always returns immediately- no
      * need to fill in the out_id
@@ -783,6 +1169,9 @@ int PINT_req_sched_release(
     /* special operations, like mode changes, may not be associated w/ a list */
     if(tmp_list)
     {
+        tmp_list->active_count[tmp_element->group]--;
+        assert(tmp_list->active_count[tmp_element->group] >= 0);
+
 	/* find out if there is another operation queued behind it or
 	 * not 
 	 */
@@ -796,77 +1185,10 @@ int PINT_req_sched_release(
 	}
 	else
 	{
-	    /* something is queued behind this request */
-	    /* find the next request, change its state, and add it to
-	     * the queue of requests that are ready to be scheduled
+	    /* something is queued behind this request; move everything
+	     * that is no longer blocked to the ready queues
 	     */
-	    next_element = qlist_entry((tmp_list->req_list.next),
-				       struct req_sched_element,
-				       list_link);
-	    /* skip it if the top queue item is already ready for
-	     * scheduling 
-	     */
-	    if (next_element->state != REQ_READY_TO_SCHEDULE &&
-		next_element->state != REQ_SCHEDULED)
-	    {
-		next_element->state = REQ_READY_TO_SCHEDULE;
-		qlist_add_tail(&(next_element->ready_link), &ready_queue);
-
-                if(next_element->op == PVFS_SERV_IO)
-                {
-                    /* keep going as long as the operations are I/O requests;
-                     * we let these all go concurrently
-                     */
-                    while (next_element &&
-                           (next_element->op == PVFS_SERV_IO) &&
-                           (next_element->list_link.next != &(tmp_list->req_list)))
-                    {
-                        next_element =
-                            qlist_entry(next_element->list_link.next,
-                                        struct req_sched_element,
-                                        list_link);
-                        if (next_element &&
-                            (next_element->op == PVFS_SERV_IO))
-                        {
-                            gossip_debug(
-                                GOSSIP_REQ_SCHED_DEBUG,
-                                "REQ SCHED allowing concurrent I/O (release time), "
-                                "handle: %llu\n", llu(next_element->handle));
-                            assert(next_element->state == REQ_QUEUED);
-                            next_element->state = REQ_READY_TO_SCHEDULE;
-                            qlist_add_tail(
-                                &(next_element->ready_link), &ready_queue);
-                        }
-                    }
-                }
-                else if(next_element->access_type == PINT_SERVER_REQ_READONLY)
-                {
-                    /* keep going as long as the operations are read only;
-                     * we let these all go concurrently
-                     */
-                    while (next_element &&
-                           (next_element->access_type == PINT_SERVER_REQ_READONLY) &&
-                           (next_element->list_link.next != &(tmp_list->req_list)))
-                    {
-                        next_element =
-                            qlist_entry(next_element->list_link.next,
-                                        struct req_sched_element,
-                                        list_link);
-                        if (next_element &&
-                            (next_element->access_type == PINT_SERVER_REQ_READONLY))
-                        {
-                            gossip_debug(
-                                GOSSIP_REQ_SCHED_DEBUG,
-                                "REQ SCHED allowing concurrent read only (release time), "
-                                "handle: %llu\n", llu(next_element->handle));
-                            assert(next_element->state == REQ_QUEUED);
-                            next_element->state = REQ_READY_TO_SCHEDULE;
-                            qlist_add_tail(
-                                &(next_element->ready_link), &ready_queue);
-                        }
-                    }
-                }
-	    }
+            req_sched_wake(tmp_list);
 	}
 	sched_count--;
     }
@@ -918,7 +1240,8 @@ int PINT_req_sched_test(
 	/* let it roll */
 	tmp_element->state = REQ_SCHEDULED;
 	/* remove from ready queue */
-	qlist_del(&(tmp_element->ready_link));
+	ready_remove(tmp_element);
+        req_sched_wait_done(tmp_element);
 	if (returned_user_ptr_p)
 	{
 	    returned_user_ptr_p[0] = tmp_element->user_ptr;
@@ -1011,7 +1334,8 @@ int PINT_req_sched_testsome(
 	    /* let it roll */
 	    tmp_element->state = REQ_SCHEDULED;
 	    /* remove from ready queue, leave in hash table queue */
-	    qlist_del(&(tmp_element->ready_link));
+	    ready_remove(tmp_element);
+            req_sched_wait_done(tmp_element);
 	    if (returned_user_ptr_array)
 	    {
 		returned_user_ptr_array[*inout_count_p] = tmp_element->user_ptr;
@@ -1112,12 +1436,8 @@ int PINT_req_sched_testworld(
 	}
     }
 
-    while (!qlist_empty(&ready_queue) && (*inout_count_p < incount))
+    while (*inout_count_p < incount && (tmp_element = ready_next()) != NULL)
     {
-	tmp_element = qlist_entry((ready_queue.next), struct req_sched_element,
-				  ready_link);
-	/* remove from ready queue */
-	qlist_del(&(tmp_element->ready_link));
 	out_id_array[*inout_count_p] = tmp_element->id;
 	if (returned_user_ptr_array)
 	{
@@ -1125,6 +1445,7 @@ int PINT_req_sched_testworld(
 	}
 	out_status_array[*inout_count_p] = 0;
 	tmp_element->state = REQ_SCHEDULED;
+        req_sched_wait_done(tmp_element);
 	(*inout_count_p)++;
 	gossip_debug(GOSSIP_REQ_SCHED_DEBUG,
 		     "REQ SCHED SCHEDULING, "
@@ -1185,6 +1506,47 @@ static int hash_handle_compare(
     return (0);
 }
 
+/* hash_client()
+ *
+ * hash function for client ready queues
+ *
+ * returns integer offset into table
+ */
+static int hash_client(
+    const void *key,
+    int table_size)
+{
+    const struct req_sched_client_key *real_key = key;
+    uint64_t tmp;
+
+    tmp = ((uint64_t)real_key->addr * PINT_REQ_SCHED_CLASS_COUNT) +
+        real_key->op_class;
+    return ((int)(tmp % table_size));
+}
+
+/* hash_client_compare()
+ *
+ * performs a comparison of a client ready queue to a given key
+ *
+ * returns 1 if match found, 0 otherwise
+ */
+static int hash_client_compare(
+    const void *key,
+    struct qlist_head *link)
+{
+    const struct req_sched_client_key *real_key = key;
+    struct req_sched_client *client;
+
+    client = qlist_entry(link, struct req_sched_client, hash_link);
+    if (client->addr == real_key->addr &&
+        client->op_class == real_key->op_class)
+    {
+        return (1);
+    }
+
+    return (0);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -35,6 +35,33 @@ enum PINT_server_sched_policy
     PINT_SERVER_REQ_SCHEDULE
 };
 
+/** classes of requests; queued requests of each class are released
+ *  in weighted round robin order
+ */
+enum PINT_req_sched_class
+{
+    PINT_REQ_SCHED_CLASS_METADATA = 0,
+    PINT_REQ_SCHED_CLASS_IO = 1,
+    PINT_REQ_SCHED_CLASS_MGMT = 2,
+    PINT_REQ_SCHED_CLASS_COUNT = 3
+};
+
+/** tunable parameters for PINT_req_sched_set_info() */
+enum PINT_req_sched_option
+{
+    /* weights share values with the matching request class */
+    PINT_REQ_SCHED_METADATA_WEIGHT = PINT_REQ_SCHED_CLASS_METADATA,
+    PINT_REQ_SCHED_IO_WEIGHT = PINT_REQ_SCHED_CLASS_IO,
+    PINT_REQ_SCHED_MGMT_WEIGHT = PINT_REQ_SCHED_CLASS_MGMT,
+    /** number of shared requests that may pass a queued request */
+    PINT_REQ_SCHED_MAX_BYPASS = 3
+};
+
+#define PINT_REQ_SCHED_METADATA_WEIGHT_DEFAULT 4
+#define PINT_REQ_SCHED_IO_WEIGHT_DEFAULT 4
+#define PINT_REQ_SCHED_MGMT_WEIGHT_DEFAULT 1
+#define PINT_REQ_SCHED_MAX_BYPASS_DEFAULT 16
+
 /* setup and teardown */
 int PINT_req_sched_initialize(
     void);
@@ -44,12 +71,16 @@ int PINT_req_sched_finalize(
 
 int PINT_timer_queue_finalize(void);
 
+int PINT_req_sched_set_info(enum PINT_req_sched_option option,
+                            int arg);
+
 
 /* retrieving information about incoming requests */
 /* scheduler submission */
 int PINT_req_sched_post(enum PVFS_server_op op,
                         PVFS_fs_id fs_id,
                         PVFS_handle handle,
+                        PVFS_BMI_addr_t client_addr,
                         enum PINT_server_req_access_type access_type,
                         enum PINT_server_sched_policy sched_policy,
 			void *in_user_ptr,
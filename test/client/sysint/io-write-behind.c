@@ -0,0 +1,351 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ *
+ * Exercises client write-behind: creates a file, turns on write-behind,
+ * appends it in small pieces followed by a forward strided pattern,
+ * checks the size and contents seen through getattr and read, and
+ * reports how many application writes went out per I/O request.  With
+ * -n the same writes are issued without write-behind for comparison.
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "client.h"
+#include "pvfs2-util.h"
+#include "str-utils.h"
+#include "pint-sysint-utils.h"
+#include "pvfs2-internal.h"
+#include "wbcache.h"
+
+#define DEFAULT_WRITE_SIZE 4096
+#define DEFAULT_WRITE_COUNT 1024
+#define STRIDED_COUNT 64
+
+static double wtime(void)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return ((double) t.tv_sec + (double) t.tv_usec / 1000000.0);
+}
+
+static char pattern(PVFS_offset off)
+{
+    return ((char) ('a' + (off % 23)));
+}
+
+static int write_at(PVFS_object_ref ref, PVFS_offset off, char *buf,
+                    int size, PVFS_credential *credentials)
+{
+    PVFS_Request mem_req;
+    PVFS_sysresp_io resp_io;
+    int i = 0;
+    int ret = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        buf[i] = pattern(off + i);
+    }
+    ret = PVFS_Request_contiguous(size, PVFS_BYTE, &mem_req);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = PVFS_sys_write(ref, PVFS_BYTE, off, buf, mem_req,
+                         credentials, &resp_io, NULL);
+    PVFS_Request_free(&mem_req);
+    if (ret == 0 && resp_io.total_completed != size)
+    {
+        ret = -PVFS_EIO;
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = -1;
+    char str_buf[256] = {0};
+    char *filename = NULL;
+    char *buf = NULL;
+    char *rbuf = NULL;
+    PVFS_fs_id cur_fs;
+    PVFS_sysresp_create resp_create;
+    PVFS_sysresp_getattr resp_getattr;
+    PVFS_sysresp_io resp_io;
+    PVFS_Request mem_req;
+    PVFS_object_ref parent_refn;
+    PVFS_object_ref ref;
+    PVFS_sys_attr attr;
+    PVFS_credential credentials;
+    PVFS_size expected_size = 0;
+    PVFS_offset off = 0;
+    int write_size = DEFAULT_WRITE_SIZE;
+    int write_count = DEFAULT_WRITE_COUNT;
+    int use_wb = 1;
+    int errors = 0;
+    int64_t writes = 0;
+    int64_t flushes = 0;
+    int64_t *counts = NULL;
+    struct PINT_perf_counter *pc = NULL;
+    int i = 0;
+    int c = 0;
+    double t1, t2;
+
+    while ((c = getopt(argc, argv, "s:c:n")) != -1)
+    {
+        switch (c)
+        {
+        case 's':
+            write_size = atoi(optarg);
+            break;
+        case 'c':
+            write_count = atoi(optarg);
+            break;
+        case 'n':
+            use_wb = 0;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-s size] [-c count] [-n] "
+                    "filename\n", argv[0]);
+            return (-1);
+        }
+    }
+    if (optind != argc - 1 || write_size < 1 || write_count < 1)
+    {
+        fprintf(stderr, "Usage: %s [-s size] [-c count] [-n] filename\n",
+                argv[0]);
+        return (-1);
+    }
+    filename = argv[optind];
+
+    ret = PVFS_util_init_defaults();
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_util_init_defaults", ret);
+        return (-1);
+    }
+    ret = PVFS_util_get_default_fsid(&cur_fs);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_util_get_default_fsid", ret);
+        return (-1);
+    }
+
+    if (PINT_remove_base_dir(filename, str_buf, 256))
+    {
+        if (filename[0] != '/')
+        {
+            printf("You forgot the leading '/'\n");
+        }
+        printf("Cannot retrieve entry name for creation on %s\n",
+               filename);
+        return (-1);
+    }
+
+    memset(&resp_create, 0, sizeof(PVFS_sysresp_create));
+    PVFS_util_gen_credential_defaults(&credentials);
+
+    attr.mask = PVFS_ATTR_SYS_ALL_SETABLE;
+    attr.owner = credentials.userid;
+    attr.group = credentials.group_array[0];
+    attr.perms = 0644;
+    attr.atime = attr.ctime = attr.mtime = time(NULL);
+
+    ret = PINT_lookup_parent(filename, cur_fs, &credentials,
+                             &parent_refn.handle);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_util_lookup_parent", ret);
+        return (-1);
+    }
+    parent_refn.fs_id = cur_fs;
+
+    ret = PVFS_sys_create(str_buf, parent_refn, attr,
+                          &credentials, NULL, &resp_create, NULL, NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_create", ret);
+        return (-1);
+    }
+    ref = resp_create.ref;
+
+    if (use_wb)
+    {
+        ret = PVFS_sys_write_behind_enable(ref);
+        if (ret < 0)
+        {
+            PVFS_perror("PVFS_sys_write_behind_enable", ret);
+            return (-1);
+        }
+    }
+
+    buf = malloc(write_size);
+    if (!buf)
+    {
+        fprintf(stderr, "Error: out of memory.\n");
+        return (-1);
+    }
+
+    /* sequential appends */
+    t1 = wtime();
+    for (i = 0; i < write_count; i++)
+    {
+        ret = write_at(ref, off, buf, write_size, &credentials);
+        if (ret < 0)
+        {
+            PVFS_perror("sequential write", ret);
+            return (-1);
+        }
+        off += write_size;
+    }
+    t2 = wtime();
+    printf("%d sequential writes of %d bytes: %f seconds\n",
+           write_count, write_size, t2 - t1);
+
+    /* forward strided writes, leaving holes of the same size */
+    for (i = 0; i < STRIDED_COUNT; i++)
+    {
+        off += write_size;
+        ret = write_at(ref, off, buf, write_size, &credentials);
+        if (ret < 0)
+        {
+            PVFS_perror("strided write", ret);
+            return (-1);
+        }
+        off += write_size;
+    }
+    expected_size = off;
+
+    /* the size must include data still buffered */
+    ret = PVFS_sys_getattr(ref, PVFS_ATTR_SYS_SIZE, &credentials,
+                           &resp_getattr, NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_getattr", ret);
+        return (-1);
+    }
+    if (resp_getattr.attr.size != expected_size)
+    {
+        fprintf(stderr, "Error: size %lld, expected %lld\n",
+                lld(resp_getattr.attr.size), lld(expected_size));
+        errors++;
+    }
+    PVFS_util_release_sys_attr(&resp_getattr.attr);
+
+    /* leave some data buffered for the read to find */
+    ret = write_at(ref, expected_size, buf, write_size, &credentials);
+    if (ret < 0)
+    {
+        PVFS_perror("tail write", ret);
+        return (-1);
+    }
+    expected_size += write_size;
+
+    rbuf = malloc(expected_size);
+    if (!rbuf)
+    {
+        fprintf(stderr, "Error: out of memory.\n");
+        return (-1);
+    }
+    ret = PVFS_Request_contiguous(expected_size, PVFS_BYTE, &mem_req);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_Request_contiguous", ret);
+        return (-1);
+    }
+    ret = PVFS_sys_read(ref, PVFS_BYTE, 0, rbuf, mem_req, &credentials,
+                        &resp_io, NULL);
+    PVFS_Request_free(&mem_req);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_read", ret);
+        return (-1);
+    }
+    if (resp_io.total_completed != expected_size)
+    {
+        fprintf(stderr, "Error: read %lld bytes, expected %lld\n",
+                lld(resp_io.total_completed), lld(expected_size));
+        errors++;
+    }
+    off = (PVFS_offset) write_count * write_size;
+    for (i = 0; i < resp_io.total_completed; i++)
+    {
+        int in_hole = (i >= off && i < expected_size - write_size &&
+                       ((i - off) / write_size) % 2 == 0);
+        char want = in_hole ? 0 : pattern(i);
+        if (rbuf[i] != want)
+        {
+            fprintf(stderr, "Error: mismatch at offset %d\n", i);
+            errors++;
+            break;
+        }
+    }
+
+    ret = PVFS_sys_flush(ref, &credentials, NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_flush", ret);
+        errors++;
+    }
+
+    if (use_wb)
+    {
+        /* counts since the last rollover */
+        pc = PINT_wbcache_get_pc();
+        if (pc && pc->sample)
+        {
+            counts = pc->sample->value.c;
+            writes = counts[PERF_WBCACHE_WRITES];
+            flushes = counts[PERF_WBCACHE_FLUSHES];
+        }
+        printf("write-behind: %lld writes buffered in %lld requests",
+               lld(writes), lld(flushes));
+        if (flushes)
+        {
+            printf(" (%.1f writes per request)",
+                   (double) writes / (double) flushes);
+        }
+        printf("\n");
+
+        ret = PVFS_sys_write_behind_release(ref);
+        if (ret < 0)
+        {
+            PVFS_perror("PVFS_sys_write_behind_release", ret);
+            errors++;
+        }
+    }
+
+    free(buf);
+    free(rbuf);
+
+    ret = PVFS_sys_finalize();
+    if (ret < 0)
+    {
+        printf("finalizing sysint failed with errcode = %d\n", ret);
+        return (-1);
+    }
+
+    if (errors)
+    {
+        printf("FAILED\n");
+        return (-1);
+    }
+    printf("PASSED\n");
+    return (0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
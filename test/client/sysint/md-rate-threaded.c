@@ -0,0 +1,329 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ *
+ * Measures metadata rates as the number of client threads grows: for
+ * 1, 2, 4, ... up to the given number of threads, every thread creates
+ * its own set of files in one shared directory, then stats them, then
+ * removes them, and the aggregate creates, stats and removes per second
+ * are printed for each thread count.  The client attribute cache is
+ * turned off so every stat reaches the server.  Run it against servers
+ * configured with different ServerStateMachineThreads values to see how
+ * well state machine processing scales on the server.
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "client.h"
+#include "pvfs2-util.h"
+#include "pvfs2-internal.h"
+
+#define DEFAULT_MAX_THREADS 16
+#define DEFAULT_FILES_PER_THREAD 200
+
+enum md_phase
+{
+    PHASE_CREATE = 0,
+    PHASE_STAT = 1,
+    PHASE_REMOVE = 2,
+    PHASE_COUNT = 3
+};
+
+static const char *phase_names[PHASE_COUNT] = {"create", "stat", "remove"};
+
+struct md_thread
+{
+    pthread_t id;
+    int rank;
+    int round;
+    int nfiles;
+    PVFS_object_ref dir_ref;
+    PVFS_object_ref *refs;
+    PVFS_credential credentials;
+    int errors;
+};
+
+static pthread_barrier_t phase_barrier;
+
+static double wtime(void)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return ((double) t.tv_sec + (double) t.tv_usec / 1000000.0);
+}
+
+static void run_phase(struct md_thread *t, enum md_phase phase)
+{
+    PVFS_sys_attr attr;
+    PVFS_sysresp_create resp_create;
+    PVFS_sysresp_getattr resp_getattr;
+    char name[64];
+    int i;
+    int ret = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.owner = t->credentials.userid;
+    attr.group = t->credentials.group_array[0];
+    attr.perms = 0644;
+    attr.atime = attr.ctime = attr.mtime = time(NULL);
+    attr.mask = PVFS_ATTR_SYS_ALL_SETABLE;
+
+    for (i = 0; i < t->nfiles; i++)
+    {
+        snprintf(name, sizeof(name), "r%d-t%d-f%d", t->round, t->rank, i);
+        switch (phase)
+        {
+        case PHASE_CREATE:
+            ret = PVFS_sys_create(name, t->dir_ref, attr, &t->credentials,
+                                  NULL, &resp_create, NULL, NULL);
+            if (ret == 0)
+            {
+                t->refs[i] = resp_create.ref;
+            }
+            break;
+        case PHASE_STAT:
+            ret = PVFS_sys_getattr(t->refs[i], PVFS_ATTR_SYS_ALL_NOHINT,
+                                   &t->credentials, &resp_getattr, NULL);
+            if (ret == 0)
+            {
+                PVFS_util_release_sys_attr(&resp_getattr.attr);
+            }
+            break;
+        case PHASE_REMOVE:
+            ret = PVFS_sys_remove(name, t->dir_ref, &t->credentials, NULL);
+            break;
+        default:
+            break;
+        }
+        if (ret < 0)
+        {
+            if (!t->errors)
+            {
+                PVFS_perror(phase_names[phase], ret);
+            }
+            t->errors++;
+        }
+    }
+}
+
+static void *thread_fn(void *arg)
+{
+    struct md_thread *t = (struct md_thread *) arg;
+    int phase;
+
+    for (phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        /* the main thread times each phase between two barriers */
+        pthread_barrier_wait(&phase_barrier);
+        run_phase(t, phase);
+        pthread_barrier_wait(&phase_barrier);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = -1;
+    int c = 0;
+    int i = 0;
+    int nthreads = 0;
+    int round = 0;
+    int phase = 0;
+    int errors = 0;
+    int max_threads = DEFAULT_MAX_THREADS;
+    int nfiles = DEFAULT_FILES_PER_THREAD;
+    char *dirname = NULL;
+    char *entry_name = NULL;
+    PVFS_fs_id fs_id;
+    PVFS_credential credentials;
+    PVFS_sysresp_getparent gp_resp;
+    PVFS_sysresp_mkdir resp_mkdir;
+    PVFS_sys_attr attr;
+    struct md_thread *threads = NULL;
+    double start = 0;
+    double elapsed[PHASE_COUNT];
+
+    while ((c = getopt(argc, argv, "t:n:")) != -1)
+    {
+        switch (c)
+        {
+        case 't':
+            max_threads = atoi(optarg);
+            break;
+        case 'n':
+            nfiles = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t max_threads] "
+                    "[-n files_per_thread] dirname\n", argv[0]);
+            return (-1);
+        }
+    }
+    if (optind != argc - 1 || max_threads < 1 || nfiles < 1)
+    {
+        fprintf(stderr, "Usage: %s [-t max_threads] "
+                "[-n files_per_thread] dirname\n", argv[0]);
+        return (-1);
+    }
+    dirname = argv[optind];
+    if (dirname[0] != '/')
+    {
+        fprintf(stderr, "Error: %s must be an absolute path.\n", dirname);
+        return (-1);
+    }
+
+    ret = PVFS_util_init_defaults();
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_util_init_defaults", ret);
+        return (-1);
+    }
+    ret = PVFS_util_get_default_fsid(&fs_id);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_util_get_default_fsid", ret);
+        return (-1);
+    }
+
+    /* make every stat go to the server */
+    ret = PVFS_sys_set_info(PVFS_SYS_ACACHE_TIMEOUT_MSECS, 0);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_set_info", ret);
+        return (-1);
+    }
+
+    PVFS_util_gen_credential_defaults(&credentials);
+
+    memset(&gp_resp, 0, sizeof(gp_resp));
+    ret = PVFS_sys_getparent(fs_id, dirname, &credentials, &gp_resp, NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_getparent", ret);
+        return (-1);
+    }
+    entry_name = strrchr(dirname, '/') + 1;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.owner = credentials.userid;
+    attr.group = credentials.group_array[0];
+    attr.perms = 0755;
+    attr.atime = attr.ctime = attr.mtime = time(NULL);
+    attr.mask = PVFS_ATTR_SYS_ALL_SETABLE;
+
+    ret = PVFS_sys_mkdir(entry_name, gp_resp.parent_ref, attr,
+                         &credentials, &resp_mkdir, NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_mkdir", ret);
+        return (-1);
+    }
+
+    threads = (struct md_thread *) calloc(max_threads, sizeof(*threads));
+    if (!threads)
+    {
+        fprintf(stderr, "Error: out of memory.\n");
+        return (-1);
+    }
+    for (i = 0; i < max_threads; i++)
+    {
+        threads[i].refs = (PVFS_object_ref *)
+            malloc(nfiles * sizeof(PVFS_object_ref));
+        if (!threads[i].refs)
+        {
+            fprintf(stderr, "Error: out of memory.\n");
+            return (-1);
+        }
+    }
+
+    printf("%8s %8s %12s %12s %12s\n", "threads", "files",
+           "creates/sec", "stats/sec", "removes/sec");
+
+    for (nthreads = 1; nthreads <= max_threads; nthreads *= 2, round++)
+    {
+        pthread_barrier_init(&phase_barrier, NULL, nthreads + 1);
+        for (i = 0; i < nthreads; i++)
+        {
+            threads[i].rank = i;
+            threads[i].round = round;
+            threads[i].nfiles = nfiles;
+            threads[i].dir_ref = resp_mkdir.ref;
+            threads[i].credentials = credentials;
+            threads[i].errors = 0;
+            ret = pthread_create(&threads[i].id, NULL, thread_fn,
+                                 &threads[i]);
+            if (ret != 0)
+            {
+                fprintf(stderr, "Error: pthread_create failed.\n");
+                return (-1);
+            }
+        }
+
+        for (phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            pthread_barrier_wait(&phase_barrier);
+            start = wtime();
+            pthread_barrier_wait(&phase_barrier);
+            elapsed[phase] = wtime() - start;
+        }
+
+        for (i = 0; i < nthreads; i++)
+        {
+            pthread_join(threads[i].id, NULL);
+            errors += threads[i].errors;
+        }
+        pthread_barrier_destroy(&phase_barrier);
+
+        printf("%8d %8d %12.1f %12.1f %12.1f\n", nthreads,
+               nthreads * nfiles,
+               (double) (nthreads * nfiles) / elapsed[PHASE_CREATE],
+               (double) (nthreads * nfiles) / elapsed[PHASE_STAT],
+               (double) (nthreads * nfiles) / elapsed[PHASE_REMOVE]);
+        fflush(stdout);
+    }
+
+    ret = PVFS_sys_remove(entry_name, gp_resp.parent_ref, &credentials,
+                          NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PVFS_sys_remove", ret);
+        errors++;
+    }
+
+    for (i = 0; i < max_threads; i++)
+    {
+        free(threads[i].refs);
+    }
+    free(threads);
+
+    ret = PVFS_sys_finalize();
+    if (ret < 0)
+    {
+        printf("finalizing sysint failed with errcode = %d\n", ret);
+        return (-1);
+    }
+
+    if (errors)
+    {
+        printf("%d operations failed\n", errors);
+        return (-1);
+    }
+    return (0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,220 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/*
+ * Microbenchmark for the BMI method op_list.  Measures the cost of
+ * matching an incoming (address, tag) pair against the list of posted
+ * operations as the number of outstanding operations grows, using the
+ * indexed search that methods use for expected receives, and compares
+ * it to a full scan of the same list.  Also reports the cost of
+ * adding and removing an operation, since every post and completion
+ * pays for maintaining the indexes.
+ *
+ * No network is involved; operations and addresses are fabricated in
+ * memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "pvfs2.h"
+#include "bmi-method-support.h"
+#include "op-list.h"
+
+#define DEFAULT_MAX_OPS 16384
+#define DEFAULT_ADDRS 64
+#define DEFAULT_LOOKUPS 200000
+
+static double wtime(void)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return ((double) t.tv_sec + (double) t.tv_usec / 1000000.0);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-n max_ops] [-a addresses] [-l lookups]\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    int max_ops = DEFAULT_MAX_OPS;
+    int num_addrs = DEFAULT_ADDRS;
+    int lookups = DEFAULT_LOOKUPS;
+    bmi_method_addr_p *addrs = NULL;
+    method_op_p *ops = NULL;
+    op_list_p olp = NULL;
+    struct op_list_search_key key;
+    method_op_p found = NULL;
+    int scan_lookups = 0;
+    int nops = 0;
+    int i = 0;
+    int j = 0;
+    int c = 0;
+    double t1, t2;
+    double indexed_us, scan_us, churn_us;
+
+    while ((c = getopt(argc, argv, "n:a:l:")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            max_ops = atoi(optarg);
+            break;
+        case 'a':
+            num_addrs = atoi(optarg);
+            break;
+        case 'l':
+            lookups = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return (1);
+        }
+    }
+    if (max_ops < 1 || num_addrs < 1 || lookups < 1)
+    {
+        usage(argv[0]);
+        return (1);
+    }
+
+    addrs = malloc(num_addrs * sizeof(*addrs));
+    ops = malloc(max_ops * sizeof(*ops));
+    if (!addrs || !ops)
+    {
+        fprintf(stderr, "Error: out of memory.\n");
+        return (1);
+    }
+    for (i = 0; i < num_addrs; i++)
+    {
+        addrs[i] = bmi_alloc_method_addr(0, 0);
+        if (!addrs[i])
+        {
+            fprintf(stderr, "Error: out of memory.\n");
+            return (1);
+        }
+    }
+
+    printf("# %d addresses, %d lookups per point\n", num_addrs, lookups);
+    printf("# %10s %16s %16s %16s\n", "ops", "indexed (us)",
+           "full scan (us)", "add+remove (us)");
+
+    for (nops = 16; nops <= max_ops; nops *= 2)
+    {
+        olp = op_list_new();
+        if (!olp)
+        {
+            fprintf(stderr, "Error: op_list_new() failure.\n");
+            return (1);
+        }
+
+        /* spread ops round robin over the addresses; each address gets
+         * a run of distinct tags, as the server does for concurrent
+         * flows to the same client
+         */
+        for (i = 0; i < nops; i++)
+        {
+            ops[i] = bmi_alloc_method_op(0);
+            if (!ops[i])
+            {
+                fprintf(stderr, "Error: out of memory.\n");
+                return (1);
+            }
+            ops[i]->op_id = i;
+            ops[i]->addr = addrs[i % num_addrs];
+            ops[i]->msg_tag = i / num_addrs;
+            ops[i]->send_recv = BMI_RECV;
+            op_list_add(olp, ops[i]);
+        }
+
+        /* indexed (address, tag) matching */
+        memset(&key, 0, sizeof(key));
+        key.method_addr_yes = 1;
+        key.msg_tag_yes = 1;
+        t1 = wtime();
+        for (j = 0; j < lookups; j++)
+        {
+            i = (int) (((unsigned) j * 2654435761u) % (unsigned) nops);
+            key.method_addr = ops[i]->addr;
+            key.msg_tag = ops[i]->msg_tag;
+            found = op_list_search(olp, &key);
+            if (found != ops[i])
+            {
+                fprintf(stderr, "Error: indexed search mismatch.\n");
+                return (1);
+            }
+        }
+        t2 = wtime();
+        indexed_us = (t2 - t1) * 1000000.0 / lookups;
+
+        /* full scan; an op_id-only key is not indexed, which walks the
+         * list exactly as every search did before the indexes existed.
+         * Scale the lookup count down so large lists finish promptly.
+         */
+        scan_lookups = lookups / (nops / 16);
+        if (scan_lookups < 100)
+        {
+            scan_lookups = 100;
+        }
+        memset(&key, 0, sizeof(key));
+        key.op_id_yes = 1;
+        t1 = wtime();
+        for (j = 0; j < scan_lookups; j++)
+        {
+            i = (int) (((unsigned) j * 2654435761u) % (unsigned) nops);
+            key.op_id = ops[i]->op_id;
+            found = op_list_search(olp, &key);
+            if (found != ops[i])
+            {
+                fprintf(stderr, "Error: scan search mismatch.\n");
+                return (1);
+            }
+        }
+        t2 = wtime();
+        scan_us = (t2 - t1) * 1000000.0 / scan_lookups;
+
+        /* post/complete churn */
+        t1 = wtime();
+        for (j = 0; j < lookups; j++)
+        {
+            i = (int) (((unsigned) j * 2654435761u) % (unsigned) nops);
+            op_list_remove(ops[i]);
+            op_list_add(olp, ops[i]);
+        }
+        t2 = wtime();
+        churn_us = (t2 - t1) * 1000000.0 / lookups;
+
+        printf("  %10d %16.3f %16.3f %16.3f\n", nops, indexed_us, scan_us,
+               churn_us);
+
+        /* frees the ops as well */
+        op_list_cleanup(olp);
+    }
+
+    for (i = 0; i < num_addrs; i++)
+    {
+        bmi_dealloc_method_addr(addrs[i]);
+    }
+    free(addrs);
+    free(ops);
+
+    return (0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
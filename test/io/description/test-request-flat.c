@@ -0,0 +1,341 @@
+/*
+ * (C) 2002 Clemson University.
+ *
+ * See COPYING in top-level directory.
+ *
+ * Compares PINT_process_request() on flattened request states against
+ * the tree walk it replaces.  Each case processes a noncontiguous type
+ * both ways, in server mode for one of four servers (with small strips
+ * so that most of each type belongs to other servers) and in client mode
+ * with a memory type, a few segments at a time so that every call
+ * resumes where the last one stopped.  The segments have to match
+ * exactly; the rates are segments produced per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "pvfs2-types.h"
+#include "gossip.h"
+#include "pvfs2-debug.h"
+#include "pint-distribution.h"
+#include "pint-dist-utils.h"
+#include "pvfs2-dist-simple-stripe.h"
+#include "pvfs2-request.h"
+#include "pint-request.h"
+#include "pvfs2-internal.h"
+
+#define DEFAULT_BLOCKS 65536
+#define DEFAULT_REPEATS 3
+#define SEGMAX 64
+#define BYTEMAX (4*1024*1024)
+#define TILES 3
+#define STRIP_SIZE 4096
+
+struct flat_outcome
+{
+    uint64_t hash;
+    int64_t segs;
+    PVFS_size bytes;
+    PVFS_offset type_offset;
+    double secs;
+};
+
+static PVFS_offset seg_offsets[SEGMAX];
+static PVFS_size seg_sizes[SEGMAX];
+
+static double now_secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec + (double) ts.tv_nsec / 1e9);
+}
+
+static uint64_t hash_add(uint64_t hash, int64_t value)
+{
+    hash ^= (uint64_t) value;
+    return (hash * 1099511628211ULL);
+}
+
+/* processes file_req from target to final, with mem_req in client mode */
+static int run_once(PINT_Request *file_req, PINT_Request *mem_req,
+                    int mode, int server_nr, PVFS_offset target,
+                    PVFS_offset final, int flatten,
+                    struct flat_outcome *out)
+{
+    PINT_Request_state *file_state;
+    PINT_Request_state *mem_state = NULL;
+    PINT_request_file_data rfdata;
+    PINT_Request_result result;
+    double start;
+    int ret;
+    int i;
+
+    PINT_request_flatten = flatten;
+    file_state = PINT_new_request_state(file_req);
+    if (mem_req)
+    {
+        mem_state = PINT_new_request_state(mem_req);
+    }
+    PINT_request_flatten = 1;
+    if (!file_state || (mem_req && !mem_state))
+    {
+        return -1;
+    }
+    PINT_REQUEST_STATE_SET_TARGET(file_state, target);
+    PINT_REQUEST_STATE_SET_FINAL(file_state, final);
+
+    memset(&rfdata, 0, sizeof(rfdata));
+    rfdata.server_nr = server_nr;
+    rfdata.server_ct = 4;
+    rfdata.fsize = 0;
+    rfdata.extend_flag = 1;
+    rfdata.dist = PINT_dist_create("simple_stripe");
+    PINT_dist_lookup(rfdata.dist);
+    ((PVFS_simple_stripe_params *) rfdata.dist->params)->strip_size =
+        STRIP_SIZE;
+
+    memset(&result, 0, sizeof(result));
+    result.offset_array = seg_offsets;
+    result.size_array = seg_sizes;
+    result.segmax = SEGMAX;
+    result.bytemax = BYTEMAX;
+
+    memset(out, 0, sizeof(*out));
+    out->hash = 14695981039346656037ULL;
+    start = now_secs();
+    do
+    {
+        result.segs = 0;
+        result.bytes = 0;
+        ret = PINT_process_request(file_state, mem_state, &rfdata,
+                                   &result, mode);
+        if (ret < 0)
+        {
+            break;
+        }
+        out->hash = hash_add(out->hash, result.segs);
+        for (i = 0; i < result.segs; i++)
+        {
+            out->hash = hash_add(out->hash, seg_offsets[i]);
+            out->hash = hash_add(out->hash, seg_sizes[i]);
+        }
+        out->segs += result.segs;
+        out->bytes += result.bytes;
+    } while (!PINT_REQUEST_DONE(file_state));
+    out->secs = now_secs() - start;
+    out->type_offset = file_state->type_offset;
+
+    PINT_dist_free(rfdata.dist);
+    PINT_free_request_state(file_state);
+    if (mem_state)
+    {
+        PINT_free_request_state(mem_state);
+    }
+    return ret;
+}
+
+/* runs one case both ways; returns 0 if the results match */
+static int run_case(const char *name, PINT_Request *file_req,
+                    PINT_Request *mem_req, int mode, PVFS_offset target,
+                    PVFS_offset final, int repeats)
+{
+    struct flat_outcome walk, flat, tmp;
+    double walk_secs = 0, flat_secs = 0;
+    int server_nr = PINT_IS_CLIENT(mode) ? 0 : 1;
+    int r;
+
+    for (r = 0; r < repeats; r++)
+    {
+        if (run_once(file_req, mem_req, mode, server_nr, target, final,
+                     0, &walk) < 0 ||
+            run_once(file_req, mem_req, mode, server_nr, target, final,
+                     1, &flat) < 0)
+        {
+            printf("%-30s PINT_process_request failed\n", name);
+            return -1;
+        }
+        walk_secs += walk.secs;
+        flat_secs += flat.secs;
+    }
+
+    /* make sure the flattened request is really used for this case */
+    tmp.segs = 0;
+    if (PINT_IS_CLIENT(mode))
+    {
+        PINT_Request_state *state = PINT_new_request_state(mem_req);
+        PINT_Request_state *fstate = PINT_new_request_state(file_req);
+        tmp.segs = (state->flat || fstate->flat);
+        PINT_free_request_state(state);
+        PINT_free_request_state(fstate);
+    }
+    else
+    {
+        PINT_Request_state *state = PINT_new_request_state(file_req);
+        tmp.segs = (state->flat != NULL);
+        PINT_free_request_state(state);
+    }
+
+    printf("%-30s %10lld %12lld %12.0f %12.0f %6.1fx %s%s\n", name,
+           lld(flat.segs), lld(flat.bytes),
+           walk.segs * repeats / walk_secs, flat.segs * repeats / flat_secs,
+           walk_secs / flat_secs, tmp.segs ? "" : "(walk) ",
+           (walk.hash == flat.hash && walk.segs == flat.segs &&
+            walk.bytes == flat.bytes &&
+            walk.type_offset == flat.type_offset) ? "ok" : "MISMATCH");
+
+    if (walk.hash != flat.hash || walk.segs != flat.segs ||
+        walk.bytes != flat.bytes || walk.type_offset != flat.type_offset)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* runs the server and client cases for one file type */
+static int run_type(const char *name, PINT_Request *type, int repeats)
+{
+    char label[64];
+    PINT_Request *contig = NULL;
+    PVFS_size total = PINT_REQUEST_TOTAL_BYTES(type) * TILES;
+    PVFS_size extent = type->ub - type->lb;
+    int errors = 0;
+
+    PVFS_Request_contiguous(total, PVFS_BYTE, &contig);
+
+    snprintf(label, sizeof(label), "%s server", name);
+    errors += run_case(label, type, NULL, PINT_SERVER, 0, total, repeats);
+    snprintf(label, sizeof(label), "%s server skip", name);
+    errors += run_case(label, type, NULL, PINT_SERVER, extent / 3 + 1,
+                       total - 5, repeats);
+    snprintf(label, sizeof(label), "%s client file", name);
+    errors += run_case(label, type, contig, PINT_CLIENT, 0, total, repeats);
+    snprintf(label, sizeof(label), "%s client mem", name);
+    errors += run_case(label, contig, type, PINT_CLIENT, 0,
+                       PINT_REQUEST_TOTAL_BYTES(type), repeats);
+
+    PVFS_Request_free(&contig);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int blocks = DEFAULT_BLOCKS;
+    int repeats = DEFAULT_REPEATS;
+    int errors = 0;
+    int32_t *lens;
+    PVFS_offset *offs;
+    PVFS_size disps[2];
+    int32_t struct_lens[2] = {1, 2};
+    PINT_Request *struct_types[2];
+    PINT_Request *inner, *outer, *tmp;
+    PVFS_offset off;
+    int c, i;
+
+    while ((c = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            blocks = atoi(optarg);
+            break;
+        case 'r':
+            repeats = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n blocks] [-r repeats]\n", argv[0]);
+            return (1);
+        }
+    }
+    if (blocks < 8 || repeats < 1)
+    {
+        fprintf(stderr, "Usage: %s [-n blocks] [-r repeats]\n", argv[0]);
+        return (1);
+    }
+
+    lens = malloc(blocks * sizeof(*lens));
+    offs = malloc(blocks * sizeof(*offs));
+    if (!lens || !offs)
+    {
+        fprintf(stderr, "Error: out of memory.\n");
+        return (1);
+    }
+    PINT_dist_initialize(NULL);
+
+    printf("%d blocks, %d repeats; rates in segments per second\n",
+           blocks, repeats);
+    printf("%-30s %10s %12s %12s %12s %7s\n", "case", "segments", "bytes",
+           "tree walk", "flattened", "speedup");
+
+    /* MPI_Type_vector of ints: 4 bytes out of every 8 */
+    PVFS_Request_vector(blocks, 1, 2, PVFS_INT, &outer);
+    errors += run_type("vector", outer, repeats);
+    PVFS_Request_free(&outer);
+
+    /* the ROMIO noncontig pattern: hindexed with a constant stride */
+    for (i = 0; i < blocks; i++)
+    {
+        lens[i] = 4;
+        offs[i] = 4 + (8 * i);
+    }
+    PVFS_Request_hindexed(blocks, lens, offs, PVFS_BYTE, &outer);
+    errors += run_type("hindexed", outer, repeats);
+    PVFS_Request_free(&outer);
+
+    /* hindexed with irregular lengths and gaps, one run per block */
+    off = 0;
+    for (i = 0; i < blocks / 64; i++)
+    {
+        lens[i] = 4 * ((i % 7) + 1);
+        offs[i] = off;
+        off += lens[i] + 4 * ((i % 3) + 1);
+    }
+    PVFS_Request_hindexed(blocks / 64, lens, offs, PVFS_BYTE, &outer);
+    errors += run_type("irregular", outer, repeats);
+    PVFS_Request_free(&outer);
+
+    /* vector of a noncontiguous vector (2D subarray) */
+    PVFS_Request_vector(16, 1, 2, PVFS_INT, &inner);
+    PVFS_Request_vector(blocks / 16, 1, 2, inner, &outer);
+    errors += run_type("vector of vectors", outer, repeats);
+    PVFS_Request_free(&outer);
+    PVFS_Request_free(&inner);
+
+    /* vector of a struct {int; gap; double[2]}; two runs per block, so
+     * all but small ones are left to the tree walk
+     */
+    disps[0] = 0;
+    disps[1] = 8;
+    struct_types[0] = PVFS_INT;
+    struct_types[1] = PVFS_DOUBLE;
+    PVFS_Request_struct(2, struct_lens, disps, struct_types, &tmp);
+    PVFS_Request_vector(blocks / 4, 1, 2, tmp, &outer);
+    errors += run_type("vector of structs", outer, repeats);
+    PVFS_Request_free(&outer);
+    PVFS_Request_free(&tmp);
+
+    free(lens);
+    free(offs);
+    PINT_dist_finalize();
+
+    if (errors)
+    {
+        printf("FAILURE: flattened results differ\n");
+        return (1);
+    }
+    printf("SUCCESS.\n");
+    return (0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
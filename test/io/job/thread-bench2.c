@@ -1,9 +1,23 @@
+/*
+ * With no arguments, measures the cost of one thread waking another
+ * through a pair of condition variables.  With -p, measures how many
+ * job completions per second a single thread can collect from one job
+ * context with job_testcontext() while 1, 2, 4, ... producer threads
+ * complete jobs into it with job_null().
+ */
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <assert.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include "pvfs2-internal.h"
+#include "id-generator.h"
+#include "job.h"
+
 pthread_cond_t cond1 = PTHREAD_COND_INITIALIZER;
 pthread_mutex_t mut1 = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t cond2 = PTHREAD_COND_INITIALIZER;
@@ -12,9 +26,14 @@ pthread_mutex_t mut2 = PTHREAD_MUTEX_INITIALIZER;
 int done = 0;
 int todo = 0;
 
+job_context_id bench_context;
+int jobs_per_producer = 100000;
+
 double wtime(void);
 void* thread1_fn(void* foo);
 void wakeywakey(void);
+void* producer_fn(void* foo);
+int bench_completions(int max_producers);
 
 double wtime(void)
 {
@@ -67,6 +86,98 @@ void wakeywakey(void)
     
 }
 
+void* producer_fn(void* foo)
+{
+    int i;
+    int ret;
+    job_status_s status;
+    job_id_t id;
+
+    for(i=0; i<jobs_per_producer; i++)
+    {
+	ret = job_null(0, NULL, 0, &status, &id, bench_context);
+	assert(ret >= 0);
+	if(ret == 1)
+	{
+	    /* completed immediately; would not be seen by the tester */
+	    fprintf(stderr, "Error: unexpected immediate completion.\n");
+	    exit(1);
+	}
+    }
+    return(NULL);
+}
+
+#define TEST_COUNT 64
+int bench_completions(int max_producers)
+{
+    pthread_t *producers;
+    job_id_t id_array[TEST_COUNT];
+    job_status_s status_array[TEST_COUNT];
+    int nproducers;
+    int count;
+    int total;
+    int want;
+    int i;
+    int ret;
+    double time1, time2;
+
+    producers = malloc(max_producers * sizeof(*producers));
+    if(!producers)
+    {
+	return(-1);
+    }
+
+    /* null jobs need nothing below the job interface, so skip
+     * job_initialize(), which would also want BMI and trove set up
+     */
+    id_gen_safe_initialize();
+    ret = job_open_context(&bench_context);
+    if(ret < 0)
+    {
+	fprintf(stderr, "job_open_context failure.\n");
+	return(-1);
+    }
+
+    printf("# producers  completions  seconds  completions/sec\n");
+    for(nproducers=1; nproducers<=max_producers; nproducers*=2)
+    {
+	want = nproducers * jobs_per_producer;
+	total = 0;
+
+	time1 = wtime();
+	for(i=0; i<nproducers; i++)
+	{
+	    ret = pthread_create(&producers[i], NULL, producer_fn, NULL);
+	    assert(ret == 0);
+	}
+	while(total < want)
+	{
+	    count = TEST_COUNT;
+	    ret = job_testcontext(id_array, &count, NULL, status_array,
+		100, bench_context);
+	    if(ret < 0)
+	    {
+		fprintf(stderr, "job_testcontext failure.\n");
+		return(-1);
+	    }
+	    total += count;
+	}
+	time2 = wtime();
+	for(i=0; i<nproducers; i++)
+	{
+	    pthread_join(producers[i], NULL);
+	}
+
+	printf("%11d  %11d  %7.3f  %15.0f\n", nproducers, total,
+	    (time2-time1), (double)total/(time2-time1));
+    }
+
+    job_close_context(bench_context);
+    id_gen_safe_finalize();
+    free(producers);
+    return(0);
+}
+
 #define ITERATIONS 100000
 int main(int argc, char **argv)	
 {
@@ -74,6 +185,28 @@ int main(int argc, char **argv)
     int ret = -1;
     int i = 0;
     double time1, time2;
+    int max_producers = 0;
+
+    while((ret = getopt(argc, argv, "p:n:")) != -1)
+    {
+	switch(ret)
+	{
+	case 'p':
+	    max_producers = atoi(optarg);
+	    break;
+	case 'n':
+	    jobs_per_producer = atoi(optarg);
+	    break;
+	default:
+	    fprintf(stderr, "Usage: %s [-p max_producers [-n jobs_per_producer]]\n",
+		argv[0]);
+	    return(-1);
+	}
+    }
+    if(max_producers > 0 && jobs_per_producer > 0)
+    {
+	return(bench_completions(max_producers));
+    }
 
     ret = pthread_create(&thread1, NULL, thread1_fn, NULL);
     assert(ret == 0);
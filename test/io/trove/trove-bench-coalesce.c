@@ -0,0 +1,489 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ *
+ * Compares servicing many small bstream writes (and reads) one trove list
+ * operation each against coalescing them the way the server does for
+ * small I/O requests: a batch of records is sorted by offset and staged
+ * in one buffer, adjacent regions are merged, and the batch is issued as
+ * a single list operation.
+ *
+ * The workload models clients that each write fixed size records to a
+ * shared checkpoint file: record r of client c lands at offset
+ * (r * clients + c) * size.  The clients write record r at about the same
+ * time, so each round of records arrives in a random order; the regions
+ * of a batch are out of order but abut once sorted.
+ *
+ * The storage space uses the server's default alt-aio method.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <assert.h>
+#include <string.h>
+
+#include "trove.h"
+#include "trove-types.h"
+#include "pvfs2-internal.h"
+#include "id-generator.h"
+
+struct record
+{
+    TROVE_offset offset;
+    TROVE_size size;
+    char *buffer;
+    int seq;
+};
+
+static int clients;
+static int records;
+static int record_size;
+static int batch_ops;
+static int sync_data;
+
+static double Wtime(void)
+{
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return((double)t.tv_sec + (double)(t.tv_usec) / 1000000);
+}
+
+static TROVE_method_id trove_method_callback(TROVE_coll_id id)
+{
+    return(TROVE_METHOD_DBPF_ALTAIO);
+}
+
+static int record_compare(const void *a, const void *b)
+{
+    const struct record *ra = a;
+    const struct record *rb = b;
+
+    if(ra->offset != rb->offset)
+    {
+        return (ra->offset < rb->offset) ? -1 : 1;
+    }
+    return ra->seq - rb->seq;
+}
+
+static int wait_ops(TROVE_context_id trove_context, int inflight)
+{
+    TROVE_op_id id_array[64];
+    TROVE_ds_state state_array[64];
+    void *user_ptr_array[64];
+    int count;
+    int i;
+
+    while(inflight > 0)
+    {
+        count = (inflight < 64) ? inflight : 64;
+        trove_dspace_testcontext(1, id_array, &count, state_array,
+            user_ptr_array, 10, trove_context);
+        for(i=0; i<count; i++)
+        {
+            if(state_array[i] != 0)
+            {
+                fprintf(stderr, "Error: trove op failed: %d\n",
+                    (int)state_array[i]);
+                return(-1);
+            }
+            inflight--;
+        }
+    }
+    return(0);
+}
+
+/* post one list operation per record, keeping batch_ops of them in flight */
+static int run_individual(TROVE_context_id trove_context,
+    struct record *recs, int write)
+{
+    TROVE_op_id op_id;
+    TROVE_size out_size;
+    int inflight = 0;
+    int i;
+    int ret;
+
+    for(i=0; i<records; i++)
+    {
+        if(write)
+        {
+            ret = trove_bstream_write_list(1, 1, &recs[i].buffer,
+                &recs[i].size, 1, &recs[i].offset, &recs[i].size, 1,
+                &out_size, (sync_data ? TROVE_SYNC : 0), NULL, NULL,
+                trove_context, &op_id, NULL);
+        }
+        else
+        {
+            ret = trove_bstream_read_list(1, 1, &recs[i].buffer,
+                &recs[i].size, 1, &recs[i].offset, &recs[i].size, 1,
+                &out_size, 0, NULL, NULL, trove_context, &op_id, NULL);
+        }
+        if(ret < 0)
+        {
+            return(ret);
+        }
+        if(ret == 0)
+        {
+            inflight++;
+        }
+        if(inflight == batch_ops)
+        {
+            ret = wait_ops(trove_context, inflight);
+            if(ret < 0)
+            {
+                return(ret);
+            }
+            inflight = 0;
+        }
+    }
+    return(wait_ops(trove_context, inflight));
+}
+
+/* issue records batch_ops at a time as sorted, merged list operations */
+static int run_coalesced(TROVE_context_id trove_context,
+    struct record *recs, int write, int *regions)
+{
+    struct record *batch;
+    char *staging;
+    char *pos;
+    TROVE_size staging_size;
+    TROVE_offset *stream_offsets;
+    TROVE_size *stream_sizes;
+    TROVE_op_id op_id;
+    TROVE_size out_size;
+    int nstreams;
+    int first;
+    int n;
+    int i;
+    int ret = 0;
+
+    batch = malloc(batch_ops * sizeof(*batch));
+    staging = malloc((size_t)batch_ops * record_size);
+    stream_offsets = malloc(batch_ops * sizeof(*stream_offsets));
+    stream_sizes = malloc(batch_ops * sizeof(*stream_sizes));
+    assert(batch && staging && stream_offsets && stream_sizes);
+
+    *regions = 0;
+    for(first=0; first<records && ret == 0; first+=batch_ops)
+    {
+        n = (records - first < batch_ops) ? records - first : batch_ops;
+        memcpy(batch, &recs[first], n * sizeof(*batch));
+        qsort(batch, n, sizeof(*batch), record_compare);
+
+        nstreams = 0;
+        pos = staging;
+        for(i=0; i<n; i++)
+        {
+            if(write)
+            {
+                memcpy(pos, batch[i].buffer, batch[i].size);
+            }
+            pos += batch[i].size;
+            if(nstreams > 0 && stream_offsets[nstreams-1] +
+                stream_sizes[nstreams-1] == batch[i].offset)
+            {
+                stream_sizes[nstreams-1] += batch[i].size;
+            }
+            else
+            {
+                stream_offsets[nstreams] = batch[i].offset;
+                stream_sizes[nstreams] = batch[i].size;
+                nstreams++;
+            }
+        }
+        *regions += nstreams;
+        staging_size = pos - staging;
+
+        if(write)
+        {
+            ret = trove_bstream_write_list(1, 1, &staging, &staging_size, 1,
+                stream_offsets, stream_sizes, nstreams, &out_size,
+                (sync_data ? TROVE_SYNC : 0), NULL, NULL, trove_context,
+                &op_id, NULL);
+        }
+        else
+        {
+            ret = trove_bstream_read_list(1, 1, &staging, &staging_size, 1,
+                stream_offsets, stream_sizes, nstreams, &out_size, 0, NULL,
+                NULL, trove_context, &op_id, NULL);
+        }
+        if(ret == 0)
+        {
+            ret = wait_ops(trove_context, 1);
+        }
+        else if(ret == 1)
+        {
+            ret = 0;
+        }
+        if(ret == 0 && !write)
+        {
+            pos = staging;
+            for(i=0; i<n; i++)
+            {
+                memcpy(batch[i].buffer, pos, batch[i].size);
+                pos += batch[i].size;
+            }
+        }
+    }
+
+    free(batch);
+    free(staging);
+    free(stream_offsets);
+    free(stream_sizes);
+    return(ret);
+}
+
+static void fill_records(struct record *recs, int pass)
+{
+    int i, j;
+
+    for(i=0; i<records; i++)
+    {
+        for(j=0; j<record_size; j++)
+        {
+            recs[i].buffer[j] = (char)(recs[i].offset + j + pass);
+        }
+    }
+}
+
+static void clear_records(struct record *recs)
+{
+    int i;
+
+    for(i=0; i<records; i++)
+    {
+        memset(recs[i].buffer, 0, record_size);
+    }
+}
+
+static int check_records(struct record *recs, int pass)
+{
+    int i, j;
+
+    for(i=0; i<records; i++)
+    {
+        for(j=0; j<record_size; j++)
+        {
+            if(recs[i].buffer[j] != (char)(recs[i].offset + j + pass))
+            {
+                fprintf(stderr, "Error: bad data in record at %lld\n",
+                    lld(recs[i].offset));
+                return(-1);
+            }
+        }
+    }
+    return(0);
+}
+
+static int do_trove_test(char* dir)
+{
+    int ret;
+    TROVE_op_id op_id;
+    TROVE_handle_extent_array extent_array;
+    TROVE_extent cur_extent;
+    TROVE_handle test_handle;
+    TROVE_context_id trove_context = -1;
+    int count;
+    TROVE_ds_state state;
+    TROVE_coll_id coll_id;
+    struct record *recs;
+    int *order;
+    int regions;
+    int i, j, k, tmp;
+    double t1, t_ind_w, t_co_w, t_ind_r, t_co_r;
+
+    /* trove registers its ops with the id generator */
+    id_gen_safe_initialize();
+
+    ret = trove_initialize(TROVE_METHOD_DBPF_ALTAIO, trove_method_callback, dir, dir, 0);
+    if(ret < 0)
+    {
+        /* try to create new storage space */
+        ret = trove_storage_create(TROVE_METHOD_DBPF_ALTAIO, dir, dir, NULL, &op_id);
+        if(ret != 1)
+        {
+            fprintf(stderr, "Error: failed to create storage space at %s\n",
+                dir);
+            return(-1);
+        }
+
+        ret = trove_initialize(TROVE_METHOD_DBPF_ALTAIO, trove_method_callback, dir, dir, 0);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: failed to initialize.\n");
+            return(-1);
+        }
+
+        ret = trove_collection_create("foo", 1, NULL, &op_id);
+        if(ret != 1)
+        {
+            fprintf(stderr, "Error: failed to create collection.\n");
+            return(-1);
+        }
+    }
+
+    ret = trove_open_context(1, &trove_context);
+    if (ret < 0)
+    {
+        fprintf(stderr, "Error: trove_open_context failed\n");
+        return -1;
+    }
+
+    ret = trove_collection_lookup(TROVE_METHOD_DBPF_ALTAIO, "foo", &coll_id, NULL, &op_id);
+    if (ret != 1) {
+	fprintf(stderr, "collection lookup failed.\n");
+	return -1;
+    }
+
+    cur_extent.first = cur_extent.last = 1;
+    extent_array.extent_count = 1;
+    extent_array.extent_array = &cur_extent;
+
+    ret = trove_dspace_create(1, &extent_array, &test_handle, 1, NULL,
+        (TROVE_SYNC | TROVE_FORCE_REQUESTED_HANDLE), NULL, trove_context,
+        &op_id, NULL);
+    while (ret == 0) ret = trove_dspace_test(
+        1, op_id, trove_context, &count, NULL, NULL, &state,
+        10);
+    if (ret < 0) {
+	fprintf(stderr, "Error: failed to create test handle.\n");
+	return -1;
+    }
+    if(state != 0 && state != -TROVE_EEXIST)
+    {
+	fprintf(stderr, "Error: failed to create test handle.\n");
+	return -1;
+    }
+
+    /* each round of records arrives in a random order */
+    recs = malloc(records * sizeof(*recs));
+    order = malloc(clients * sizeof(*order));
+    assert(recs && order);
+    srandom(1);
+    for(i=0; i<records; i++)
+    {
+        if(i % clients == 0)
+        {
+            for(j=0; j<clients; j++)
+            {
+                order[j] = j;
+            }
+            for(j=clients-1; j>0; j--)
+            {
+                k = random() % (j + 1);
+                tmp = order[j];
+                order[j] = order[k];
+                order[k] = tmp;
+            }
+        }
+        recs[i].offset = (TROVE_offset)((i / clients) * clients +
+            order[i % clients]) * record_size;
+        recs[i].size = record_size;
+        recs[i].seq = i;
+        recs[i].buffer = malloc(record_size);
+        assert(recs[i].buffer);
+    }
+
+    fill_records(recs, 0);
+    t1 = Wtime();
+    ret = run_individual(trove_context, recs, 1);
+    t_ind_w = Wtime() - t1;
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: individual writes failed.\n");
+        return(-1);
+    }
+    clear_records(recs);
+    t1 = Wtime();
+    ret = run_individual(trove_context, recs, 0);
+    t_ind_r = Wtime() - t1;
+    if(ret < 0 || check_records(recs, 0) < 0)
+    {
+        fprintf(stderr, "Error: individual reads failed.\n");
+        return(-1);
+    }
+
+    fill_records(recs, 1);
+    t1 = Wtime();
+    ret = run_coalesced(trove_context, recs, 1, &regions);
+    t_co_w = Wtime() - t1;
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: coalesced writes failed.\n");
+        return(-1);
+    }
+    clear_records(recs);
+    t1 = Wtime();
+    ret = run_coalesced(trove_context, recs, 0, &regions);
+    t_co_r = Wtime() - t1;
+    if(ret < 0 || check_records(recs, 1) < 0)
+    {
+        fprintf(stderr, "Error: coalesced reads failed.\n");
+        return(-1);
+    }
+
+    printf("# %d records of %d bytes from %d clients, batches of %d\n",
+        records, record_size, clients, batch_ops);
+    printf("# coalesced batches issued %d regions in total\n", regions);
+    printf("individual writes: %f seconds, %f ops/s\n", t_ind_w,
+        ((double)records)/t_ind_w);
+    printf("coalesced writes:  %f seconds, %f ops/s\n", t_co_w,
+        ((double)records)/t_co_w);
+    printf("individual reads:  %f seconds, %f ops/s\n", t_ind_r,
+        ((double)records)/t_ind_r);
+    printf("coalesced reads:   %f seconds, %f ops/s\n", t_co_r,
+        ((double)records)/t_co_r);
+
+    for(i=0; i<records; i++)
+    {
+        free(recs[i].buffer);
+    }
+    free(recs);
+    free(order);
+
+    trove_close_context(1, trove_context);
+    trove_finalize(TROVE_METHOD_DBPF_ALTAIO);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int ret;
+
+    if(argc != 7)
+    {
+        fprintf(stderr, "Usage: trove-bench-coalesce <trove dir> <clients> <records> <record size> <batch ops> <data sync 1|0>\n");
+        return(-1);
+    }
+
+    ret = sscanf(argv[2], "%d", &clients);
+    ret += sscanf(argv[3], "%d", &records);
+    ret += sscanf(argv[4], "%d", &record_size);
+    ret += sscanf(argv[5], "%d", &batch_ops);
+    ret += sscanf(argv[6], "%d", &sync_data);
+    if(ret != 5 || clients < 1 || records < 1 || record_size < 1 ||
+        batch_ops < 1 || sync_data < 0 || sync_data > 1)
+    {
+        fprintf(stderr, "Usage: trove-bench-coalesce <trove dir> <clients> <records> <record size> <batch ops> <data sync 1|0>\n");
+        return(-1);
+    }
+
+    if(do_trove_test(argv[1]) < 0)
+    {
+        return(-1);
+    }
+    return 0;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ft=c ts=8 sts=4 sw=4 expandtab
+ */
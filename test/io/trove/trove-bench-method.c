@@ -0,0 +1,330 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ */
+
+/* Compares the bstream methods of trove (alt-aio, directio, io-uring,
+ * ...) by running the same read or write workload against one of them
+ * and reporting operations per second, bandwidth, and the CPU time the
+ * process spent per GB moved.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <assert.h>
+#include <string.h>
+
+#include "trove.h"
+#include "trove-types.h"
+#include "pvfs2-internal.h"
+#include "quicklist.h"
+
+struct op_buffer
+{
+    char* buffer;
+    TROVE_offset offset;
+    TROVE_size size;
+    TROVE_size out_size;
+    struct qlist_head list_link;
+};
+
+QLIST_HEAD(buffer_list);
+
+static TROVE_method_id method;
+static int concurrent;
+static int do_write;
+static int random_offsets;
+static TROVE_size op_size;
+static int64_t op_count;
+
+static double Wtime(void)
+{
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return((double)t.tv_sec + (double)(t.tv_usec) / 1000000);
+}
+
+static double Ctime(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return((double)usage.ru_utime.tv_sec +
+           (double)usage.ru_utime.tv_usec / 1000000 +
+           (double)usage.ru_stime.tv_sec +
+           (double)usage.ru_stime.tv_usec / 1000000);
+}
+
+static TROVE_method_id trove_method_callback(TROVE_coll_id id)
+{
+    return(method);
+}
+
+static int parse_method(const char *name, TROVE_method_id *out)
+{
+    if(!strcmp(name, "dbpf"))
+        *out = TROVE_METHOD_DBPF;
+    else if(!strcmp(name, "alt-aio"))
+        *out = TROVE_METHOD_DBPF_ALTAIO;
+    else if(!strcmp(name, "null-aio"))
+        *out = TROVE_METHOD_DBPF_NULLAIO;
+    else if(!strcmp(name, "directio"))
+        *out = TROVE_METHOD_DBPF_DIRECTIO;
+    else if(!strcmp(name, "io-uring"))
+        *out = TROVE_METHOD_DBPF_IOURING;
+    else
+        return(-1);
+    return(0);
+}
+
+static TROVE_offset next_offset(int64_t i)
+{
+    if(random_offsets)
+    {
+        return((TROVE_offset)(random() % op_count) * op_size);
+    }
+    return((TROVE_offset)i * op_size);
+}
+
+/* runs op_count operations with up to concurrent in flight */
+static int run_ops(TROVE_context_id trove_context, int writing,
+                   int random_order)
+{
+    int ret;
+    int count;
+    int inflight = 0;
+    int i;
+    int64_t posted = 0;
+    struct op_buffer* tmp_buffer;
+    struct qlist_head* tmp_link;
+    TROVE_op_id op_id;
+    TROVE_op_id id_array[concurrent];
+    TROVE_ds_state state_array[concurrent];
+    void* user_ptr_array[concurrent];
+    int save_random = random_offsets;
+
+    random_offsets = random_order;
+    while(inflight > 0 || posted < op_count)
+    {
+        while(inflight < concurrent && posted < op_count)
+        {
+            tmp_link = qlist_pop(&buffer_list);
+            assert(tmp_link);
+            tmp_buffer = qlist_entry(tmp_link, struct op_buffer, list_link);
+            tmp_buffer->offset = next_offset(posted);
+
+            if(writing)
+            {
+                ret = trove_bstream_write_list(1, 1, &tmp_buffer->buffer,
+                    &tmp_buffer->size, 1, &tmp_buffer->offset,
+                    &tmp_buffer->size, 1, &tmp_buffer->out_size, 0, NULL,
+                    tmp_buffer, trove_context, &op_id, NULL);
+            }
+            else
+            {
+                ret = trove_bstream_read_list(1, 1, &tmp_buffer->buffer,
+                    &tmp_buffer->size, 1, &tmp_buffer->offset,
+                    &tmp_buffer->size, 1, &tmp_buffer->out_size, 0, NULL,
+                    tmp_buffer, trove_context, &op_id, NULL);
+            }
+            if(ret < 0)
+            {
+                fprintf(stderr, "Error: failed to post I/O (%d).\n", ret);
+                return(-1);
+            }
+            posted++;
+            if(ret == 1)
+            {
+                qlist_add_tail(&tmp_buffer->list_link, &buffer_list);
+                continue;
+            }
+            inflight++;
+        }
+
+        count = concurrent;
+        ret = trove_dspace_testcontext(1, id_array, &count, state_array,
+            user_ptr_array, 10, trove_context);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: testcontext failed (%d).\n", ret);
+            return(-1);
+        }
+        for(i=0; i<count; i++)
+        {
+            if(state_array[i] != 0)
+            {
+                fprintf(stderr, "Error: I/O failed (%d).\n", state_array[i]);
+                return(-1);
+            }
+            inflight--;
+            tmp_buffer = user_ptr_array[i];
+            qlist_add_tail(&tmp_buffer->list_link, &buffer_list);
+        }
+    }
+    random_offsets = save_random;
+
+    return(0);
+}
+
+int main(int argc, char *argv[])
+{
+    int ret;
+    int i;
+    int64_t total_mb;
+    char *dir;
+    TROVE_op_id op_id;
+    TROVE_handle_extent_array extent_array;
+    TROVE_extent cur_extent;
+    TROVE_handle test_handle;
+    TROVE_context_id trove_context = -1;
+    TROVE_coll_id coll_id;
+    TROVE_ds_state state;
+    int count;
+    struct op_buffer* tmp_buffer;
+    double start_tm, end_tm, start_cpu, end_cpu;
+    double bytes;
+
+    if(argc < 7 || argc > 8)
+    {
+        fprintf(stderr, "Usage: trove-bench-method <trove dir> "
+                "<dbpf|alt-aio|null-aio|directio|io-uring> <read|write> "
+                "<op size KB> <total MB> <concurrent ops> [random]\n");
+        return(-1);
+    }
+
+    dir = argv[1];
+    if(parse_method(argv[2], &method) < 0)
+    {
+        fprintf(stderr, "Error: unknown method %s\n", argv[2]);
+        return(-1);
+    }
+    do_write = (strcmp(argv[3], "write") == 0);
+    op_size = (TROVE_size)atoll(argv[4]) * 1024;
+    total_mb = atoll(argv[5]);
+    concurrent = atoi(argv[6]);
+    random_offsets = (argc == 8 && strcmp(argv[7], "random") == 0);
+    if(op_size < 1 || total_mb < 1 || concurrent < 1)
+    {
+        fprintf(stderr, "Error: sizes and concurrency must be positive.\n");
+        return(-1);
+    }
+    op_count = (total_mb * 1024 * 1024) / op_size;
+    if(op_count < 1)
+    {
+        op_count = 1;
+    }
+
+    ret = trove_initialize(method, trove_method_callback, dir, dir, 0);
+    if(ret < 0)
+    {
+        /* try to create new storage space */
+        ret = trove_storage_create(method, dir, dir, NULL, &op_id);
+        if(ret != 1)
+        {
+            fprintf(stderr, "Error: failed to create storage space at %s\n",
+                dir);
+            return(-1);
+        }
+
+        ret = trove_initialize(method, trove_method_callback, dir, dir, 0);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: failed to initialize.\n");
+            return(-1);
+        }
+
+        ret = trove_collection_create("foo", 1, NULL, &op_id);
+        if(ret != 1)
+        {
+            fprintf(stderr, "Error: failed to create collection.\n");
+            return(-1);
+        }
+    }
+
+    ret = trove_open_context(1, &trove_context);
+    if (ret < 0)
+    {
+        fprintf(stderr, "Error: trove_open_context failed\n");
+        return(-1);
+    }
+
+    ret = trove_collection_lookup(method, "foo", &coll_id, NULL, &op_id);
+    if (ret != 1)
+    {
+        fprintf(stderr, "collection lookup failed.\n");
+        return(-1);
+    }
+
+    cur_extent.first = cur_extent.last = 1;
+    extent_array.extent_count = 1;
+    extent_array.extent_array = &cur_extent;
+
+    ret = trove_dspace_create(1, &extent_array, &test_handle, 1, NULL,
+        (TROVE_SYNC | TROVE_FORCE_REQUESTED_HANDLE), NULL, trove_context,
+        &op_id, NULL);
+    while (ret == 0) ret = trove_dspace_test(
+        1, op_id, trove_context, &count, NULL, NULL, &state,
+        10);
+    if (ret < 0 || (state != 0 && state != -TROVE_EEXIST))
+    {
+        fprintf(stderr, "Error: failed to create test handle.\n");
+        return(-1);
+    }
+
+    /* aligned so that directio can use them */
+    for(i=0; i<concurrent; i++)
+    {
+        tmp_buffer = malloc(sizeof(*tmp_buffer));
+        assert(tmp_buffer);
+        tmp_buffer->size = op_size;
+        ret = posix_memalign((void **)&tmp_buffer->buffer, 4096, op_size);
+        assert(ret == 0);
+        memset(tmp_buffer->buffer, 'a', op_size);
+        qlist_add_tail(&tmp_buffer->list_link, &buffer_list);
+    }
+
+    if(!do_write)
+    {
+        /* lay the file down first so that reads have something to find */
+        if(run_ops(trove_context, 1, 0) < 0)
+        {
+            return(-1);
+        }
+    }
+
+    start_cpu = Ctime();
+    start_tm = Wtime();
+    if(run_ops(trove_context, do_write, random_offsets) < 0)
+    {
+        return(-1);
+    }
+    end_tm = Wtime();
+    end_cpu = Ctime();
+
+    bytes = (double)op_count * (double)op_size;
+    printf("# %s %s, %lld ops of %lld bytes, %d concurrent%s\n",
+           argv[2], (do_write ? "write" : "read"), lld(op_count),
+           lld(op_size), concurrent, (random_offsets ? ", random" : ""));
+    printf("%f ops/s\n", ((double)op_count)/(end_tm-start_tm));
+    printf("%f MB/s\n", (bytes/(1024.0*1024.0))/(end_tm-start_tm));
+    printf("%f CPU s/GB\n",
+           (end_cpu-start_cpu)/(bytes/(1024.0*1024.0*1024.0)));
+
+    trove_close_context(1, trove_context);
+    trove_finalize(method);
+
+    return 0;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ft=c ts=8 sts=4 sw=4 expandtab
+ */
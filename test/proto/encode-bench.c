@@ -0,0 +1,366 @@
+/*
+ * (C) 2001 Clemson University and The University of Chicago
+ *
+ * See COPYING in top-level directory.
+ *
+ * Microbenchmark for the request protocol encoder: for a handful of
+ * common requests and responses, times encode + release, decode +
+ * release, and getting and returning a worst case receive buffer from
+ * the encoder's buffer pool versus BMI_memalloc()/BMI_memfree().  All
+ * times are in nanoseconds per operation.  Nothing is sent; the tcp
+ * method connects to a socket this program listens on only so that
+ * there is an address to allocate buffers for.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "pvfs2-types.h"
+#include "pvfs2-internal.h"
+#include "gossip.h"
+#include "bmi.h"
+#include "pint-dist-utils.h"
+#include "PINT-reqproto-encode.h"
+
+#define DEFAULT_ITERATIONS 100000
+#define BENCH_GROUPS 4
+#define BENCH_DFILES 8
+#define BENCH_SEGMENTS 4
+#define BENCH_DIRENTS 64
+
+struct bench_case
+{
+    const char *name;
+    enum PINT_encode_msg_type type;
+    void *msg;
+    enum PVFS_server_op op;
+};
+
+static PVFS_gid groups[BENCH_GROUPS] = {100, 101, 102, 103};
+static PVFS_handle handles[BENCH_DFILES];
+static PVFS_object_attr attrs[BENCH_SEGMENTS];
+static PVFS_dirent dirents[BENCH_DIRENTS];
+static char path[] = "home/user/project/file.dat";
+static char entry[] = "file.dat";
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec * 1e9 + (double) ts.tv_nsec);
+}
+
+/* listens on an unused local port; returns the port or -1 */
+static int listen_local(void)
+{
+    struct sockaddr_in sin;
+    socklen_t len = sizeof(sin);
+    int fd;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return (-1);
+    }
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0 ||
+        listen(fd, 1) < 0 ||
+        getsockname(fd, (struct sockaddr *) &sin, &len) < 0)
+    {
+        close(fd);
+        return (-1);
+    }
+    return (ntohs(sin.sin_port));
+}
+
+static void fill_credential(PVFS_credential *cred)
+{
+    memset(cred, 0, sizeof(*cred));
+    cred->userid = 1000;
+    cred->num_groups = BENCH_GROUPS;
+    cred->group_array = groups;
+    cred->timeout = time(NULL) + 3600;
+}
+
+static void fill_meta_attr(PVFS_object_attr *attr)
+{
+    memset(attr, 0, sizeof(*attr));
+    attr->owner = 1000;
+    attr->group = 100;
+    attr->perms = 0644;
+    attr->atime = attr->mtime = attr->ctime = time(NULL);
+    attr->objtype = PVFS_TYPE_METAFILE;
+    attr->mask = PVFS_ATTR_COMMON_ALL | PVFS_ATTR_META_DFILES |
+        PVFS_ATTR_META_UNSTUFFED;
+    attr->u.meta.dfile_count = BENCH_DFILES;
+    attr->u.meta.dfile_array = handles;
+}
+
+static int run_case(struct bench_case *c, PVFS_BMI_addr_t addr,
+                    int iterations)
+{
+    struct PINT_encoded_msg enc;
+    struct PINT_decoded_msg dec;
+    int max_size;
+    void *buf;
+    double t1, t_enc, t_dec, t_pool, t_bmi;
+    int ret;
+    int i;
+
+    t1 = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        ret = PINT_encode(c->msg, c->type, &enc, addr, ENCODING_LE_BFIELD);
+        if (ret < 0)
+        {
+            PVFS_perror("PINT_encode", ret);
+            return (-1);
+        }
+        PINT_encode_release(&enc, c->type);
+    }
+    t_enc = (now_ns() - t1) / iterations;
+
+    /* keep one encoding around to decode over and over */
+    ret = PINT_encode(c->msg, c->type, &enc, addr, ENCODING_LE_BFIELD);
+    if (ret < 0)
+    {
+        PVFS_perror("PINT_encode", ret);
+        return (-1);
+    }
+    t1 = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        ret = PINT_decode(enc.buffer_list[0], c->type, &dec, addr,
+                          enc.total_size);
+        if (ret < 0)
+        {
+            PVFS_perror("PINT_decode", ret);
+            return (-1);
+        }
+        PINT_decode_release(&dec, c->type);
+    }
+    t_dec = (now_ns() - t1) / iterations;
+    PINT_encode_release(&enc, c->type);
+
+    /* what a client posts to receive the response to this operation */
+    max_size = PINT_encode_calc_max_size(PINT_ENCODE_RESP, c->op,
+                                         ENCODING_LE_BFIELD);
+    t1 = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        buf = PINT_encode_buffer_get(addr, max_size, BMI_RECV);
+        if (!buf)
+        {
+            fprintf(stderr, "Error: PINT_encode_buffer_get failed.\n");
+            return (-1);
+        }
+        PINT_encode_buffer_put(buf, 0);
+    }
+    t_pool = (now_ns() - t1) / iterations;
+
+    t1 = now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        buf = BMI_memalloc(addr, max_size, BMI_RECV);
+        if (!buf)
+        {
+            fprintf(stderr, "Error: BMI_memalloc failed.\n");
+            return (-1);
+        }
+        BMI_memfree(addr, buf, max_size, BMI_RECV);
+    }
+    t_bmi = (now_ns() - t1) / iterations;
+
+    printf("%-18s %8lld %10.0f %10.0f %10d %10.0f %10.0f\n", c->name,
+           lld(enc.total_size), t_enc, t_dec, max_size, t_pool, t_bmi);
+    return (0);
+}
+
+int main(int argc, char **argv)
+{
+    struct PVFS_server_req getattr_req, lookup_req, crdirent_req;
+    struct PVFS_server_resp getattr_resp, lookup_resp, readdir_resp;
+    struct PVFS_server_resp wc_resp;
+    struct bench_case cases[7];
+    PVFS_BMI_addr_t addr;
+    char addr_str[64];
+    int port;
+    int iterations = DEFAULT_ITERATIONS;
+    int ncases = 0;
+    int errors = 0;
+    int ret;
+    int c;
+    int i;
+
+    while ((c = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n iterations]\n", argv[0]);
+            return (-1);
+        }
+    }
+    if (optind != argc || iterations < 1)
+    {
+        fprintf(stderr, "Usage: %s [-n iterations]\n", argv[0]);
+        return (-1);
+    }
+
+    /* methods are loaded on demand by the address lookup below */
+    ret = BMI_initialize(NULL, NULL, 0);
+    if (ret < 0)
+    {
+        PVFS_perror("BMI_initialize", ret);
+        return (-1);
+    }
+    ret = PINT_dist_initialize(NULL);
+    if (ret < 0)
+    {
+        PVFS_perror("PINT_dist_initialize", ret);
+        return (-1);
+    }
+    ret = PINT_encode_initialize();
+    if (ret < 0)
+    {
+        PVFS_perror("PINT_encode_initialize", ret);
+        return (-1);
+    }
+    port = listen_local();
+    if (port < 0)
+    {
+        perror("listen_local");
+        return (-1);
+    }
+    snprintf(addr_str, sizeof(addr_str), "tcp://127.0.0.1:%d", port);
+    ret = BMI_addr_lookup(&addr, addr_str);
+    if (ret < 0)
+    {
+        PVFS_perror("BMI_addr_lookup", ret);
+        return (-1);
+    }
+
+    for (i = 0; i < BENCH_DFILES; i++)
+    {
+        handles[i] = 1048576 + i;
+    }
+    for (i = 0; i < BENCH_SEGMENTS; i++)
+    {
+        fill_meta_attr(&attrs[i]);
+    }
+    for (i = 0; i < BENCH_DIRENTS; i++)
+    {
+        snprintf(dirents[i].d_name, sizeof(dirents[i].d_name),
+                 "entry-%d", i);
+        dirents[i].handle = 2097152 + i;
+    }
+
+    memset(&getattr_req, 0, sizeof(getattr_req));
+    getattr_req.op = PVFS_SERV_GETATTR;
+    fill_credential(&getattr_req.u.getattr.credential);
+    getattr_req.u.getattr.fs_id = 1;
+    getattr_req.u.getattr.handle = handles[0];
+    getattr_req.u.getattr.attrmask = PVFS_ATTR_SYS_ALL_NOHINT;
+    cases[ncases].name = "getattr req";
+    cases[ncases].type = PINT_ENCODE_REQ;
+    cases[ncases].msg = &getattr_req;
+    cases[ncases++].op = PVFS_SERV_GETATTR;
+
+    memset(&getattr_resp, 0, sizeof(getattr_resp));
+    getattr_resp.op = PVFS_SERV_GETATTR;
+    fill_meta_attr(&getattr_resp.u.getattr.attr);
+    cases[ncases].name = "getattr resp";
+    cases[ncases].type = PINT_ENCODE_RESP;
+    cases[ncases].msg = &getattr_resp;
+    cases[ncases++].op = PVFS_SERV_GETATTR;
+
+    memset(&lookup_req, 0, sizeof(lookup_req));
+    lookup_req.op = PVFS_SERV_LOOKUP_PATH;
+    fill_credential(&lookup_req.u.lookup_path.credential);
+    lookup_req.u.lookup_path.path = path;
+    lookup_req.u.lookup_path.fs_id = 1;
+    lookup_req.u.lookup_path.handle = handles[0];
+    lookup_req.u.lookup_path.attrmask = PVFS_ATTR_SYS_ALL_NOHINT;
+    cases[ncases].name = "lookup_path req";
+    cases[ncases].type = PINT_ENCODE_REQ;
+    cases[ncases].msg = &lookup_req;
+    cases[ncases++].op = PVFS_SERV_LOOKUP_PATH;
+
+    memset(&lookup_resp, 0, sizeof(lookup_resp));
+    lookup_resp.op = PVFS_SERV_LOOKUP_PATH;
+    lookup_resp.u.lookup_path.handle_array = handles;
+    lookup_resp.u.lookup_path.handle_count = BENCH_SEGMENTS;
+    lookup_resp.u.lookup_path.attr_array = attrs;
+    lookup_resp.u.lookup_path.attr_count = BENCH_SEGMENTS;
+    cases[ncases].name = "lookup_path resp";
+    cases[ncases].type = PINT_ENCODE_RESP;
+    cases[ncases].msg = &lookup_resp;
+    cases[ncases++].op = PVFS_SERV_LOOKUP_PATH;
+
+    memset(&crdirent_req, 0, sizeof(crdirent_req));
+    crdirent_req.op = PVFS_SERV_CRDIRENT;
+    fill_credential(&crdirent_req.u.crdirent.credential);
+    crdirent_req.u.crdirent.name = entry;
+    crdirent_req.u.crdirent.new_handle = handles[1];
+    crdirent_req.u.crdirent.handle = handles[0];
+    crdirent_req.u.crdirent.dirent_handle = handles[2];
+    crdirent_req.u.crdirent.fs_id = 1;
+    cases[ncases].name = "crdirent req";
+    cases[ncases].type = PINT_ENCODE_REQ;
+    cases[ncases].msg = &crdirent_req;
+    cases[ncases++].op = PVFS_SERV_CRDIRENT;
+
+    memset(&readdir_resp, 0, sizeof(readdir_resp));
+    readdir_resp.op = PVFS_SERV_READDIR;
+    readdir_resp.u.readdir.dirent_array = dirents;
+    readdir_resp.u.readdir.dirent_count = BENCH_DIRENTS;
+    cases[ncases].name = "readdir resp";
+    cases[ncases].type = PINT_ENCODE_RESP;
+    cases[ncases].msg = &readdir_resp;
+    cases[ncases++].op = PVFS_SERV_READDIR;
+
+    memset(&wc_resp, 0, sizeof(wc_resp));
+    wc_resp.op = PVFS_SERV_WRITE_COMPLETION;
+    wc_resp.u.write_completion.total_completed = 65536;
+    cases[ncases].name = "write_compl resp";
+    cases[ncases].type = PINT_ENCODE_RESP;
+    cases[ncases].msg = &wc_resp;
+    cases[ncases++].op = PVFS_SERV_WRITE_COMPLETION;
+
+    printf("%d iterations; times in ns per operation\n", iterations);
+    printf("%-18s %8s %10s %10s %10s %10s %10s\n", "message", "bytes",
+           "encode", "decode", "recv size", "recv pool", "recv bmi");
+    for (i = 0; i < ncases; i++)
+    {
+        if (run_case(&cases[i], addr, iterations) < 0)
+        {
+            errors++;
+        }
+    }
+
+    PINT_encode_finalize();
+    BMI_finalize();
+
+    return (errors ? -1 : 0);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */